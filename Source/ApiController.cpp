@@ -27,6 +27,8 @@
 
 =============================================================================*/
 #include <afxwin.h>
+#include <cmath>
+#include <cctype>
 #include <ApiController.h>
 #include "Common/StreamSystemInfo.h"
 #include "Common/ErrorCodeToMessage.h"
@@ -36,11 +38,64 @@ namespace Examples {
 
 //enum { NUM_FRAMES = 3, };
 enum { NUM_FRAMES = 10, };
+// Frames a reader may lag behind on the shared frame bus before it skips
+enum { FRAME_BUS_SLOTS = 8, };
+// Writes per path of the feature write benchmark
+enum { FEATURE_BENCHMARK_WRITES = 200000, };
+// Cameras opened at the same time by OpenCameras
+enum { MAX_PARALLEL_OPENS = 4, };
+// Time a command feature may take before it is given up
+enum { COMMAND_TIMEOUT_MS = 5000, };
+// Frame rate planned for cameras that do not report one
+enum { DEFAULT_TARGET_FPS = 30, };
+// Time the link model simulates to check a bandwidth plan
+enum { LINK_SIMULATION_MS = 1000, };
+// Time between two attempts to reopen a camera that came back
+enum { RECOVERY_RETRY_MS = 1000, };
+// The frame counters are written here for a scraper to pick up
+static const char * const METRICS_FILE = "vmb_metrics.prom";
+enum { METRICS_EXPORT_MS = 1000, };
+// Frames waiting for the statistics, older ones are skipped when it falls behind
+enum { STATS_QUEUE_DEPTH = 2, };
+// Frames motion detection may lag behind before the oldest is skipped
+enum { MOTION_QUEUE_DEPTH = 4, };
+// Frames waiting for the merge, a bracket losing one is skipped
+enum { HDR_QUEUE_DEPTH = HDR_MAX_FRAMES, };
+// Frames the YUV conversion may lag behind before the oldest is skipped
+enum { YUV_QUEUE_DEPTH = 2, };
+// The flat-field maps of a camera are stored as <prefix><serial number><extension>
+static const char * const CALIBRATION_FILE_PREFIX = "calibration_";
+static const char * const CALIBRATION_FILE_EXTENSION = ".ffc";
+// The defective pixels of a camera are stored as <prefix><camera ID><extension>
+static const char * const DEFECT_FILE_PREFIX = "defects_";
+static const char * const DEFECT_FILE_EXTENSION = ".dpm";
+// The remap table of a camera is stored as <prefix><serial number><extension>
+static const char * const REMAP_FILE_PREFIX = "undistort_";
+static const char * const REMAP_FILE_EXTENSION = ".map";
+// The lens of a camera is described in <prefix><serial number><extension>
+static const char * const LENS_FILE_PREFIX = "lens_";
+static const char * const LENS_FILE_EXTENSION = ".txt";
+// Frames the auto exposure is given against the exposure model
+enum { EXPOSURE_SIMULATION_FRAMES = 100, };
+// Frames an average keeps by their leases, the camera needs the rest
+enum { AVERAGE_MAX_LEASES = NUM_FRAMES / 2, };
 
 ApiController::ApiController()
 // Get a reference to the Vimba singleton
     : m_system( VimbaSystem::GetInstance() )
+    , m_nPayloadSize( 0 )
+    , m_nPayloadSize2( 0 )
+    , m_bFrameBusEnabled( false )
+    , m_FeatureWriter( [this]( const std::string &rStrName, const FeatureWriter::Value &rValue ) { return WriteQueuedFeature( 1, rStrName, rValue ); } )
+    , m_FeatureWriter2( [this]( const std::string &rStrName, const FeatureWriter::Value &rValue ) { return WriteQueuedFeature( 2, rStrName, rValue ); } )
 {
+    m_pStreamMetrics = m_Metrics.AddStream( "camera1" );
+    m_pStreamMetrics2 = m_Metrics.AddStream( "camera2" );
+    m_ePipelineError = BuildPipeline( 1 );
+    if( VmbErrorSuccess == m_ePipelineError )
+    {
+        m_ePipelineError = BuildPipeline( 2 );
+    }
 	VmbErrorType res = VmbErrorSuccess;
 	VmbVersionInfo_t version;
 	res = m_system.QueryVersion(version);
@@ -75,12 +130,23 @@ VmbErrorType ApiController::StartUp()
 {
     VmbErrorType res;
 
+    if( VmbErrorSuccess != m_ePipelineError )
+    {
+        return m_ePipelineError;
+    }
     // Start Vimba
     res = m_system.Startup();
     if( VmbErrorSuccess == res )
     {
         // Register an observer whose callback routine gets triggered whenever a camera is plugged in or out
-        res = m_system.RegisterCameraListObserver( ICameraListObserverPtr( new CameraObserver() ) );
+        res = m_system.RegisterCameraListObserver( ICameraListObserverPtr( new CameraObserver( &m_Registry ) ) );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        // The only full enumeration, later changes arrive as deltas
+        m_Registry.Populate( GetCameraList() );
+        // Counters that cannot be exported do not keep the cameras from streaming
+        m_MetricsExporter.Start( &m_Metrics, METRICS_FILE, METRICS_EXPORT_MS );
     }
 	CameraIsOpen1=false;
 	CameraIsAcq1=false;
@@ -95,43 +161,72 @@ VmbErrorType ApiController::StartUp()
 //
 void ApiController::ShutDown()
 {
+    m_MetricsExporter.Stop();
+    // Whoever listened for write results may be gone after this
+    m_FeatureWriter.Flush();
+    m_FeatureWriter2.Flush();
+    m_FeatureWriter.SetCompletionCallback( FeatureWriter::CompletionCallback() );
+    m_FeatureWriter2.SetCompletionCallback( FeatureWriter::CompletionCallback() );
     // Release Vimba
     m_system.Shutdown();
 }
 
-/** read an integer feature from camera.
-*/
- inline VmbErrorType GetFeatureIntValue( const CameraPtr &camera, const std::string &featureName, VmbInt64_t & value )
-{
-    if( SP_ISNULL( camera ) )
-    {
-        return VmbErrorBadParameter;
-    }
-    FeaturePtr      pFeature;
-    VmbErrorType    result;
-    result = SP_ACCESS( camera )->GetFeatureByName( featureName.c_str(), pFeature );
-    if( VmbErrorSuccess == result )
-    {
-        result = SP_ACCESS( pFeature )->GetValue( value );
-    }
-    return result;
-}
-/** write an integer feature from camera.
-*/
- inline VmbErrorType SetFeatureIntValue( const CameraPtr &camera, const std::string &featureName, VmbInt64_t value )
+//
+// Configures a freshly opened camera: sets the maximum possible Ethernet
+// packet size, selects the pixel format and reads back the image geometry.
+// Only touches the given camera, so different cameras can be configured
+// at the same time.
+//
+// Parameters:
+//  [in]    rFeatures       The feature cache attached to the camera
+//  [out]   rnWidth         The width of a frame
+//  [out]   rnHeight        The height of a frame
+//  [out]   rnPixelFormat   The selected pixel format
+//  [out]   rnPayloadSize   The size of one frame in bytes
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::ConfigureCamera( FeatureCache &rFeatures, VmbInt64_t &rnWidth, VmbInt64_t &rnHeight, VmbInt64_t &rnPixelFormat, VmbInt64_t &rnPayloadSize )
 {
-    if( SP_ISNULL( camera ) )
-    {
-        return VmbErrorBadParameter;
-    }
-    FeaturePtr      pFeature;
-    VmbErrorType    result;
-    result = SP_ACCESS( camera )->GetFeatureByName( featureName.c_str(), pFeature );
-    if( VmbErrorSuccess == result )
-    {
-        result = SP_ACCESS( pFeature )->SetValue( value );
-    }
-    return result;
+	VmbErrorType res;
+	// Set the GeV packet size to the highest possible value
+	// (In this example we do not test whether this cam actually is a GigE cam)
+	FeaturePtr pCommandFeature;
+	if( VmbErrorSuccess == rFeatures.GetFeature( "GVSPAdjustPacketSize", pCommandFeature ) )
+	{
+		// The executor polls for completion, this thread sleeps meanwhile. A
+		// failed or timed out adjustment leaves the packet size as it was.
+		m_Commands.Execute( pCommandFeature, "GVSPAdjustPacketSize", COMMAND_TIMEOUT_MS ).wait();
+	}
+
+	// Save the current width
+	res = rFeatures.GetIntValue( "Width", rnWidth );
+	if( VmbErrorSuccess == res )
+	{
+		// Save current height
+		res = rFeatures.GetIntValue( "Height", rnHeight );
+		if( VmbErrorSuccess == res )
+		{
+			// Set pixel format. For the sake of simplicity we only support Mono and BGR in this example.
+			// Try to set BGR
+			// res = SetFeatureIntValue( pCamera, "PixelFormat", VmbPixelFormatBgr8 );//˴ҪΪRGB
+			res = rFeatures.SetIntValue( "PixelFormat", VmbPixelFormatRgb8 );//˴ҪΪRGB
+			if( VmbErrorSuccess != res )
+			{
+				// Fall back to Mono
+				res = rFeatures.SetIntValue( "PixelFormat", VmbPixelFormatMono8 );
+			}
+			// Read back the currently selected pixel format
+			res =  rFeatures.GetIntValue( "PixelFormat", rnPixelFormat );
+			if( VmbErrorSuccess == res )
+			{
+				// The burst arena is sized by the payload of the selected format
+				res = rFeatures.GetIntValue( "PayloadSize", rnPayloadSize );
+			}
+		}
+	}
+	return res;
 }
 
 //
@@ -158,50 +253,42 @@ VmbErrorType ApiController::OpenCloseCamera1(const std::string &rStrCameraID)
 		res = m_system.OpenCameraByID( rStrCameraID.c_str(), VmbAccessModeFull, m_pCamera );
 		if( VmbErrorSuccess == res )
 		{
-			// Set the GeV packet size to the highest possible value
-			// (In this example we do not test whether this cam actually is a GigE cam)
+			m_strCameraID = rStrCameraID;
+			// Camera 1 stays with this camera, whatever its position in the list
+			m_Registry.BindSlot( 1, rStrCameraID );
+			m_Metrics.SetCameraID( m_pStreamMetrics, rStrCameraID );
+			// Resolve the frequently used features once
+			m_Features.Attach( m_pCamera );
 			CameraIsOpen1=true;
-			FeaturePtr pCommandFeature;
-			if( VmbErrorSuccess == m_pCamera->GetFeatureByName( "GVSPAdjustPacketSize", pCommandFeature ) )
+			res = ConfigureCamera( m_Features, m_nWidth, m_nHeight, m_nPixelFormat, m_nPayloadSize );
+			if(     VmbErrorSuccess == res
+				&&  m_bFrameBusEnabled )
 			{
-				if( VmbErrorSuccess == pCommandFeature->RunCommand() )
-				{
-					bool bIsCommandDone = false;
-					do
-					{
-						if( VmbErrorSuccess != pCommandFeature->IsCommandDone( bIsCommandDone ) )
-						{
-							break;
-						}
-					} while( false == bIsCommandDone );
-				}
+				// A missing bus does not keep the camera from streaming
+				m_FrameBus.Open( rStrCameraID, FRAME_BUS_SLOTS, static_cast<VmbUint32_t>( m_nPayloadSize ) );
 			}
-
-			// Save the current width
-			res = GetFeatureIntValue( m_pCamera, "Width", m_nWidth );
 			if( VmbErrorSuccess == res )
 			{
-				// Save current height
-				res = GetFeatureIntValue( m_pCamera, "Height", m_nHeight );
-				if( VmbErrorSuccess == res )
-				{
-					// Set pixel format. For the sake of simplicity we only support Mono and BGR in this example.
-					// Try to set BGR
-					// res = SetFeatureIntValue( m_pCamera, "PixelFormat", VmbPixelFormatBgr8 );//˴ҪΪRGB
-					res = SetFeatureIntValue( m_pCamera, "PixelFormat", VmbPixelFormatRgb8 );//˴ҪΪRGB
-					if( VmbErrorSuccess != res )
-					{
-						// Fall back to Mono
-						res = SetFeatureIntValue( m_pCamera,"PixelFormat", VmbPixelFormatMono8 );
-					}
-					// Read back the currently selected pixel format
-					res =  GetFeatureIntValue( m_pCamera, "PixelFormat", m_nPixelFormat );
-				}
+				LoadCalibration( 1 );
 			}
 		}
 	}
 	else
 	{
+		// No motion may arm the burst again
+		m_pMotionStage->DisableTrigger();
+		m_Burst.Finish();
+		m_FrameBus.Close();
+		// The next camera brings its own maps
+		m_pCorrectionStage->Reset();
+		m_pAverageStage->Reset();
+		m_pUndistortStage->Reset();
+		m_pYuvStage->ClearLatest();
+		// Nothing is left to write to
+		m_pAutoExposureStage->Disable();
+		DisableHdr( 1 );
+		m_FeatureWriter.Discard();
+		m_Features.Invalidate();
 		res = SP_ACCESS( m_pCamera )->Close();
 		CameraIsOpen1=false;
 	    CameraIsAcq1=false;
@@ -216,7 +303,16 @@ VmbErrorType ApiController::StartContinuousImageAcquisition()
     if( CameraIsOpen1 )
     {
         // Create a frame observer for this camera (This will be wrapped in a shared_ptr so we don't delete it)
-        SP_SET( m_pFrameObserver,new FrameObserver( m_pCamera ) );
+        SP_SET( m_pFrameObserver,new FrameObserver( m_pCamera, &m_Pipeline, m_pStreamMetrics ) );
+        m_Pipeline.Start();
+        // Values still settling in the writer, e.g. the packet size, are
+        // locked once the camera streams
+        m_FeatureWriter.Flush();
+        // Make room on the link before the camera starts sending
+        RebalanceBandwidth( 1 );
+        // Remember what the camera streams with to restore it after a replug
+        m_Session.strCameraID = m_strCameraID;
+        m_Session.state.Capture( m_Features );
         // Start streaming
         res = SP_ACCESS( m_pCamera )->StartContinuousImageAcquisition( NUM_FRAMES, m_pFrameObserver );
 		CameraIsAcq1=true;
@@ -233,49 +329,38 @@ VmbErrorType ApiController::OpenCloseCamera2(const std::string &rStrCameraID)
 		res = m_system.OpenCameraByID( rStrCameraID.c_str(), VmbAccessModeFull, m_pCamera2 );
 		if( VmbErrorSuccess == res )
 		{
-			// Set the GeV packet size to the highest possible value
-			// (In this example we do not test whether this cam actually is a GigE cam)
+			m_strCameraID2 = rStrCameraID;
+			m_Registry.BindSlot( 2, rStrCameraID );
+			m_Metrics.SetCameraID( m_pStreamMetrics2, rStrCameraID );
+			// Resolve the frequently used features once
+			m_Features2.Attach( m_pCamera2 );
 			CameraIsOpen2=true;
-			FeaturePtr pCommandFeature;
-			if( VmbErrorSuccess == m_pCamera2->GetFeatureByName( "GVSPAdjustPacketSize", pCommandFeature ) )
+			res = ConfigureCamera( m_Features2, m_nWidth2, m_nHeight2, m_nPixelFormat2, m_nPayloadSize2 );
+			if(     VmbErrorSuccess == res
+				&&  m_bFrameBusEnabled )
 			{
-				if( VmbErrorSuccess == pCommandFeature->RunCommand() )
-				{
-					bool bIsCommandDone = false;
-					do
-					{
-						if( VmbErrorSuccess != pCommandFeature->IsCommandDone( bIsCommandDone ) )
-						{
-							break;
-						}
-					} while( false == bIsCommandDone );
-				}
+				// A missing bus does not keep the camera from streaming
+				m_FrameBus2.Open( rStrCameraID, FRAME_BUS_SLOTS, static_cast<VmbUint32_t>( m_nPayloadSize2 ) );
 			}
-			// Save the current width
-			res = GetFeatureIntValue( m_pCamera2, "Width", m_nWidth2 );
 			if( VmbErrorSuccess == res )
 			{
-				// Save current height
-				res = GetFeatureIntValue( m_pCamera2, "Height", m_nHeight2 );
-				if( VmbErrorSuccess == res )
-				{
-					// Set pixel format. For the sake of simplicity we only support Mono and BGR in this example.
-					// Try to set BGR
-					//res = SetFeatureIntValue( m_pCamera2, "PixelFormat", VmbPixelFormatBgr8 );//˴ҪΪRGB
-					res = SetFeatureIntValue( m_pCamera2, "PixelFormat", VmbPixelFormatRgb8 );//˴ҪΪRGB
-					if( VmbErrorSuccess != res )
-					{
-						// Fall back to Mono
-						res = SetFeatureIntValue( m_pCamera2,"PixelFormat", VmbPixelFormatMono8 );
-					}
-					// Read back the currently selected pixel format
-					res =  GetFeatureIntValue( m_pCamera2, "PixelFormat", m_nPixelFormat2 );
-				}
+				LoadCalibration( 2 );
 			}
 		}
 	}
 	else
 	{
+		m_pMotionStage2->DisableTrigger();
+		m_Burst2.Finish();
+		m_FrameBus2.Close();
+		m_pCorrectionStage2->Reset();
+		m_pAverageStage2->Reset();
+		m_pUndistortStage2->Reset();
+		m_pYuvStage2->ClearLatest();
+		m_pAutoExposureStage2->Disable();
+		DisableHdr( 2 );
+		m_FeatureWriter2.Discard();
+		m_Features2.Invalidate();
 		SP_ACCESS( m_pCamera2 )->Close();
 		CameraIsOpen2=false;
 	    CameraIsAcq2=false;
@@ -289,13 +374,70 @@ VmbErrorType ApiController::StartContinuousImageAcquisition2()
     if( CameraIsOpen2 )
     {
         // Create a frame observer for this camera (This will be wrapped in a shared_ptr so we don't delete it)
-        SP_SET( m_pFrameObserver2,new FrameObserver2( m_pCamera2 ) );
+        SP_SET( m_pFrameObserver2,new FrameObserver2( m_pCamera2, &m_Pipeline2, m_pStreamMetrics2 ) );
+        m_Pipeline2.Start();
+        m_FeatureWriter2.Flush();
+        // Make room on the link before the camera starts sending
+        RebalanceBandwidth( 2 );
+        // Remember what the camera streams with to restore it after a replug
+        m_Session2.strCameraID = m_strCameraID2;
+        m_Session2.state.Capture( m_Features2 );
         // Start streaming
         res = SP_ACCESS( m_pCamera2 )->StartContinuousImageAcquisition( NUM_FRAMES, m_pFrameObserver2 );
 		CameraIsAcq2=true;
     }        
     return res;
 }
+//
+// Opens and configures several cameras at the same time. The first ID
+// goes to camera 1, the second to camera 2, an empty ID leaves its camera
+// as it is. A camera that fails to open does not keep the others from
+// opening.
+//
+// Parameters:
+//  [in]    rCameraIDs      The IDs of the cameras to open
+//  [out]   rResults        The result and timing of every camera
+//  [out]   rdWallTimeMs    The time it took to open all of them
+//
+// Returns:
+//  VmbErrorSuccess if all cameras were opened, else the first error
+//
+VmbErrorType ApiController::OpenCameras( const std::vector<std::string> &rCameraIDs, std::vector<CameraOpenResult> &rResults, double &rdWallTimeMs )
+{
+    ParallelCameraOpener opener( MAX_PARALLEL_OPENS );
+    // Every slot has its own camera, features and geometry members, so the
+    // two opens do not share any state
+    rdWallTimeMs = opener.Run(  rCameraIDs,
+                                [this]( size_t nIndex, const std::string &rStrCameraID ) -> VmbErrorType
+                                {
+                                    if( rStrCameraID.empty() )
+                                    {
+                                        // Nothing to open for this camera
+                                        return VmbErrorSuccess;
+                                    }
+                                    switch( nIndex )
+                                    {
+                                    case 0:
+                                        return CameraIsOpen1 ? VmbErrorInvalidCall : OpenCloseCamera1( rStrCameraID );
+                                    case 1:
+                                        return CameraIsOpen2 ? VmbErrorInvalidCall : OpenCloseCamera2( rStrCameraID );
+                                    default:
+                                        // There is no view for more cameras
+                                        return VmbErrorResources;
+                                    }
+                                },
+                                rResults );
+
+    for( size_t i = 0; i < rResults.size(); ++i )
+    {
+        if( VmbErrorSuccess != rResults[i].eResult )
+        {
+            return rResults[i].eResult;
+        }
+    }
+    return VmbErrorSuccess;
+}
+
 //
 // Calls the API convenience function to stop image acquisition
 // Closes the camera
@@ -306,44 +448,58 @@ VmbErrorType ApiController::StartContinuousImageAcquisition2()
 
 VmbErrorType ApiController::SetCameraFloatFeature(int cameraIndex,const std::string &featureName, float value)
 {
-	VmbErrorType res;
-	FeaturePtr feature;
-	if (cameraIndex<2)
-	{
-
-	
-     res = m_pCamera ->GetFeatureByName( featureName.c_str(), feature );
-     res = feature ->SetValue(value) ;
-
-	}
-	else
-	{
-     res = m_pCamera2 ->GetFeatureByName( featureName.c_str(), feature );
-     res = feature ->SetValue(value) ;
-	}
-	 return res;
+    // The slider may fire dozens of times a second, so the features it
+    // writes most go through the handles resolved on open, the others come
+    // from the cache instead of a GenICam lookup
+    FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+    FloatFeature feature;
+    if( "ExposureTimeAbs" == featureName )
+    {
+        feature = rFeatures.GetExposureTimeFeature();
+    }
+    else if( "Gain" == featureName )
+    {
+        feature = rFeatures.GetGainFeature();
+    }
+    VmbErrorType res = feature.IsValid() ? feature.Set( value ) : rFeatures.SetFloatValue( featureName, value );
+    if( VmbErrorSuccess == res )
+    {
+        ( cameraIndex < 2 ? m_Session : m_Session2 ).state.Update( featureName, static_cast<double>( value ) );
+    }
+    return res;
 }
 VmbErrorType ApiController::SetCameraIntFeature(int cameraIndex,const std::string &featureName, int value)
 {
-	VmbErrorType res;
-	FeaturePtr feature;
-	if (cameraIndex<2)
-	{	
-     res = m_pCamera ->GetFeatureByName( featureName.c_str(), feature );
-     res = feature ->SetValue(value) ;
-	}
-	else
-	{
-     res = m_pCamera2 ->GetFeatureByName( featureName.c_str(), feature );
-     res = feature ->SetValue(value) ;
-	}
-	 return res;
+    // The packet size typed into the dialog is written while the camera
+    // streams, through the handle resolved on open
+    FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+    IntFeature feature;
+    if( "GevSCPSPacketSize" == featureName )
+    {
+        feature = rFeatures.GetPacketSizeFeature();
+    }
+    VmbErrorType res = feature.IsValid() ? feature.Set( value ) : rFeatures.SetIntValue( featureName, value );
+    if( VmbErrorSuccess == res )
+    {
+        ( cameraIndex < 2 ? m_Session : m_Session2 ).state.Update( featureName, static_cast<VmbInt64_t>( value ) );
+    }
+    return res;
 }
 VmbErrorType ApiController::StopContinuousImageAcquisition()
 {
     // Stop streaming
 	CameraIsAcq1=false;
-    return SP_ACCESS( m_pCamera )->StopContinuousImageAcquisition();
+    // A running burst ends with the acquisition and gets flushed
+    m_Burst.Finish();
+    VmbErrorType res = SP_ACCESS( m_pCamera )->StopContinuousImageAcquisition();
+    // Frames still waiting in stage queues are let go
+    m_Pipeline.Stop();
+    // The next acquisition does not average or merge with these frames
+    m_pAverageStage->Reset();
+    m_pHdrMergeStage->Reset();
+    // The other cameras may use the freed bandwidth
+    RebalanceBandwidth( 0 );
+    return res;
 
     // Close camera
     //return  SP_ACCESS( m_pCamera )->Close();
@@ -353,7 +509,17 @@ VmbErrorType ApiController::StopContinuousImageAcquisition2()
 
     // Stop streaming
    CameraIsAcq2=false;
-   return SP_ACCESS( m_pCamera2 )->StopContinuousImageAcquisition();
+   // A running burst ends with the acquisition and gets flushed
+   m_Burst2.Finish();
+   VmbErrorType res = SP_ACCESS( m_pCamera2 )->StopContinuousImageAcquisition();
+   // Frames still waiting in stage queues are let go
+   m_Pipeline2.Stop();
+   // The next acquisition does not average or merge with these frames
+   m_pAverageStage2->Reset();
+   m_pHdrMergeStage2->Reset();
+   // The other cameras may use the freed bandwidth
+   RebalanceBandwidth( 0 );
+   return res;
 
     // Close camera
     //return  SP_ACCESS( m_pCamera2 )->Close();
@@ -423,45 +589,1490 @@ VmbPixelFormatType ApiController::GetPixelFormat2()
 // Gets the oldest frame that has not been picked up yet
 //
 // Returns:
-//  A frame shared pointer
+//  The lease of the frame. Letting go of it queues the frame to be
+//  filled by the API again.
 //
-FramePtr ApiController::GetFrame()
+FrameLeasePtr ApiController::GetFrame()
 {
-    return SP_DYN_CAST( m_pFrameObserver,FrameObserver )->GetFrame();
+    FrameLeasePtr pLease = m_pDisplayStage->GetFrame();
+    NoteFirstFrame( m_Session, pLease );
+    return pLease;
 }
-FramePtr ApiController::GetFrame2()
+FrameLeasePtr ApiController::GetFrame2()
 {
-    return SP_DYN_CAST( m_pFrameObserver2,FrameObserver2 )->GetFrame();
+    FrameLeasePtr pLease = m_pDisplayStage2->GetFrame();
+    NoteFirstFrame( m_Session2, pLease );
+    return pLease;
 }
 //
 // Clears all remaining frames that have not been picked up
 //
 void ApiController::ClearFrameQueue()
 {
-    SP_DYN_CAST( m_pFrameObserver,FrameObserver )->ClearFrameQueue();
+    m_pDisplayStage->ClearFrameQueue();
 }
 void ApiController::ClearFrameQueue2()
 {
-    SP_DYN_CAST( m_pFrameObserver2,FrameObserver2 )->ClearFrameQueue();
+    m_pDisplayStage2->ClearFrameQueue();
+}
+//
+// Reserves the burst arena of an open camera. The burst starts with the
+// next complete frame and ends after nFrames frames, nDurationMs
+// milliseconds or when acquisition is stopped, whatever comes first.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nFrames         The number of frames to capture
+//  [in]    nDurationMs     The maximum burst length, 0 for no limit
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::ArmBurst( int cameraIndex, VmbUint32_t nFrames, VmbUint32_t nDurationMs )
+{
+    if( cameraIndex < 2 )
+    {
+        if( !CameraIsOpen1 )
+        {
+            return VmbErrorDeviceNotOpen;
+        }
+        return m_Burst.Arm( static_cast<VmbUint32_t>( m_nPayloadSize ), nFrames, nDurationMs, "burst_cam1" );
+    }
+    else
+    {
+        if( !CameraIsOpen2 )
+        {
+            return VmbErrorDeviceNotOpen;
+        }
+        return m_Burst2.Arm( static_cast<VmbUint32_t>( m_nPayloadSize2 ), nFrames, nDurationMs, "burst_cam2" );
+    }
+}
+
+//
+// Gets the burst recorder of a camera to end a burst or to query its progress
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The burst recorder
+//
+BurstRecorder& ApiController::GetBurstRecorder( int cameraIndex )
+{
+    return cameraIndex < 2 ? m_Burst : m_Burst2;
+}
+
+//
+// Lets motion in front of an open camera trigger its burst. The burst
+// is armed now and again whenever motion starts, it records while the
+// motion goes on and is flushed when it stops.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to record on motion, false to record regardless
+//  [in]    nFrames         The number of frames a burst captures at most
+//  [in]    nDurationMs     The maximum burst length, 0 for no limit
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::SetMotionTrigger( int cameraIndex, bool bEnable, VmbUint32_t nFrames, VmbUint32_t nDurationMs )
+{
+    MotionStage &rStage = *( cameraIndex < 2 ? m_pMotionStage : m_pMotionStage2 );
+    BurstRecorder &rBurst = GetBurstRecorder( cameraIndex );
+    if( !bEnable )
+    {
+        rStage.DisableTrigger();
+        // Motion going on keeps what it recorded
+        if( !rStage.IsActive() )
+        {
+            rBurst.Finish();
+        }
+        return VmbErrorSuccess;
+    }
+    // Armed ahead, so the first frame with motion does not wait for the arena
+    VmbErrorType res = ArmBurst( cameraIndex, nFrames, nDurationMs );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    rStage.EnableTrigger( [this, cameraIndex, nFrames, nDurationMs]( const MotionResult &rResult )
+    {
+        BurstRecorder &rBurst = GetBurstRecorder( cameraIndex );
+        if( MotionEventStopped == rResult.eEvent )
+        {
+            rBurst.Finish();
+        }
+        else if( BurstRecorder::StateIdle == rBurst.GetState() )
+        {
+            // A burst still flushing misses this motion
+            ArmBurst( cameraIndex, nFrames, nDurationMs );
+        }
+    } );
+    return VmbErrorSuccess;
+}
+
+//
+// Takes the motion starts and stops of a camera since the last call
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [out]   rEvents         Oldest first
+//
+void ApiController::TakeMotionEvents( int cameraIndex, std::vector<MotionResult> &rEvents )
+{
+    ( cameraIndex < 2 ? m_pMotionStage : m_pMotionStage2 )->TakeEvents( rEvents );
 }
+
 //
-// Queues a given frame to be filled by the API
+// Stacks the next frames of a camera for its flat-field calibration.
+// Dark frames start a new calibration with the lens covered, flat
+// frames follow with the camera looking at an even light.
 //
 // Parameters:
-//  [in]    pFrame          The frame to queue
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    eType           What the camera looks at
+//  [in]    nFrames         The number of frames to stack
 //
 // Returns:
 //  An API status code
 //
-VmbErrorType ApiController::QueueFrame( FramePtr pFrame )
+VmbErrorType ApiController::CaptureCalibration( int cameraIndex, CalibrationFrameType eType, VmbUint32_t nFrames )
+{
+    if( !( cameraIndex < 2 ? CameraIsOpen1 : CameraIsOpen2 ) )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+    if( 0 == nFrames )
+    {
+        return VmbErrorBadParameter;
+    }
+    ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->StartCapture( eType, nFrames );
+    return VmbErrorSuccess;
+}
+
+bool ApiController::IsCalibrationCapturing( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->IsCapturing();
+}
+
+//
+// Builds the maps of a camera from the frames stacked, corrects with
+// them and stores them for the serial number of the camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  VmbErrorInvalidCall without flat frames, else an API status code
+//
+VmbErrorType ApiController::BuildCalibration( int cameraIndex )
+{
+    CorrectionStage &rStage = *( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 );
+    std::shared_ptr<CalibrationMaps> pMaps( new CalibrationMaps() );
+    VmbErrorType res = rStage.BuildMaps( *pMaps );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    rStage.SetMaps( pMaps );
+    // The maps are used even if they cannot be stored
+    return pMaps->Save( GetCalibrationPath( cameraIndex ) );
+}
+
+//
+// Switches the flat-field and dark-frame correction of a camera on or off
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to correct the frames
+//
+void ApiController::SetFlatFieldCorrection( int cameraIndex, bool bEnable )
+{
+    ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->SetFlatFieldEnabled( bEnable );
+}
+
+bool ApiController::HasCalibration( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->HasMaps();
+}
+
+//
+// Finds the defective pixels of a camera in the frames stacked for its
+// calibration, repairs them and stores them for the camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [out]   rnCount         The number of defective pixels
+//
+// Returns:
+//  VmbErrorInvalidCall if no frames were stacked, else an API status code
+//
+VmbErrorType ApiController::DetectDefectivePixels( int cameraIndex, size_t &rnCount )
+{
+    std::shared_ptr<DefectivePixelMap> pMap( new DefectivePixelMap() );
+    rnCount = 0;
+    VmbErrorType res = ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->DetectDefects( *pMap );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    rnCount = pMap->GetPixels().size();
+    ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->SetDefectMap( pMap );
+    return pMap->Save( GetDefectMapPath( cameraIndex ) );
+}
+
+//
+// Switches the repair of defective pixels of a camera on or off
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to repair them
+//
+void ApiController::SetDefectCorrection( int cameraIndex, bool bEnable )
+{
+    ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->SetDefectRepairEnabled( bEnable );
+}
+
+//
+// Returns:
+//  The number of defective pixels of a camera, 0 without a map
+//
+size_t ApiController::GetDefectCount( int cameraIndex ) const
+{
+    const std::shared_ptr<const DefectivePixelMap> pMap = ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->GetDefectMap();
+    return NULL == pMap ? 0 : pMap->GetPixels().size();
+}
+
+//
+// Averages the last frames of a camera to reduce noise. Every frame
+// is still delivered, as the mean of the window ending with it.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nFrames         The frames to average, 1 for none
+//
+// Returns:
+//  VmbErrorBadParameter beyond AverageStage::MAX_WINDOW
+//
+VmbErrorType ApiController::SetAveraging( int cameraIndex, VmbUint32_t nFrames )
+{
+    return ( cameraIndex < 2 ? m_pAverageStage : m_pAverageStage2 )->SetWindow( nFrames );
+}
+
+//
+// Returns:
+//  The number of frames a camera averages, 1 for none
+//
+VmbUint32_t ApiController::GetAveraging( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pAverageStage : m_pAverageStage2 )->GetWindow();
+}
+
+//
+// Undistorts the frames of an open camera taken through a lens. The
+// lookup table is stored for the camera, a table stored for the same
+// lens and frames is read instead of built again.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rLens           The intrinsics and distortion of the lens
+//
+// Returns:
+//  VmbErrorWrongType for packed formats, else an API status code
+//
+VmbErrorType ApiController::SetLensModel( int cameraIndex, const LensModel &rLens )
+{
+    const VmbUint32_t nWidth = static_cast<VmbUint32_t>( cameraIndex < 2 ? m_nWidth : m_nWidth2 );
+    const VmbUint32_t nHeight = static_cast<VmbUint32_t>( cameraIndex < 2 ? m_nHeight : m_nHeight2 );
+    const VmbPixelFormatType ePixelFormat = static_cast<VmbPixelFormatType>( cameraIndex < 2 ? m_nPixelFormat : m_nPixelFormat2 );
+    const std::string strPath = GetRemapPath( cameraIndex );
+    std::shared_ptr<RemapTable> pTable( new RemapTable() );
+    if(     VmbErrorSuccess == pTable->Load( strPath )
+        &&  pTable->IsBuiltFrom( rLens, nWidth, nHeight, ePixelFormat ) )
+    {
+        ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->SetTable( pTable );
+        return VmbErrorSuccess;
+    }
+    VmbErrorType res = pTable->Build( rLens, nWidth, nHeight, ePixelFormat );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->SetTable( pTable );
+    return pTable->Save( strPath );
+}
+
+//
+// Remaps the frames of an open camera by any other mapping, e.g. to
+// rectify them, and stores the table for the camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    mapping         Where a pixel of the remapped frame comes from
+//
+// Returns:
+//  VmbErrorWrongType for packed formats, else an API status code
+//
+VmbErrorType ApiController::SetRemapping( int cameraIndex, const RemapTable::Mapping &mapping )
+{
+    std::shared_ptr<RemapTable> pTable( new RemapTable() );
+    VmbErrorType res = pTable->Build(   mapping,
+                                        static_cast<VmbUint32_t>( cameraIndex < 2 ? m_nWidth : m_nWidth2 ),
+                                        static_cast<VmbUint32_t>( cameraIndex < 2 ? m_nHeight : m_nHeight2 ),
+                                        static_cast<VmbPixelFormatType>( cameraIndex < 2 ? m_nPixelFormat : m_nPixelFormat2 ) );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->SetTable( pTable );
+    return pTable->Save( GetRemapPath( cameraIndex ) );
+}
+
+//
+// Switches the remapping of the frames of a camera on or off
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to remap the frames
+//
+void ApiController::SetUndistortion( int cameraIndex, bool bEnable )
+{
+    ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->SetEnabled( bEnable );
+}
+
+bool ApiController::HasRemapTable( int cameraIndex ) const
+{
+    return NULL != ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->GetTable();
+}
+
+//
+// Gets the name files of an open camera are stored under, its serial
+// number so they follow the camera, or its ID without one
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The name
+//
+std::string ApiController::GetSerialFileName( int cameraIndex ) const
 {
-    return SP_ACCESS( m_pCamera )->QueueFrame( pFrame );
+    const std::string &rStrCameraID = cameraIndex < 2 ? m_strCameraID : m_strCameraID2;
+    CameraInfo info;
+    if(     m_Registry.Find( rStrCameraID, info )
+        &&  !info.strSerialNumber.empty() )
+    {
+        return info.strSerialNumber;
+    }
+    return rStrCameraID;
 }
 
-VmbErrorType ApiController::QueueFrame2( FramePtr pFrame )
+//
+// Gets the file with the calibration maps of an open camera, named
+// after its serial number so the maps follow the camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The path of the file
+//
+std::string ApiController::GetCalibrationPath( int cameraIndex ) const
 {
-    return SP_ACCESS( m_pCamera2 )->QueueFrame( pFrame );
+    return CALIBRATION_FILE_PREFIX + GetSerialFileName( cameraIndex ) + CALIBRATION_FILE_EXTENSION;
 }
+
+//
+// Maps the stored calibration of a freshly opened camera and reads its
+// defective pixels and its remap table, if there are any. A lens file
+// of the camera builds the table anew unless the stored one matches it.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void ApiController::LoadCalibration( int cameraIndex )
+{
+    std::shared_ptr<CalibrationMaps> pMaps( new CalibrationMaps() );
+    // A camera without maps or with a damaged file streams uncorrected
+    if( VmbErrorSuccess == pMaps->Load( GetCalibrationPath( cameraIndex ) ) )
+    {
+        ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->SetMaps( pMaps );
+    }
+    std::shared_ptr<DefectivePixelMap> pDefects( new DefectivePixelMap() );
+    if( VmbErrorSuccess == pDefects->Load( GetDefectMapPath( cameraIndex ) ) )
+    {
+        ( cameraIndex < 2 ? m_pCorrectionStage : m_pCorrectionStage2 )->SetDefectMap( pDefects );
+    }
+    LensModel lens;
+    if(     VmbErrorSuccess == lens.Load( GetLensPath( cameraIndex ) )
+        &&  VmbErrorSuccess == SetLensModel( cameraIndex, lens ) )
+    {
+        return;
+    }
+    // Frames of another size or format than the table pass as they are
+    std::shared_ptr<RemapTable> pTable( new RemapTable() );
+    if( VmbErrorSuccess == pTable->Load( GetRemapPath( cameraIndex ) ) )
+    {
+        ( cameraIndex < 2 ? m_pUndistortStage : m_pUndistortStage2 )->SetTable( pTable );
+    }
+}
+
+//
+// Gets the file with the defective pixels of an open camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The path of the file
+//
+std::string ApiController::GetDefectMapPath( int cameraIndex ) const
+{
+    std::string strName = cameraIndex < 2 ? m_strCameraID : m_strCameraID2;
+    // IDs of network cameras may hold characters a file name may not
+    for( size_t i = 0; i < strName.size(); ++i )
+    {
+        if( !isalnum( static_cast<unsigned char>( strName[i] ) ) && '-' != strName[i] )
+        {
+            strName[i] = '_';
+        }
+    }
+    return DEFECT_FILE_PREFIX + strName + DEFECT_FILE_EXTENSION;
+}
+
+//
+// Gets the file with the remap table of an open camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The path of the file
+//
+std::string ApiController::GetRemapPath( int cameraIndex ) const
+{
+    return REMAP_FILE_PREFIX + GetSerialFileName( cameraIndex ) + REMAP_FILE_EXTENSION;
+}
+
+//
+// Gets the file with the lens of an open camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The path of the file
+//
+std::string ApiController::GetLensPath( int cameraIndex ) const
+{
+    return LENS_FILE_PREFIX + GetSerialFileName( cameraIndex ) + LENS_FILE_EXTENSION;
+}
+
+//
+// Switches publishing of complete frames to the shared frame bus on or
+// off. Cameras opened later follow this setting.
+//
+// Parameters:
+//  [in]    bEnable         true to publish frames
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::EnableFrameBus( bool bEnable )
+{
+    VmbErrorType res = VmbErrorSuccess;
+    m_bFrameBusEnabled = bEnable;
+    if( !bEnable )
+    {
+        m_FrameBus.Close();
+        m_FrameBus2.Close();
+        return res;
+    }
+    if( CameraIsOpen1 && !m_FrameBus.IsOpen() )
+    {
+        res = m_FrameBus.Open( m_strCameraID, FRAME_BUS_SLOTS, static_cast<VmbUint32_t>( m_nPayloadSize ) );
+    }
+    if( CameraIsOpen2 && !m_FrameBus2.IsOpen() )
+    {
+        VmbErrorType res2 = m_FrameBus2.Open( m_strCameraID2, FRAME_BUS_SLOTS, static_cast<VmbUint32_t>( m_nPayloadSize2 ) );
+        if( VmbErrorSuccess == res )
+        {
+            res = res2;
+        }
+    }
+    return res;
+}
+
+//
+// Gets the shared frame bus of a camera to query its readers
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The frame bus
+//
+SharedFrameBus& ApiController::GetFrameBus( int cameraIndex )
+{
+    return cameraIndex < 2 ? m_FrameBus : m_FrameBus2;
+}
+
+//
+// Gets the feature handle cache of a camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The feature cache, empty while the camera is closed
+//
+FeatureCache& ApiController::GetFeatureCache( int cameraIndex )
+{
+    return cameraIndex < 2 ? m_Features : m_Features2;
+}
+
+//
+// Gets the feature writer of a camera. Writes queued there leave the
+// calling thread at once, e.g. the UI while a slider is dragged.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The feature writer, pending writes are dropped when the camera closes
+//
+FeatureWriter& ApiController::GetFeatureWriter( int cameraIndex )
+{
+    return cameraIndex < 2 ? m_FeatureWriter : m_FeatureWriter2;
+}
+
+//
+// Compares feature writes per second with a name lookup per write and
+// through a resolved handle, against a simulated node map
+//
+// Parameters:
+//  [out]   rResult         The writes per second of both paths
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::BenchmarkFeatureWrites( FeatureBenchmarkResult &rResult ) const
+{
+    FeatureBenchmark benchmark;
+    return benchmark.Run( FEATURE_BENCHMARK_WRITES, rResult );
+}
+
+//
+// Assigns a camera to a link of the bandwidth planner. Without one, the
+// cameras of one host interface share a link.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rStrLinkID      The link, described with GetBandwidthPlanner().SetLink,
+//                          empty to go back to the interface of the camera
+//
+void ApiController::SetCameraLink( int cameraIndex, const std::string &rStrLinkID )
+{
+    ( cameraIndex < 2 ? m_strLinkID : m_strLinkID2 ) = rStrLinkID;
+}
+
+//
+// Gets the bandwidth planner to describe the links between cameras and host
+//
+// Returns:
+//  The bandwidth planner
+//
+BandwidthPlanner& ApiController::GetBandwidthPlanner()
+{
+    return m_Bandwidth;
+}
+
+//
+// Gets the bandwidth plan applied last and what the link model predicted for it
+//
+// Parameters:
+//  [out]   rAllocations    The allocation of every streaming camera
+//  [out]   rSimulation     The simulated drops and resends, same order
+//
+void ApiController::GetBandwidthPlan( std::vector<StreamAllocation> &rAllocations, std::vector<LinkSimulationResult> &rSimulation ) const
+{
+    rAllocations = m_BandwidthPlan;
+    rSimulation = m_BandwidthSimulation;
+}
+
+//
+// Collects what a camera is going to send
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bStarting       true if the camera is about to start streaming
+//  [out]   rDemand         The stream demand of the camera
+//
+void ApiController::GetStreamDemand( int cameraIndex, bool bStarting, StreamDemand &rDemand )
+{
+    FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+    rDemand.strCameraID = cameraIndex < 2 ? m_strCameraID : m_strCameraID2;
+    // Cameras on one host interface share its link unless told otherwise
+    rDemand.strLinkID = cameraIndex < 2 ? m_strLinkID : m_strLinkID2;
+    if(     rDemand.strLinkID.empty()
+        &&  VmbErrorSuccess != SP_ACCESS( cameraIndex < 2 ? m_pCamera : m_pCamera2 )->GetInterfaceID( rDemand.strLinkID ) )
+    {
+        rDemand.strLinkID = rDemand.strCameraID;
+    }
+    rDemand.nPayloadSize = cameraIndex < 2 ? m_nPayloadSize : m_nPayloadSize2;
+    // The packet size is fixed while the camera streams
+    rDemand.bPacketSizeLocked = !bStarting;
+
+    if( VmbErrorSuccess != rFeatures.GetFloatValue( "AcquisitionFrameRateAbs", rDemand.dTargetFps ) )
+    {
+        rDemand.dTargetFps = DEFAULT_TARGET_FPS;
+    }
+
+    VmbInt64_t nValue = 0;
+    rDemand.nCurrentPacketSize = 1500;
+    if( VmbErrorSuccess == rFeatures.GetIntValue( "GevSCPSPacketSize", nValue ) )
+    {
+        rDemand.nCurrentPacketSize = static_cast<VmbUint32_t>( nValue );
+    }
+    // GVSPAdjustPacketSize on open found the largest packet the path
+    // carries, or the size was typed in, the plan never goes above it
+    rDemand.nMaxPacketSize = rDemand.nCurrentPacketSize;
+    rDemand.dTickFrequency = 1e9;
+    if(     VmbErrorSuccess == rFeatures.GetIntValue( "GevTimestampTickFrequency", nValue )
+        &&  0 < nValue )
+    {
+        rDemand.dTickFrequency = static_cast<double>( nValue );
+    }
+}
+
+//
+// Plans the bandwidth of all streaming cameras, checks the plan against
+// the link model and applies it
+//
+// Parameters:
+//  [in]    nStartingCamera The camera about to start (1 or 2), 0 for none
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::RebalanceBandwidth( int nStartingCamera )
+{
+    std::vector<StreamDemand> demands;
+    std::vector<int> cameraIndices;
+    for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+    {
+        const bool bStreaming = ( 1 == cameraIndex ) ? CameraIsAcq1 : CameraIsAcq2;
+        const bool bStarting = ( nStartingCamera == cameraIndex );
+        if( bStreaming || bStarting )
+        {
+            StreamDemand demand;
+            GetStreamDemand( cameraIndex, bStarting, demand );
+            demands.push_back( demand );
+            cameraIndices.push_back( cameraIndex );
+        }
+    }
+
+    m_Bandwidth.Plan( demands, m_BandwidthPlan );
+
+    // Predict drops and resends link by link
+    m_BandwidthSimulation.assign( demands.size(), LinkSimulationResult() );
+    LinkSimulator simulator;
+    std::map< std::string, std::vector<size_t> > indicesByLink;
+    for( size_t i = 0; i < demands.size(); ++i )
+    {
+        indicesByLink[demands[i].strLinkID].push_back( i );
+    }
+    for(    std::map< std::string, std::vector<size_t> >::const_iterator iter = indicesByLink.begin();
+            indicesByLink.end() != iter;
+            ++iter )
+    {
+        std::vector<StreamDemand> linkDemands;
+        std::vector<StreamAllocation> linkAllocations;
+        for( size_t n = 0; n < iter->second.size(); ++n )
+        {
+            linkDemands.push_back( demands[iter->second[n]] );
+            linkAllocations.push_back( m_BandwidthPlan[iter->second[n]] );
+        }
+        std::vector<LinkSimulationResult> linkResults;
+        simulator.Simulate( m_Bandwidth.GetLink( iter->first ), linkDemands, linkAllocations, LINK_SIMULATION_MS / 1000.0, linkResults );
+        for( size_t n = 0; n < iter->second.size(); ++n )
+        {
+            m_BandwidthSimulation[iter->second[n]] = linkResults[n];
+        }
+    }
+
+    VmbErrorType res = VmbErrorSuccess;
+    for( size_t i = 0; i < m_BandwidthPlan.size(); ++i )
+    {
+        FeatureCache &rFeatures = GetFeatureCache( cameraIndices[i] );
+        const StreamAllocation &rAllocation = m_BandwidthPlan[i];
+        if(     !demands[i].bPacketSizeLocked
+            &&  rAllocation.nPacketSize != demands[i].nCurrentPacketSize )
+        {
+            rFeatures.SetIntValue( "GevSCPSPacketSize", rAllocation.nPacketSize );
+        }
+        VmbErrorType resCamera = rFeatures.SetIntValue( "StreamBytesPerSecond", rAllocation.nStreamBytesPerSecond );
+        if( VmbErrorSuccess != resCamera )
+        {
+            // Not every camera paces by rate, GevSCPD covers the others.
+            // Both at once would slow the camera down twice.
+            resCamera = rFeatures.SetIntValue( "GevSCPD", rAllocation.nInterPacketDelay );
+        }
+        if( VmbErrorSuccess == res )
+        {
+            res = resCamera;
+        }
+    }
+    return res;
+}
+
+//
+// Checks whether a camera is still connected
+//
+// Parameters:
+//  [in]    rStrCameraID    The ID of the camera
+//
+// Returns:
+//  true if the camera registry lists the camera
+//
+bool ApiController::IsCameraPresent( const std::string &rStrCameraID )
+{
+    return m_Registry.Contains( rStrCameraID );
+}
+
+//
+// Applies the queued plug events to the camera registry
+//
+// Parameters:
+//  [out]   rChanges        The cameras that showed up or went away
+//
+void ApiController::ApplyCameraListChanges( std::vector<CameraChange> &rChanges )
+{
+    m_Registry.ApplyChanges( rChanges );
+}
+
+//
+// Gets the registry of all connected cameras
+//
+// Returns:
+//  The camera registry
+//
+CameraRegistry& ApiController::GetCameraRegistry()
+{
+    return m_Registry;
+}
+
+//
+// Gets the frame counters of a camera, e.g. to add the conversion time
+// of the view
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The counters of the camera
+//
+StreamMetrics& ApiController::GetStreamMetrics( int cameraIndex )
+{
+    return cameraIndex < 2 ? *m_pStreamMetrics : *m_pStreamMetrics2;
+}
+
+//
+// Gets the registry with the frame counters of all cameras
+//
+// Returns:
+//  The metrics registry
+//
+const MetricsRegistry& ApiController::GetMetricsRegistry() const
+{
+    return m_Metrics;
+}
+
+//
+// Gets the pipeline the frames of a camera run through. Stages are
+// added while the camera does not stream, with the record stage of
+// GetPipelineStages as parent to see every frame as it was corrected.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The pipeline of the camera
+//
+FramePipeline& ApiController::GetPipeline( int cameraIndex )
+{
+    return cameraIndex < 2 ? m_Pipeline : m_Pipeline2;
+}
+
+//
+// Gets where the built-in stages of a camera pipeline were added
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The stage indices of the camera
+//
+const PipelineStageIndices& ApiController::GetPipelineStages( int cameraIndex ) const
+{
+    return cameraIndex < 2 ? m_StageIndices : m_StageIndices2;
+}
+
+//
+// Adds the built-in stages to the pipeline of a camera, each one with
+// the index its parent got
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The first error of FramePipeline::AddStage
+//
+VmbErrorType ApiController::BuildPipeline( int cameraIndex )
+{
+    const bool bFirst = cameraIndex < 2;
+    FramePipeline &rPipeline = bFirst ? m_Pipeline : m_Pipeline2;
+    PipelineStageIndices &rIndices = bFirst ? m_StageIndices : m_StageIndices2;
+    std::shared_ptr<DisplayStage> &rpDisplayStage = bFirst ? m_pDisplayStage : m_pDisplayStage2;
+    std::shared_ptr<ImageStatsStage> &rpStatsStage = bFirst ? m_pStatsStage : m_pStatsStage2;
+    std::shared_ptr<AutoExposureStage> &rpAutoExposureStage = bFirst ? m_pAutoExposureStage : m_pAutoExposureStage2;
+    std::shared_ptr<SharpnessStage> &rpSharpnessStage = bFirst ? m_pSharpnessStage : m_pSharpnessStage2;
+    std::shared_ptr<MotionStage> &rpMotionStage = bFirst ? m_pMotionStage : m_pMotionStage2;
+    std::shared_ptr<CorrectionStage> &rpCorrectionStage = bFirst ? m_pCorrectionStage : m_pCorrectionStage2;
+    std::shared_ptr<AverageStage> &rpAverageStage = bFirst ? m_pAverageStage : m_pAverageStage2;
+    std::shared_ptr<UndistortStage> &rpUndistortStage = bFirst ? m_pUndistortStage : m_pUndistortStage2;
+    std::shared_ptr<HdrBracketStage> &rpHdrBracketStage = bFirst ? m_pHdrBracketStage : m_pHdrBracketStage2;
+    std::shared_ptr<HdrMergeStage> &rpHdrMergeStage = bFirst ? m_pHdrMergeStage : m_pHdrMergeStage2;
+    std::shared_ptr<YuvStage> &rpYuvStage = bFirst ? m_pYuvStage : m_pYuvStage2;
+
+    // Every frame is corrected by the flat-field maps and its defective
+    // pixels are repaired. Exposure brackets are marked next, so the next
+    // exposure time is written as early as possible. The frame may then be
+    // averaged with the frames before it and undistorted, then it is
+    // recorded and handed to the view and to the statistics, which run on a
+    // thread of their own. Auto exposure follows the statistics on their
+    // thread. The sharpness is measured on another one, so focusing and
+    // exposure do not hold each other up. Motion gets a thread of its own,
+    // it has to keep up with every frame to gate the recording. Exposure
+    // brackets are merged on another thread from the corrected frames.
+    // Frames for video encoders are converted on one more.
+    const FramePipeline::StageOptions statsOptions( FramePipeline::ThreadingDedicated, FramePipeline::DropOldest, STATS_QUEUE_DEPTH );
+    const FramePipeline::StageOptions motionOptions( FramePipeline::ThreadingDedicated, FramePipeline::DropOldest, MOTION_QUEUE_DEPTH );
+    const FramePipeline::StageOptions hdrOptions( FramePipeline::ThreadingDedicated, FramePipeline::DropOldest, HDR_QUEUE_DEPTH );
+    const FramePipeline::StageOptions yuvOptions( FramePipeline::ThreadingDedicated, FramePipeline::DropOldest, YUV_QUEUE_DEPTH );
+    rpDisplayStage.reset( new DisplayStage( bFirst ? WM_FRAME_READY1 : WM_FRAME_READY2, bFirst ? m_pStreamMetrics : m_pStreamMetrics2 ) );
+    rpMotionStage.reset( new MotionStage( bFirst ? m_pStreamMetrics : m_pStreamMetrics2 ) );
+    rpCorrectionStage.reset( new CorrectionStage( &m_AnalysisPool ) );
+    rpAverageStage.reset( new AverageStage( &m_AnalysisPool, AVERAGE_MAX_LEASES ) );
+    rpUndistortStage.reset( new UndistortStage( &m_AnalysisPool ) );
+    rpHdrBracketStage.reset( new HdrBracketStage( bFirst ? &m_FeatureWriter : &m_FeatureWriter2 ) );
+    rpHdrMergeStage.reset( new HdrMergeStage( &m_AnalysisPool ) );
+    VmbErrorType res = rPipeline.AddStage( "correction", rpCorrectionStage, FramePipeline::StageOptions(), std::vector<size_t>(), rIndices.nCorrection );
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "bracket", rpHdrBracketStage, FramePipeline::StageOptions(), std::vector<size_t>( 1, rIndices.nCorrection ), rIndices.nBracket );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "average", rpAverageStage, FramePipeline::StageOptions(), std::vector<size_t>( 1, rIndices.nCorrection ), rIndices.nAverage );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "undistort", rpUndistortStage, FramePipeline::StageOptions(), std::vector<size_t>( 1, rIndices.nAverage ), rIndices.nUndistort );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "hdr", rpHdrMergeStage, hdrOptions, std::vector<size_t>( 1, rIndices.nBracket ), rIndices.nHdr );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage(   "record",
+                                    FrameStagePtr( new RecordStage( bFirst ? &m_Burst : &m_Burst2, bFirst ? &m_FrameBus : &m_FrameBus2, rpMotionStage.get() ) ),
+                                    FramePipeline::StageOptions(),
+                                    std::vector<size_t>( 1, rIndices.nUndistort ),
+                                    rIndices.nRecord );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "display", rpDisplayStage, FramePipeline::StageOptions(), std::vector<size_t>( 1, rIndices.nRecord ), rIndices.nDisplay );
+    }
+    rpStatsStage.reset( new ImageStatsStage( &m_AnalysisPool, bFirst ? m_pStreamMetrics : m_pStreamMetrics2 ) );
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "stats", rpStatsStage, statsOptions, std::vector<size_t>( 1, rIndices.nRecord ), rIndices.nStats );
+    }
+    rpAutoExposureStage.reset( new AutoExposureStage( bFirst ? &m_FeatureWriter : &m_FeatureWriter2 ) );
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "autoexposure", rpAutoExposureStage, FramePipeline::StageOptions(), std::vector<size_t>( 1, rIndices.nStats ), rIndices.nAutoExposure );
+    }
+    rpSharpnessStage.reset( new SharpnessStage( &m_AnalysisPool, bFirst ? m_pStreamMetrics : m_pStreamMetrics2 ) );
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "sharpness", rpSharpnessStage, statsOptions, std::vector<size_t>( 1, rIndices.nRecord ), rIndices.nSharpness );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "motion", rpMotionStage, motionOptions, std::vector<size_t>( 1, rIndices.nRecord ), rIndices.nMotion );
+    }
+    rpYuvStage.reset( new YuvStage( &m_AnalysisPool ) );
+    if( VmbErrorSuccess == res )
+    {
+        res = rPipeline.AddStage( "yuv", rpYuvStage, yuvOptions, std::vector<size_t>( 1, rIndices.nRecord ), rIndices.nYuv );
+    }
+    return res;
+}
+
+//
+// Gets the exposure statistics of the last analysed frame of a camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The statistics, empty before the first complete frame
+//
+std::shared_ptr<const ImageStatistics> ApiController::GetImageStatistics( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pStatsStage : m_pStatsStage2 )->GetLatest();
+}
+
+//
+// Makes the statistics of a camera look at fewer pixels
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nSubsampling    Every nth pixel of every nth row, 1 for all
+//
+void ApiController::SetStatisticsSubsampling( int cameraIndex, VmbUint32_t nSubsampling )
+{
+    ( cameraIndex < 2 ? m_pStatsStage : m_pStatsStage2 )->SetSubsampling( nSubsampling );
+}
+
+//
+// Gets the sharpness of the last frames of a camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [out]   rHistory        Oldest first
+//
+void ApiController::GetSharpnessHistory( int cameraIndex, std::vector<SharpnessMeasure> &rHistory ) const
+{
+    ( cameraIndex < 2 ? m_pSharpnessStage : m_pSharpnessStage2 )->GetHistory( rHistory );
+}
+
+//
+// Sets the region of the frames of a camera the sharpness is measured in.
+// The history starts over.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nLeft           The first column
+//  [in]    nTop            The first row
+//  [in]    nWidth          The width, 0 for the whole frame
+//  [in]    nHeight         The height, 0 for the whole frame
+//
+void ApiController::SetSharpnessRegion( int cameraIndex, VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight )
+{
+    ( cameraIndex < 2 ? m_pSharpnessStage : m_pSharpnessStage2 )->SetRegion( nLeft, nTop, nWidth, nHeight );
+}
+
+//
+// Lets the host steer exposure time and gain of a camera by the
+// statistics of its frames. The limits are the ranges of ExposureTimeAbs
+// and Gain, a camera without Gain is steered by exposure time alone.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to steer, false to keep the values written last
+//  [in]    settings        The target, the limits are taken from the camera
+//
+// Returns:
+//  An API status code, an error if ExposureTimeAbs cannot be read
+//
+VmbErrorType ApiController::SetAutoExposure( int cameraIndex, bool bEnable, const AutoExposureSettings &settings )
+{
+    AutoExposureStage &rStage = *( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 );
+    if( !bEnable )
+    {
+        rStage.Disable();
+        return VmbErrorSuccess;
+    }
+    // Both would write the exposure time
+    DisableHdr( cameraIndex );
+
+    FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+    AutoExposureSettings limited( settings );
+    double dExposureUs = 0.0;
+    FeaturePtr pFeature;
+    VmbErrorType res = rFeatures.GetFloatValue( "ExposureTimeAbs", dExposureUs );
+    if( VmbErrorSuccess == res )
+    {
+        res = rFeatures.GetFeature( "ExposureTimeAbs", pFeature );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetRange( limited.dMinExposureUs, limited.dMaxExposureUs );
+    }
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+
+    double dGainDb = 0.0;
+    if(     VmbErrorSuccess != rFeatures.GetFloatValue( "Gain", dGainDb )
+        ||  VmbErrorSuccess != rFeatures.GetFeature( "Gain", pFeature )
+        ||  VmbErrorSuccess != SP_ACCESS( pFeature )->GetRange( limited.dMinGainDb, limited.dMaxGainDb ) )
+    {
+        // Without gain the controller keeps it where it is
+        limited.dMinGainDb = limited.dMaxGainDb = dGainDb = 0.0;
+    }
+    rStage.Enable( limited, dExposureUs, dGainDb );
+    return VmbErrorSuccess;
+}
+
+bool ApiController::IsAutoExposureEnabled( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 )->IsEnabled();
+}
+
+bool ApiController::IsAutoExposureConverged( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 )->IsConverged();
+}
+
+double ApiController::GetAutoExposureTime( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 )->GetExposure();
+}
+
+//
+// Runs the auto exposure of a camera against the exposure model. The
+// brightness of the scene is taken from the last analysed frame.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [out]   rResult         How the controller did against the model
+//
+// Returns:
+//  VmbErrorInvalidCall while auto exposure is off or before the first
+//  analysed frame, VmbErrorBadParameter for a black frame
+//
+VmbErrorType ApiController::SimulateAutoExposure( int cameraIndex, ExposureSimulationResult &rResult ) const
+{
+    const AutoExposureStage &rStage = *( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 );
+    std::shared_ptr<const ImageStatistics> pStatistics = GetImageStatistics( cameraIndex );
+    if(     !rStage.IsEnabled()
+        ||  !pStatistics
+        ||  0 == pStatistics->nPixels )
+    {
+        return VmbErrorInvalidCall;
+    }
+    // Brightness follows exposure time times gain, the model scene gets the
+    // brightness per microsecond the camera saw
+    const VmbUint32_t c = 3 == pStatistics->nChannels ? 1 : 0;
+    const double dFullScale = static_cast<double>( ( 1u << pStatistics->nBitDepth ) - 1 );
+    const double dExposureUs = rStage.GetExposure();
+    const double dBrightness = dExposureUs * std::pow( 10.0, rStage.GetGain() / 20.0 );
+    const double dRadiance = pStatistics->dMean[c] / dFullScale / dBrightness;
+
+    ExposureSimulator simulator;
+    return simulator.Run( rStage.GetSettings(), dRadiance, dExposureUs, EXPOSURE_SIMULATION_FRAMES, rResult );
+}
+
+//
+// Cycles the exposure time of a camera over consecutive frames and
+// merges every bracket into one tone mapped image. Ends auto exposure.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    settings        The bracket, derived exposure times are kept
+//                          within the range of ExposureTimeAbs
+//
+// Returns:
+//  An API status code, an error if ExposureTimeAbs cannot be read,
+//  VmbErrorBadParameter for a bracket of more than HDR_MAX_FRAMES
+//
+VmbErrorType ApiController::EnableHdr( int cameraIndex, const HdrSettings &settings )
+{
+    FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+    double dExposureUs = 0.0;
+    double dMinUs = 0.0;
+    double dMaxUs = 0.0;
+    FeaturePtr pFeature;
+    VmbErrorType res = rFeatures.GetFloatValue( "ExposureTimeAbs", dExposureUs );
+    if( VmbErrorSuccess == res )
+    {
+        res = rFeatures.GetFeature( "ExposureTimeAbs", pFeature );
+    }
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetRange( dMinUs, dMaxUs );
+    }
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+
+    std::vector<double> exposuresUs( settings.exposuresUs );
+    if( exposuresUs.empty() )
+    {
+        // Centered on the current exposure time, one step apart
+        const VmbUint32_t nFrames = (std::min)( static_cast<VmbUint32_t>( HDR_MAX_FRAMES ), (std::max)( 2u, settings.nFrames ) );
+        for( VmbUint32_t i = 0; i < nFrames; ++i )
+        {
+            const double dUs = dExposureUs * std::pow( settings.dStep, i - ( nFrames - 1 ) / 2.0 );
+            exposuresUs.push_back( (std::min)( dMaxUs, (std::max)( dMinUs, dUs ) ) );
+        }
+    }
+    // Both would write the exposure time
+    ( cameraIndex < 2 ? m_pAutoExposureStage : m_pAutoExposureStage2 )->Disable();
+    HdrMergeStage &rMergeStage = *( cameraIndex < 2 ? m_pHdrMergeStage : m_pHdrMergeStage2 );
+    rMergeStage.SetKey( settings.dKey );
+    rMergeStage.Reset();
+    return ( cameraIndex < 2 ? m_pHdrBracketStage : m_pHdrBracketStage2 )->Enable( exposuresUs, settings.nWriteLatency, dExposureUs );
+}
+
+//
+// Stops the cycling, the camera returns to the exposure time from before
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void ApiController::DisableHdr( int cameraIndex )
+{
+    ( cameraIndex < 2 ? m_pHdrBracketStage : m_pHdrBracketStage2 )->Disable();
+    ( cameraIndex < 2 ? m_pHdrMergeStage : m_pHdrMergeStage2 )->ClearLatest();
+}
+
+bool ApiController::IsHdrEnabled( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pHdrBracketStage : m_pHdrBracketStage2 )->IsEnabled();
+}
+
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The last bracket merged, empty before the first
+//
+std::shared_ptr<const HdrImage> ApiController::GetHdrImage( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pHdrMergeStage : m_pHdrMergeStage2 )->GetLatest();
+}
+
+//
+// Converts the frames of a camera to NV12 or I420 for video encoders,
+// next to the frames for the view
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    bEnable         true to convert the frames
+//  [in]    settings        The layout, matrix and range to convert to
+//
+void ApiController::SetYuvOutput( int cameraIndex, bool bEnable, const YuvSettings &settings )
+{
+    YuvStage &rStage = *( cameraIndex < 2 ? m_pYuvStage : m_pYuvStage2 );
+    rStage.SetSettings( settings );
+    rStage.SetEnabled( bEnable );
+    if( !bEnable )
+    {
+        rStage.ClearLatest();
+    }
+}
+
+bool ApiController::IsYuvOutputEnabled( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pYuvStage : m_pYuvStage2 )->IsEnabled();
+}
+
+//
+// Hands every converted frame of a camera to a sink, e.g. a video
+// encoder. It is called on the thread of the conversion.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    sink            The sink, empty for none
+//
+void ApiController::SetYuvSink( int cameraIndex, const YuvSink &sink )
+{
+    ( cameraIndex < 2 ? m_pYuvStage : m_pYuvStage2 )->SetSink( sink );
+}
+
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+// Returns:
+//  The last frame converted, empty before the first
+//
+YuvImagePtr ApiController::GetYuvImage( int cameraIndex ) const
+{
+    return ( cameraIndex < 2 ? m_pYuvStage : m_pYuvStage2 )->GetLatest();
+}
+
+//
+// Writes a feature queued on the feature writer of a camera. Runs on the
+// thread of the writer, the feature cache and the session are locked.
+// An exposure time that made it to the camera lets the frames bracketed
+// with it count.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rStrName        The name of the feature
+//  [in]    rValue          The value to write
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType ApiController::WriteQueuedFeature( int cameraIndex, const std::string &rStrName, const FeatureWriter::Value &rValue )
+{
+    const VmbErrorType res = rValue.bIsFloat    ? SetCameraFloatFeature( cameraIndex, rStrName, static_cast<float>( rValue.dValue ) )
+                                                : SetCameraIntFeature( cameraIndex, rStrName, static_cast<int>( rValue.nValue ) );
+    if(     VmbErrorSuccess == res
+        &&  rValue.bIsFloat
+        &&  "ExposureTimeAbs" == rStrName )
+    {
+        ( cameraIndex < 2 ? m_pHdrBracketStage : m_pHdrBracketStage2 )->OnExposureWritten( rValue.dValue );
+    }
+    return res;
+}
+
+//
+// Looks for open cameras that were unplugged. Their streams are torn down
+// and their sessions are kept for RecoverCameras. Cameras that are still
+// there are not touched.
+//
+// Parameters:
+//  [out]   rLostCameras    The cameras (1 or 2) that were found missing
+//
+void ApiController::DetectLostCameras( std::vector<int> &rLostCameras )
+{
+    rLostCameras.clear();
+    if( CameraIsOpen1 && !IsCameraPresent( m_strCameraID ) )
+    {
+        TearDownLostCamera( 1 );
+        rLostCameras.push_back( 1 );
+    }
+    if( CameraIsOpen2 && !IsCameraPresent( m_strCameraID2 ) )
+    {
+        TearDownLostCamera( 2 );
+        rLostCameras.push_back( 2 );
+    }
+}
+
+//
+// Reopens cameras that came back after being unplugged, restores their
+// features and resumes streaming. A camera that is listed but cannot be
+// opened yet (e.g. still booting) is tried again on a later call.
+//
+// Parameters:
+//  [out]   rRecovered      One entry per camera an attempt was made for
+//
+void ApiController::RecoverCameras( std::vector<RecoveryResult> &rRecovered )
+{
+    rRecovered.clear();
+    for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+    {
+        CameraSession &rSession = ( cameraIndex < 2 ) ? m_Session : m_Session2;
+        const bool bIsOpen = ( cameraIndex < 2 ) ? CameraIsOpen1 : CameraIsOpen2;
+        if( !rSession.bLost )
+        {
+            continue;
+        }
+        if( bIsOpen )
+        {
+            // The slot was reused for another camera meanwhile
+            rSession.bLost = false;
+            continue;
+        }
+
+        const CameraSession::Clock::time_point now = CameraSession::Clock::now();
+        if( now < rSession.nextAttemptAt )
+        {
+            continue;
+        }
+        if( !IsCameraPresent( rSession.strCameraID ) )
+        {
+            // Not back yet, the replug time starts once it is listed again
+            rSession.replugAt = CameraSession::Clock::time_point();
+            continue;
+        }
+        if( CameraSession::Clock::time_point() == rSession.replugAt )
+        {
+            rSession.replugAt = now;
+        }
+
+        RecoveryResult result;
+        result.cameraIndex = cameraIndex;
+        result.strCameraID = rSession.strCameraID;
+        result.nAttempt = ++rSession.nAttempts;
+        result.eResult = ( cameraIndex < 2 ) ? OpenCloseCamera1( rSession.strCameraID ) : OpenCloseCamera2( rSession.strCameraID );
+        if( VmbErrorSuccess != result.eResult )
+        {
+            // Opened but not configured, close it and start over
+            if( cameraIndex < 2 && CameraIsOpen1 )
+            {
+                OpenCloseCamera1( rSession.strCameraID );
+            }
+            else if( cameraIndex >= 2 && CameraIsOpen2 )
+            {
+                OpenCloseCamera2( rSession.strCameraID );
+            }
+            rSession.nextAttemptAt = now + std::chrono::milliseconds( RECOVERY_RETRY_MS );
+            result.bResumed = false;
+            rRecovered.push_back( result );
+            continue;
+        }
+
+        FeatureCache &rFeatures = GetFeatureCache( cameraIndex );
+        VmbErrorType res = rSession.state.Restore( rFeatures );
+        // The restored ROI and pixel format decide the frame geometry
+        rFeatures.GetIntValue( "Width", cameraIndex < 2 ? m_nWidth : m_nWidth2 );
+        rFeatures.GetIntValue( "Height", cameraIndex < 2 ? m_nHeight : m_nHeight2 );
+        rFeatures.GetIntValue( "PixelFormat", cameraIndex < 2 ? m_nPixelFormat : m_nPixelFormat2 );
+        rFeatures.GetIntValue( "PayloadSize", cameraIndex < 2 ? m_nPayloadSize : m_nPayloadSize2 );
+
+        rSession.bLost = false;
+        result.bResumed = false;
+        if( rSession.bWasStreaming )
+        {
+            // Announces fresh buffers and queues them before streaming starts
+            rSession.bAwaitingFirstFrame = true;
+            rSession.bFirstFrameReported = false;
+            VmbErrorType resStart = ( cameraIndex < 2 ) ? StartContinuousImageAcquisition() : StartContinuousImageAcquisition2();
+            result.bResumed = ( VmbErrorSuccess == resStart );
+            if( VmbErrorSuccess == res )
+            {
+                res = resStart;
+            }
+        }
+        result.eResult = res;
+        rRecovered.push_back( result );
+    }
+}
+
+//
+// Checks whether cameras wait to be recovered
+//
+// Returns:
+//  true if at least one camera is lost
+//
+bool ApiController::IsRecoveryPending() const
+{
+    return m_Session.bLost || m_Session2.bLost;
+}
+
+//
+// Picks up the time a recovered camera took from replug to its first frame
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [out]   rdMilliseconds  The time from the replug to the first frame
+//
+// Returns:
+//  true once per recovery, after the first frame arrived
+//
+bool ApiController::TakeReplugToFirstFrame( int cameraIndex, double &rdMilliseconds )
+{
+    CameraSession &rSession = ( cameraIndex < 2 ) ? m_Session : m_Session2;
+    if(     rSession.bFirstFrameReported
+        ||  rSession.bAwaitingFirstFrame )
+    {
+        return false;
+    }
+    rSession.bFirstFrameReported = true;
+    rdMilliseconds = rSession.dReplugToFirstFrameMs;
+    return true;
+}
+
+//
+// Tears down the stream of an unplugged camera and keeps its session
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void ApiController::TearDownLostCamera( int cameraIndex )
+{
+    CameraSession &rSession = ( cameraIndex < 2 ) ? m_Session : m_Session2;
+    const bool bStreaming = ( cameraIndex < 2 ) ? CameraIsAcq1 : CameraIsAcq2;
+    rSession.strCameraID = ( cameraIndex < 2 ) ? m_strCameraID : m_strCameraID2;
+    rSession.bLost = true;
+    rSession.bWasStreaming = bStreaming;
+    rSession.bAwaitingFirstFrame = false;
+    rSession.nAttempts = 0;
+    rSession.lostAt = CameraSession::Clock::now();
+    rSession.replugAt = CameraSession::Clock::time_point();
+    rSession.nextAttemptAt = CameraSession::Clock::time_point();
+
+    // The camera is gone, errors on the way down do not matter. The frame
+    // bus stays open so external readers keep their mapping.
+    if( cameraIndex < 2 )
+    {
+        if( bStreaming )
+        {
+            StopContinuousImageAcquisition();
+            ClearFrameQueue();
+        }
+        m_pMotionStage->DisableTrigger();
+        m_Burst.Finish();
+        m_pAutoExposureStage->Disable();
+        DisableHdr( 1 );
+        m_FeatureWriter.Discard();
+        m_Features.Invalidate();
+        SP_ACCESS( m_pCamera )->Close();
+        CameraIsOpen1 = false;
+        CameraIsAcq1 = false;
+    }
+    else
+    {
+        if( bStreaming )
+        {
+            StopContinuousImageAcquisition2();
+            ClearFrameQueue2();
+        }
+        m_pMotionStage2->DisableTrigger();
+        m_Burst2.Finish();
+        m_pAutoExposureStage2->Disable();
+        DisableHdr( 2 );
+        m_FeatureWriter2.Discard();
+        m_Features2.Invalidate();
+        SP_ACCESS( m_pCamera2 )->Close();
+        CameraIsOpen2 = false;
+        CameraIsAcq2 = false;
+    }
+}
+
+//
+// Ends the replug measurement of a recovered camera with its first frame
+//
+// Parameters:
+//  [in]    rSession        The session of the camera
+//  [in]    pLease          The frame just picked up
+//
+void ApiController::NoteFirstFrame( CameraSession &rSession, const FrameLeasePtr &pLease )
+{
+    if(     rSession.bAwaitingFirstFrame
+        &&  pLease )
+    {
+        rSession.bAwaitingFirstFrame = false;
+        rSession.dReplugToFirstFrameMs = std::chrono::duration<double, std::milli>( CameraSession::Clock::now() - rSession.replugAt ).count();
+    }
+}
+
+//
+// Gets the executor that runs command features of all cameras
+//
+// Returns:
+//  The command executor, it also holds the command latency statistics
+//
+CommandExecutor& ApiController::GetCommandExecutor()
+{
+    return m_Commands;
+}
+
 //
 // Gets the version of the Vimba API
 //
@@ -47,12 +47,40 @@
 #include "CameraObserver.h"
 #include "FrameObserver2.h"
 #include "FrameObserver.h"
+#include "FramePipeline.h"
+#include "FrameStages.h"
+#include "ThreadPool.h"
+#include "BurstRecorder.h"
+#include "SharedFrameBus.h"
+#include "FeatureCache.h"
+#include "FeatureBenchmark.h"
+#include "ParallelCameraOpener.h"
+#include "CommandExecutor.h"
+#include "BandwidthPlanner.h"
+#include "LinkSimulator.h"
+#include "CameraSession.h"
+#include "FrameMetrics.h"
+#include "MetricsExporter.h"
+#include "FeatureWriter.h"
+#include "AutoExposure.h"
+#include "ExposureSimulator.h"
 
 
 namespace AVT {
 namespace VmbAPI {
 namespace Examples {
 
+// The outcome of one attempt to bring back an unplugged camera
+struct RecoveryResult
+{
+    int             cameraIndex;
+    std::string     strCameraID;
+    VmbErrorType    eResult;
+    VmbUint32_t     nAttempt;
+    // Streaming was resumed
+    bool            bResumed;
+};
+
 class ApiController
 {
   public:
@@ -99,6 +127,23 @@ class ApiController
 	VmbErrorType ApiController::OpenCloseCamera2(const std::string &rStrCameraID);
 	bool CameraIsOpen2;
 	bool CameraIsAcq2;
+
+    //
+    // Opens and configures several cameras at the same time. The first ID
+    // goes to camera 1, the second to camera 2, an empty ID leaves its camera
+    // as it is. A camera that fails to open does not keep the others from
+    // opening.
+    //
+    // Parameters:
+    //  [in]    rCameraIDs      The IDs of the cameras to open
+    //  [out]   rResults        The result and timing of every camera
+    //  [out]   rdWallTimeMs    The time it took to open all of them
+    //
+    // Returns:
+    //  VmbErrorSuccess if all cameras were opened, else the first error
+    //
+    VmbErrorType        OpenCameras( const std::vector<std::string> &rCameraIDs, std::vector<CameraOpenResult> &rResults, double &rdWallTimeMs );
+
     //
     // Calls the API convenience function to stop image acquisition
     // Closes the camera
@@ -144,21 +189,11 @@ class ApiController
     // Gets the oldest frame that has not been picked up yet
     //
     // Returns:
-    //  A frame shared pointer
+    //  The lease of the frame. Letting go of it queues the frame to be
+    //  filled by the API again.
     //
-    FramePtr            GetFrame();
-	FramePtr            GetFrame2();
-    //
-    // Queues a given frame to be filled by the API
-    //
-    // Parameters:
-    //  [in]    pFrame          The frame to queue
-    //
-    // Returns:
-    //  An API status code
-    //    
-    VmbErrorType        QueueFrame( FramePtr pFrame );
-	VmbErrorType        QueueFrame2( FramePtr pFrame );
+    FrameLeasePtr       GetFrame();
+	FrameLeasePtr       GetFrame2();
     //
     // Clears all remaining frames that have not been picked up
     //
@@ -183,10 +218,701 @@ class ApiController
     //
     string_type         GetVersion() const;
 
+    //
+    // Reserves the burst arena of an open camera. The burst starts with the
+    // next complete frame and ends after nFrames frames, nDurationMs
+    // milliseconds or when acquisition is stopped, whatever comes first.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nFrames         The number of frames to capture
+    //  [in]    nDurationMs     The maximum burst length, 0 for no limit
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        ArmBurst( int cameraIndex, VmbUint32_t nFrames, VmbUint32_t nDurationMs );
+
+    //
+    // Gets the burst recorder of a camera to end a burst or to query its progress
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The burst recorder
+    //
+    BurstRecorder&      GetBurstRecorder( int cameraIndex );
+
+    //
+    // Lets motion in front of an open camera trigger its burst. The burst
+    // is armed now and again whenever motion starts, it records while the
+    // motion goes on and is flushed when it stops.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to record on motion, false to record regardless
+    //  [in]    nFrames         The number of frames a burst captures at most
+    //  [in]    nDurationMs     The maximum burst length, 0 for no limit
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        SetMotionTrigger( int cameraIndex, bool bEnable, VmbUint32_t nFrames, VmbUint32_t nDurationMs );
+
+    //
+    // Takes the motion starts and stops of a camera since the last call
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [out]   rEvents         Oldest first
+    //
+    void                TakeMotionEvents( int cameraIndex, std::vector<MotionResult> &rEvents );
+
+    //
+    // Stacks the next frames of a camera for its flat-field calibration.
+    // Dark frames start a new calibration with the lens covered, flat
+    // frames follow with the camera looking at an even light.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    eType           What the camera looks at
+    //  [in]    nFrames         The number of frames to stack
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        CaptureCalibration( int cameraIndex, CalibrationFrameType eType, VmbUint32_t nFrames );
+
+    // Whether the frames of a calibration are still being stacked
+    bool                IsCalibrationCapturing( int cameraIndex ) const;
+
+    //
+    // Builds the maps of a camera from the frames stacked, corrects with
+    // them and stores them for the serial number of the camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  VmbErrorInvalidCall without flat frames, else an API status code
+    //
+    VmbErrorType        BuildCalibration( int cameraIndex );
+
+    //
+    // Switches the flat-field and dark-frame correction of a camera on or off
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to correct the frames
+    //
+    void                SetFlatFieldCorrection( int cameraIndex, bool bEnable );
+
+    // Whether a camera has maps to correct with
+    bool                HasCalibration( int cameraIndex ) const;
+
+    //
+    // Finds the defective pixels of a camera in the frames stacked for its
+    // calibration, repairs them and stores them for the camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [out]   rnCount         The number of defective pixels
+    //
+    // Returns:
+    //  VmbErrorInvalidCall if no frames were stacked, else an API status code
+    //
+    VmbErrorType        DetectDefectivePixels( int cameraIndex, size_t &rnCount );
+
+    //
+    // Switches the repair of defective pixels of a camera on or off
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to repair them
+    //
+    void                SetDefectCorrection( int cameraIndex, bool bEnable );
+
+    //
+    // Returns:
+    //  The number of defective pixels of a camera, 0 without a map
+    //
+    size_t              GetDefectCount( int cameraIndex ) const;
+
+    //
+    // Averages the last frames of a camera to reduce noise. Every frame
+    // is still delivered, as the mean of the window ending with it.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nFrames         The frames to average, 1 for none
+    //
+    // Returns:
+    //  VmbErrorBadParameter beyond AverageStage::MAX_WINDOW
+    //
+    VmbErrorType        SetAveraging( int cameraIndex, VmbUint32_t nFrames );
+
+    //
+    // Returns:
+    //  The number of frames a camera averages, 1 for none
+    //
+    VmbUint32_t         GetAveraging( int cameraIndex ) const;
+
+    //
+    // Undistorts the frames of an open camera taken through a lens. The
+    // lookup table is stored for the camera, a table stored for the same
+    // lens and frames is read instead of built again.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rLens           The intrinsics and distortion of the lens
+    //
+    // Returns:
+    //  VmbErrorWrongType for packed formats, else an API status code
+    //
+    VmbErrorType        SetLensModel( int cameraIndex, const LensModel &rLens );
+
+    //
+    // Remaps the frames of an open camera by any other mapping, e.g. to
+    // rectify them, and stores the table for the camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    mapping         Where a pixel of the remapped frame comes from
+    //
+    // Returns:
+    //  VmbErrorWrongType for packed formats, else an API status code
+    //
+    VmbErrorType        SetRemapping( int cameraIndex, const RemapTable::Mapping &mapping );
+
+    //
+    // Switches the remapping of the frames of a camera on or off
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to remap the frames
+    //
+    void                SetUndistortion( int cameraIndex, bool bEnable );
+
+    // Whether there is a table to remap the frames of a camera by
+    bool                HasRemapTable( int cameraIndex ) const;
+
+    //
+    // Switches publishing of complete frames to the shared frame bus on or
+    // off. Cameras opened later follow this setting.
+    //
+    // Parameters:
+    //  [in]    bEnable         true to publish frames
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        EnableFrameBus( bool bEnable );
+
+    //
+    // Gets the shared frame bus of a camera to query its readers
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The frame bus
+    //
+    SharedFrameBus&     GetFrameBus( int cameraIndex );
+
+    //
+    // Gets the feature handle cache of a camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The feature cache, empty while the camera is closed
+    //
+    FeatureCache&       GetFeatureCache( int cameraIndex );
+
+    //
+    // Compares feature writes per second with a name lookup per write and
+    // through a resolved handle, against a simulated node map
+    //
+    // Parameters:
+    //  [out]   rResult         The writes per second of both paths
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        BenchmarkFeatureWrites( FeatureBenchmarkResult &rResult ) const;
+
+    //
+    // Gets the feature writer of a camera. Writes queued there leave the
+    // calling thread at once, e.g. the UI while a slider is dragged.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The feature writer, pending writes are dropped when the camera closes
+    //
+    FeatureWriter&      GetFeatureWriter( int cameraIndex );
+
+    //
+    // Gets the executor that runs command features of all cameras
+    //
+    // Returns:
+    //  The command executor, it also holds the command latency statistics
+    //
+    CommandExecutor&    GetCommandExecutor();
+
+    //
+    // Looks for open cameras that were unplugged. Their streams are torn down
+    // and their sessions are kept for RecoverCameras. Cameras that are still
+    // there are not touched.
+    //
+    // Parameters:
+    //  [out]   rLostCameras    The cameras (1 or 2) that were found missing
+    //
+    void                DetectLostCameras( std::vector<int> &rLostCameras );
+
+    //
+    // Reopens cameras that came back after being unplugged, restores their
+    // features and resumes streaming. A camera that is listed but cannot be
+    // opened yet (e.g. still booting) is tried again on a later call.
+    //
+    // Parameters:
+    //  [out]   rRecovered      One entry per camera an attempt was made for
+    //
+    void                RecoverCameras( std::vector<RecoveryResult> &rRecovered );
+
+    //
+    // Checks whether cameras wait to be recovered
+    //
+    // Returns:
+    //  true if at least one camera is lost
+    //
+    bool                IsRecoveryPending() const;
+
+    //
+    // Picks up the time a recovered camera took from replug to its first frame
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [out]   rdMilliseconds  The time from the replug to the first frame
+    //
+    // Returns:
+    //  true once per recovery, after the first frame arrived
+    //
+    bool                TakeReplugToFirstFrame( int cameraIndex, double &rdMilliseconds );
+
+    //
+    // Applies the queued plug events to the camera registry
+    //
+    // Parameters:
+    //  [out]   rChanges        The cameras that showed up or went away
+    //
+    void                ApplyCameraListChanges( std::vector<CameraChange> &rChanges );
+
+    //
+    // Gets the registry of all connected cameras
+    //
+    // Returns:
+    //  The camera registry
+    //
+    CameraRegistry&     GetCameraRegistry();
+
+    //
+    // Gets the frame counters of a camera, e.g. to add the conversion time
+    // of the view
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The counters of the camera
+    //
+    StreamMetrics&      GetStreamMetrics( int cameraIndex );
+
+    //
+    // Gets the registry with the frame counters of all cameras
+    //
+    // Returns:
+    //  The metrics registry
+    //
+    const MetricsRegistry& GetMetricsRegistry() const;
+
+    //
+    // Gets the pipeline the frames of a camera run through. Stages are
+    // added while the camera does not stream, with the record stage of
+    // GetPipelineStages as parent to see every frame as it was corrected.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The pipeline of the camera
+    //
+    FramePipeline&      GetPipeline( int cameraIndex );
+
+    //
+    // Gets the exposure statistics of the last analysed frame of a camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The statistics, empty before the first complete frame
+    //
+    std::shared_ptr<const ImageStatistics> GetImageStatistics( int cameraIndex ) const;
+
+    //
+    // Makes the statistics of a camera look at fewer pixels
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nSubsampling    Every nth pixel of every nth row, 1 for all
+    //
+    void                SetStatisticsSubsampling( int cameraIndex, VmbUint32_t nSubsampling );
+
+    //
+    // Gets the sharpness of the last frames of a camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [out]   rHistory        Oldest first
+    //
+    void                GetSharpnessHistory( int cameraIndex, std::vector<SharpnessMeasure> &rHistory ) const;
+
+    //
+    // Sets the region of the frames of a camera the sharpness is measured in.
+    // The history starts over.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nLeft           The first column
+    //  [in]    nTop            The first row
+    //  [in]    nWidth          The width, 0 for the whole frame
+    //  [in]    nHeight         The height, 0 for the whole frame
+    //
+    void                SetSharpnessRegion( int cameraIndex, VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight );
+
+    //
+    // Lets the host steer exposure time and gain of a camera by the
+    // statistics of its frames. The limits are the ranges of ExposureTimeAbs
+    // and Gain, a camera without Gain is steered by exposure time alone.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to steer, false to keep the values written last
+    //  [in]    settings        The target, the limits are taken from the camera
+    //
+    // Returns:
+    //  An API status code, an error if ExposureTimeAbs cannot be read
+    //
+    VmbErrorType        SetAutoExposure( int cameraIndex, bool bEnable, const AutoExposureSettings &settings = AutoExposureSettings() );
+    bool                IsAutoExposureEnabled( int cameraIndex ) const;
+
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  true while auto exposure is on and the target is reached, or a limit
+    //  keeps it from being reached
+    //
+    bool                IsAutoExposureConverged( int cameraIndex ) const;
+
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The exposure time auto exposure wrote last
+    //
+    double              GetAutoExposureTime( int cameraIndex ) const;
+
+    //
+    // Runs the auto exposure of a camera against the exposure model. The
+    // brightness of the scene is taken from the last analysed frame.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [out]   rResult         How the controller did against the model
+    //
+    // Returns:
+    //  VmbErrorInvalidCall while auto exposure is off or before the first
+    //  analysed frame, VmbErrorBadParameter for a black frame
+    //
+    VmbErrorType        SimulateAutoExposure( int cameraIndex, ExposureSimulationResult &rResult ) const;
+
+    //
+    // Cycles the exposure time of a camera over consecutive frames and
+    // merges every bracket into one tone mapped image. Ends auto exposure.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    settings        The bracket, derived exposure times are kept
+    //                          within the range of ExposureTimeAbs
+    //
+    // Returns:
+    //  An API status code, an error if ExposureTimeAbs cannot be read,
+    //  VmbErrorBadParameter for a bracket of more than HDR_MAX_FRAMES
+    //
+    VmbErrorType        EnableHdr( int cameraIndex, const HdrSettings &settings = HdrSettings() );
+
+    //
+    // Stops the cycling, the camera returns to the exposure time from before
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void                DisableHdr( int cameraIndex );
+    bool                IsHdrEnabled( int cameraIndex ) const;
+
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The last bracket merged, empty before the first
+    //
+    std::shared_ptr<const HdrImage> GetHdrImage( int cameraIndex ) const;
+
+    //
+    // Converts the frames of a camera to NV12 or I420 for video encoders,
+    // next to the frames for the view
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bEnable         true to convert the frames
+    //  [in]    settings        The layout, matrix and range to convert to
+    //
+    void                SetYuvOutput( int cameraIndex, bool bEnable, const YuvSettings &settings = YuvSettings() );
+    bool                IsYuvOutputEnabled( int cameraIndex ) const;
+
+    //
+    // Hands every converted frame of a camera to a sink, e.g. a video
+    // encoder. It is called on the thread of the conversion.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    sink            The sink, empty for none
+    //
+    void                SetYuvSink( int cameraIndex, const YuvSink &sink );
+
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The last frame converted, empty before the first
+    //
+    YuvImagePtr         GetYuvImage( int cameraIndex ) const;
+
+    //
+    // Gets where the built-in stages of a camera pipeline were added
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The stage indices of the camera
+    //
+    const PipelineStageIndices& GetPipelineStages( int cameraIndex ) const;
+
+    //
+    // Assigns a camera to a link of the bandwidth planner. Without one, the
+    // cameras of one host interface share a link.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rStrLinkID      The link, described with GetBandwidthPlanner().SetLink,
+    //                          empty to go back to the interface of the camera
+    //
+    void                SetCameraLink( int cameraIndex, const std::string &rStrLinkID );
+
+    //
+    // Gets the bandwidth planner to describe the links between cameras and host
+    //
+    // Returns:
+    //  The bandwidth planner
+    //
+    BandwidthPlanner&   GetBandwidthPlanner();
+
+    //
+    // Gets the bandwidth plan applied last and what the link model predicted for it
+    //
+    // Parameters:
+    //  [out]   rAllocations    The allocation of every streaming camera
+    //  [out]   rSimulation     The simulated drops and resends, same order
+    //
+    void                GetBandwidthPlan( std::vector<StreamAllocation> &rAllocations, std::vector<LinkSimulationResult> &rSimulation ) const;
+
   private:
+    //
+    // Adds the built-in stages to the pipeline of a camera, each one with
+    // the index its parent got
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The first error of FramePipeline::AddStage
+    //
+    VmbErrorType        BuildPipeline( int cameraIndex );
+
+    //
+    // Configures a freshly opened camera: sets the maximum possible Ethernet
+    // packet size, selects the pixel format and reads back the image geometry
+    //
+    // Parameters:
+    //  [in]    rFeatures       The feature cache attached to the camera
+    //  [out]   rnWidth         The width of a frame
+    //  [out]   rnHeight        The height of a frame
+    //  [out]   rnPixelFormat   The selected pixel format
+    //  [out]   rnPayloadSize   The size of one frame in bytes
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        ConfigureCamera( FeatureCache &rFeatures, VmbInt64_t &rnWidth, VmbInt64_t &rnHeight, VmbInt64_t &rnPixelFormat, VmbInt64_t &rnPayloadSize );
+
+    //
+    // Gets the name files of an open camera are stored under, its serial
+    // number so they follow the camera, or its ID without one
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The name
+    //
+    std::string         GetSerialFileName( int cameraIndex ) const;
+
+    //
+    // Gets the file with the calibration maps of an open camera, named
+    // after its serial number so the maps follow the camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The path of the file
+    //
+    std::string         GetCalibrationPath( int cameraIndex ) const;
+
+    //
+    // Maps the stored calibration of a freshly opened camera and reads its
+    // defective pixels and its remap table, if there are any. A lens file
+    // of the camera builds the table anew unless the stored one matches it.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void                LoadCalibration( int cameraIndex );
+
+    //
+    // Gets the file with the defective pixels of an open camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The path of the file
+    //
+    std::string         GetDefectMapPath( int cameraIndex ) const;
+
+    //
+    // Gets the file with the remap table of an open camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The path of the file
+    //
+    std::string         GetRemapPath( int cameraIndex ) const;
+
+    //
+    // Gets the file with the lens of an open camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    // Returns:
+    //  The path of the file
+    //
+    std::string         GetLensPath( int cameraIndex ) const;
+
+    //
+    // Collects what a camera is going to send
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    bStarting       true if the camera is about to start streaming
+    //  [out]   rDemand         The stream demand of the camera
+    //
+    void                GetStreamDemand( int cameraIndex, bool bStarting, StreamDemand &rDemand );
+
+    //
+    // Plans the bandwidth of all streaming cameras, checks the plan against
+    // the link model and applies it
+    //
+    // Parameters:
+    //  [in]    nStartingCamera The camera about to start (1 or 2), 0 for none
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        RebalanceBandwidth( int nStartingCamera );
+
+    //
+    // Checks whether a camera is still connected
+    //
+    // Parameters:
+    //  [in]    rStrCameraID    The ID of the camera
+    //
+    // Returns:
+    //  true if the camera registry lists the camera
+    //
+    bool                IsCameraPresent( const std::string &rStrCameraID );
+
+    //
+    // Tears down the stream of an unplugged camera and keeps its session
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void                TearDownLostCamera( int cameraIndex );
+
+    //
+    // Ends the replug measurement of a recovered camera with its first frame
+    //
+    // Parameters:
+    //  [in]    rSession        The session of the camera
+    //  [in]    pLease          The frame just picked up
+    //
+    void                NoteFirstFrame( CameraSession &rSession, const FrameLeasePtr &pLease );
+
+    //
+    // Writes a feature queued on the feature writer of a camera. An
+    // exposure time that made it to the camera lets the frames bracketed
+    // with it count.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rStrName        The name of the feature
+    //  [in]    rValue          The value to write
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        WriteQueuedFeature( int cameraIndex, const std::string &rStrName, const FeatureWriter::Value &rValue );
+
     // A reference to our Vimba singleton
     VimbaSystem &m_system;
 
+    // All connected cameras, kept current by the camera observer
+    CameraRegistry m_Registry;
+
     // The currently streaming camera
     CameraPtr m_pCamera;
     CameraPtr m_pCamera2;
@@ -206,6 +932,87 @@ class ApiController
     // The current height
     VmbInt64_t m_nHeight;
 	VmbInt64_t m_nHeight2;
+
+    // The size of one frame in bytes
+    VmbInt64_t m_nPayloadSize;
+    VmbInt64_t m_nPayloadSize2;
+
+    // Every camera has its own burst arena
+    BurstRecorder m_Burst;
+    BurstRecorder m_Burst2;
+
+    // Resolved feature handles of every camera
+    FeatureCache m_Features;
+    FeatureCache m_Features2;
+
+    // The IDs of the open cameras, frame buses are named after them
+    std::string m_strCameraID;
+    std::string m_strCameraID2;
+
+    // Every camera publishes to its own frame bus if enabled
+    bool m_bFrameBusEnabled;
+    SharedFrameBus m_FrameBus;
+    SharedFrameBus m_FrameBus2;
+
+    // Waits for command features of all cameras on one thread
+    CommandExecutor m_Commands;
+
+    // Shares the links between the streaming cameras
+    BandwidthPlanner m_Bandwidth;
+    // Empty while the camera shares the link of its interface
+    std::string m_strLinkID;
+    std::string m_strLinkID2;
+    std::vector<StreamAllocation> m_BandwidthPlan;
+    std::vector<LinkSimulationResult> m_BandwidthSimulation;
+
+    // What every camera streamed with, to bring it back after a replug
+    CameraSession m_Session;
+    CameraSession m_Session2;
+
+    // Frame counters of every camera, written to a file for a scraper
+    MetricsRegistry m_Metrics;
+    StreamMetrics *m_pStreamMetrics;
+    StreamMetrics *m_pStreamMetrics2;
+    MetricsExporter m_MetricsExporter;
+
+    // Feature writes of every camera, off the thread that asks for them.
+    // Declared behind the features and sessions they write to.
+    FeatureWriter m_FeatureWriter;
+    FeatureWriter m_FeatureWriter2;
+
+    // Spreads the analysis of a frame over the cores
+    ThreadPool m_AnalysisPool;
+
+    // Every camera runs its frames through its own pipeline. The view
+    // picks them up from the display stage.
+    FramePipeline m_Pipeline;
+    FramePipeline m_Pipeline2;
+    PipelineStageIndices m_StageIndices;
+    PipelineStageIndices m_StageIndices2;
+    // A pipeline that could not be built keeps StartUp from succeeding
+    VmbErrorType m_ePipelineError;
+    std::shared_ptr<DisplayStage> m_pDisplayStage;
+    std::shared_ptr<DisplayStage> m_pDisplayStage2;
+    std::shared_ptr<ImageStatsStage> m_pStatsStage;
+    std::shared_ptr<ImageStatsStage> m_pStatsStage2;
+    std::shared_ptr<AutoExposureStage> m_pAutoExposureStage;
+    std::shared_ptr<AutoExposureStage> m_pAutoExposureStage2;
+    std::shared_ptr<SharpnessStage> m_pSharpnessStage;
+    std::shared_ptr<SharpnessStage> m_pSharpnessStage2;
+    std::shared_ptr<MotionStage> m_pMotionStage;
+    std::shared_ptr<MotionStage> m_pMotionStage2;
+    std::shared_ptr<CorrectionStage> m_pCorrectionStage;
+    std::shared_ptr<CorrectionStage> m_pCorrectionStage2;
+    std::shared_ptr<AverageStage> m_pAverageStage;
+    std::shared_ptr<AverageStage> m_pAverageStage2;
+    std::shared_ptr<UndistortStage> m_pUndistortStage;
+    std::shared_ptr<UndistortStage> m_pUndistortStage2;
+    std::shared_ptr<HdrBracketStage> m_pHdrBracketStage;
+    std::shared_ptr<HdrBracketStage> m_pHdrBracketStage2;
+    std::shared_ptr<HdrMergeStage> m_pHdrMergeStage;
+    std::shared_ptr<HdrMergeStage> m_pHdrMergeStage2;
+    std::shared_ptr<YuvStage> m_pYuvStage;
+    std::shared_ptr<YuvStage> m_pYuvStage2;
 };
 
 }}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,223 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AsyncLog.cpp
+
+  Description: A lock-free log ring any thread can write to. Repeated
+               messages are rate limited and summed up, a timer drains the
+               ring to a file, the debugger output and the dialog.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <cwchar>
+#include <iomanip>
+#include <sstream>
+#include <AsyncLog.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+static const struct
+{
+    const wchar_t  *pName;
+    // Messages shown per window, the rest is only counted
+    VmbUint32_t     nLimit;
+} s_LogCategories[LogCategoryCount] =
+{
+    { L"Messages",                              20 },
+    { L"Incomplete frames of camera #1",        3 },
+    { L"Incomplete frames of camera #2",        3 },
+    { L"Late frame notifications",              3 },
+    { L"Image conversion errors",               3 },
+    { L"Feature writes",                        10 },
+};
+
+// Length of one rate limit window
+static const std::chrono::milliseconds LOG_WINDOW( 1000 );
+
+AsyncLog::AsyncLog()
+    : m_Ring( LOG_RING_SIZE )
+    , m_nWritePosition( 0 )
+    , m_nReadPosition( 0 )
+    , m_nOverflows( 0 )
+    , m_Start( Clock::now() )
+{
+    for( size_t i = 0; i < m_Ring.size(); ++i )
+    {
+        m_Ring[i].nSequence.store( i, std::memory_order_relaxed );
+    }
+    for( int i = 0; i < LogCategoryCount; ++i )
+    {
+        m_Categories[i].nWritten.store( 0, std::memory_order_relaxed );
+        m_Categories[i].nSuppressed.store( 0, std::memory_order_relaxed );
+        m_Categories[i].windowStart = m_Start;
+    }
+}
+
+//
+// Appends all lines drained from now on to a file
+//
+// Parameters:
+//  [in]    rStrPath        The log file
+//
+// Returns:
+//  VmbErrorResources if the file cannot be opened
+//
+VmbErrorType AsyncLog::OpenFile( const std::string &rStrPath )
+{
+    m_File.open( rStrPath.c_str(), std::ios::out | std::ios::app );
+    return m_File.is_open() ? VmbErrorSuccess : VmbErrorResources;
+}
+
+//
+// Puts a message into the ring. Never blocks and never allocates, may be
+// called from any thread including the frame callbacks.
+//
+// Parameters:
+//  [in]    eCategory       The category the rate limit is kept for
+//  [in]    rStrMsg         The message, cut off at LOG_ENTRY_CHARS
+//
+// Returns:
+//  false if the message was held back by the rate limit or the ring is full
+//
+bool AsyncLog::Write( LogCategory eCategory, const std::wstring &rStrMsg )
+{
+    Category &rCategory = m_Categories[eCategory];
+    if( rCategory.nWritten.fetch_add( 1, std::memory_order_relaxed ) >= s_LogCategories[eCategory].nLimit )
+    {
+        rCategory.nSuppressed.fetch_add( 1, std::memory_order_relaxed );
+        return false;
+    }
+
+    // Claim a slot, the sequence tells whether the reader is done with it
+    size_t nPosition = m_nWritePosition.load( std::memory_order_relaxed );
+    Entry *pEntry = NULL;
+    for( ;; )
+    {
+        pEntry = &m_Ring[nPosition % LOG_RING_SIZE];
+        const size_t nSequence = pEntry->nSequence.load( std::memory_order_acquire );
+        const std::ptrdiff_t nDifference = static_cast<std::ptrdiff_t>( nSequence ) - static_cast<std::ptrdiff_t>( nPosition );
+        if( 0 == nDifference )
+        {
+            if( m_nWritePosition.compare_exchange_weak( nPosition, nPosition + 1, std::memory_order_relaxed ) )
+            {
+                break;
+            }
+        }
+        else if( nDifference < 0 )
+        {
+            // The reader is a whole ring behind
+            m_nOverflows.fetch_add( 1, std::memory_order_relaxed );
+            return false;
+        }
+        else
+        {
+            nPosition = m_nWritePosition.load( std::memory_order_relaxed );
+        }
+    }
+
+    pEntry->time = Clock::now();
+    const size_t nLength = (std::min)( rStrMsg.size(), static_cast<size_t>( LOG_ENTRY_CHARS - 1 ) );
+    wmemcpy( pEntry->text, rStrMsg.c_str(), nLength );
+    pEntry->text[nLength] = L'\0';
+    pEntry->nSequence.store( nPosition + 1, std::memory_order_release );
+    return true;
+}
+
+//
+// Takes all messages out of the ring, adds a summary for every category
+// that was held back and writes them to the file and the debugger
+// output. Must only be called by one thread, the dialog's timer.
+//
+// Parameters:
+//  [out]   rLines          The drained messages, oldest first
+//
+void AsyncLog::Drain( std::vector<std::wstring> &rLines )
+{
+    rLines.clear();
+    for( ;; )
+    {
+        Entry &rEntry = m_Ring[m_nReadPosition % LOG_RING_SIZE];
+        if( rEntry.nSequence.load( std::memory_order_acquire ) != m_nReadPosition + 1 )
+        {
+            // Empty or the writer has not finished yet
+            break;
+        }
+        Emit( rEntry.time, rEntry.text, rLines );
+        // Hand the slot back for the next round
+        rEntry.nSequence.store( m_nReadPosition + LOG_RING_SIZE, std::memory_order_release );
+        ++m_nReadPosition;
+    }
+
+    const Clock::time_point now = Clock::now();
+    for( int i = 0; i < LogCategoryCount; ++i )
+    {
+        Category &rCategory = m_Categories[i];
+        if( now - rCategory.windowStart < LOG_WINDOW )
+        {
+            continue;
+        }
+        // A new window, late writers of the old one are counted in the new one
+        const VmbUint32_t nWritten = rCategory.nWritten.exchange( 0, std::memory_order_relaxed );
+        const VmbUint32_t nSuppressed = rCategory.nSuppressed.exchange( 0, std::memory_order_relaxed );
+        if( 0 != nSuppressed )
+        {
+            std::wostringstream strMsg;
+            strMsg  << s_LogCategories[i].pName << L" x" << nWritten << L" in last "
+                    << std::fixed << std::setprecision( 1 ) << std::chrono::duration<double>( now - rCategory.windowStart ).count() << L"s"
+                    << L" (" << nSuppressed << L" not shown)";
+            Emit( now, strMsg.str(), rLines );
+        }
+        rCategory.windowStart = now;
+    }
+    const VmbUint32_t nOverflows = m_nOverflows.exchange( 0, std::memory_order_relaxed );
+    if( 0 != nOverflows )
+    {
+        std::wostringstream strMsg;
+        strMsg << L"Log ring full, " << nOverflows << L" messages lost";
+        Emit( now, strMsg.str(), rLines );
+    }
+
+    if( m_File.is_open() && !rLines.empty() )
+    {
+        m_File.flush();
+    }
+}
+
+void AsyncLog::Emit( Clock::time_point time, const std::wstring &rStrMsg, std::vector<std::wstring> &rLines )
+{
+    rLines.push_back( rStrMsg );
+
+    // File and debugger get the time since start up, the dialog shows the message only
+    std::wostringstream strLine;
+    strLine << L"[" << std::fixed << std::setprecision( 3 ) << std::setw( 10 )
+            << std::chrono::duration<double>( time - m_Start ).count() << L"] " << rStrMsg << L"\n";
+    const std::wstring strText = strLine.str();
+    OutputDebugStringW( strText.c_str() );
+    if( m_File.is_open() )
+    {
+        m_File << strText;
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
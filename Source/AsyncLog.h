@@ -0,0 +1,134 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AsyncLog.h
+
+  Description: A lock-free log ring any thread can write to. Repeated
+               messages are rate limited and summed up, a timer drains the
+               ring to a file, the debugger output and the dialog.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_ASYNCLOG
+#define AVT_VMBAPI_EXAMPLES_ASYNCLOG
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Messages of one category share a rate limit and are summed up together
+enum LogCategory
+{
+    LogGeneral,
+    LogIncompleteFrame1,
+    LogIncompleteFrame2,
+    LogLateFrame,
+    LogConversion,
+    LogFeatureWrite,
+    LogCategoryCount,
+};
+
+class AsyncLog
+{
+  public:
+    AsyncLog();
+
+    //
+    // Appends all lines drained from now on to a file
+    //
+    // Parameters:
+    //  [in]    rStrPath        The log file
+    //
+    // Returns:
+    //  VmbErrorResources if the file cannot be opened
+    //
+    VmbErrorType    OpenFile( const std::string &rStrPath );
+
+    //
+    // Puts a message into the ring. Never blocks and never allocates, may be
+    // called from any thread including the frame callbacks.
+    //
+    // Parameters:
+    //  [in]    eCategory       The category the rate limit is kept for
+    //  [in]    rStrMsg         The message, cut off at LOG_ENTRY_CHARS
+    //
+    // Returns:
+    //  false if the message was held back by the rate limit or the ring is full
+    //
+    bool            Write( LogCategory eCategory, const std::wstring &rStrMsg );
+
+    //
+    // Takes all messages out of the ring, adds a summary for every category
+    // that was held back and writes them to the file and the debugger
+    // output. Must only be called by one thread, the dialog's timer.
+    //
+    // Parameters:
+    //  [out]   rLines          The drained messages, oldest first
+    //
+    void            Drain( std::vector<std::wstring> &rLines );
+
+  private:
+    enum { LOG_ENTRY_CHARS = 256, };
+    enum { LOG_RING_SIZE = 1024, };
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        // Equal to the write position once the entry may be read
+        std::atomic<size_t>     nSequence;
+        Clock::time_point       time;
+        wchar_t                 text[LOG_ENTRY_CHARS];
+    };
+
+    struct Category
+    {
+        std::atomic<VmbUint32_t>    nWritten;
+        std::atomic<VmbUint32_t>    nSuppressed;
+        Clock::time_point           windowStart;
+    };
+
+    // No copies, the ring is shared by all writers
+    AsyncLog( const AsyncLog& );
+    AsyncLog& operator=( const AsyncLog& );
+
+    void            Emit( Clock::time_point time, const std::wstring &rStrMsg, std::vector<std::wstring> &rLines );
+
+    std::vector<Entry>          m_Ring;
+    std::atomic<size_t>         m_nWritePosition;
+    // Only touched by Drain
+    size_t                      m_nReadPosition;
+    std::atomic<VmbUint32_t>    m_nOverflows;
+    Category                    m_Categories[LogCategoryCount];
+    Clock::time_point           m_Start;
+    std::wofstream              m_File;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -33,16 +33,65 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <chrono>
 #define NUM_COLORS 3
 #define BIT_DEPTH 8
+// A burst ends after this many frames or milliseconds, whatever comes first
+#define BURST_FRAMES 200
+#define BURST_DURATION_MS 2000
+// Frames averaged into the dark and into the flat-field calibration
+#define CALIBRATION_FRAMES 32
+// Periodic refresh of status texts
+#define STATUS_TIMER_ID 1
+#define STATUS_TIMER_MS 250
+// The log list box drops its oldest lines beyond this
+#define MAX_LOG_LINES 500
+// Refresh cap of the picture boxes, lowered to the refresh rate of the monitor
+#define DISPLAY_MAX_FPS 30
+// The overview shows every camera and a zoomed region of it below
+#define MOSAIC_TILES 4
+// Side of the region a click in a picture box zooms in on
+#define ZOOM_ROI_SIZE 48
+// A dragged slider or a typed number reaches the camera once it rests this long
+#define SLIDER_DEBOUNCE_MS 30
+#define EDIT_DEBOUNCE_MS 500
+// The packet sizes the edit boxes accept, in bytes
+#define PACKET_SIZE_MIN 500
+#define PACKET_SIZE_MAX 9973
 
 using AVT::VmbAPI::FramePtr;
 using AVT::VmbAPI::CameraPtrVector;
+using AVT::VmbAPI::Examples::BurstRecorder;
+using AVT::VmbAPI::Examples::CameraOpenResult;
+using AVT::VmbAPI::Examples::CommandExecutor;
+using AVT::VmbAPI::Examples::StreamAllocation;
+using AVT::VmbAPI::Examples::LinkSimulationResult;
+using AVT::VmbAPI::Examples::RecoveryResult;
+using AVT::VmbAPI::Examples::LogGeneral;
+using AVT::VmbAPI::Examples::LogIncompleteFrame1;
+using AVT::VmbAPI::Examples::LogIncompleteFrame2;
+using AVT::VmbAPI::Examples::LogLateFrame;
+using AVT::VmbAPI::Examples::LogConversion;
+using AVT::VmbAPI::Examples::MosaicRect;
+using AVT::VmbAPI::Examples::FrameLeasePtr;
+using AVT::VmbAPI::Examples::FramePipeline;
+using AVT::VmbAPI::Examples::ImageStatistics;
+using AVT::VmbAPI::Examples::ExposureSimulationResult;
+using AVT::VmbAPI::Examples::LogFeatureWrite;
+using AVT::VmbAPI::Examples::MotionEventStarted;
+using AVT::VmbAPI::Examples::CalibrationDark;
+using AVT::VmbAPI::Examples::CalibrationFlat;
 // Ctor
 CAsynchronousGrabDlg::CAsynchronousGrabDlg( CWnd* pParent )
     : CDialog( CAsynchronousGrabDlg::IDD, pParent )   
 	, packetSize1(1500)
 	, packetSize2(1500)
+	, m_Mosaic( m_ProcessingPool )
+	, m_bMosaicEnabled( false )
+	, m_bAutoExposureConverged( false )
+	, m_bAutoExposureConverged2( false )
+	, m_bCalibrationPending( false )
+	, m_bCalibrationPending2( false )
 {
     m_hIcon = AfxGetApp()->LoadIcon( IDR_MAINFRAME );
 }
@@ -67,6 +116,22 @@ BEGIN_MESSAGE_MAP( CAsynchronousGrabDlg, CDialog )
 	ON_BN_CLICKED(IDC_BT_OPENCAM1, &CAsynchronousGrabDlg::OnBnClickedBtOpencam1)
 	ON_BN_CLICKED(IDC_BT_OPENCAM2, &CAsynchronousGrabDlg::OnBnClickedBtOpencam2)
 	ON_EN_CHANGE(IDC_EDIT2, &CAsynchronousGrabDlg::OnEnChangeEdit2)
+	ON_WM_TIMER()
+	ON_BN_CLICKED(IDC_CHECK_FRAMEBUS, &CAsynchronousGrabDlg::OnBnClickedCheckFramebus)
+	ON_BN_CLICKED(IDC_BT_OPENALL, &CAsynchronousGrabDlg::OnBnClickedBtOpenall)
+	ON_BN_CLICKED(IDC_CHECK_MOSAIC, &CAsynchronousGrabDlg::OnBnClickedCheckMosaic)
+	ON_BN_CLICKED(IDC_CHECK_AUTOEXPOSURE1, &CAsynchronousGrabDlg::OnBnClickedCheckAutoexposure1)
+	ON_BN_CLICKED(IDC_CHECK_AUTOEXPOSURE2, &CAsynchronousGrabDlg::OnBnClickedCheckAutoexposure2)
+	ON_BN_CLICKED(IDC_CHECK_MOTION1, &CAsynchronousGrabDlg::OnBnClickedCheckMotion1)
+	ON_BN_CLICKED(IDC_CHECK_MOTION2, &CAsynchronousGrabDlg::OnBnClickedCheckMotion2)
+	ON_BN_CLICKED(IDC_BT_CAPTURE_DARK, &CAsynchronousGrabDlg::OnBnClickedBtCaptureDark)
+	ON_BN_CLICKED(IDC_BT_CAPTURE_FLAT, &CAsynchronousGrabDlg::OnBnClickedBtCaptureFlat)
+	ON_BN_CLICKED(IDC_CHECK_FLATFIELD, &CAsynchronousGrabDlg::OnBnClickedCheckFlatfield)
+	ON_BN_CLICKED(IDC_CHECK_DEFECTS, &CAsynchronousGrabDlg::OnBnClickedCheckDefects)
+	ON_EN_CHANGE(IDC_EDIT_AVERAGE, &CAsynchronousGrabDlg::OnEnChangeEditAverage)
+	ON_BN_CLICKED(IDC_CHECK_HDR, &CAsynchronousGrabDlg::OnBnClickedCheckHdr)
+	ON_BN_CLICKED(IDC_CHECK_UNDISTORT, &CAsynchronousGrabDlg::OnBnClickedCheckUndistort)
+	ON_WM_LBUTTONDOWN()
 END_MESSAGE_MAP()
 
 BOOL CAsynchronousGrabDlg::OnInitDialog()
@@ -92,6 +157,32 @@ BOOL CAsynchronousGrabDlg::OnInitDialog()
 	m_Slider2.EnableWindow(false);
 	m_packageEidt2.EnableWindow(false);
 
+	// Frames are passed as they are until a window is entered
+	SetDlgItemInt( IDC_EDIT_AVERAGE, 1, FALSE );
+
+    // Never refresh faster than the monitor does
+    double dMaxFps = DISPLAY_MAX_FPS;
+    {
+        CClientDC dc( this );
+        const int nRefreshRate = dc.GetDeviceCaps( VREFRESH );
+        // 0 and 1 stand for the default refresh rate of the hardware
+        if( nRefreshRate > 1 && nRefreshRate < dMaxFps )
+        {
+            dMaxFps = nRefreshRate;
+        }
+    }
+    m_Display.SetMaxRate( dMaxFps );
+    m_Display2.SetMaxRate( dMaxFps );
+
+    // Two cameras above their zoomed regions, filling the third picture box
+    CRect mosaicRect;
+    m_PictureBoxMosaic.GetClientRect( &mosaicRect );
+    m_Mosaic.Resize( mosaicRect.Width(), mosaicRect.Height() );
+    m_Mosaic.SetLayout( MOSAIC_TILES, 0 );
+
+    // A missing log file leaves the list box and the debugger output
+    m_Log.OpenFile( "AsynchronousGrab.log" );
+
     // Start Vimba
     VmbErrorType err = m_ApiController.StartUp();
     string_type DialogTitle( _TEXT( "AsynchronousGrab (MFC version) Vimba V" ) );
@@ -102,10 +193,29 @@ BOOL CAsynchronousGrabDlg::OnInitDialog()
         // Initially get all connected cameras
         UpdateCameraListBox();
         string_stream_type strMsg;
-        strMsg << "Cameras found..." << m_cameras.size();
+        strMsg << "Cameras found..." << m_ApiController.GetCameraRegistry().GetCount();
         Log( strMsg.str() );
     }
 
+    FeatureBenchmarkResult benchmark;
+    err = m_ApiController.BenchmarkFeatureWrites( benchmark );
+    string_stream_type strBenchmark;
+    strBenchmark    << "Feature writes/s, simulated: " << static_cast<VmbUint64_t>( benchmark.dLookupWritesPerSecond ) << " by name, "
+                    << static_cast<VmbUint64_t>( benchmark.dHandleWritesPerSecond ) << " by handle";
+    Log( strBenchmark.str(), err );
+
+    // Feature writes are done in the background, their results come back here
+    for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+    {
+        m_ApiController.GetFeatureWriter( cameraIndex ).SetCompletionCallback(
+            [this, cameraIndex]( const std::string &rStrName, const FeatureWriter::Value &rValue, VmbErrorType eResult, double dLatencyMs )
+            {
+                ReportFeatureWrite( cameraIndex, rStrName, rValue, eResult, dLatencyMs );
+            } );
+    }
+
+    SetTimer( STATUS_TIMER_ID, STATUS_TIMER_MS, NULL );
+
     return TRUE;
 }
 
@@ -121,6 +231,8 @@ void CAsynchronousGrabDlg::OnSysCommand( UINT nID, LPARAM lParam )
 
         // Before we close the application we stop Vimba SDK library
         m_ApiController.ShutDown();
+        // The file gets the messages of the shut down as well
+        DrainLog();
     }
 
     CDialog::OnSysCommand( nID, lParam );
@@ -145,12 +257,17 @@ void CAsynchronousGrabDlg::OnBnClickedButtonStartstop()
             m_ClearBackground = true;
         }
         Log( _TEXT( "Camera 1 Starting Acquisition" ), err );
+        if( VmbErrorSuccess == err )
+        {
+            ArmBurstOnStart( 1 );
+        }
              
     }
     else
     {
        
         // Stop acquisition
+        FinishBurstOnStop( 1 );
         err = m_ApiController.StopContinuousImageAcquisition();
         m_ApiController.ClearFrameQueue();
         if( NULL != m_Image )
@@ -158,7 +275,9 @@ void CAsynchronousGrabDlg::OnBnClickedButtonStartstop()
             m_Image.Destroy();
         }
         Log( _TEXT( "Camera 1 Stopping Acquisition" ), err );
+        LogPipelineStatistics( 1 );
     }
+    LogBandwidthPlan();
 
    UpdateContronls();
 }
@@ -182,12 +301,17 @@ void CAsynchronousGrabDlg::OnBnClickedButtonStartstop2()
             m_ClearBackground2 = true;
         }
         Log( _TEXT( "Camera 2 Starting Acquisition" ), err );
+        if( VmbErrorSuccess == err )
+        {
+            ArmBurstOnStart( 2 );
+        }
         
       }
        
     else
     {      
         // Stop acquisition
+        FinishBurstOnStop( 2 );
         err = m_ApiController.StopContinuousImageAcquisition2();
         m_ApiController.ClearFrameQueue2();
         if( NULL != m_Image2 )
@@ -195,7 +319,9 @@ void CAsynchronousGrabDlg::OnBnClickedButtonStartstop2()
             m_Image2.Destroy();
         }
         Log( _TEXT( "Camera 2 Stopping Acquisition" ), err );
+        LogPipelineStatistics( 2 );
     }
+    LogBandwidthPlan();
 
 	UpdateContronls();
    
@@ -216,19 +342,39 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady( WPARAM status, LPARAM lParam )
     if( true == m_ApiController.CameraIsAcq1 )
     {
         // Pick up frame for camera #1
-        FramePtr pFrame = m_ApiController.GetFrame();
-        if( SP_ISNULL( pFrame) )
+        FrameLeasePtr pLease = m_ApiController.GetFrame();
+        if( !pLease )
         {
-            Log( _TEXT("frame ptr is NULL, late call") );
+            m_Log.Write( LogLateFrame, _TEXT( "frame lease is NULL, late call" ) );
             return 0;
         }
+        FramePtr pFrame = pLease->GetFrame();
         // See if it is not corrupt
         if( VmbFrameStatusComplete == status )
         {
             VmbUchar_t *pBuffer;
             VmbUchar_t *pColorBuffer = NULL;
             VmbErrorType err = pFrame->GetImage( pBuffer );
-            if (VmbErrorSuccess == err)
+            // Stages such as the correction replace the image of the lease
+            const VmbUchar_t *pImage = pBuffer;
+            ImageView view;
+            if( VmbErrorSuccess == pLease->GetImage( view ) )
+            {
+                pImage = view.pBuffer;
+            }
+            // While bracketing the view shows the last merged bracket
+            std::shared_ptr<const HdrImage> pHdr;
+            if( m_ApiController.IsHdrEnabled( 1 ) )
+            {
+                pHdr = m_ApiController.GetHdrImage( 1 );
+            }
+            if( pHdr )
+            {
+                pImage = pHdr->view.pBuffer;
+            }
+            // Frames the screen would never show are not converted at all
+            if(     VmbErrorSuccess == err
+                &&  m_Display.ShouldShow( 0 != m_ApiController.GetStreamMetrics( 1 ).nQueueDepth.load( std::memory_order_relaxed ) ) )
             {
                 // show frame number
                 VmbUint64_t nFrameID1;
@@ -246,12 +392,26 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady( WPARAM status, LPARAM lParam )
                 if (VmbErrorSuccess == err)
                 {
                     VmbPixelFormatType ePixelFormat = m_ApiController.GetPixelFormat();
-                    CopyToImage(pBuffer, ePixelFormat, m_Image);
-                    // Display it
-                    RECT rect;
-                    m_PictureBoxStream.GetWindowRect(&rect);
-                    ScreenToClient(&rect);
-                    InvalidateRect(&rect, false);
+                    if( pHdr )
+                    {
+                        ePixelFormat = pHdr->view.ePixelFormat;
+                    }
+                    const std::chrono::steady_clock::time_point convertStart = std::chrono::steady_clock::now();
+                    if( m_bMosaicEnabled )
+                    {
+                        ShowInMosaic( 1, pImage, ePixelFormat );
+                    }
+                    else
+                    {
+                        CopyToImage(pImage, ePixelFormat, m_Image);
+                        // Display it
+                        RECT rect;
+                        m_PictureBoxStream.GetWindowRect(&rect);
+                        ScreenToClient(&rect);
+                        InvalidateRect(&rect, false);
+                    }
+                    m_ApiController.GetStreamMetrics( 1 ).OnConversion(
+                        std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - convertStart ).count() );
                 }
 
 
@@ -260,11 +420,11 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady( WPARAM status, LPARAM lParam )
         else
         {
             // If we receive an incomplete image we do nothing but logging
-            Log( _TEXT( "Failure in receiving image of camera #1:" ), VmbErrorOther );
+            Log( LogIncompleteFrame1, _TEXT( "Failure in receiving image of camera #1:" ), VmbErrorOther );
         }
 
-        // And queue it to continue streaming
-        m_ApiController.QueueFrame( pFrame );
+        // Letting go of the lease queues the frame to continue streaming
+        pLease.reset();
     }
 
     return 0;
@@ -275,19 +435,39 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady2( WPARAM status, LPARAM lParam )
     if( true == m_ApiController.CameraIsAcq2 )
     {
         // Pick up frame for camera #2
-        FramePtr pFrame = m_ApiController.GetFrame2();
-        if( SP_ISNULL( pFrame) )
+        FrameLeasePtr pLease = m_ApiController.GetFrame2();
+        if( !pLease )
         {
-            Log( _TEXT("frame ptr is NULL, late call") );
+            m_Log.Write( LogLateFrame, _TEXT( "frame lease is NULL, late call" ) );
             return 0;
         }
+        FramePtr pFrame = pLease->GetFrame();
         // See if it is not corrupt
         if( VmbFrameStatusComplete == status )
         {
             VmbUchar_t *pBuffer;
             VmbUchar_t *pColorBuffer = NULL;
             VmbErrorType err = pFrame->GetImage( pBuffer );
-            if( VmbErrorSuccess == err )
+            // Stages such as the correction replace the image of the lease
+            const VmbUchar_t *pImage = pBuffer;
+            ImageView view;
+            if( VmbErrorSuccess == pLease->GetImage( view ) )
+            {
+                pImage = view.pBuffer;
+            }
+            // While bracketing the view shows the last merged bracket
+            std::shared_ptr<const HdrImage> pHdr;
+            if( m_ApiController.IsHdrEnabled( 2 ) )
+            {
+                pHdr = m_ApiController.GetHdrImage( 2 );
+            }
+            if( pHdr )
+            {
+                pImage = pHdr->view.pBuffer;
+            }
+            // Frames the screen would never show are not converted at all
+            if(     VmbErrorSuccess == err
+                &&  m_Display2.ShouldShow( 0 != m_ApiController.GetStreamMetrics( 2 ).nQueueDepth.load( std::memory_order_relaxed ) ) )
             {
                 // show frame number
                 VmbUint64_t nFrameID2;
@@ -305,23 +485,37 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady2( WPARAM status, LPARAM lParam )
                 if( VmbErrorSuccess == err )
                 {
                     VmbPixelFormatType ePixelFormat = m_ApiController.GetPixelFormat2();
-                    CopyToImage2( pBuffer,ePixelFormat, m_Image2 );
-                    // Display it
-                    RECT rect;
-                    m_PictureBoxStream2.GetWindowRect( &rect );
-                    ScreenToClient( &rect );
-                    InvalidateRect( &rect, false );
+                    if( pHdr )
+                    {
+                        ePixelFormat = pHdr->view.ePixelFormat;
+                    }
+                    const std::chrono::steady_clock::time_point convertStart = std::chrono::steady_clock::now();
+                    if( m_bMosaicEnabled )
+                    {
+                        ShowInMosaic( 2, pImage, ePixelFormat );
+                    }
+                    else
+                    {
+                        CopyToImage2( pImage,ePixelFormat, m_Image2 );
+                        // Display it
+                        RECT rect;
+                        m_PictureBoxStream2.GetWindowRect( &rect );
+                        ScreenToClient( &rect );
+                        InvalidateRect( &rect, false );
+                    }
+                    m_ApiController.GetStreamMetrics( 2 ).OnConversion(
+                        std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - convertStart ).count() );
                 }
             }
         }
         else
         {
             // If we receive an incomplete image we do nothing but logging
-            Log( _TEXT( "Failure in receiving image of camera #2:" ), VmbErrorOther );
+            Log( LogIncompleteFrame2, _TEXT( "Failure in receiving image of camera #2:" ), VmbErrorOther );
         }
 
-        // And queue it to continue streaming
-        m_ApiController.QueueFrame2( pFrame );
+        // Letting go of the lease queues the frame to continue streaming
+        pLease.reset();
     }
 
     return 0;
@@ -339,18 +533,35 @@ LRESULT CAsynchronousGrabDlg::OnFrameReady2( WPARAM status, LPARAM lParam )
 LRESULT CAsynchronousGrabDlg::OnCameraListChanged( WPARAM reason, LPARAM lParam )
 {
     bool bUpdateList = false;
+    // Every event posts a message, the first one applies all queued changes
+    std::vector<CameraChange> changes;
+    m_ApiController.ApplyCameraListChanges( changes );
 
     // We only react on new cameras being found and known cameras being unplugged
     if( AVT::VmbAPI::UpdateTriggerPluggedIn == reason )
     {
         Log( _TEXT( "Camera list changed. A new camera was discovered by Vimba." ) );
         bUpdateList = true;
+        // It may be one of ours coming back
+        RecoverCameras();
     }
     else if( AVT::VmbAPI::UpdateTriggerPluggedOut == reason )
     {
         Log( _TEXT( "Camera list changed. A camera was disconnected from Vimba." ) );
         
         bUpdateList = true;
+        std::vector<int> lostCameras;
+        m_ApiController.DetectLostCameras( lostCameras );
+        for( size_t i = 0; i < lostCameras.size(); ++i )
+        {
+            string_stream_type strMsg;
+            strMsg << "Camera " << lostCameras[i] << " was unplugged, it is reopened once it is back";
+            Log( strMsg.str() );
+        }
+        if( !lostCameras.empty() )
+        {
+            UpdateContronls();
+        }
     }
     // Avoid stopping streaming cameras
     /*
@@ -366,7 +577,7 @@ LRESULT CAsynchronousGrabDlg::OnCameraListChanged( WPARAM reason, LPARAM lParam
 
     if( true == bUpdateList )
     {
-        UpdateCameraListBox();
+        UpdateCameraListBox( changes );
     }
 
    // m_btOpencam1.EnableWindow( 0 < m_cameras.size());
@@ -378,11 +589,11 @@ LRESULT CAsynchronousGrabDlg::OnCameraListChanged( WPARAM reason, LPARAM lParam
 // Copies the content of a byte buffer to a MFC image with respect to the image's alignment
 //
 // Parameters:
-//  [in]    pInbuffer       The byte buffer as received from the cam
+//  [in]    pInbuffer       The image of the frame, as the pipeline stages left it
 //  [in]    ePixelFormat    The pixel format of the frame
 //  [out]   OutImage        The filled MFC image
 //
-void CAsynchronousGrabDlg::CopyToImage2( VmbUchar_t *pInBuffer, VmbPixelFormat_t ePixelFormat, CImage &OutImage )
+void CAsynchronousGrabDlg::CopyToImage2( const VmbUchar_t *pInBuffer, VmbPixelFormat_t ePixelFormat, CImage &OutImage )
 {
     const int               nHeight         = m_ApiController.GetHeight2();
     const int               nWidth          = m_ApiController.GetWidth2();
@@ -391,20 +602,21 @@ void CAsynchronousGrabDlg::CopyToImage2( VmbUchar_t *pInBuffer, VmbPixelFormat_t
     VmbError_t              Result;
     if( ( nWidth*nBitsPerPixel ) /8 != nStride )
     {
-        Log( _TEXT( "Vimba only supports stride that is equal to width." ), VmbErrorWrongType );
+        Log( LogConversion, _TEXT( "Vimba only supports stride that is equal to width." ), VmbErrorWrongType );
         return;
     }
     VmbImage                SourceImage,DestinationImage;
     SourceImage.Size        = sizeof( SourceImage );
     DestinationImage.Size   = sizeof( DestinationImage );
 
-    SourceImage.Data        = pInBuffer;
+    // The transform only reads the source
+    SourceImage.Data        = const_cast<VmbUchar_t*>( pInBuffer );
     DestinationImage.Data   = OutImage.GetBits();
 
     Result = VmbSetImageInfoFromPixelFormat( ePixelFormat, nWidth, nHeight, &SourceImage );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error setting source image info." ), static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error setting source image info." ), static_cast<VmbErrorType>( Result ) );
         return;
     }
 	static const std::string DisplayFormat( "BGR24" );
@@ -412,16 +624,16 @@ void CAsynchronousGrabDlg::CopyToImage2( VmbUchar_t *pInBuffer, VmbPixelFormat_t
     Result = VmbSetImageInfoFromString( DisplayFormat.c_str(), (VmbUint32_t)DisplayFormat.size(), nWidth,nHeight, &DestinationImage );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error setting destination image info." ),static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error setting destination image info." ),static_cast<VmbErrorType>( Result ) );
         return;
     }
     Result = VmbImageTransform( &SourceImage, &DestinationImage,NULL,0 );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error transforming image." ), static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error transforming image." ), static_cast<VmbErrorType>( Result ) );
     }
 }
-void CAsynchronousGrabDlg::CopyToImage( VmbUchar_t *pInBuffer, VmbPixelFormat_t ePixelFormat, CImage &OutImage )
+void CAsynchronousGrabDlg::CopyToImage( const VmbUchar_t *pInBuffer, VmbPixelFormat_t ePixelFormat, CImage &OutImage )
 {
     const int               nHeight         = m_ApiController.GetHeight();
     const int               nWidth          = m_ApiController.GetWidth();
@@ -430,33 +642,34 @@ void CAsynchronousGrabDlg::CopyToImage( VmbUchar_t *pInBuffer, VmbPixelFormat_t
     VmbError_t              Result;
     if( ( nWidth*nBitsPerPixel ) /8 != nStride )
     {
-        Log( _TEXT( "Vimba only supports stride that is equal to width." ), VmbErrorWrongType );
+        Log( LogConversion, _TEXT( "Vimba only supports stride that is equal to width." ), VmbErrorWrongType );
         return;
     }
     VmbImage                SourceImage,DestinationImage;
     SourceImage.Size        = sizeof( SourceImage );
     DestinationImage.Size   = sizeof( DestinationImage );
 
-    SourceImage.Data        = pInBuffer;
+    // The transform only reads the source
+    SourceImage.Data        = const_cast<VmbUchar_t*>( pInBuffer );
     DestinationImage.Data   = OutImage.GetBits();
 
     Result = VmbSetImageInfoFromPixelFormat( ePixelFormat, nWidth, nHeight, &SourceImage );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error setting source image info." ), static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error setting source image info." ), static_cast<VmbErrorType>( Result ) );
         return;
     }
     static const std::string DisplayFormat( "RGB24" );
     Result = VmbSetImageInfoFromString( DisplayFormat.c_str(), (VmbUint32_t)DisplayFormat.size(), nWidth,nHeight, &DestinationImage );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error setting destination image info." ),static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error setting destination image info." ),static_cast<VmbErrorType>( Result ) );
         return;
     }
     Result = VmbImageTransform( &SourceImage, &DestinationImage,NULL,0 );
     if( VmbErrorSuccess != Result )
     {
-        Log( _TEXT( "Error transforming image." ), static_cast<VmbErrorType>( Result ) );
+        Log( LogConversion, _TEXT( "Error transforming image." ), static_cast<VmbErrorType>( Result ) );
     }
 }
 
@@ -465,47 +678,75 @@ void CAsynchronousGrabDlg::CopyToImage( VmbUchar_t *pInBuffer, VmbPixelFormat_t
 //
 void CAsynchronousGrabDlg::UpdateCameraListBox()
 {
-    // Get all cameras currently connected to Vimba
-    CameraPtrVector cameras = m_ApiController.GetCameraList();
+    std::vector<CameraInfo> cameras;
+    m_ApiController.GetCameraRegistry().GetCameras( cameras );
 
-    // Simply forget about all cameras known so far
     m_ListBoxCameras.ResetContent();
-    m_cameras.clear();
+    for( size_t i = 0; i < cameras.size(); ++i )
+    {
+        m_ListBoxCameras.AddString( GetCameraListEntry( cameras[i] ) );
+    }
 
-    // And query the camera details again
-    for(    CameraPtrVector::const_iterator iter = cameras.begin();
-            cameras.end() != iter;
-            ++iter )
+    // Select first cam if none is selected
+    if (    -1 == m_ListBoxCameras.GetCurSel()
+         && 0 < cameras.size() )
     {
-        std::string strCameraName;
-        std::string strCameraID;
-        if( VmbErrorSuccess != (*iter)->GetName( strCameraName ) )
+        m_ListBoxCameras.SetCurSel( 0 );
+    }
+
+    m_btOpencam1.EnableWindow( 0 < cameras.size());
+	m_btOpencam2.EnableWindow( 1 < cameras.size());
+}
+
+//
+// Adds and removes the list entries of the cameras that changed
+//
+// Parameters:
+//  [in]    rChanges        The cameras that showed up or went away
+//
+void CAsynchronousGrabDlg::UpdateCameraListBox( const std::vector<CameraChange> &rChanges )
+{
+    for( size_t i = 0; i < rChanges.size(); ++i )
+    {
+        const CString strEntry = GetCameraListEntry( rChanges[i].info );
+        const int nIndex = m_ListBoxCameras.FindStringExact( -1, strEntry );
+        if( AVT::VmbAPI::UpdateTriggerPluggedIn == rChanges[i].eReason )
         {
-            strCameraName = "[NoName]";
+            if( LB_ERR == nIndex )
+            {
+                m_ListBoxCameras.AddString( strEntry );
+            }
         }
-        // If for any reason we cannot get the ID of a camera we skip it
-        if( VmbErrorSuccess == (*iter)->GetID( strCameraID ) )
+        else if( LB_ERR != nIndex )
         {
-            
-            std::string strInfo = strCameraName + " " + strCameraID;
-            m_ListBoxCameras.AddString( CString( strInfo.c_str() ) );
-            m_cameras.push_back( strCameraID );
-        }
-        else
-        {
-            Log( _TEXT("Could not get camera ID") );
+            m_ListBoxCameras.DeleteString( nIndex );
         }
     }
 
-    // Select first cam if none is selected
+    const size_t nCameras = m_ApiController.GetCameraRegistry().GetCount();
     if (    -1 == m_ListBoxCameras.GetCurSel()
-         && 0 < m_cameras.size() )
+         && 0 < nCameras )
     {
         m_ListBoxCameras.SetCurSel( 0 );
     }
+    // An open camera can always be closed
+    m_btOpencam1.EnableWindow( 0 < nCameras || m_ApiController.CameraIsOpen1 );
+	m_btOpencam2.EnableWindow( 1 < nCameras || m_ApiController.CameraIsOpen2 );
+}
 
-    m_btOpencam1.EnableWindow( 0 < m_cameras.size());
-	m_btOpencam2.EnableWindow( 1 < m_cameras.size());
+//
+// Gets the text a camera is listed with
+//
+// Parameters:
+//  [in]    rInfo           The camera
+//
+// Returns:
+//  Name and ID of the camera
+//
+CString CAsynchronousGrabDlg::GetCameraListEntry( const CameraInfo &rInfo )
+{
+    std::string strInfo = rInfo.strName + " " + rInfo.strCameraID;
+    return CString( strInfo.c_str() );
 }
 
 //
@@ -517,8 +758,7 @@ void CAsynchronousGrabDlg::UpdateCameraListBox()
 //
 void CAsynchronousGrabDlg::Log( string_type strMsg, VmbErrorType eErr )
 {
-    strMsg += _TEXT( "..." ) + m_ApiController.ErrorCodeToMessage( eErr );
-    m_ListLog.InsertString( 0, strMsg.c_str() );
+    Log( LogGeneral, strMsg, eErr );
 }
 
 //
@@ -529,7 +769,49 @@ void CAsynchronousGrabDlg::Log( string_type strMsg, VmbErrorType eErr )
 //
 void CAsynchronousGrabDlg::Log( string_type strMsg )
 {
-    m_ListLog.InsertString( 0, strMsg.c_str() );
+    // Shown by the timer, the list box is not touched here
+    m_Log.Write( LogGeneral, strMsg );
+}
+
+//
+// Prints out a message of a category that may come in floods, e.g. once
+// per frame. Only a few of them are shown, the rest is summed up.
+//
+// Parameters:
+//  [in]    eCategory       The category the rate limit is kept for
+//  [in]    strMsg          A given message to be printed out
+//  [in]    eErr            The API status code
+//
+void CAsynchronousGrabDlg::Log( LogCategory eCategory, string_type strMsg, VmbErrorType eErr )
+{
+    strMsg += _TEXT( "..." ) + m_ApiController.ErrorCodeToMessage( eErr );
+    m_Log.Write( eCategory, strMsg );
+}
+
+//
+// Moves the messages logged since the last call to the log list box
+// and keeps the list box from growing without bound
+//
+void CAsynchronousGrabDlg::DrainLog()
+{
+    std::vector<std::wstring> lines;
+    m_Log.Drain( lines );
+    if( lines.empty() )
+    {
+        return;
+    }
+    m_ListLog.SetRedraw( FALSE );
+    // Newest on top as before
+    for( size_t i = 0; i < lines.size(); ++i )
+    {
+        m_ListLog.InsertString( 0, lines[i].c_str() );
+    }
+    while( m_ListLog.GetCount() > MAX_LOG_LINES )
+    {
+        m_ListLog.DeleteString( m_ListLog.GetCount() - 1 );
+    }
+    m_ListLog.SetRedraw( TRUE );
+    m_ListLog.Invalidate();
 }
 
 //
@@ -549,17 +831,18 @@ void CAsynchronousGrabDlg::DoDataExchange( CDataExchange* pDX )
 	DDX_Control( pDX, IDC_BUTTON_STARTSTOP, m_ButtonStartStop );
 	DDX_Control( pDX, IDC_PICTURE_STREAM, m_PictureBoxStream );
 	DDX_Control(pDX, IDC_PICTURE_STREAM2, m_PictureBoxStream2);
+	DDX_Control(pDX, IDC_PICTURE_STREAM3, m_PictureBoxMosaic);
 	DDX_Control(pDX, IDC_BUTTON_STARTSTOP2, m_ButtonStartStop2);
 	DDX_Control(pDX, IDC_SLIDER2, m_Slider1);
 	DDX_Control(pDX, IDC_SLIDER3, m_Slider2);
 	DDX_Text(pDX, IDC_EDIT1, packetSize1);
-	DDV_MinMaxInt(pDX, packetSize1, 500, 9973);
+	DDV_MinMaxInt(pDX, packetSize1, PACKET_SIZE_MIN, PACKET_SIZE_MAX);
 	DDX_Control(pDX, IDC_EDIT1, m_packageEidt1);
 	DDX_Control(pDX, IDC_BT_OPENCAM1, m_btOpencam1);
 	DDX_Control(pDX, IDC_BT_OPENCAM2, m_btOpencam2);
 	DDX_Control(pDX, IDC_EDIT2, m_packageEidt2);
 	DDX_Text(pDX, IDC_EDIT2, packetSize2);
-	DDV_MinMaxInt(pDX, packetSize2, 500, 9973);
+	DDV_MinMaxInt(pDX, packetSize2, PACKET_SIZE_MIN, PACKET_SIZE_MAX);
 }
 
 template <typename T>
@@ -595,6 +878,24 @@ void CAsynchronousGrabDlg::OnPaint()
     {
         CDialog::OnPaint();
 
+        if(     m_bMosaicEnabled
+            &&  NULL != m_Mosaic.GetFrameBuffer() )
+        {
+            CPaintDC dc( &m_PictureBoxMosaic );
+            BITMAPINFO info;
+            memset( &info, 0, sizeof( info ) );
+            info.bmiHeader.biSize = sizeof( BITMAPINFOHEADER );
+            info.bmiHeader.biWidth = m_Mosaic.GetWidth();
+            // Negative for a top down bitmap
+            info.bmiHeader.biHeight = -static_cast<LONG>( m_Mosaic.GetHeight() );
+            info.bmiHeader.biPlanes = 1;
+            info.bmiHeader.biBitCount = 24;
+            info.bmiHeader.biCompression = BI_RGB;
+            // One blit for all cameras, the update region clips it to the changed tiles
+            SetDIBitsToDevice(  dc.m_hDC, 0, 0, m_Mosaic.GetWidth(), m_Mosaic.GetHeight(),
+                                0, 0, 0, m_Mosaic.GetHeight(), m_Mosaic.GetFrameBuffer(), &info, DIB_RGB_COLORS );
+        }
+
         if( NULL != m_Image )
         {
             CPaintDC dc( &m_PictureBoxStream );
@@ -610,6 +911,7 @@ void CAsynchronousGrabDlg::OnPaint()
             // HALFTONE enhances image quality but decreases performance
             dc.SetStretchBltMode( HALFTONE );
             m_Image.StretchBlt( dc.m_hDC, rect );
+            m_Display.OnPainted();
         }
 		if( NULL != m_Image2 )
         {
@@ -626,6 +928,7 @@ void CAsynchronousGrabDlg::OnPaint()
             // HALFTONE enhances image quality but decreases performance
             dc.SetStretchBltMode( HALFTONE );
             m_Image2.StretchBlt( dc.m_hDC, rect );
+            m_Display2.OnPainted();
         }
     }
 }
@@ -637,41 +940,128 @@ void CAsynchronousGrabDlg::OnHScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrol
 		CSliderCtrl   *pSlidCtrl=(CSliderCtrl*)GetDlgItem(IDC_SLIDER2);
 		//m_int 即为当前滑块的值。
 		int m_int =1*pSlidCtrl->GetPos();//取得当前位置值
-		float m_float=(float)m_int;
-		//m_ApiController.SetCameraFloatFeature(1,"ExposureTimeAbs",m_float);
+		QueueExposure( 1, IDC_CHECK_AUTOEXPOSURE1, nSBCode, m_int );
 	}
 	else if  (pScrollBar->GetDlgCtrlID() == IDC_SLIDER3 )
 	{
 		CSliderCtrl   *pSlidCtrl=(CSliderCtrl*)GetDlgItem(IDC_SLIDER3);
 		//m_int 即为当前滑块的值。
 		int m_int =1*pSlidCtrl->GetPos();//取得当前位置值
-		float m_float=(float)m_int;
-		//m_ApiController.SetCameraFloatFeature(2,"ExposureTimeAbs",m_float);
+		QueueExposure( 2, IDC_CHECK_AUTOEXPOSURE2, nSBCode, m_int );
 	}
 
 	CDialog::OnHScroll(nSBCode, nPos, pScrollBar);
 }
 
 
-void CAsynchronousGrabDlg::OnEnChangeEdit1()
+//
+// Hands an exposure time from the slider to the feature writer. While the
+// thumb is dragged the camera gets the value once it rests, letting go
+// writes it at once. Taking the slider over ends auto exposure.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDCheck        The auto exposure check box of the camera
+//  [in]    nSBCode         The scroll request of the slider
+//  [in]    nPos            The exposure time in microseconds
+//
+void CAsynchronousGrabDlg::QueueExposure( int cameraIndex, int nIDCheck, UINT nSBCode, int nPos )
 {
-	UpdateData(TRUE);
-	//m_ApiController.SetCameraIntFeature(1,"GevSCPSPacketSize",packetSize1);
+	// Every change ends with TB_ENDTRACK, the steps in between are left out
+	if(     TB_THUMBTRACK != nSBCode
+		&&  TB_ENDTRACK != nSBCode )
+	{
+		return;
+	}
+	if( m_ApiController.IsAutoExposureEnabled( cameraIndex ) )
+	{
+		CheckDlgButton( nIDCheck, BST_UNCHECKED );
+		ToggleAutoExposure( cameraIndex, nIDCheck );
+	}
+	if( m_ApiController.IsHdrEnabled( cameraIndex ) )
+	{
+		m_ApiController.DisableHdr( cameraIndex );
+		UpdateHdrCheck();
+	}
+	const VmbUint32_t nDebounceMs = TB_THUMBTRACK == nSBCode ? SLIDER_DEBOUNCE_MS : 0;
+	m_ApiController.GetFeatureWriter( cameraIndex ).SetFloat( "ExposureTimeAbs", nPos, nDebounceMs );
+}
 
+void CAsynchronousGrabDlg::OnEnChangeEdit1()
+{
+	QueuePacketSize( 1, IDC_EDIT1, packetSize1 );
 }
 
 void CAsynchronousGrabDlg::OnEnChangeEdit2()
 {
-	UpdateData(TRUE);
-	//m_ApiController.SetCameraIntFeature(2,"GevSCPSPacketSize",packetSize2);
-	
+	QueuePacketSize( 2, IDC_EDIT2, packetSize2 );
+}
+
+//
+// Hands the packet size typed into an edit box to the feature writer.
+// Every keystroke changes the number, only the one typed last is written.
+// Numbers still being typed that are out of range are not queued, and
+// the edit box is read directly so they do not bring up a message box.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDEdit         The packet size edit box of the camera
+//  [out]   rPacketSize     The packet size of the camera, set if valid
+//
+void CAsynchronousGrabDlg::QueuePacketSize( int cameraIndex, int nIDEdit, int &rPacketSize )
+{
+	BOOL bTranslated = FALSE;
+	const UINT nPacketSize = GetDlgItemInt( nIDEdit, &bTranslated, FALSE );
+	if(     !bTranslated
+		||  PACKET_SIZE_MIN > nPacketSize
+		||  PACKET_SIZE_MAX < nPacketSize )
+	{
+		return;
+	}
+	rPacketSize = static_cast<int>( nPacketSize );
+	m_ApiController.GetFeatureWriter( cameraIndex ).SetInt( "GevSCPSPacketSize", rPacketSize, EDIT_DEBOUNCE_MS );
+}
+
+//
+// Logs the result of a feature write. Runs on the thread of the feature
+// writer, so it only touches the log.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rStrName        The name of the feature
+//  [in]    rValue          The value written
+//  [in]    eResult         The result of the write
+//  [in]    dLatencyMs      The time from the first queued value to the write
+//
+void CAsynchronousGrabDlg::ReportFeatureWrite( int cameraIndex, const std::string &rStrName, const FeatureWriter::Value &rValue, VmbErrorType eResult, double dLatencyMs )
+{
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << " " << rStrName.c_str() << " = ";
+	if( rValue.bIsFloat )
+	{
+		strMsg << rValue.dValue;
+	}
+	else
+	{
+		strMsg << rValue.nValue;
+	}
+	strMsg << " after " << static_cast<int>( dLatencyMs + 0.5 ) << " ms";
+	if( VmbErrorSuccess == eResult )
+	{
+		m_Log.Write( LogFeatureWrite, strMsg.str() );
+	}
+	else
+	{
+		Log( LogFeatureWrite, strMsg.str(), eResult );
+	}
 }
 
 void CAsynchronousGrabDlg::OnBnClickedBtOpencam1()
 {
-	if (m_cameras.size() >= 1)
+	std::string strCameraID;
+	if (m_ApiController.CameraIsOpen1 || m_ApiController.GetCameraRegistry().ResolveSlot(1, strCameraID))
 	{
-		m_ApiController.OpenCloseCamera1(m_cameras[0]);
+		m_ApiController.OpenCloseCamera1(strCameraID);
 		UpdateContronls();
 	}
     else
@@ -682,9 +1072,10 @@ void CAsynchronousGrabDlg::OnBnClickedBtOpencam1()
 
 void CAsynchronousGrabDlg::OnBnClickedBtOpencam2()
 {
-	if (m_cameras.size() >= 2)
+	std::string strCameraID;
+	if (m_ApiController.CameraIsOpen2 || m_ApiController.GetCameraRegistry().ResolveSlot(2, strCameraID))
 	{
-		m_ApiController.OpenCloseCamera2(m_cameras[1]);
+		m_ApiController.OpenCloseCamera2(strCameraID);
 		UpdateContronls();
 	}
 	else
@@ -693,14 +1084,793 @@ void CAsynchronousGrabDlg::OnBnClickedBtOpencam2()
 	}
 }
 
+// Opens all cameras that are not open yet at the same time
+void CAsynchronousGrabDlg::OnBnClickedBtOpenall()
+{
+	std::vector<std::string> cameraIDs;
+	bool bAnyCamera = false;
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		// Keep the slot of an open camera so every ID still lands on its own camera
+		std::string strCameraID;
+		if(		!bIsOpen
+			&&	m_ApiController.GetCameraRegistry().ResolveSlot( cameraIndex, strCameraID ) )
+		{
+			bAnyCamera = true;
+		}
+		cameraIDs.push_back( strCameraID );
+	}
+	if( !bAnyCamera )
+	{
+		Log( _TEXT( "Can not find any camera." ) );
+		return;
+	}
+
+	std::vector<CameraOpenResult> results;
+	double dWallTimeMs = 0.0;
+	CWaitCursor waitCursor;
+	m_ApiController.OpenCameras( cameraIDs, results, dWallTimeMs );
+
+	double dSumMs = 0.0;
+	for( size_t i = 0; i < results.size(); ++i )
+	{
+		if( results[i].strCameraID.empty() )
+		{
+			continue;
+		}
+		string_stream_type strMsg;
+		strMsg << "Camera " << ( i + 1 ) << " (" << results[i].strCameraID.c_str() << ") opened in "
+			   << static_cast<int>( results[i].dDurationMs ) << " ms";
+		Log( strMsg.str(), results[i].eResult );
+		dSumMs += results[i].dDurationMs;
+	}
+	string_stream_type strMsg;
+	strMsg << "Opened cameras in " << static_cast<int>( dWallTimeMs ) << " ms, one by one would take "
+		   << static_cast<int>( dSumMs ) << " ms";
+	Log( strMsg.str() );
+	LogCommandStatistics();
+	UpdateContronls();
+}
+
+// Reopens unplugged cameras that are back and resumes their streams
+void CAsynchronousGrabDlg::RecoverCameras()
+{
+	std::vector<RecoveryResult> recovered;
+	m_ApiController.RecoverCameras( recovered );
+	for( size_t i = 0; i < recovered.size(); ++i )
+	{
+		string_stream_type strMsg;
+		strMsg	<< "Camera " << recovered[i].cameraIndex << " (" << recovered[i].strCameraID.c_str() << ") reopen attempt "
+				<< recovered[i].nAttempt << ( recovered[i].bResumed ? ", streaming resumed" : "" );
+		Log( strMsg.str(), recovered[i].eResult );
+	}
+	if( !recovered.empty() )
+	{
+		UpdateContronls();
+	}
+}
+
+// Prints the bandwidth share of every streaming camera and the drops the link model expects
+void CAsynchronousGrabDlg::LogBandwidthPlan()
+{
+	std::vector<StreamAllocation> allocations;
+	std::vector<LinkSimulationResult> simulation;
+	m_ApiController.GetBandwidthPlan( allocations, simulation );
+	for( size_t i = 0; i < allocations.size() && i < simulation.size(); ++i )
+	{
+		string_stream_type strMsg;
+		strMsg.setf( std::ios::fixed );
+		strMsg.precision( 1 );
+		strMsg	<< allocations[i].strCameraID.c_str() << ": " << allocations[i].nStreamBytesPerSecond / 1000000.0 << " MB/s, packet size "
+				<< allocations[i].nPacketSize << ", GevSCPD " << allocations[i].nInterPacketDelay << ", "
+				<< allocations[i].dExpectedFps << " fps" << ( allocations[i].bDemandMet ? "" : " (throttled)" ) << ", simulated drops "
+				<< 100.0 * simulation[i].dDropRate << "%, resends " << 100.0 * simulation[i].dResendRate << "%";
+		Log( strMsg.str() );
+	}
+}
+
+// Prints how long the command features took to complete so far
+void CAsynchronousGrabDlg::LogCommandStatistics()
+{
+	std::vector<CommandExecutor::CommandStatistics> statistics;
+	m_ApiController.GetCommandExecutor().GetStatistics( statistics );
+	for( size_t i = 0; i < statistics.size(); ++i )
+	{
+		string_stream_type strMsg;
+		strMsg.setf( std::ios::fixed );
+		strMsg.precision( 1 );
+		strMsg	<< statistics[i].strName.c_str() << ": " << statistics[i].nCompleted << " done in "
+				<< statistics[i].dMinMs << "/" << statistics[i].dMeanMs << "/" << statistics[i].dMaxMs << " ms (min/mean/max), "
+				<< statistics[i].nTimedOut << " timed out, " << statistics[i].nFailed << " failed";
+		Log( strMsg.str() );
+	}
+}
+
+// Prints how long every stage of the pipeline of a camera took
+void CAsynchronousGrabDlg::LogPipelineStatistics( int cameraIndex )
+{
+	std::vector<FramePipeline::StageStatistics> statistics;
+	m_ApiController.GetPipeline( cameraIndex ).GetStatistics( statistics );
+	for( size_t i = 0; i < statistics.size(); ++i )
+	{
+		string_stream_type strMsg;
+		strMsg.setf( std::ios::fixed );
+		strMsg.precision( 1 );
+		strMsg	<< "Camera " << cameraIndex << " stage " << statistics[i].strName.c_str() << ": " << statistics[i].nProcessed << " done in "
+				<< statistics[i].dMeanUs << "/" << statistics[i].dMaxUs << " us (mean/max), "
+				<< statistics[i].nDropped << " dropped, " << statistics[i].nFailed << " failed, queue high water " << statistics[i].nQueueHighWater;
+		Log( strMsg.str() );
+	}
+}
+
+//
+// Arms a burst on a camera that just started streaming when burst mode is on
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void CAsynchronousGrabDlg::ArmBurstOnStart( int cameraIndex )
+{
+	if( BST_CHECKED != IsDlgButtonChecked( IDC_CHECK_BURST ) )
+	{
+		return;
+	}
+	VmbErrorType err = m_ApiController.ArmBurst( cameraIndex, BURST_FRAMES, BURST_DURATION_MS );
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << " burst armed for " << BURST_FRAMES << " frames";
+	Log( strMsg.str(), err );
+}
+
+//
+// Ends the burst of a camera that is about to stop streaming, a burst never
+// outlives its acquisition
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void CAsynchronousGrabDlg::FinishBurstOnStop( int cameraIndex )
+{
+	BurstRecorder &rBurst = m_ApiController.GetBurstRecorder( cameraIndex );
+	const BurstRecorder::StateType eState = rBurst.GetState();
+	if(     BurstRecorder::StateArmed != eState
+		&&  BurstRecorder::StateCapturing != eState )
+	{
+		return;
+	}
+	rBurst.Finish();
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << " burst ended after " << rBurst.GetFrameCount() << " frames";
+	Log( strMsg.str() );
+}
+
+void CAsynchronousGrabDlg::OnTimer( UINT_PTR nIDEvent )
+{
+	if( STATUS_TIMER_ID == nIDEvent )
+	{
+		DrainLog();
+		UpdateBurstStatus( 1, IDC_STATIC_BURST1 );
+		UpdateBurstStatus( 2, IDC_STATIC_BURST2 );
+		UpdateFrameBusStatus();
+		UpdateDisplayStatus( 1, IDC_STATIC_DISPLAY1 );
+		UpdateDisplayStatus( 2, IDC_STATIC_DISPLAY2 );
+		UpdateFocusStatus( 1, IDC_STATIC_FOCUS1 );
+		UpdateFocusStatus( 2, IDC_STATIC_FOCUS2 );
+		ReportMotionEvents( 1 );
+		ReportMotionEvents( 2 );
+		FinishCalibration( 1 );
+		FinishCalibration( 2 );
+		UpdateAutoExposure( 1, m_Slider1 );
+		UpdateAutoExposure( 2, m_Slider2 );
+		if( m_ApiController.IsRecoveryPending() )
+		{
+			// A camera may be listed before it accepts being opened
+			RecoverCameras();
+		}
+		for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+		{
+			double dReplugMs = 0.0;
+			if( m_ApiController.TakeReplugToFirstFrame( cameraIndex, dReplugMs ) )
+			{
+				string_stream_type strMsg;
+				strMsg << "Camera " << cameraIndex << " first frame " << static_cast<int>( dReplugMs ) << " ms after replug";
+				Log( strMsg.str() );
+			}
+		}
+	}
+
+	CDialog::OnTimer( nIDEvent );
+}
+
+//
+// Shows fill rate and flush progress of the burst of a camera
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDStatic       The static text control to print to
+//
+void CAsynchronousGrabDlg::UpdateBurstStatus( int cameraIndex, int nIDStatic )
+{
+	const BurstRecorder &rBurst = m_ApiController.GetBurstRecorder( cameraIndex );
+	const VmbUint32_t nFrames = rBurst.GetFrameCount();
+	CString strStatus;
+	switch( rBurst.GetState() )
+	{
+	case BurstRecorder::StateArmed:
+		strStatus.Format( L"Burst #%d: armed, %u frames reserved", cameraIndex, rBurst.GetCapacity() );
+		break;
+	case BurstRecorder::StateCapturing:
+		strStatus.Format( L"Burst #%d: %u/%u frames @ %.1f fps", cameraIndex, nFrames, rBurst.GetCapacity(), rBurst.GetFillRate() );
+		break;
+	case BurstRecorder::StateFlushing:
+		strStatus.Format( L"Burst #%d: flushing %u/%u", cameraIndex, rBurst.GetFlushedCount(), nFrames );
+		break;
+	default:
+		if( 0 < rBurst.GetFlushedCount() )
+		{
+			strStatus.Format( L"Burst #%d: %u frames written @ %.1f fps", cameraIndex, rBurst.GetFlushedCount(), rBurst.GetFillRate() );
+		}
+		else
+		{
+			strStatus.Format( L"Burst #%d: idle", cameraIndex );
+		}
+		break;
+	}
+
+	// Avoid flicker when nothing changed
+	CString strOld;
+	GetDlgItemText( nIDStatic, strOld );
+	if( strOld != strStatus )
+	{
+		SetDlgItemText( nIDStatic, strStatus );
+	}
+}
+
+//
+// Shows the sharpness of the last frame of a camera and the best one
+// seen since the focus region was set
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDStatic       The static text control to print to
+//
+void CAsynchronousGrabDlg::UpdateFocusStatus( int cameraIndex, int nIDStatic )
+{
+	std::vector<SharpnessMeasure> &rHistory = cameraIndex < 2 ? m_FocusHistory : m_FocusHistory2;
+	m_ApiController.GetSharpnessHistory( cameraIndex, rHistory );
+	if( rHistory.empty() )
+	{
+		return;
+	}
+	// Turning the lens through the focus leaves the peak behind to come back to
+	double dPeak = 0.0;
+	for( size_t i = 0; i < rHistory.size(); ++i )
+	{
+		dPeak = (std::max)( dPeak, rHistory[i].dLaplacianVariance );
+	}
+	const SharpnessMeasure &rLatest = rHistory.back();
+	CString strStatus;
+	strStatus.Format(	L"Focus #%d: Laplacian %.1f (peak %.1f), Tenengrad %.1f",
+						cameraIndex, rLatest.dLaplacianVariance, dPeak, rLatest.dTenengrad );
+	SetDlgItemText( nIDStatic, strStatus );
+}
+
+// Publishes the frames of all open cameras to shared memory for other processes
+void CAsynchronousGrabDlg::OnBnClickedCheckFramebus()
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_FRAMEBUS ) );
+	VmbErrorType err = m_ApiController.EnableFrameBus( bEnable );
+	Log( bEnable ? _TEXT( "Publishing frames to shared memory" ) : _TEXT( "Stopped publishing frames to shared memory" ), err );
+}
+
+void CAsynchronousGrabDlg::OnBnClickedCheckAutoexposure1()
+{
+	ToggleAutoExposure( 1, IDC_CHECK_AUTOEXPOSURE1 );
+}
+
+void CAsynchronousGrabDlg::OnBnClickedCheckAutoexposure2()
+{
+	ToggleAutoExposure( 2, IDC_CHECK_AUTOEXPOSURE2 );
+}
+
+void CAsynchronousGrabDlg::OnBnClickedCheckMotion1()
+{
+	ToggleMotionTrigger( 1, IDC_CHECK_MOTION1 );
+}
+
+void CAsynchronousGrabDlg::OnBnClickedCheckMotion2()
+{
+	ToggleMotionTrigger( 2, IDC_CHECK_MOTION2 );
+}
+
+//
+// Lets motion trigger the burst of a camera as its check box says
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDCheck        The check box of the camera
+//
+void CAsynchronousGrabDlg::ToggleMotionTrigger( int cameraIndex, int nIDCheck )
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( nIDCheck ) );
+	VmbErrorType err = m_ApiController.SetMotionTrigger( cameraIndex, bEnable, BURST_FRAMES, BURST_DURATION_MS );
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << ( bEnable ? " records on motion" : " records regardless of motion" );
+	Log( strMsg.str(), err );
+	if( VmbErrorSuccess != err )
+	{
+		CheckDlgButton( nIDCheck, BST_UNCHECKED );
+	}
+}
+
+//
+// Logs when motion in front of a camera started and stopped
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void CAsynchronousGrabDlg::ReportMotionEvents( int cameraIndex )
+{
+	m_ApiController.TakeMotionEvents( cameraIndex, m_MotionEvents );
+	for( size_t i = 0; i < m_MotionEvents.size(); ++i )
+	{
+		const MotionResult &rEvent = m_MotionEvents[i];
+		string_stream_type strMsg;
+		strMsg	<< "Camera " << cameraIndex
+				<< ( MotionEventStarted == rEvent.eEvent ? " motion started" : " motion stopped" )
+				<< " at frame " << rEvent.nFrameID
+				<< ", " << static_cast<int>( 100.0 * rEvent.dChangedRatio + 0.5 ) << "% changed";
+		Log( strMsg.str() );
+	}
+}
+
+// Stacks dark frames on every open camera, their lenses have to be covered
+void CAsynchronousGrabDlg::OnBnClickedBtCaptureDark()
+{
+	CaptureCalibration( CalibrationDark );
+}
+
+// Stacks flat frames on every open camera, they have to look at an even light
+void CAsynchronousGrabDlg::OnBnClickedBtCaptureFlat()
+{
+	CaptureCalibration( CalibrationFlat );
+}
+
+// Corrects the frames of all cameras, also of those opened later
+void CAsynchronousGrabDlg::OnBnClickedCheckFlatfield()
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_FLATFIELD ) );
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		m_ApiController.SetFlatFieldCorrection( cameraIndex, bEnable );
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		if(     bEnable
+			&&  bIsOpen
+			&&  !m_ApiController.HasCalibration( cameraIndex ) )
+		{
+			string_stream_type strMsg;
+			strMsg << "Camera " << cameraIndex << " has no flat-field calibration yet";
+			Log( strMsg.str() );
+		}
+	}
+	string_stream_type strMsg;
+	strMsg << ( bEnable ? "Flat-field correction on" : "Flat-field correction off" );
+	Log( strMsg.str() );
+}
+
+// Repairs the defective pixels of all cameras, also of those opened later
+void CAsynchronousGrabDlg::OnBnClickedCheckDefects()
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_DEFECTS ) );
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		m_ApiController.SetDefectCorrection( cameraIndex, bEnable );
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		if( bEnable && bIsOpen )
+		{
+			string_stream_type strMsg;
+			strMsg << "Camera " << cameraIndex << " repairs " << m_ApiController.GetDefectCount( cameraIndex ) << " defective pixels";
+			Log( strMsg.str() );
+		}
+	}
+}
+
+// Undistorts the frames of all cameras, also of those opened later
+void CAsynchronousGrabDlg::OnBnClickedCheckUndistort()
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_UNDISTORT ) );
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		m_ApiController.SetUndistortion( cameraIndex, bEnable );
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		if(     bEnable
+			&&  bIsOpen
+			&&  !m_ApiController.HasRemapTable( cameraIndex ) )
+		{
+			string_stream_type strMsg;
+			strMsg << "Camera " << cameraIndex << " has no lens model yet, put its fx fy cx cy k1 k2 p1 p2 k3 into lens_<serial number>.txt and open it again";
+			Log( strMsg.str() );
+		}
+	}
+}
+
+// Averages the frames of all cameras, also of those opened later
+void CAsynchronousGrabDlg::OnEnChangeEditAverage()
+{
+	BOOL bTranslated = FALSE;
+	const UINT nFrames = GetDlgItemInt( IDC_EDIT_AVERAGE, &bTranslated, FALSE );
+	// An empty field is being edited, the window stays as it is
+	if( !bTranslated )
+	{
+		return;
+	}
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		if( VmbErrorSuccess != m_ApiController.SetAveraging( cameraIndex, nFrames ) )
+		{
+			string_stream_type strMsg;
+			strMsg << "At most " << AverageStage::MAX_WINDOW << " frames can be averaged";
+			Log( strMsg.str() );
+			return;
+		}
+	}
+}
+
+// Brackets the exposure of every open camera
+void CAsynchronousGrabDlg::OnBnClickedCheckHdr()
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_HDR ) );
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		string_stream_type strMsg;
+		if( !bEnable )
+		{
+			if( m_ApiController.IsHdrEnabled( cameraIndex ) )
+			{
+				m_ApiController.DisableHdr( cameraIndex );
+				strMsg << "Camera " << cameraIndex << " HDR bracketing off";
+				Log( strMsg.str() );
+			}
+			continue;
+		}
+		if( !bIsOpen )
+		{
+			continue;
+		}
+		VmbErrorType err = m_ApiController.EnableHdr( cameraIndex );
+		strMsg << "Camera " << cameraIndex << " HDR bracketing on";
+		Log( strMsg.str(), err );
+		if( VmbErrorSuccess == err )
+		{
+			// The bracketing ended auto exposure
+			CheckDlgButton( cameraIndex < 2 ? IDC_CHECK_AUTOEXPOSURE1 : IDC_CHECK_AUTOEXPOSURE2, BST_UNCHECKED );
+		}
+	}
+	UpdateHdrCheck();
+}
+
+//
+// Unchecks the HDR check box once no camera brackets any more
+//
+void CAsynchronousGrabDlg::UpdateHdrCheck()
+{
+	if(     !m_ApiController.IsHdrEnabled( 1 )
+		&&  !m_ApiController.IsHdrEnabled( 2 ) )
+	{
+		CheckDlgButton( IDC_CHECK_HDR, BST_UNCHECKED );
+	}
+}
+
+//
+// Stacks calibration frames on every open camera
+//
+// Parameters:
+//  [in]    eType           What the cameras look at
+//
+void CAsynchronousGrabDlg::CaptureCalibration( CalibrationFrameType eType )
+{
+	for( int cameraIndex = 1; cameraIndex <= 2; ++cameraIndex )
+	{
+		const bool bIsOpen = ( 1 == cameraIndex ) ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+		if( !bIsOpen )
+		{
+			continue;
+		}
+		VmbErrorType err = m_ApiController.CaptureCalibration( cameraIndex, eType, CALIBRATION_FRAMES );
+		( cameraIndex < 2 ? m_bCalibrationPending : m_bCalibrationPending2 ) = ( VmbErrorSuccess == err && CalibrationFlat == eType );
+		string_stream_type strMsg;
+		strMsg << "Camera " << cameraIndex << " stacks " << CALIBRATION_FRAMES << ( CalibrationDark == eType ? " dark frames" : " flat frames" );
+		Log( strMsg.str(), err );
+	}
+}
+
+//
+// Builds and stores the flat-field maps and the defective pixels of a
+// camera once its flat frames are stacked
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//
+void CAsynchronousGrabDlg::FinishCalibration( int cameraIndex )
+{
+	bool &rbPending = cameraIndex < 2 ? m_bCalibrationPending : m_bCalibrationPending2;
+	if(     !rbPending
+		||  m_ApiController.IsCalibrationCapturing( cameraIndex ) )
+	{
+		return;
+	}
+	rbPending = false;
+	VmbErrorType err = m_ApiController.BuildCalibration( cameraIndex );
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << " flat-field calibration built and stored";
+	Log( strMsg.str(), err );
+	size_t nDefects = 0;
+	err = m_ApiController.DetectDefectivePixels( cameraIndex, nDefects );
+	string_stream_type strDefects;
+	strDefects << "Camera " << cameraIndex << " has " << nDefects << " defective pixels";
+	Log( strDefects.str(), err );
+}
+
+//
+// Turns auto exposure of a camera on or off as its check box says. The
+// controller is run against the exposure model of the scene first, so the
+// log tells what to expect.
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDCheck        The check box of the camera
+//
+void CAsynchronousGrabDlg::ToggleAutoExposure( int cameraIndex, int nIDCheck )
+{
+	const bool bEnable = ( BST_CHECKED == IsDlgButtonChecked( nIDCheck ) );
+	VmbErrorType err = m_ApiController.SetAutoExposure( cameraIndex, bEnable );
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << ( bEnable ? " auto exposure on" : " auto exposure off" );
+	Log( strMsg.str(), err );
+	( cameraIndex < 2 ? m_bAutoExposureConverged : m_bAutoExposureConverged2 ) = false;
+	if( VmbErrorSuccess != err )
+	{
+		CheckDlgButton( nIDCheck, BST_UNCHECKED );
+		return;
+	}
+	// Auto exposure ends the bracketing
+	UpdateHdrCheck();
+
+	ExposureSimulationResult result;
+	if(     bEnable
+		&&  VmbErrorSuccess == m_ApiController.SimulateAutoExposure( cameraIndex, result ) )
+	{
+		string_stream_type strModel;
+		strModel << "Camera " << cameraIndex << " auto exposure ";
+		if( result.bConverged )
+		{
+			strModel << "converges in " << result.nFramesToConverge << " frames against the model";
+		}
+		else
+		{
+			strModel << "does not converge against the model";
+		}
+		strModel << ", " << result.nReversals << " reversals";
+		Log( strModel.str() );
+	}
+}
+
+//
+// Moves the exposure slider to what auto exposure wrote and logs when
+// it converges
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rSlider         The exposure slider of the camera
+//
+void CAsynchronousGrabDlg::UpdateAutoExposure( int cameraIndex, CSliderCtrl &rSlider )
+{
+	if( !m_ApiController.IsAutoExposureEnabled( cameraIndex ) )
+	{
+		return;
+	}
+	const double dExposureUs = m_ApiController.GetAutoExposureTime( cameraIndex );
+	const int nPos = static_cast<int>( dExposureUs + 0.5 );
+	if( rSlider.GetPos() != nPos )
+	{
+		rSlider.SetPos( nPos );
+	}
+
+	bool &rbConverged = cameraIndex < 2 ? m_bAutoExposureConverged : m_bAutoExposureConverged2;
+	const bool bConverged = m_ApiController.IsAutoExposureConverged( cameraIndex );
+	if( bConverged && !rbConverged )
+	{
+		string_stream_type strMsg;
+		strMsg << "Camera " << cameraIndex << " auto exposure converged at " << nPos << " us";
+		Log( strMsg.str() );
+	}
+	rbConverged = bConverged;
+}
+
+//
+// Shows all cameras in the third picture box instead of one per box
+//
+void CAsynchronousGrabDlg::OnBnClickedCheckMosaic()
+{
+	m_bMosaicEnabled = ( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_MOSAIC ) );
+	// Start from empty tiles
+	m_Mosaic.SetLayout( m_Mosaic.GetTileCount(), 0 );
+	m_PictureBoxMosaic.Invalidate();
+}
+
+//
+// Scales a frame into the tile of its camera and the zoomed region
+// into the tile below, then repaints these tiles
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    pBuffer         The image of the frame, as the pipeline stages left it
+//  [in]    ePixelFormat    The pixel format of the image
+//
+void CAsynchronousGrabDlg::ShowInMosaic( int cameraIndex, const VmbUchar_t *pBuffer, VmbPixelFormatType ePixelFormat )
+{
+	const int nWidth = cameraIndex < 2 ? m_ApiController.GetWidth() : m_ApiController.GetWidth2();
+	const int nHeight = cameraIndex < 2 ? m_ApiController.GetHeight() : m_ApiController.GetHeight2();
+	const CRect &rZoomRoi = cameraIndex < 2 ? m_ZoomRoi : m_ZoomRoi2;
+	const VmbUint32_t nTile = cameraIndex < 2 ? 0 : 1;
+
+	ImageView view;
+	VmbErrorType err = MakeImageView( pBuffer, nWidth, nHeight, ePixelFormat, view );
+	if( VmbErrorSuccess == err )
+	{
+		err = m_Mosaic.Render( nTile, view );
+	}
+	if(     VmbErrorSuccess == err
+		&&  !rZoomRoi.IsRectEmpty() )
+	{
+		// Only the pixels of the region are touched, whatever the sensor size
+		ImageView roi;
+		err = CropImageView( view, rZoomRoi.left, rZoomRoi.top, rZoomRoi.Width(), rZoomRoi.Height(), roi );
+		if( VmbErrorSuccess == err )
+		{
+			err = m_Mosaic.RenderZoom( nTile + 2, roi );
+		}
+	}
+	if( VmbErrorSuccess != err )
+	{
+		Log( LogConversion, _TEXT( "Error composing the overview." ), err );
+	}
+	MosaicRect dirty;
+	if( m_Mosaic.TakeDirtyRect( dirty ) )
+	{
+		// Only the changed tiles are repainted
+		CRect rect( dirty.nLeft, dirty.nTop, dirty.nLeft + dirty.nWidth, dirty.nTop + dirty.nHeight );
+		m_PictureBoxMosaic.MapWindowPoints( this, &rect );
+		InvalidateRect( &rect, false );
+	}
+}
+
+//
+// Centers the zoomed region of a camera on a point of its picture box
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    rPictureBox     The picture box of the camera
+//  [in]    point           The point in screen coordinates
+//
+// Returns:
+//  false if the point is not on the image of the camera
+//
+bool CAsynchronousGrabDlg::SelectZoomRoi( int cameraIndex, CStatic &rPictureBox, CPoint point )
+{
+	const bool bIsOpen = cameraIndex < 2 ? m_ApiController.CameraIsOpen1 : m_ApiController.CameraIsOpen2;
+	if( !bIsOpen )
+	{
+		return false;
+	}
+	const int nWidth = cameraIndex < 2 ? m_ApiController.GetWidth() : m_ApiController.GetWidth2();
+	const int nHeight = cameraIndex < 2 ? m_ApiController.GetHeight() : m_ApiController.GetHeight2();
+	CRect clientRect;
+	rPictureBox.GetClientRect( &clientRect );
+	// The image is fitted into the box the same way OnPaint draws it
+	const CRect imageRect = fitRect( nWidth, nHeight, clientRect );
+	rPictureBox.ScreenToClient( &point );
+	if( 0 >= nWidth || 0 >= nHeight || !imageRect.PtInRect( point ) )
+	{
+		return false;
+	}
+	const int nCenterX = ( point.x - imageRect.left ) * nWidth / imageRect.Width();
+	const int nCenterY = ( point.y - imageRect.top ) * nHeight / imageRect.Height();
+	const int nRoiWidth = (std::min)( ZOOM_ROI_SIZE, nWidth );
+	const int nRoiHeight = (std::min)( ZOOM_ROI_SIZE, nHeight );
+	const int nLeft = (std::max)( 0, (std::min)( nCenterX - nRoiWidth / 2, nWidth - nRoiWidth ) );
+	const int nTop = (std::max)( 0, (std::min)( nCenterY - nRoiHeight / 2, nHeight - nRoiHeight ) );
+	CRect &rZoomRoi = cameraIndex < 2 ? m_ZoomRoi : m_ZoomRoi2;
+	rZoomRoi.SetRect( nLeft, nTop, nLeft + nRoiWidth, nTop + nRoiHeight );
+	// The lens is focused on what is looked at
+	m_ApiController.SetSharpnessRegion( cameraIndex, nLeft, nTop, nRoiWidth, nRoiHeight );
+
+	string_stream_type strMsg;
+	strMsg << "Camera " << cameraIndex << " zoom and focus on " << nRoiWidth << "x" << nRoiHeight << " at " << nLeft << "," << nTop;
+	Log( strMsg.str() );
+	return true;
+}
+
+void CAsynchronousGrabDlg::OnLButtonDown( UINT nFlags, CPoint point )
+{
+	// Picture boxes are static controls, so their clicks arrive here
+	CPoint screenPoint( point );
+	ClientToScreen( &screenPoint );
+	if( !SelectZoomRoi( 1, m_PictureBoxStream, screenPoint ) )
+	{
+		SelectZoomRoi( 2, m_PictureBoxStream2, screenPoint );
+	}
+
+	CDialog::OnLButtonDown( nFlags, point );
+}
+
+//
+// Shows how often a picture box is painted, how many conversions the
+// refresh cap saves and the exposure of the last analysed frame
+//
+// Parameters:
+//  [in]    cameraIndex     The camera (1 or 2)
+//  [in]    nIDStatic       The static text control to print to
+//
+void CAsynchronousGrabDlg::UpdateDisplayStatus( int cameraIndex, int nIDStatic )
+{
+	DisplayScheduler &rDisplay = cameraIndex < 2 ? m_Display : m_Display2;
+	double dPaintsPerSecond = 0.0;
+	double dSavedPerSecond = 0.0;
+	if( rDisplay.TakeRates( dPaintsPerSecond, dSavedPerSecond ) )
+	{
+		CString strStatus;
+		strStatus.Format(	L"Display #%d: %.1f paints/s (cap %.0f Hz), %.1f conversions/s saved",
+							cameraIndex, dPaintsPerSecond, rDisplay.GetMaxRate(), dSavedPerSecond );
+		const std::shared_ptr<const ImageStatistics> pStatistics = m_ApiController.GetImageStatistics( cameraIndex );
+		if( pStatistics )
+		{
+			// Color images report their green channel
+			const VmbUint32_t c = 3 == pStatistics->nChannels ? 1 : 0;
+			CString strExposure;
+			strExposure.Format(	L", mean %.1f, %.2f%% clipped",
+								pStatistics->dMean[c], 100.0 * pStatistics->nClippedHigh[c] / pStatistics->nPixels );
+			strStatus += strExposure;
+		}
+		SetDlgItemText( nIDStatic, strStatus );
+	}
+}
+
+//
+// Shows the readers of the shared frame buses and how far they lag behind
+//
+void CAsynchronousGrabDlg::UpdateFrameBusStatus()
+{
+	CString strStatus( L"Frame bus: off" );
+	if( BST_CHECKED == IsDlgButtonChecked( IDC_CHECK_FRAMEBUS ) )
+	{
+		VmbUint32_t nReaders1;
+		VmbUint32_t nReaders2;
+		const VmbUint64_t nLag1 = m_ApiController.GetFrameBus( 1 ).GetMaxReaderLag( nReaders1 );
+		const VmbUint64_t nLag2 = m_ApiController.GetFrameBus( 2 ).GetMaxReaderLag( nReaders2 );
+		strStatus.Format( L"Frame bus: #1 %u readers, lag %llu / #2 %u readers, lag %llu", nReaders1, nLag1, nReaders2, nLag2 );
+	}
+	CString strOld;
+	GetDlgItemText( IDC_STATIC_FRAMEBUS, strOld );
+	if( strOld != strStatus )
+	{
+		SetDlgItemText( IDC_STATIC_FRAMEBUS, strStatus );
+	}
+}
+
 void CAsynchronousGrabDlg::UpdateContronls()
 {
+	// Closing a camera ends its bracketing
+	UpdateHdrCheck();
 	if (m_ApiController.CameraIsOpen1)//只有相机打开后才能进行相关的参数设置
 	{
 		m_btOpencam1.SetWindowText( _TEXT( "CloseCamera #1" ) );
 		m_ButtonStartStop.EnableWindow(true);		
 		
 		m_Slider1.EnableWindow(true);
+		GetDlgItem( IDC_CHECK_AUTOEXPOSURE1 )->EnableWindow( true );
+		GetDlgItem( IDC_CHECK_MOTION1 )->EnableWindow( true );
 		if (m_ApiController.CameraIsAcq1)//采集状态下PackageSize是不能进行设置的
 		{
 			m_ButtonStartStop.SetWindowText( _TEXT( "Stop Image Acquisition #1" ) );
@@ -719,6 +1889,11 @@ void CAsynchronousGrabDlg::UpdateContronls()
 	    m_ButtonStartStop.EnableWindow(false);
 		m_Slider1.EnableWindow(false);
 		m_packageEidt1.EnableWindow(false);
+		// Auto exposure ends with the camera
+		CheckDlgButton( IDC_CHECK_AUTOEXPOSURE1, BST_UNCHECKED );
+		GetDlgItem( IDC_CHECK_AUTOEXPOSURE1 )->EnableWindow( false );
+		CheckDlgButton( IDC_CHECK_MOTION1, BST_UNCHECKED );
+		GetDlgItem( IDC_CHECK_MOTION1 )->EnableWindow( false );
 	}
 
 	if (m_ApiController.CameraIsOpen2)//只有相机打开后才能进行相关的参数设置
@@ -727,6 +1902,8 @@ void CAsynchronousGrabDlg::UpdateContronls()
 		m_ButtonStartStop2.EnableWindow(true);		
 		
 		m_Slider2.EnableWindow(true);
+		GetDlgItem( IDC_CHECK_AUTOEXPOSURE2 )->EnableWindow( true );
+		GetDlgItem( IDC_CHECK_MOTION2 )->EnableWindow( true );
 		if (m_ApiController.CameraIsAcq2)//采集状态下PackageSize是不能进行设置的
 		{
 			m_ButtonStartStop2.SetWindowText( _TEXT( "Stop Image Acquisition #2" ) );
@@ -745,6 +1922,10 @@ void CAsynchronousGrabDlg::UpdateContronls()
 	    m_ButtonStartStop2.EnableWindow(false);
 		m_Slider2.EnableWindow(false);
 		m_packageEidt2.EnableWindow(false);
+		CheckDlgButton( IDC_CHECK_AUTOEXPOSURE2, BST_UNCHECKED );
+		GetDlgItem( IDC_CHECK_AUTOEXPOSURE2 )->EnableWindow( false );
+		CheckDlgButton( IDC_CHECK_MOTION2, BST_UNCHECKED );
+		GetDlgItem( IDC_CHECK_MOTION2 )->EnableWindow( false );
 	}
 }
 
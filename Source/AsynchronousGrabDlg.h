@@ -32,8 +32,24 @@
 #include <atlimage.h>
 #include <VimbaCPP/Include/VimbaCPP.h>
 #include <ApiController.h>
+#include "AsyncLog.h"
+#include "DisplayScheduler.h"
+#include "ThreadPool.h"
+#include "MosaicCompositor.h"
 #include "afxcmn.h"
 using AVT::VmbAPI::Examples::ApiController;
+using AVT::VmbAPI::Examples::CameraInfo;
+using AVT::VmbAPI::Examples::CameraChange;
+using AVT::VmbAPI::Examples::AsyncLog;
+using AVT::VmbAPI::Examples::LogCategory;
+using AVT::VmbAPI::Examples::FeatureWriter;
+using AVT::VmbAPI::Examples::DisplayScheduler;
+using AVT::VmbAPI::Examples::ThreadPool;
+using AVT::VmbAPI::Examples::MosaicCompositor;
+using AVT::VmbAPI::Examples::ImageView;
+using AVT::VmbAPI::Examples::SharpnessMeasure;
+using AVT::VmbAPI::Examples::MotionResult;
+using AVT::VmbAPI::Examples::CalibrationFrameType;
 
 class CAsynchronousGrabDlg : public CDialog
 {
@@ -83,8 +99,29 @@ protected:
 private:
     // Our controller that wraps API access
     ApiController m_ApiController;
-    // A list of known camera IDs
-    std::vector<std::string> m_cameras;
+    // Messages of all threads, shown by the timer
+    AsyncLog m_Log;
+    // Limit the refresh of the picture boxes
+    DisplayScheduler m_Display;
+    DisplayScheduler m_Display2;
+    // Workers for image processing in the GUI
+    ThreadPool m_ProcessingPool;
+    // All cameras side by side in the third picture box
+    MosaicCompositor m_Mosaic;
+    bool m_bMosaicEnabled;
+    // The region of every camera shown zoomed in the overview, empty for none
+    CRect m_ZoomRoi;
+    CRect m_ZoomRoi2;
+    // Auto exposure was converged when the timer looked last
+    bool m_bAutoExposureConverged;
+    bool m_bAutoExposureConverged2;
+    // Filled by the timer, kept to not allocate every time
+    std::vector<SharpnessMeasure> m_FocusHistory;
+    std::vector<SharpnessMeasure> m_FocusHistory2;
+    std::vector<MotionResult> m_MotionEvents;
+    // Flat frames are being stacked, the timer builds the maps once they are in
+    bool m_bCalibrationPending;
+    bool m_bCalibrationPending2;
     // Are we streaming?
    // bool m_bIsStreaming;
 	 // Are we streaming?
@@ -96,9 +133,28 @@ private:
     bool m_ClearBackground;
 	bool m_ClearBackground2;
     //
-    // Queries and lists all known camera
+    // Lists all known cameras
     //
     void UpdateCameraListBox();
+
+    //
+    // Adds and removes the list entries of the cameras that changed
+    //
+    // Parameters:
+    //  [in]    rChanges        The cameras that showed up or went away
+    //
+    void UpdateCameraListBox( const std::vector<CameraChange> &rChanges );
+
+    //
+    // Gets the text a camera is listed with
+    //
+    // Parameters:
+    //  [in]    rInfo           The camera
+    //
+    // Returns:
+    //  Name and ID of the camera
+    //
+    static CString GetCameraListEntry( const CameraInfo &rInfo );
     void UpdateContronls();
     //
     // Prints out a given logging string, error code and the descriptive representation of that error code
@@ -116,22 +172,34 @@ private:
     //  [in]    strMsg          A given message to be printed out
     //
     void Log( string_type strMsg);
+
+    //
+    // Prints out a message of a category that may come in floods, e.g. once
+    // per frame. Only a few of them are shown, the rest is summed up.
+    //
+    // Parameters:
+    //  [in]    eCategory       The category the rate limit is kept for
+    //  [in]    strMsg          A given message to be printed out
+    //  [in]    eErr            The API status code
+    //
+    void Log( LogCategory eCategory, string_type strMsg, VmbErrorType eErr );
     
     //
     // Copies the content of a byte buffer to a MFC image with respect to the image's alignment
     //
     // Parameters:
-    //  [in]    pInbuffer       The byte buffer as received from the cam
+    //  [in]    pInbuffer       The image of the frame, as the pipeline stages left it
     //  [in]    ePixelFormat    The pixel format of the frame
     //  [out]   OutImage        The filled MFC image
     //
-    void CopyToImage( VmbUchar_t *pInBuffer, VmbPixelFormat_t PixelFormat, CImage &pOutImage );
-	void CopyToImage2( VmbUchar_t *pInBuffer, VmbPixelFormat_t PixelFormat, CImage &pOutImage );
+    void CopyToImage( const VmbUchar_t *pInBuffer, VmbPixelFormat_t PixelFormat, CImage &pOutImage );
+	void CopyToImage2( const VmbUchar_t *pInBuffer, VmbPixelFormat_t PixelFormat, CImage &pOutImage );
     // MFC Controls
     CListBox m_ListBoxCameras;
     CListBox m_ListLog;
     CButton m_ButtonStartStop;
     CStatic m_PictureBoxStream;
+    CStatic m_PictureBoxMosaic;
 public:
 	CStatic m_PictureBoxStream2;
 	CButton m_ButtonStartStop2;
@@ -150,5 +218,208 @@ public:
 	int packetSize2;
 	afx_msg void OnBnClickedBtOpencam2();
 	afx_msg void OnEnChangeEdit2();
+	afx_msg void OnTimer(UINT_PTR nIDEvent);
+	afx_msg void OnBnClickedCheckFramebus();
+	afx_msg void OnBnClickedBtOpenall();
+	afx_msg void OnBnClickedCheckMosaic();
+	afx_msg void OnLButtonDown(UINT nFlags, CPoint point);
+	afx_msg void OnBnClickedCheckAutoexposure1();
+	afx_msg void OnBnClickedCheckAutoexposure2();
+	afx_msg void OnBnClickedCheckMotion1();
+	afx_msg void OnBnClickedCheckMotion2();
+	afx_msg void OnBnClickedBtCaptureDark();
+	afx_msg void OnBnClickedBtCaptureFlat();
+	afx_msg void OnBnClickedCheckFlatfield();
+	afx_msg void OnBnClickedCheckDefects();
+	afx_msg void OnEnChangeEditAverage();
+	afx_msg void OnBnClickedCheckHdr();
+	afx_msg void OnBnClickedCheckUndistort();
+private:
+    //
+    // Shows fill rate and flush progress of the burst of a camera
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDStatic       The static text control to print to
+    //
+    void ArmBurstOnStart( int cameraIndex );
+    void FinishBurstOnStop( int cameraIndex );
+    void UpdateBurstStatus( int cameraIndex, int nIDStatic );
+
+    //
+    // Shows the readers of the shared frame buses and how far they lag behind
+    //
+    void UpdateFrameBusStatus();
+
+    //
+    // Shows how often a picture box is painted, how many conversions the
+    // refresh cap saves and the exposure of the last analysed frame
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDStatic       The static text control to print to
+    //
+    void UpdateDisplayStatus( int cameraIndex, int nIDStatic );
+
+    //
+    // Shows the sharpness of the last frame of a camera and the best one
+    // seen since the focus region was set
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDStatic       The static text control to print to
+    //
+    void UpdateFocusStatus( int cameraIndex, int nIDStatic );
+
+    //
+    // Turns auto exposure of a camera on or off as its check box says
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDCheck        The check box of the camera
+    //
+    void ToggleAutoExposure( int cameraIndex, int nIDCheck );
+
+    //
+    // Lets motion trigger the burst of a camera as its check box says
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDCheck        The check box of the camera
+    //
+    void ToggleMotionTrigger( int cameraIndex, int nIDCheck );
+
+    //
+    // Logs when motion in front of a camera started and stopped
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void ReportMotionEvents( int cameraIndex );
+
+    //
+    // Stacks calibration frames on every open camera
+    //
+    // Parameters:
+    //  [in]    eType           What the cameras look at
+    //
+    void CaptureCalibration( CalibrationFrameType eType );
+
+    //
+    // Builds and stores the flat-field maps and the defective pixels of a
+    // camera once its flat frames are stacked
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void FinishCalibration( int cameraIndex );
+
+    //
+    // Moves the exposure slider to what auto exposure wrote and logs when
+    // it converges
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rSlider         The exposure slider of the camera
+    //
+    void UpdateAutoExposure( int cameraIndex, CSliderCtrl &rSlider );
+
+    //
+    // Hands an exposure time from the slider to the feature writer. While the
+    // thumb is dragged the camera gets the value once it rests, letting go
+    // writes it at once. Taking the slider over ends auto exposure.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDCheck        The auto exposure check box of the camera
+    //  [in]    nSBCode         The scroll request of the slider
+    //  [in]    nPos            The exposure time in microseconds
+    //
+    void QueueExposure( int cameraIndex, int nIDCheck, UINT nSBCode, int nPos );
+
+    //
+    // Hands the packet size typed into an edit box to the feature writer.
+    // Every keystroke changes the number, only the one typed last is written.
+    // Numbers still being typed that are out of range are not queued, and
+    // the edit box is read directly so they do not bring up a message box.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    nIDEdit         The packet size edit box of the camera
+    //  [out]   rPacketSize     The packet size of the camera, set if valid
+    //
+    void QueuePacketSize( int cameraIndex, int nIDEdit, int &rPacketSize );
+
+    //
+    // Unchecks the HDR check box once no camera brackets any more
+    //
+    void UpdateHdrCheck();
+
+    //
+    // Logs the result of a feature write. Runs on the thread of the feature
+    // writer, so it only touches the log.
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rStrName        The name of the feature
+    //  [in]    rValue          The value written
+    //  [in]    eResult         The result of the write
+    //  [in]    dLatencyMs      The time from the first queued value to the write
+    //
+    void ReportFeatureWrite( int cameraIndex, const std::string &rStrName, const FeatureWriter::Value &rValue, VmbErrorType eResult, double dLatencyMs );
+
+    //
+    // Scales a frame into the tile of its camera and the zoomed region
+    // into the tile below, then repaints these tiles
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    pBuffer         The image of the frame, as the pipeline stages left it
+    //  [in]    ePixelFormat    The pixel format of the image
+    //
+    void ShowInMosaic( int cameraIndex, const VmbUchar_t *pBuffer, VmbPixelFormatType ePixelFormat );
+
+    //
+    // Centers the zoomed region of a camera on a point of its picture box
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //  [in]    rPictureBox     The picture box of the camera
+    //  [in]    point           The point in screen coordinates
+    //
+    // Returns:
+    //  false if the point is not on the image of the camera
+    //
+    bool SelectZoomRoi( int cameraIndex, CStatic &rPictureBox, CPoint point );
+
+    //
+    // Prints how long the command features took to complete so far
+    //
+    void LogCommandStatistics();
+
+    //
+    // Prints how long every stage of the pipeline of a camera took
+    //
+    // Parameters:
+    //  [in]    cameraIndex     The camera (1 or 2)
+    //
+    void LogPipelineStatistics( int cameraIndex );
+
+    //
+    // Prints the bandwidth share of every streaming camera and the drops
+    // the link model expects
+    //
+    void LogBandwidthPlan();
+
+    //
+    // Moves the messages logged since the last call to the log list box
+    // and keeps the list box from growing without bound
+    //
+    void DrainLog();
+
+    //
+    // Reopens unplugged cameras that are back and resumes their streams
+    //
+    void RecoverCameras();
 };
 
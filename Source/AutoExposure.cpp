@@ -0,0 +1,216 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AutoExposure.cpp
+
+  Description: Drives exposure time and gain of a camera towards a target
+               brightness, from the statistics of the frames it delivers.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <AutoExposure.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+double DbToFactor( double dDb )
+{
+    return std::pow( 10.0, dDb / 20.0 );
+}
+
+double FactorToDb( double dFactor )
+{
+    return 20.0 * std::log10( dFactor );
+}
+
+}
+
+// Brightness stays this far below where it clipped last
+static const double CLIP_CEILING_MARGIN = 0.85;
+// The ceiling is lifted this much per update without a single pixel at
+// full scale, so a scene that got darker is followed again
+static const double CLIP_CEILING_RECOVERY = 1.05;
+// Brightness factor applied when too many pixels clip, the mean says
+// nothing about how far above full scale they are
+static const double CLIP_BACK_OFF = 0.7;
+// Beyond this part of the pixels at full scale the largest step back is taken
+static const double CLIP_SATURATED = 0.5;
+// Settle frames are doubled after each reversal up to this many
+static const VmbUint32_t MAX_SETTLE_FRAMES = 16;
+
+AutoExposureSettings::AutoExposureSettings()
+    : dTarget( 0.45 )
+    , dTolerance( 0.05 )
+    , dMaxClipped( 0.01 )
+    , dMaxStep( 8.0 )
+    , nSettleFrames( 3 )
+    , dMinExposureUs( 10.0 )
+    , dMaxExposureUs( 100000.0 )
+    , dMinGainDb( 0.0 )
+    , dMaxGainDb( 0.0 )
+{
+}
+
+AutoExposureController::AutoExposureController( const AutoExposureSettings &settings )
+{
+    Reset( settings, settings.dMinExposureUs, settings.dMinGainDb );
+}
+
+//
+// Starts over from what the camera currently uses
+//
+// Parameters:
+//  [in]    settings        The limits and the target
+//  [in]    dExposureUs     The current exposure time
+//  [in]    dGainDb         The current gain
+//
+void AutoExposureController::Reset( const AutoExposureSettings &settings, double dExposureUs, double dGainDb )
+{
+    m_Settings          = settings;
+    m_dExposureUs       = dExposureUs;
+    m_dGainDb           = dGainDb;
+    m_bConverged        = false;
+    m_nSettledFrameID   = 0;
+    m_nLastDirection    = 0;
+    m_nSettleFrames     = settings.nSettleFrames;
+    m_dClipCeiling      = HUGE_VAL;
+}
+
+//
+// Looks at the statistics of a frame. Brightness is taken to follow
+// exposure time times gain, so one update usually gets close. Frames
+// taken before the last change settled are skipped.
+//
+// Parameters:
+//  [in]    rStatistics     The statistics of the frame
+//  [out]   rExposureUs     The new exposure time
+//  [out]   rGainDb         The new gain
+//
+// Returns:
+//  true if the camera should get the new values
+//
+bool AutoExposureController::Update( const ImageStatistics &rStatistics, double &rExposureUs, double &rGainDb )
+{
+    if(     rStatistics.nFrameID < m_nSettledFrameID
+        ||  0 == rStatistics.nPixels )
+    {
+        return false;
+    }
+
+    // Color images go by their green channel, it carries most of the luminance
+    const VmbUint32_t c = 3 == rStatistics.nChannels ? 1 : 0;
+    const double dFullScale = static_cast<double>( ( 1u << rStatistics.nBitDepth ) - 1 );
+    const double dMean = rStatistics.dMean[c] / dFullScale;
+    const double dClipped = static_cast<double>( rStatistics.nClippedHigh[c] ) / rStatistics.nPixels;
+    const double dBrightness = m_dExposureUs * DbToFactor( m_dGainDb );
+
+    double dFactor;
+    if( dClipped > m_Settings.dMaxClipped )
+    {
+        m_dClipCeiling = dBrightness;
+        dFactor = dClipped > CLIP_SATURATED ? 1.0 / m_Settings.dMaxStep
+                                            : (std::min)( CLIP_BACK_OFF, m_Settings.dTarget / (std::max)( dMean, 1.0 / dFullScale ) );
+    }
+    else
+    {
+        if( 0 == rStatistics.nClippedHigh[c] )
+        {
+            // The brightest pixel tells how far full scale is at least
+            const double dHeadroom = dFullScale / (std::max)( rStatistics.nMax[c], 1u );
+            m_dClipCeiling = (std::max)( m_dClipCeiling * CLIP_CEILING_RECOVERY, dBrightness * dHeadroom );
+        }
+        if( std::fabs( dMean - m_Settings.dTarget ) <= m_Settings.dTolerance * m_Settings.dTarget )
+        {
+            m_bConverged = true;
+            return false;
+        }
+        // A black frame gives no hint how far off it is
+        dFactor = m_Settings.dTarget / (std::max)( dMean, 1.0 / dFullScale );
+    }
+    dFactor = (std::max)( 1.0 / m_Settings.dMaxStep, (std::min)( m_Settings.dMaxStep, dFactor ) );
+    const int nDirection = dFactor > 1.0 ? 1 : -1;
+    if( 0 != m_nLastDirection && nDirection != m_nLastDirection )
+    {
+        // Turning back means the camera took longer than the settle
+        // frames, so wait longer and take half the step
+        dFactor = std::sqrt( dFactor );
+        m_nSettleFrames = (std::min)( MAX_SETTLE_FRAMES, (std::max)( m_nSettleFrames * 2, 1u ) );
+    }
+
+    const double dMinGain = DbToFactor( m_Settings.dMinGainDb );
+    const double dMaxGain = DbToFactor( m_Settings.dMaxGainDb );
+    double dNewBrightness = dBrightness * dFactor;
+    if( dFactor > 1.0 )
+    {
+        // Going back up to where it clipped would only clip again
+        dNewBrightness = (std::min)( dNewBrightness, (std::max)( dBrightness, m_dClipCeiling * CLIP_CEILING_MARGIN ) );
+    }
+    dNewBrightness = (std::max)( m_Settings.dMinExposureUs * dMinGain, (std::min)( m_Settings.dMaxExposureUs * dMaxGain, dNewBrightness ) );
+
+    // Exposure time first, gain adds noise
+    const double dNewExposureUs = (std::max)( m_Settings.dMinExposureUs, (std::min)( m_Settings.dMaxExposureUs, dNewBrightness / dMinGain ) );
+    const double dNewGain = (std::max)( dMinGain, (std::min)( dMaxGain, dNewBrightness / dNewExposureUs ) );
+    const double dNewGainDb = FactorToDb( dNewGain );
+    if(     std::fabs( dNewExposureUs - m_dExposureUs ) < 0.005 * m_dExposureUs
+        &&  std::fabs( dNewGainDb - m_dGainDb ) < 0.05 )
+    {
+        // A limit or the clip ceiling keeps it where it is
+        m_bConverged = true;
+        return false;
+    }
+
+    m_bConverged        = false;
+    m_nLastDirection    = nDirection;
+    m_dExposureUs       = dNewExposureUs;
+    m_dGainDb           = dNewGainDb;
+    m_nSettledFrameID   = rStatistics.nFrameID + 1 + m_nSettleFrames;
+    rExposureUs         = m_dExposureUs;
+    rGainDb             = m_dGainDb;
+    return true;
+}
+
+// The target is reached, or a limit keeps it from being reached
+bool AutoExposureController::IsConverged() const
+{
+    return m_bConverged;
+}
+
+double AutoExposureController::GetExposure() const
+{
+    return m_dExposureUs;
+}
+
+double AutoExposureController::GetGain() const
+{
+    return m_dGainDb;
+}
+
+const AutoExposureSettings& AutoExposureController::GetSettings() const
+{
+    return m_Settings;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
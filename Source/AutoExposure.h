@@ -0,0 +1,114 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        AutoExposure.h
+
+  Description: Drives exposure time and gain of a camera towards a target
+               brightness, from the statistics of the frames it delivers.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_AUTOEXPOSURE
+#define AVT_VMBAPI_EXAMPLES_AUTOEXPOSURE
+
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageStats.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+struct AutoExposureSettings
+{
+    // The mean as part of full scale
+    double          dTarget;
+    // Converged while the mean is within target * ( 1 +- tolerance )
+    double          dTolerance;
+    // The part of the pixels that may be at full scale
+    double          dMaxClipped;
+    // The largest brightness factor of one update
+    double          dMaxStep;
+    // Frames after a change that may still show the old exposure
+    VmbUint32_t     nSettleFrames;
+    double          dMinExposureUs;
+    double          dMaxExposureUs;
+    // Equal for cameras without gain
+    double          dMinGainDb;
+    double          dMaxGainDb;
+
+    AutoExposureSettings();
+};
+
+class AutoExposureController
+{
+  public:
+    explicit AutoExposureController( const AutoExposureSettings &settings = AutoExposureSettings() );
+
+    //
+    // Starts over from what the camera currently uses
+    //
+    // Parameters:
+    //  [in]    settings        The limits and the target
+    //  [in]    dExposureUs     The current exposure time
+    //  [in]    dGainDb         The current gain
+    //
+    void            Reset( const AutoExposureSettings &settings, double dExposureUs, double dGainDb );
+
+    //
+    // Looks at the statistics of a frame. Brightness is taken to follow
+    // exposure time times gain, so one update usually gets close. Frames
+    // taken before the last change settled are skipped.
+    //
+    // Parameters:
+    //  [in]    rStatistics     The statistics of the frame
+    //  [out]   rExposureUs     The new exposure time
+    //  [out]   rGainDb         The new gain
+    //
+    // Returns:
+    //  true if the camera should get the new values
+    //
+    bool            Update( const ImageStatistics &rStatistics, double &rExposureUs, double &rGainDb );
+
+    // The target is reached, or a limit keeps it from being reached
+    bool            IsConverged() const;
+    double          GetExposure() const;
+    double          GetGain() const;
+    const AutoExposureSettings& GetSettings() const;
+
+  private:
+    AutoExposureSettings    m_Settings;
+    double                  m_dExposureUs;
+    double                  m_dGainDb;
+    bool                    m_bConverged;
+    // Frames before this one were taken with the old values
+    VmbUint64_t             m_nSettledFrameID;
+    // +1 if the last change brightened, -1 if it darkened
+    int                     m_nLastDirection;
+    // Grows when the camera turns out slower than the settings say
+    VmbUint32_t             m_nSettleFrames;
+    // Exposure times gain that clipped, the controller stays below it
+    double                  m_dClipCeiling;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,185 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BandwidthPlanner.cpp
+
+  Description: Splits the bandwidth of shared GigE links between the cameras
+               streaming over them.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <BandwidthPlanner.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Frame rates vary a little, a camera gets this much more than it needs
+static const double DEMAND_MARGIN = 1.05;
+// Smallest sensible packet, anything below is mostly header
+static const VmbUint32_t MIN_PACKET_SIZE = 576;
+
+BandwidthPlanner::BandwidthPlanner()
+{
+}
+
+//
+// Adds or replaces a link. Cameras of an unknown link are planned on
+// a gigabit link of their own and keep their packet size.
+//
+// Parameters:
+//  [in]    rLink           The link description
+//
+void BandwidthPlanner::SetLink( const LinkDescription &rLink )
+{
+    m_Links[rLink.strLinkID] = rLink;
+}
+
+//
+// Gets the description of a link
+//
+// Parameters:
+//  [in]    rStrLinkID      The ID of the link
+//
+// Returns:
+//  The link, or the default gigabit link if it is unknown
+//
+LinkDescription BandwidthPlanner::GetLink( const std::string &rStrLinkID ) const
+{
+    std::map<std::string, LinkDescription>::const_iterator iter = m_Links.find( rStrLinkID );
+    return m_Links.end() != iter ? iter->second : GetDefaultLink( rStrLinkID );
+}
+
+//
+// Gets the number of bytes a frame occupies on the wire
+//
+// Parameters:
+//  [in]    nPayloadSize    The size of one frame in bytes
+//  [in]    nPacketSize     The packet size (GevSCPSPacketSize)
+//
+// Returns:
+//  The payload plus all per packet and per frame overhead
+//
+double BandwidthPlanner::GetWireBytesPerFrame( VmbInt64_t nPayloadSize, VmbUint32_t nPacketSize )
+{
+    const VmbUint32_t nDataPerPacket = nPacketSize > GVSP_PACKET_HEADER_BYTES ? nPacketSize - GVSP_PACKET_HEADER_BYTES : 1;
+    const VmbInt64_t nPackets = ( nPayloadSize + nDataPerPacket - 1 ) / nDataPerPacket;
+    return static_cast<double>( nPayloadSize )
+           + static_cast<double>( nPackets ) * ( GVSP_PACKET_HEADER_BYTES + ETHERNET_OVERHEAD_BYTES )
+           + GVSP_FRAME_OVERHEAD_BYTES;
+}
+
+//
+// Plans all streaming cameras. Cameras of one link get max-min fair
+// shares: a camera that needs less than its share gets its demand,
+// the rest is split evenly among the others.
+//
+// Parameters:
+//  [in]    rDemands        The cameras that stream
+//  [out]   rAllocations    One allocation per demand, in the same order
+//
+void BandwidthPlanner::Plan( const std::vector<StreamDemand> &rDemands, std::vector<StreamAllocation> &rAllocations ) const
+{
+    rAllocations.assign( rDemands.size(), StreamAllocation() );
+
+    // The packet size comes first, it decides the overhead of the demand
+    std::vector<double> wireDemand( rDemands.size(), 0.0 );
+    std::map< std::string, std::vector<size_t> > cameraIndicesByLink;
+    for( size_t i = 0; i < rDemands.size(); ++i )
+    {
+        const StreamDemand &rDemand = rDemands[i];
+        const LinkDescription link = GetLink( rDemand.strLinkID );
+        StreamAllocation &rAllocation = rAllocations[i];
+
+        rAllocation.strCameraID = rDemand.strCameraID;
+        if( rDemand.bPacketSizeLocked )
+        {
+            rAllocation.nPacketSize = rDemand.nCurrentPacketSize;
+        }
+        else if( m_Links.end() != m_Links.find( rDemand.strLinkID ) )
+        {
+            // Larger packets mean less overhead, as long as the link carries them
+            rAllocation.nPacketSize = (std::max)( MIN_PACKET_SIZE, (std::min)( rDemand.nMaxPacketSize, link.nMtu ) );
+        }
+        else
+        {
+            // Nothing is known about the link, the size the camera found
+            // on its path is the best there is
+            rAllocation.nPacketSize = rDemand.nMaxPacketSize;
+        }
+        wireDemand[i] = GetWireBytesPerFrame( rDemand.nPayloadSize, rAllocation.nPacketSize ) * rDemand.dTargetFps * DEMAND_MARGIN;
+        cameraIndicesByLink[rDemand.strLinkID].push_back( i );
+    }
+
+    for(    std::map< std::string, std::vector<size_t> >::const_iterator linkIter = cameraIndicesByLink.begin();
+            cameraIndicesByLink.end() != linkIter;
+            ++linkIter )
+    {
+        const LinkDescription link = GetLink( linkIter->first );
+        std::vector<size_t> cameraIndices = linkIter->second;
+
+        // Water filling: serve the smallest demands first, whatever is left
+        // is shared evenly by the cameras that want more
+        std::sort(  cameraIndices.begin(), cameraIndices.end(),
+                    [&wireDemand]( size_t a, size_t b ) { return wireDemand[a] < wireDemand[b]; } );
+        double dRemaining = link.dBytesPerSecond * ( 1.0 - link.dHeadroom );
+        for( size_t n = 0; n < cameraIndices.size(); ++n )
+        {
+            const size_t i = cameraIndices[n];
+            const double dFairShare = dRemaining / static_cast<double>( cameraIndices.size() - n );
+            const double dWireRate = (std::min)( wireDemand[i], dFairShare );
+            dRemaining -= dWireRate;
+
+            const StreamDemand &rDemand = rDemands[i];
+            StreamAllocation &rAllocation = rAllocations[i];
+            const double dPacketWireBytes = static_cast<double>( rAllocation.nPacketSize ) + ETHERNET_OVERHEAD_BYTES;
+            rAllocation.dWireBytesPerSecond = dWireRate;
+            rAllocation.bDemandMet = ( dWireRate >= wireDemand[i] );
+            rAllocation.dExpectedFps = (std::min)(  rDemand.dTargetFps,
+                                                    dWireRate / GetWireBytesPerFrame( rDemand.nPayloadSize, rAllocation.nPacketSize ) );
+            // StreamBytesPerSecond counts from the IP header on
+            rAllocation.nStreamBytesPerSecond = static_cast<VmbInt64_t>( dWireRate * rAllocation.nPacketSize / dPacketWireBytes );
+            // Packets leave the camera at line rate, the delay stretches
+            // the gap between them to the allocated rate
+            double dDelaySeconds = 0.0;
+            if( dWireRate > 0.0 )
+            {
+                dDelaySeconds = dPacketWireBytes / dWireRate - dPacketWireBytes / link.dBytesPerSecond;
+            }
+            rAllocation.nInterPacketDelay = static_cast<VmbInt64_t>( std::floor( (std::max)( 0.0, dDelaySeconds ) * rDemand.dTickFrequency ) );
+        }
+    }
+}
+
+LinkDescription BandwidthPlanner::GetDefaultLink( const std::string &rStrLinkID )
+{
+    LinkDescription link;
+    link.strLinkID          = rStrLinkID;
+    link.dBytesPerSecond    = 125000000.0;
+    link.nMtu               = 1500;
+    link.dHeadroom          = 0.1;
+    link.nSwitchBufferBytes = 256 * 1024;
+    return link;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,159 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BandwidthPlanner.h
+
+  Description: Splits the bandwidth of shared GigE links between the cameras
+               streaming over them. Cameras behind one switch share a single
+               gigabit uplink; if together they send more than it carries,
+               the switch drops packets and every camera suffers resends.
+               The planner computes for every camera the packet size,
+               StreamBytesPerSecond and inter-packet delay (GevSCPD) so that
+               the link is shared max-min fair.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_BANDWIDTHPLANNER
+#define AVT_VMBAPI_EXAMPLES_BANDWIDTHPLANNER
+
+#include <string>
+#include <vector>
+#include <map>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// IP, UDP and GVSP headers, counted in GevSCPSPacketSize
+const VmbUint32_t GVSP_PACKET_HEADER_BYTES  = 36;
+// Ethernet header, FCS, preamble and inter frame gap, on the wire only
+const VmbUint32_t ETHERNET_OVERHEAD_BYTES   = 38;
+// Leader and trailer packet of every frame including all overhead
+const VmbUint32_t GVSP_FRAME_OVERHEAD_BYTES = 2 * ( 64 + ETHERNET_OVERHEAD_BYTES );
+
+// A link several cameras share, e.g. the uplink of a switch
+struct LinkDescription
+{
+    std::string     strLinkID;
+    // The line rate, 125000000 for gigabit Ethernet
+    double          dBytesPerSecond;
+    // The largest packet the link carries, 1500 or a jumbo frame size
+    VmbUint32_t     nMtu;
+    // The fraction of the line rate kept free, 0.1 leaves 10%
+    double          dHeadroom;
+    // The egress buffer of the switch port in bytes
+    VmbUint32_t     nSwitchBufferBytes;
+};
+
+// What a camera would like to send
+struct StreamDemand
+{
+    std::string     strCameraID;
+    std::string     strLinkID;
+    // The size of one frame in bytes (PayloadSize)
+    VmbInt64_t      nPayloadSize;
+    double          dTargetFps;
+    // The largest packet size to plan with, the size the camera was
+    // adjusted to on open
+    VmbUint32_t     nMaxPacketSize;
+    // The packet size in use, kept if it cannot be changed
+    VmbUint32_t     nCurrentPacketSize;
+    // Packet size cannot be changed while the camera streams
+    bool            bPacketSizeLocked;
+    // The camera's GevSCPD unit in ticks per second
+    double          dTickFrequency;
+};
+
+// What a camera is allowed to send
+struct StreamAllocation
+{
+    std::string     strCameraID;
+    VmbUint32_t     nPacketSize;
+    // The rate at IP level, the unit of StreamBytesPerSecond
+    VmbInt64_t      nStreamBytesPerSecond;
+    // The gap between two packets in GevSCPD ticks
+    VmbInt64_t      nInterPacketDelay;
+    // The rate on the wire including all overhead
+    double          dWireBytesPerSecond;
+    // The frame rate reached with this allocation
+    double          dExpectedFps;
+    // false if the camera had to be throttled below its target
+    bool            bDemandMet;
+};
+
+class BandwidthPlanner
+{
+  public:
+    BandwidthPlanner();
+
+    //
+    // Adds or replaces a link. Cameras of an unknown link are planned on
+    // a gigabit link of their own and keep their packet size.
+    //
+    // Parameters:
+    //  [in]    rLink           The link description
+    //
+    void SetLink( const LinkDescription &rLink );
+
+    //
+    // Gets the description of a link
+    //
+    // Parameters:
+    //  [in]    rStrLinkID      The ID of the link
+    //
+    // Returns:
+    //  The link, or the default gigabit link if it is unknown
+    //
+    LinkDescription GetLink( const std::string &rStrLinkID ) const;
+
+    //
+    // Plans all streaming cameras. Cameras of one link get max-min fair
+    // shares: a camera that needs less than its share gets its demand,
+    // the rest is split evenly among the others.
+    //
+    // Parameters:
+    //  [in]    rDemands        The cameras that stream
+    //  [out]   rAllocations    One allocation per demand, in the same order
+    //
+    void Plan( const std::vector<StreamDemand> &rDemands, std::vector<StreamAllocation> &rAllocations ) const;
+
+    //
+    // Gets the number of bytes a frame occupies on the wire
+    //
+    // Parameters:
+    //  [in]    nPayloadSize    The size of one frame in bytes
+    //  [in]    nPacketSize     The packet size (GevSCPSPacketSize)
+    //
+    // Returns:
+    //  The payload plus all per packet and per frame overhead
+    //
+    static double GetWireBytesPerFrame( VmbInt64_t nPayloadSize, VmbUint32_t nPacketSize );
+
+  private:
+    static LinkDescription GetDefaultLink( const std::string &rStrLinkID );
+
+    std::map<std::string, LinkDescription> m_Links;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
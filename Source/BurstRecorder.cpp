@@ -0,0 +1,309 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BurstRecorder.cpp
+
+  Description: Captures a burst of frames into a preallocated RAM arena and
+               flushes it to disk in the background once the burst is over.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <cstring>
+#include <new>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <BurstRecorder.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+BurstRecorder::BurstRecorder()
+    : m_nSlotBytes( 0 )
+    , m_nCapacity( 0 )
+    , m_MaxDuration( clock_type::duration::zero() )
+    , m_eState( StateIdle )
+    , m_nFrameCount( 0 )
+    , m_nWritersInFlight( 0 )
+    , m_nFlushedCount( 0 )
+    , m_nFirstFrameTicks( 0 )
+    , m_nLastFrameTicks( 0 )
+    , m_bFlushRequested( false )
+    , m_bShutDown( false )
+{
+    m_FlushThread = std::thread( &BurstRecorder::FlushThread, this );
+}
+
+BurstRecorder::~BurstRecorder()
+{
+    // Write out what has been captured so far before going away
+    Finish();
+    {
+        std::lock_guard<std::mutex> lock( m_FlushMutex );
+        m_bShutDown = true;
+    }
+    m_FlushCondition.notify_one();
+    m_FlushThread.join();
+}
+
+//
+// Reserves the arena for a new burst. All memory needed for the burst is
+// allocated here so that recording itself never allocates.
+//
+// Parameters:
+//  [in]    nFrameBytes     The size of one frame in bytes (PayloadSize)
+//  [in]    nMaxFrames      The number of frames to capture
+//  [in]    nMaxDurationMs  The maximum length of the burst, 0 for no limit
+//  [in]    rStrFilePrefix  The prefix of the files the burst is flushed to
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType BurstRecorder::Arm( VmbUint32_t nFrameBytes, VmbUint32_t nMaxFrames, VmbUint32_t nMaxDurationMs, const std::string &rStrFilePrefix )
+{
+    if(     0 == nFrameBytes
+        ||  0 == nMaxFrames )
+    {
+        return VmbErrorBadParameter;
+    }
+    // The arena is still in use by a running burst, by the flush thread or
+    // by another thread arming it. Arm is called from the UI and from the
+    // motion trigger, only the caller that leaves the idle state may touch
+    // the arena.
+    int eState = StateIdle;
+    if( false == m_eState.compare_exchange_strong( eState, StateArming ) )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if( 0 != m_nWritersInFlight.load() )
+    {
+        m_eState.store( StateIdle );
+        return VmbErrorInvalidCall;
+    }
+
+    try
+    {
+        m_Arena.resize( static_cast<size_t>( nFrameBytes ) * nMaxFrames );
+        m_SlotFrameIDs.resize( nMaxFrames );
+        m_SlotSizes.resize( nMaxFrames );
+    }
+    catch( const std::bad_alloc & )
+    {
+        m_Arena.clear();
+        m_Arena.shrink_to_fit();
+        m_eState.store( StateIdle );
+        return VmbErrorResources;
+    }
+
+    m_nSlotBytes    = nFrameBytes;
+    m_nCapacity     = nMaxFrames;
+    m_MaxDuration   = std::chrono::milliseconds( nMaxDurationMs );
+    m_strFilePrefix = rStrFilePrefix;
+    m_nFrameCount.store( 0 );
+    m_nFlushedCount.store( 0 );
+    m_nFirstFrameTicks.store( 0 );
+    m_nLastFrameTicks.store( 0 );
+    // Publishes the arena, capacity and duration to the frame callback
+    m_eState.store( StateArmed );
+
+    return VmbErrorSuccess;
+}
+
+//
+// Copies a frame into the arena. Called from the frame callback.
+// Every camera has its own recorder, so there is only one caller at a time.
+//
+// Parameters:
+//  [in]    pBuffer         The image data of the frame
+//  [in]    nSize           The size of the image data in bytes
+//  [in]    nFrameID        The frame ID as reported by the camera
+//
+// Returns:
+//  true if the frame was stored in the arena
+//
+bool BurstRecorder::Record( const VmbUchar_t *pBuffer, VmbUint32_t nSize, VmbUint64_t nFrameID )
+{
+    int eState = m_eState.load( std::memory_order_acquire );
+    if(     StateArmed != eState
+        &&  StateCapturing != eState )
+    {
+        return false;
+    }
+
+    // Announce the copy before looking at the state again so that the flush
+    // thread never starts on a slot that is still being written
+    ++m_nWritersInFlight;
+    eState = m_eState.load( std::memory_order_acquire );
+    if(     StateArmed != eState
+        &&  StateCapturing != eState )
+    {
+        --m_nWritersInFlight;
+        return false;
+    }
+
+    const clock_type::rep nNow = clock_type::now().time_since_epoch().count();
+    if( StateArmed == eState )
+    {
+        // The first frame starts the burst
+        m_nFirstFrameTicks.store( nNow );
+        if( false == m_eState.compare_exchange_strong( eState, StateCapturing ) )
+        {
+            // Disarmed in the meantime
+            --m_nWritersInFlight;
+            return false;
+        }
+    }
+    else if(    clock_type::duration::zero() != m_MaxDuration
+             && clock_type::duration( nNow - m_nFirstFrameTicks.load() ) > m_MaxDuration )
+    {
+        // Time is up
+        --m_nWritersInFlight;
+        Finish();
+        return false;
+    }
+
+    const VmbUint32_t nSlot = m_nFrameCount.load( std::memory_order_relaxed );
+    if( nSlot >= m_nCapacity )
+    {
+        --m_nWritersInFlight;
+        Finish();
+        return false;
+    }
+
+    const VmbUint32_t nBytes = nSize < m_nSlotBytes ? nSize : m_nSlotBytes;
+    memcpy( &m_Arena[ static_cast<size_t>( nSlot ) * m_nSlotBytes ], pBuffer, nBytes );
+    m_SlotFrameIDs[nSlot]   = nFrameID;
+    m_SlotSizes[nSlot]      = nBytes;
+    m_nLastFrameTicks.store( nNow );
+    m_nFrameCount.store( nSlot + 1, std::memory_order_release );
+    --m_nWritersInFlight;
+
+    // The arena is full
+    if( nSlot + 1 == m_nCapacity )
+    {
+        Finish();
+    }
+    return true;
+}
+
+//
+// Ends the burst and hands the captured frames over to the flush thread.
+// An armed burst that did not see any frame is simply disarmed.
+//
+void BurstRecorder::Finish()
+{
+    int eState = StateArmed;
+    if( m_eState.compare_exchange_strong( eState, StateIdle ) )
+    {
+        return;
+    }
+    eState = StateCapturing;
+    if( m_eState.compare_exchange_strong( eState, StateFlushing ) )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_FlushMutex );
+            m_bFlushRequested = true;
+        }
+        m_FlushCondition.notify_one();
+    }
+}
+
+BurstRecorder::StateType BurstRecorder::GetState() const
+{
+    return static_cast<StateType>( m_eState.load() );
+}
+
+VmbUint32_t BurstRecorder::GetCapacity() const
+{
+    return m_nCapacity;
+}
+
+VmbUint32_t BurstRecorder::GetFrameCount() const
+{
+    return m_nFrameCount.load();
+}
+
+VmbUint32_t BurstRecorder::GetFlushedCount() const
+{
+    return m_nFlushedCount.load();
+}
+
+//
+// Gets the rate the arena is filled at
+//
+// Returns:
+//  The captured frames per second since the first frame of the burst
+//
+double BurstRecorder::GetFillRate() const
+{
+    const VmbUint32_t nFrames = m_nFrameCount.load();
+    if( nFrames < 2 )
+    {
+        return 0.0;
+    }
+    const clock_type::duration elapsed( m_nLastFrameTicks.load() - m_nFirstFrameTicks.load() );
+    const double dSeconds = std::chrono::duration<double>( elapsed ).count();
+    return dSeconds > 0.0 ? ( nFrames - 1 ) / dSeconds : 0.0;
+}
+
+//
+// Writes every finished burst to disk, one raw file per frame
+//
+void BurstRecorder::FlushThread()
+{
+    for( ;; )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_FlushMutex );
+            m_FlushCondition.wait( lock, [this] { return m_bFlushRequested || m_bShutDown; } );
+            if( false == m_bFlushRequested )
+            {
+                return;
+            }
+            m_bFlushRequested = false;
+        }
+
+        // Let a frame that is still being copied complete
+        while( 0 != m_nWritersInFlight.load() )
+        {
+            std::this_thread::yield();
+        }
+
+        const VmbUint32_t nFrames = m_nFrameCount.load( std::memory_order_acquire );
+        for( VmbUint32_t i = 0; i < nFrames; ++i )
+        {
+            std::ostringstream strFileName;
+            strFileName << m_strFilePrefix << "_" << std::setw( 8 ) << std::setfill( '0' ) << m_SlotFrameIDs[i] << ".raw";
+            std::ofstream file( strFileName.str().c_str(), std::ios::binary );
+            if( file )
+            {
+                file.write( reinterpret_cast<const char*>( &m_Arena[ static_cast<size_t>( i ) * m_nSlotBytes ] ), m_SlotSizes[i] );
+            }
+            ++m_nFlushedCount;
+        }
+
+        // The arena may be armed again
+        m_eState.store( StateIdle );
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
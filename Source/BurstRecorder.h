@@ -0,0 +1,143 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        BurstRecorder.h
+
+  Description: Captures a burst of frames into a preallocated RAM arena and
+               flushes it to disk in the background once the burst is over.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_BURSTRECORDER
+#define AVT_VMBAPI_EXAMPLES_BURSTRECORDER
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class BurstRecorder
+{
+  public:
+    enum StateType
+    {
+        StateIdle,          // Nothing armed, arena may be reused
+        StateArming,        // Arena is being reserved by one caller of Arm
+        StateArmed,         // Arena reserved, waiting for the first frame
+        StateCapturing,     // Frames are being copied into the arena
+        StateFlushing,      // Burst is over, arena is written to disk
+    };
+
+    BurstRecorder();
+    ~BurstRecorder();
+
+    //
+    // Reserves the arena for a new burst. All memory needed for the burst is
+    // allocated here so that recording itself never allocates.
+    //
+    // Parameters:
+    //  [in]    nFrameBytes     The size of one frame in bytes (PayloadSize)
+    //  [in]    nMaxFrames      The number of frames to capture
+    //  [in]    nMaxDurationMs  The maximum length of the burst, 0 for no limit
+    //  [in]    rStrFilePrefix  The prefix of the files the burst is flushed to
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType Arm( VmbUint32_t nFrameBytes, VmbUint32_t nMaxFrames, VmbUint32_t nMaxDurationMs, const std::string &rStrFilePrefix );
+
+    //
+    // Copies a frame into the arena. Called from the frame callback.
+    //
+    // Parameters:
+    //  [in]    pBuffer         The image data of the frame
+    //  [in]    nSize           The size of the image data in bytes
+    //  [in]    nFrameID        The frame ID as reported by the camera
+    //
+    // Returns:
+    //  true if the frame was stored in the arena
+    //
+    bool Record( const VmbUchar_t *pBuffer, VmbUint32_t nSize, VmbUint64_t nFrameID );
+
+    //
+    // Ends the burst and hands the captured frames over to the flush thread.
+    // An armed burst that did not see any frame is simply disarmed.
+    //
+    void Finish();
+
+    StateType   GetState() const;
+    VmbUint32_t GetCapacity() const;
+    VmbUint32_t GetFrameCount() const;
+    VmbUint32_t GetFlushedCount() const;
+
+    //
+    // Gets the rate the arena is filled at
+    //
+    // Returns:
+    //  The captured frames per second since the first frame of the burst
+    //
+    double      GetFillRate() const;
+
+  private:
+    typedef std::chrono::steady_clock clock_type;
+
+    void FlushThread();
+
+    // The arena, sized once on Arm
+    std::vector<VmbUchar_t>     m_Arena;
+    // Frame ID and valid byte count of every arena slot
+    std::vector<VmbUint64_t>    m_SlotFrameIDs;
+    std::vector<VmbUint32_t>    m_SlotSizes;
+    VmbUint32_t                 m_nSlotBytes;
+    VmbUint32_t                 m_nCapacity;
+    clock_type::duration        m_MaxDuration;
+    std::string                 m_strFilePrefix;
+
+    std::atomic<int>            m_eState;
+    // Frames completely copied into the arena
+    std::atomic<VmbUint32_t>    m_nFrameCount;
+    // Number of Record calls currently copying into the arena
+    std::atomic<int>            m_nWritersInFlight;
+    std::atomic<VmbUint32_t>    m_nFlushedCount;
+    // Time of the first frame and of the last stored frame in ticks of clock_type
+    std::atomic<clock_type::rep> m_nFirstFrameTicks;
+    std::atomic<clock_type::rep> m_nLastFrameTicks;
+
+    // The flush thread lives as long as the recorder so that ending a burst
+    // never has to create a thread
+    std::thread                 m_FlushThread;
+    std::mutex                  m_FlushMutex;
+    std::condition_variable     m_FlushCondition;
+    bool                        m_bFlushRequested;
+    bool                        m_bShutDown;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
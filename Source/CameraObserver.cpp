@@ -33,6 +33,15 @@ namespace AVT {
 namespace VmbAPI {
 namespace Examples {
 
+//
+// Parameters:
+//  [in]    pRegistry       Receives the plug events as deltas
+//
+CameraObserver::CameraObserver( CameraRegistry *pRegistry )
+    : m_pRegistry( pRegistry )
+{
+}
+
 //
 // This is our callback routine that will be executed every time a camera was plugged in or out
 //
@@ -45,6 +54,11 @@ void CameraObserver::CameraListChanged( CameraPtr pCam, UpdateTriggerType reason
     if (    UpdateTriggerPluggedIn == reason
          || UpdateTriggerPluggedOut == reason )
     {
+        // The camera travels with the event, so the UI only looks at what changed
+        if( NULL != m_pRegistry )
+        {
+            m_pRegistry->QueueChange( pCam, reason );
+        }
         CWinApp *pApp = AfxGetApp();
         if ( NULL != pApp )
         {
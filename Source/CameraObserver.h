@@ -30,6 +30,7 @@
 #define AVT_VMBAPI_EXAMPLES_CAMERAOBSERVER
 
 #include "VimbaCPP/Include/VimbaCPP.h"
+#include "CameraRegistry.h"
 
 namespace AVT {
 namespace VmbAPI {
@@ -40,6 +41,12 @@ namespace Examples {
 class CameraObserver : virtual public ICameraListObserver
 {
   public:
+    //
+    // Parameters:
+    //  [in]    pRegistry       Receives the plug events as deltas
+    //
+    explicit CameraObserver( CameraRegistry *pRegistry );
+
     //
     // This is our callback routine that will be executed every time a camera was plugged in or out
     //
@@ -48,6 +55,9 @@ class CameraObserver : virtual public ICameraListObserver
     //  [in]    reason          The reason why the callback was triggered
     //
     virtual void CameraListChanged( CameraPtr pCamera, UpdateTriggerType reason );
+
+  private:
+    CameraRegistry *m_pRegistry;
 };
 
 }}} // namespace AVT::VmbAPI::Examples
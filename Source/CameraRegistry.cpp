@@ -0,0 +1,313 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraRegistry.cpp
+
+  Description: The connected cameras, indexed by camera ID and kept current
+               by applying plug events as deltas.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <CameraRegistry.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+CameraRegistry::CameraRegistry()
+    : m_nQueries( 0 )
+{
+}
+
+//
+// Replaces the content with a full enumeration, done once at startup
+//
+// Parameters:
+//  [in]    rCameras        All cameras known to Vimba
+//
+void CameraRegistry::Populate( const CameraPtrVector &rCameras )
+{
+    std::vector<CameraInfo> infos;
+    for( CameraPtrVector::const_iterator iter = rCameras.begin(); rCameras.end() != iter; ++iter )
+    {
+        CameraInfo info;
+        // If for any reason we cannot get the ID of a camera we skip it
+        if( QueryInfo( *iter, info ) )
+        {
+            infos.push_back( info );
+        }
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Cameras.clear();
+    m_SerialIndex.clear();
+    for( size_t i = 0; i < infos.size(); ++i )
+    {
+        Add( infos[i] );
+    }
+}
+
+//
+// Queues a plug event. Called from the Vimba thread, cheap and
+// without any camera access.
+//
+// Parameters:
+//  [in]    pCamera         The camera that triggered the event
+//  [in]    reason          Plugged in or out
+//
+void CameraRegistry::QueueChange( const CameraPtr &pCamera, UpdateTriggerType reason )
+{
+    std::lock_guard<std::mutex> lock( m_PendingMutex );
+    m_PendingChanges.push_back( std::make_pair( pCamera, reason ) );
+}
+
+//
+// Applies all queued plug events. Only the cameras that changed are
+// queried.
+//
+// Parameters:
+//  [out]   rChanges        The changes that were applied
+//
+void CameraRegistry::ApplyChanges( std::vector<CameraChange> &rChanges )
+{
+    rChanges.clear();
+    std::deque< std::pair<CameraPtr, UpdateTriggerType> > pending;
+    {
+        std::lock_guard<std::mutex> lock( m_PendingMutex );
+        pending.swap( m_PendingChanges );
+    }
+
+    for( size_t i = 0; i < pending.size(); ++i )
+    {
+        const CameraPtr &pCamera = pending[i].first;
+        CameraChange change;
+        change.eReason = pending[i].second;
+        if( SP_ISNULL( pCamera ) )
+        {
+            continue;
+        }
+
+        if( UpdateTriggerPluggedIn == change.eReason )
+        {
+            if( !QueryInfo( pCamera, change.info ) )
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            Add( change.info );
+        }
+        else if( UpdateTriggerPluggedOut == change.eReason )
+        {
+            // The camera object still knows its ID, everything else comes
+            // from the registry
+            std::string strCameraID;
+            if( VmbErrorSuccess != SP_ACCESS( pCamera )->GetID( strCameraID ) )
+            {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock( m_Mutex );
+            CameraMap::iterator iter = m_Cameras.find( strCameraID );
+            if( m_Cameras.end() == iter )
+            {
+                continue;
+            }
+            change.info = iter->second;
+            m_SerialIndex.erase( iter->second.strSerialNumber );
+            m_Cameras.erase( iter );
+        }
+        else
+        {
+            continue;
+        }
+        rChanges.push_back( change );
+    }
+}
+
+//
+// Looks up a connected camera
+//
+// Parameters:
+//  [in]    rStrCameraID    The ID of the camera
+//  [out]   rInfo           The camera
+//
+// Returns:
+//  false if no such camera is connected
+//
+bool CameraRegistry::Find( const std::string &rStrCameraID, CameraInfo &rInfo ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    CameraMap::const_iterator iter = m_Cameras.find( rStrCameraID );
+    if( m_Cameras.end() == iter )
+    {
+        return false;
+    }
+    rInfo = iter->second;
+    return true;
+}
+
+bool CameraRegistry::Contains( const std::string &rStrCameraID ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_Cameras.end() != m_Cameras.find( rStrCameraID );
+}
+
+//
+// Gets all connected cameras, ordered by camera ID
+//
+void CameraRegistry::GetCameras( std::vector<CameraInfo> &rCameras ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    rCameras.clear();
+    rCameras.reserve( m_Cameras.size() );
+    for( CameraMap::const_iterator iter = m_Cameras.begin(); m_Cameras.end() != iter; ++iter )
+    {
+        rCameras.push_back( iter->second );
+    }
+}
+
+size_t CameraRegistry::GetCount() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_Cameras.size();
+}
+
+//
+// Gets the camera of a slot. A slot stays bound to the serial number of
+// its camera; an unbound slot, or one whose camera is gone, takes the
+// first camera no other slot is bound to.
+//
+// Parameters:
+//  [in]    nSlot           The slot (camera 1 or 2)
+//  [out]   rStrCameraID    The ID of the camera for this slot
+//
+// Returns:
+//  false if there is no camera left for this slot
+//
+bool CameraRegistry::ResolveSlot( int nSlot, std::string &rStrCameraID )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    std::map<int, std::string>::const_iterator binding = m_SlotBindings.find( nSlot );
+    if( m_SlotBindings.end() != binding )
+    {
+        std::map<std::string, std::string>::const_iterator serial = m_SerialIndex.find( binding->second );
+        if( m_SerialIndex.end() != serial )
+        {
+            rStrCameraID = serial->second;
+            return true;
+        }
+    }
+
+    for( CameraMap::const_iterator iter = m_Cameras.begin(); m_Cameras.end() != iter; ++iter )
+    {
+        if( !IsSerialBound( iter->second.strSerialNumber, nSlot ) )
+        {
+            m_SlotBindings[nSlot] = iter->second.strSerialNumber;
+            rStrCameraID = iter->first;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Binds a slot to the serial number of a camera
+//
+// Parameters:
+//  [in]    nSlot           The slot (camera 1 or 2)
+//  [in]    rStrCameraID    The ID of a connected camera
+//
+void CameraRegistry::BindSlot( int nSlot, const std::string &rStrCameraID )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    CameraMap::const_iterator iter = m_Cameras.find( rStrCameraID );
+    if( m_Cameras.end() != iter )
+    {
+        m_SlotBindings[nSlot] = iter->second.strSerialNumber;
+    }
+}
+
+//
+// Gets how many property queries went to the cameras so far
+//
+VmbUint64_t CameraRegistry::GetQueryCount() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_nQueries;
+}
+
+bool CameraRegistry::QueryInfo( const CameraPtr &pCamera, CameraInfo &rInfo )
+{
+    // Five properties per camera, counted for the statistics
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_nQueries += 5;
+    }
+    rInfo.pCamera = pCamera;
+    if( VmbErrorSuccess != SP_ACCESS( pCamera )->GetID( rInfo.strCameraID ) )
+    {
+        return false;
+    }
+    if( VmbErrorSuccess != SP_ACCESS( pCamera )->GetName( rInfo.strName ) )
+    {
+        rInfo.strName = "[NoName]";
+    }
+    if( VmbErrorSuccess != SP_ACCESS( pCamera )->GetModel( rInfo.strModel ) )
+    {
+        rInfo.strModel.clear();
+    }
+    if(     VmbErrorSuccess != SP_ACCESS( pCamera )->GetSerialNumber( rInfo.strSerialNumber )
+        ||  rInfo.strSerialNumber.empty() )
+    {
+        rInfo.strSerialNumber = rInfo.strCameraID;
+    }
+    if( VmbErrorSuccess != SP_ACCESS( pCamera )->GetInterfaceID( rInfo.strInterfaceID ) )
+    {
+        rInfo.strInterfaceID.clear();
+    }
+    return true;
+}
+
+void CameraRegistry::Add( const CameraInfo &rInfo )
+{
+    // A camera reported twice simply replaces its entry
+    CameraMap::iterator iter = m_Cameras.find( rInfo.strCameraID );
+    if( m_Cameras.end() != iter )
+    {
+        m_SerialIndex.erase( iter->second.strSerialNumber );
+    }
+    m_Cameras[rInfo.strCameraID] = rInfo;
+    m_SerialIndex[rInfo.strSerialNumber] = rInfo.strCameraID;
+}
+
+bool CameraRegistry::IsSerialBound( const std::string &rStrSerialNumber, int nExceptSlot ) const
+{
+    for( std::map<int, std::string>::const_iterator iter = m_SlotBindings.begin(); m_SlotBindings.end() != iter; ++iter )
+    {
+        if( iter->first != nExceptSlot && iter->second == rStrSerialNumber )
+        {
+            // Reserved only while that camera is connected
+            return m_SerialIndex.end() != m_SerialIndex.find( rStrSerialNumber );
+        }
+    }
+    return false;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,166 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraRegistry.h
+
+  Description: The connected cameras, indexed by camera ID. Static camera
+               properties are queried once when a camera shows up; plug
+               events are queued by the camera list observer and applied as
+               deltas, so keeping the list current costs per change instead
+               of per camera. The camera slots of the example are bound to
+               serial numbers and keep their camera across replugs.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERAREGISTRY
+#define AVT_VMBAPI_EXAMPLES_CAMERAREGISTRY
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The static properties of a camera, queried once
+struct CameraInfo
+{
+    std::string     strCameraID;
+    std::string     strName;
+    std::string     strModel;
+    // The serial number, the camera ID if the camera has none
+    std::string     strSerialNumber;
+    std::string     strInterfaceID;
+    CameraPtr       pCamera;
+};
+
+// A camera that showed up or went away
+struct CameraChange
+{
+    UpdateTriggerType   eReason;
+    CameraInfo          info;
+};
+
+class CameraRegistry
+{
+  public:
+    CameraRegistry();
+
+    //
+    // Replaces the content with a full enumeration, done once at startup
+    //
+    // Parameters:
+    //  [in]    rCameras        All cameras known to Vimba
+    //
+    void            Populate( const CameraPtrVector &rCameras );
+
+    //
+    // Queues a plug event. Called from the Vimba thread, cheap and
+    // without any camera access.
+    //
+    // Parameters:
+    //  [in]    pCamera         The camera that triggered the event
+    //  [in]    reason          Plugged in or out
+    //
+    void            QueueChange( const CameraPtr &pCamera, UpdateTriggerType reason );
+
+    //
+    // Applies all queued plug events. Only the cameras that changed are
+    // queried.
+    //
+    // Parameters:
+    //  [out]   rChanges        The changes that were applied
+    //
+    void            ApplyChanges( std::vector<CameraChange> &rChanges );
+
+    //
+    // Looks up a connected camera
+    //
+    // Parameters:
+    //  [in]    rStrCameraID    The ID of the camera
+    //  [out]   rInfo           The camera
+    //
+    // Returns:
+    //  false if no such camera is connected
+    //
+    bool            Find( const std::string &rStrCameraID, CameraInfo &rInfo ) const;
+    bool            Contains( const std::string &rStrCameraID ) const;
+
+    //
+    // Gets all connected cameras, ordered by camera ID
+    //
+    void            GetCameras( std::vector<CameraInfo> &rCameras ) const;
+    size_t          GetCount() const;
+
+    //
+    // Gets the camera of a slot. A slot stays bound to the serial number of
+    // its camera; an unbound slot, or one whose camera is gone, takes the
+    // first camera no other slot is bound to.
+    //
+    // Parameters:
+    //  [in]    nSlot           The slot (camera 1 or 2)
+    //  [out]   rStrCameraID    The ID of the camera for this slot
+    //
+    // Returns:
+    //  false if there is no camera left for this slot
+    //
+    bool            ResolveSlot( int nSlot, std::string &rStrCameraID );
+
+    //
+    // Binds a slot to the serial number of a camera
+    //
+    // Parameters:
+    //  [in]    nSlot           The slot (camera 1 or 2)
+    //  [in]    rStrCameraID    The ID of a connected camera
+    //
+    void            BindSlot( int nSlot, const std::string &rStrCameraID );
+
+    //
+    // Gets how many property queries went to the cameras so far
+    //
+    VmbUint64_t     GetQueryCount() const;
+
+  private:
+    typedef std::map<std::string, CameraInfo> CameraMap;
+
+    // Queries the static properties, the only place that talks to a camera
+    bool            QueryInfo( const CameraPtr &pCamera, CameraInfo &rInfo );
+    void            Add( const CameraInfo &rInfo );
+    bool            IsSerialBound( const std::string &rStrSerialNumber, int nExceptSlot ) const;
+
+    CameraMap                           m_Cameras;
+    // Serial number to camera ID
+    std::map<std::string, std::string>  m_SerialIndex;
+    // Slot to serial number
+    std::map<int, std::string>          m_SlotBindings;
+    std::deque< std::pair<CameraPtr, UpdateTriggerType> > m_PendingChanges;
+    mutable std::mutex                  m_Mutex;
+    std::mutex                          m_PendingMutex;
+    VmbUint64_t                         m_nQueries;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
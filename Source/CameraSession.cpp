@@ -0,0 +1,165 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraSession.cpp
+
+  Description: The feature values a camera streamed with, saved to restore
+               them after a replug.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <CameraSession.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// In the order they have to be written: the pixel format changes the
+// allowed sizes, the size the allowed offsets
+static const struct
+{
+    const char *pName;
+    bool        bIsFloat;
+} s_SessionFeatures[] =
+{
+    { "PixelFormat",        false },
+    { "Width",              false },
+    { "Height",             false },
+    { "OffsetX",            false },
+    { "OffsetY",            false },
+    { "ExposureTimeAbs",    true },
+};
+
+CameraSessionState::CameraSessionState()
+{
+}
+
+//
+// Reads all session features from the camera. Features the camera
+// does not have are left out.
+//
+// Parameters:
+//  [in]    rFeatures       The feature cache of the open camera
+//
+void CameraSessionState::Capture( FeatureCache &rFeatures )
+{
+    std::vector<SavedValue> values;
+    for( size_t i = 0; i < sizeof( s_SessionFeatures ) / sizeof( s_SessionFeatures[0] ); ++i )
+    {
+        SavedValue value;
+        value.strName = s_SessionFeatures[i].pName;
+        value.bIsFloat = s_SessionFeatures[i].bIsFloat;
+        value.nValue = 0;
+        value.dValue = 0.0;
+        const VmbErrorType res = value.bIsFloat ? rFeatures.GetFloatValue( value.strName, value.dValue )
+                                                : rFeatures.GetIntValue( value.strName, value.nValue );
+        if( VmbErrorSuccess == res )
+        {
+            values.push_back( value );
+        }
+    }
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Values.swap( values );
+}
+
+//
+// Follows a feature write so the saved value stays current
+//
+// Parameters:
+//  [in]    rStrName        The name of the feature
+//  [in]    value           The value written
+//
+void CameraSessionState::Update( const std::string &rStrName, VmbInt64_t value )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    for( size_t i = 0; i < m_Values.size(); ++i )
+    {
+        if( m_Values[i].strName == rStrName && !m_Values[i].bIsFloat )
+        {
+            m_Values[i].nValue = value;
+        }
+    }
+}
+
+void CameraSessionState::Update( const std::string &rStrName, double value )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    for( size_t i = 0; i < m_Values.size(); ++i )
+    {
+        if( m_Values[i].strName == rStrName && m_Values[i].bIsFloat )
+        {
+            m_Values[i].dValue = value;
+        }
+    }
+}
+
+//
+// Writes the saved values back. The ROI offsets are cleared first, so
+// the size fits whatever offsets the camera came up with.
+//
+// Parameters:
+//  [in]    rFeatures       The feature cache of the reopened camera
+//
+// Returns:
+//  The first error, the remaining values are written anyway
+//
+VmbErrorType CameraSessionState::Restore( FeatureCache &rFeatures ) const
+{
+    std::vector<SavedValue> values;
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        values = m_Values;
+    }
+    if( values.empty() )
+    {
+        // Never streamed, the camera keeps what it comes up with
+        return VmbErrorSuccess;
+    }
+    rFeatures.SetIntValue( "OffsetX", 0 );
+    rFeatures.SetIntValue( "OffsetY", 0 );
+
+    VmbErrorType res = VmbErrorSuccess;
+    for( size_t i = 0; i < values.size(); ++i )
+    {
+        const SavedValue &rValue = values[i];
+        const VmbErrorType resValue = rValue.bIsFloat  ? rFeatures.SetFloatValue( rValue.strName, rValue.dValue )
+                                                        : rFeatures.SetIntValue( rValue.strName, rValue.nValue );
+        if( VmbErrorSuccess == res )
+        {
+            res = resValue;
+        }
+    }
+    return res;
+}
+
+bool CameraSessionState::IsCaptured() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return !m_Values.empty();
+}
+
+void CameraSessionState::Clear()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Values.clear();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
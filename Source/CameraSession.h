@@ -0,0 +1,136 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CameraSession.h
+
+  Description: What it takes to bring a camera back after it was unplugged:
+               the feature values it streamed with and the state of its
+               recovery. The values have to be saved while the camera is
+               still there, an unplugged camera cannot be asked anymore.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_CAMERASESSION
+#define AVT_VMBAPI_EXAMPLES_CAMERASESSION
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <VimbaCPP/Include/VimbaCPP.h>
+#include "FeatureCache.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The stream relevant feature values of a camera: pixel format, ROI and
+// exposure
+//
+class CameraSessionState
+{
+  public:
+    CameraSessionState();
+
+    //
+    // Reads all session features from the camera. Features the camera
+    // does not have are left out.
+    //
+    // Parameters:
+    //  [in]    rFeatures       The feature cache of the open camera
+    //
+    void            Capture( FeatureCache &rFeatures );
+
+    //
+    // Follows a feature write so the saved value stays current
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the feature
+    //  [in]    value           The value written
+    //
+    void            Update( const std::string &rStrName, VmbInt64_t value );
+    void            Update( const std::string &rStrName, double value );
+
+    //
+    // Writes the saved values back. The ROI offsets are cleared first, so
+    // the size fits whatever offsets the camera came up with.
+    //
+    // Parameters:
+    //  [in]    rFeatures       The feature cache of the reopened camera
+    //
+    // Returns:
+    //  The first error, the remaining values are written anyway
+    //
+    VmbErrorType    Restore( FeatureCache &rFeatures ) const;
+
+    bool            IsCaptured() const;
+    void            Clear();
+
+  private:
+    struct SavedValue
+    {
+        std::string strName;
+        bool        bIsFloat;
+        VmbInt64_t  nValue;
+        double      dValue;
+    };
+
+    std::vector<SavedValue> m_Values;
+    // Writes are followed from the feature writer thread
+    mutable std::mutex      m_Mutex;
+};
+
+// A camera that streamed and is to be brought back after a replug
+struct CameraSession
+{
+    typedef std::chrono::steady_clock Clock;
+
+    CameraSession()
+        : bLost( false )
+        , bWasStreaming( false )
+        , bAwaitingFirstFrame( false )
+        , bFirstFrameReported( true )
+        , nAttempts( 0 )
+        , dReplugToFirstFrameMs( 0.0 )
+    {
+    }
+
+    std::string         strCameraID;
+    CameraSessionState  state;
+    // The camera is gone and recovery is pending
+    bool                bLost;
+    // Streaming is resumed after the camera was reopened
+    bool                bWasStreaming;
+    // Set from the restart until the first frame arrives
+    bool                bAwaitingFirstFrame;
+    // The replug time has been picked up
+    bool                bFirstFrameReported;
+    VmbUint32_t         nAttempts;
+    Clock::time_point   lostAt;
+    Clock::time_point   replugAt;
+    Clock::time_point   nextAttemptAt;
+    double              dReplugToFirstFrameMs;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,246 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CommandExecutor.cpp
+
+  Description: Runs GenICam command features and waits for their completion
+               on a background thread.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <CommandExecutor.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Most commands are done within a few milliseconds, so polling starts
+// fast and slows down for the ones that take longer
+static const std::chrono::milliseconds FIRST_POLL_INTERVAL( 1 );
+static const std::chrono::milliseconds MAX_POLL_INTERVAL( 50 );
+
+CommandExecutor::CommandExecutor()
+    : m_bShutDown( false )
+{
+    m_Thread = std::thread( &CommandExecutor::PollThread, this );
+}
+
+//
+// Fails all pending commands with VmbErrorTimeout and stops the thread
+//
+CommandExecutor::~CommandExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bShutDown = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+}
+
+//
+// Runs a command feature and hands the wait for its completion to the
+// executor thread. Commands of several cameras overlap this way.
+//
+// Parameters:
+//  [in]    pCommand        The command feature
+//  [in]    rStrName        The name the statistics are kept under
+//  [in]    nTimeoutMs      The time the command may take to complete
+//  [in]    callback        Optional, called with the final result
+//
+// Returns:
+//  A future with VmbErrorSuccess once the command is done, the error of
+//  RunCommand or IsCommandDone, or VmbErrorTimeout
+//
+std::future<VmbErrorType> CommandExecutor::Execute( const FeaturePtr &pCommand,
+                                                    const std::string &rStrName,
+                                                    VmbUint32_t nTimeoutMs,
+                                                    const CompletionCallback &callback )
+{
+    PendingCommand command;
+    command.pCommand = pCommand;
+    command.strName = rStrName;
+    command.start = Clock::now();
+    command.deadline = command.start + std::chrono::milliseconds( nTimeoutMs );
+    command.nextPoll = command.start + FIRST_POLL_INTERVAL;
+    command.interval = FIRST_POLL_INTERVAL;
+    command.callback = callback;
+    std::future<VmbErrorType> result = command.result.get_future();
+
+    VmbErrorType res = SP_ISNULL( pCommand ) ? VmbErrorBadParameter : SP_ACCESS( pCommand )->RunCommand();
+    if( VmbErrorSuccess != res )
+    {
+        Complete( command, res, Clock::now() );
+        return result;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Pending.push_back( std::move( command ) );
+    }
+    m_Condition.notify_one();
+    return result;
+}
+
+//
+// Gets the completion statistics of every command run so far
+//
+// Parameters:
+//  [out]   rStatistics     One entry per command name
+//
+void CommandExecutor::GetStatistics( std::vector<CommandStatistics> &rStatistics ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    rStatistics.clear();
+    for(    std::map<std::string, Accumulator>::const_iterator iter = m_Statistics.begin();
+            m_Statistics.end() != iter;
+            ++iter )
+    {
+        CommandStatistics statistics;
+        statistics.strName      = iter->first;
+        statistics.nCompleted   = iter->second.nCompleted;
+        statistics.nFailed      = iter->second.nFailed;
+        statistics.nTimedOut    = iter->second.nTimedOut;
+        statistics.dMinMs       = iter->second.dMinMs;
+        statistics.dMaxMs       = iter->second.dMaxMs;
+        statistics.dMeanMs      = 0 == iter->second.nCompleted ? 0.0 : iter->second.dSumMs / iter->second.nCompleted;
+        rStatistics.push_back( statistics );
+    }
+}
+
+void CommandExecutor::PollThread()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    while( !m_bShutDown )
+    {
+        if( m_Pending.empty() )
+        {
+            m_Condition.wait( lock );
+            continue;
+        }
+        Clock::time_point nextPoll = m_Pending.front().nextPoll;
+        for(    std::list<PendingCommand>::const_iterator iter = m_Pending.begin();
+                m_Pending.end() != iter;
+                ++iter )
+        {
+            nextPoll = (std::min)( nextPoll, iter->nextPoll );
+        }
+        if( std::cv_status::no_timeout == m_Condition.wait_until( lock, nextPoll ) && Clock::now() < nextPoll )
+        {
+            // A new command or shut down
+            continue;
+        }
+
+        // Take the due commands out, IsCommandDone goes to the camera and
+        // must not block Execute
+        std::list<PendingCommand> due;
+        const Clock::time_point now = Clock::now();
+        for( std::list<PendingCommand>::iterator iter = m_Pending.begin(); m_Pending.end() != iter; )
+        {
+            std::list<PendingCommand>::iterator current = iter++;
+            if( current->nextPoll <= now )
+            {
+                due.splice( due.end(), m_Pending, current );
+            }
+        }
+        lock.unlock();
+
+        std::list<PendingCommand> stillPending;
+        for( std::list<PendingCommand>::iterator iter = due.begin(); due.end() != iter; )
+        {
+            std::list<PendingCommand>::iterator current = iter++;
+            bool bIsCommandDone = false;
+            const VmbErrorType res = SP_ACCESS( current->pCommand )->IsCommandDone( bIsCommandDone );
+            const Clock::time_point polled = Clock::now();
+            if( VmbErrorSuccess != res )
+            {
+                Complete( *current, res, polled );
+            }
+            else if( bIsCommandDone )
+            {
+                Complete( *current, VmbErrorSuccess, polled );
+            }
+            else if( polled >= current->deadline )
+            {
+                Complete( *current, VmbErrorTimeout, polled );
+            }
+            else
+            {
+                current->interval = (std::min)( current->interval * 2, Clock::duration( MAX_POLL_INTERVAL ) );
+                current->nextPoll = (std::min)( polled + current->interval, current->deadline );
+                stillPending.splice( stillPending.end(), due, current );
+            }
+        }
+
+        lock.lock();
+        m_Pending.splice( m_Pending.end(), stillPending );
+    }
+
+    // Nobody is going to poll them anymore
+    std::list<PendingCommand> abandoned;
+    abandoned.swap( m_Pending );
+    lock.unlock();
+    for( std::list<PendingCommand>::iterator iter = abandoned.begin(); abandoned.end() != iter; ++iter )
+    {
+        Complete( *iter, VmbErrorTimeout, Clock::now() );
+    }
+}
+
+void CommandExecutor::Complete( PendingCommand &rCommand, VmbErrorType eResult, Clock::time_point now )
+{
+    const double dElapsedMs = std::chrono::duration<double, std::milli>( now - rCommand.start ).count();
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        std::map<std::string, Accumulator>::iterator iter = m_Statistics.find( rCommand.strName );
+        if( m_Statistics.end() == iter )
+        {
+            Accumulator empty = { 0, 0, 0, 0.0, 0.0, 0.0 };
+            iter = m_Statistics.insert( std::make_pair( rCommand.strName, empty ) ).first;
+        }
+        Accumulator &rAccumulator = iter->second;
+        if( VmbErrorSuccess == eResult )
+        {
+            if( 0 == rAccumulator.nCompleted || dElapsedMs < rAccumulator.dMinMs )
+            {
+                rAccumulator.dMinMs = dElapsedMs;
+            }
+            rAccumulator.dMaxMs = (std::max)( rAccumulator.dMaxMs, dElapsedMs );
+            rAccumulator.dSumMs += dElapsedMs;
+            ++rAccumulator.nCompleted;
+        }
+        else if( VmbErrorTimeout == eResult )
+        {
+            ++rAccumulator.nTimedOut;
+        }
+        else
+        {
+            ++rAccumulator.nFailed;
+        }
+    }
+
+    if( rCommand.callback )
+    {
+        rCommand.callback( eResult );
+    }
+    rCommand.result.set_value( eResult );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
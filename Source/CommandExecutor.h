@@ -0,0 +1,144 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        CommandExecutor.h
+
+  Description: Runs GenICam command features and waits for their completion
+               on a background thread. IsCommandDone is polled with an
+               increasing interval up to a deadline, so a command that never
+               finishes neither burns a core nor hangs the caller.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_COMMANDEXECUTOR
+#define AVT_VMBAPI_EXAMPLES_COMMANDEXECUTOR
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <chrono>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class CommandExecutor
+{
+  public:
+    // Called on the executor thread once a command finished, failed or timed out
+    typedef std::function<void( VmbErrorType eResult )> CompletionCallback;
+
+    // Completion times of all runs of one command
+    struct CommandStatistics
+    {
+        std::string     strName;
+        VmbUint64_t     nCompleted;
+        VmbUint64_t     nFailed;
+        VmbUint64_t     nTimedOut;
+        double          dMinMs;
+        double          dMeanMs;
+        double          dMaxMs;
+    };
+
+    CommandExecutor();
+
+    //
+    // Fails all pending commands with VmbErrorTimeout and stops the thread
+    //
+    ~CommandExecutor();
+
+    //
+    // Runs a command feature and hands the wait for its completion to the
+    // executor thread. Commands of several cameras overlap this way.
+    //
+    // Parameters:
+    //  [in]    pCommand        The command feature
+    //  [in]    rStrName        The name the statistics are kept under
+    //  [in]    nTimeoutMs      The time the command may take to complete
+    //  [in]    callback        Optional, called with the final result
+    //
+    // Returns:
+    //  A future with VmbErrorSuccess once the command is done, the error of
+    //  RunCommand or IsCommandDone, or VmbErrorTimeout
+    //
+    std::future<VmbErrorType> Execute(  const FeaturePtr &pCommand,
+                                        const std::string &rStrName,
+                                        VmbUint32_t nTimeoutMs,
+                                        const CompletionCallback &callback = CompletionCallback() );
+
+    //
+    // Gets the completion statistics of every command run so far
+    //
+    // Parameters:
+    //  [out]   rStatistics     One entry per command name
+    //
+    void GetStatistics( std::vector<CommandStatistics> &rStatistics ) const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct PendingCommand
+    {
+        FeaturePtr                  pCommand;
+        std::string                 strName;
+        Clock::time_point           start;
+        Clock::time_point           deadline;
+        Clock::time_point           nextPoll;
+        Clock::duration             interval;
+        std::promise<VmbErrorType>  result;
+        CompletionCallback          callback;
+    };
+
+    struct Accumulator
+    {
+        VmbUint64_t     nCompleted;
+        VmbUint64_t     nFailed;
+        VmbUint64_t     nTimedOut;
+        double          dSumMs;
+        double          dMinMs;
+        double          dMaxMs;
+    };
+
+    // No copies, the object owns a thread
+    CommandExecutor( const CommandExecutor& );
+    CommandExecutor& operator=( const CommandExecutor& );
+
+    void PollThread();
+    void Complete( PendingCommand &rCommand, VmbErrorType eResult, Clock::time_point now );
+
+    std::list<PendingCommand>       m_Pending;
+    std::map<std::string, Accumulator> m_Statistics;
+    mutable std::mutex              m_Mutex;
+    std::condition_variable         m_Condition;
+    bool                            m_bShutDown;
+    std::thread                     m_Thread;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
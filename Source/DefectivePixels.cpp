@@ -0,0 +1,380 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DefectivePixels.cpp
+
+  Description: Defective pixel maps: hot, dead and stuck pixels found in
+               calibration stacks, stored per camera and repaired sparsely.
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <algorithm>
+#include <cstdio>
+#include <DefectivePixels.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum { DEFECT_FILE_MAGIC = 0x4D504441, DEFECT_FILE_VERSION = 1, };
+// The 8 neighbours of a pixel
+enum { NEIGHBOUR_COUNT = 8, };
+
+namespace {
+
+// The file starts with this, the pixels follow
+struct DefectFileHeader
+{
+    VmbUint32_t     nMagic;
+    VmbUint32_t     nVersion;
+    VmbUint32_t     nWidth;
+    VmbUint32_t     nHeight;
+    VmbUint32_t     nPixelFormat;
+    VmbUint32_t     nCount;
+};
+
+const int NEIGHBOUR_DX[NEIGHBOUR_COUNT] = { -1,  0,  1, -1, 1, -1, 0, 1 };
+const int NEIGHBOUR_DY[NEIGHBOUR_COUNT] = { -1, -1, -1,  0, 0,  1, 1, 1 };
+
+bool IsBefore( const DefectivePixel &rLeft, const DefectivePixel &rRight )
+{
+    return rLeft.nY < rRight.nY || ( rLeft.nY == rRight.nY && rLeft.nX < rRight.nX );
+}
+
+// Neighbours of a Bayer mosaic two pixels away have the same color
+VmbUint32_t GetNeighbourDistance( VmbPixelFormatType ePixelFormat )
+{
+    return 1 == GetBytesPerPixel( ePixelFormat ) && VmbPixelFormatMono8 != ePixelFormat ? 2 : 1;
+}
+
+template <typename T>
+T Median( T *pValues, size_t nCount )
+{
+    std::nth_element( pValues, pValues + nCount / 2, pValues + nCount );
+    return pValues[nCount / 2];
+}
+
+template <typename T>
+void RepairPixels( const ImageView &rView, const DefectivePixelMap &rMap, VmbUchar_t *pTarget )
+{
+    const VmbUint32_t nSamples = 3 == GetBytesPerPixel( rView.ePixelFormat ) ? 3 : 1;
+    const int nDistance = static_cast<int>( GetNeighbourDistance( rView.ePixelFormat ) );
+    const std::vector<DefectivePixel> &rPixels = rMap.GetPixels();
+    const std::vector<VmbUchar_t> &rMasks = rMap.GetNeighbourMasks();
+    for( size_t i = 0; i < rPixels.size(); ++i )
+    {
+        const VmbUchar_t nMask = rMasks[i];
+        for( VmbUint32_t c = 0; c < nSamples; ++c )
+        {
+            T values[NEIGHBOUR_COUNT];
+            size_t nCount = 0;
+            for( int n = 0; n < NEIGHBOUR_COUNT; ++n )
+            {
+                if( 0 != ( nMask & ( 1 << n ) ) )
+                {
+                    const VmbUint32_t nX = rPixels[i].nX + NEIGHBOUR_DX[n] * nDistance;
+                    const VmbUint32_t nY = rPixels[i].nY + NEIGHBOUR_DY[n] * nDistance;
+                    values[nCount++] = reinterpret_cast<const T*>( rView.pBuffer + static_cast<size_t>( nY ) * rView.nStride )[nX * nSamples + c];
+                }
+            }
+            // A pixel in a cluster of defects is left as it is
+            if( 0 != nCount )
+            {
+                reinterpret_cast<T*>( pTarget + static_cast<size_t>( rPixels[i].nY ) * rView.nStride )[rPixels[i].nX * nSamples + c] = Median( values, nCount );
+            }
+        }
+    }
+}
+
+}
+
+DefectDetectionSettings::DefectDetectionSettings()
+    : dHotThreshold( 24.0 )
+    , dDeadRatio( 0.5 )
+    , dBrightRatio( 1.5 )
+{
+}
+
+DefectivePixelMap::DefectivePixelMap()
+    : m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_ePixelFormat( VmbPixelFormatMono8 )
+{
+}
+
+//
+// Finds the defective pixels in the stacks of a calibration. Dark
+// frames reveal hot pixels, flat frames dead and stuck ones.
+//
+// Parameters:
+//  [in]    rBuilder        The stacks
+//  [in]    settings        The thresholds
+//
+// Returns:
+//  VmbErrorInvalidCall if both stacks are empty,
+//  VmbErrorWrongType for sensors wider or higher than 65536 pixels
+//
+VmbErrorType DefectivePixelMap::Detect( const CalibrationBuilder &rBuilder, const DefectDetectionSettings &settings )
+{
+    const VmbUint32_t *pDarkSums = rBuilder.GetSums( CalibrationDark );
+    const VmbUint32_t *pFlatSums = rBuilder.GetSums( CalibrationFlat );
+    if( NULL == pDarkSums && NULL == pFlatSums )
+    {
+        return VmbErrorInvalidCall;
+    }
+    const VmbUint32_t nWidth = rBuilder.GetWidth();
+    const VmbUint32_t nHeight = rBuilder.GetHeight();
+    const VmbPixelFormatType ePixelFormat = rBuilder.GetPixelFormat();
+    if( nWidth > 0x10000 || nHeight > 0x10000 )
+    {
+        return VmbErrorWrongType;
+    }
+    const VmbUint32_t nSamples = 3 == GetBytesPerPixel( ePixelFormat ) ? 3 : 1;
+    const int nDistance = static_cast<int>( GetNeighbourDistance( ePixelFormat ) );
+    const double dDarkFrames = static_cast<double>( rBuilder.GetCount( CalibrationDark ) );
+    const double dFlatFrames = static_cast<double>( rBuilder.GetCount( CalibrationFlat ) );
+    const double dHotThreshold = settings.dHotThreshold * ( 1 << ( GetBitDepth( ePixelFormat ) - 8 ) );
+    // The mean dark level and the mean flat signal of a sample
+    const auto dark = [&]( size_t nSample ) -> double
+    {
+        return NULL == pDarkSums ? 0.0 : pDarkSums[nSample] / dDarkFrames;
+    };
+    const auto signal = [&]( size_t nSample ) -> double
+    {
+        return pFlatSums[nSample] / dFlatFrames - dark( nSample );
+    };
+
+    m_Pixels.clear();
+    for( VmbUint32_t y = 0; y < nHeight; ++y )
+    {
+        for( VmbUint32_t x = 0; x < nWidth; ++x )
+        {
+            bool bDefective = false;
+            for( VmbUint32_t c = 0; c < nSamples && !bDefective; ++c )
+            {
+                double darks[NEIGHBOUR_COUNT];
+                double signals[NEIGHBOUR_COUNT];
+                size_t nCount = 0;
+                for( int n = 0; n < NEIGHBOUR_COUNT; ++n )
+                {
+                    const VmbUint32_t nX = x + NEIGHBOUR_DX[n] * nDistance;
+                    const VmbUint32_t nY = y + NEIGHBOUR_DY[n] * nDistance;
+                    // Beyond the edges the unsigned coordinates wrap above the size
+                    if( nX < nWidth && nY < nHeight )
+                    {
+                        const size_t nSample = ( static_cast<size_t>( nY ) * nWidth + nX ) * nSamples + c;
+                        darks[nCount] = dark( nSample );
+                        signals[nCount] = NULL == pFlatSums ? 0.0 : signal( nSample );
+                        ++nCount;
+                    }
+                }
+                if( 0 == nCount )
+                {
+                    continue;
+                }
+                const size_t nSample = ( static_cast<size_t>( y ) * nWidth + x ) * nSamples + c;
+                if( NULL != pDarkSums )
+                {
+                    bDefective = dark( nSample ) - Median( darks, nCount ) > dHotThreshold;
+                }
+                if( NULL != pFlatSums && !bDefective )
+                {
+                    // Too little light to tell
+                    const double dReference = Median( signals, nCount );
+                    const double dSignal = signal( nSample );
+                    bDefective =    dReference >= 1.0
+                                &&  (   dSignal < settings.dDeadRatio * dReference
+                                    ||  dSignal > settings.dBrightRatio * dReference );
+                }
+            }
+            if( bDefective )
+            {
+                const DefectivePixel pixel = { static_cast<VmbUint16_t>( x ), static_cast<VmbUint16_t>( y ) };
+                m_Pixels.push_back( pixel );
+            }
+        }
+    }
+    m_nWidth = nWidth;
+    m_nHeight = nHeight;
+    m_ePixelFormat = ePixelFormat;
+    UpdateNeighbourMasks();
+    return VmbErrorSuccess;
+}
+
+//
+// Reads a map written by Save
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  VmbErrorNotFound if there is no such file,
+//  VmbErrorInvalidValue if it is no defect map
+//
+VmbErrorType DefectivePixelMap::Load( const std::string &rStrPath )
+{
+    FILE *pFile = fopen( rStrPath.c_str(), "rb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorNotFound;
+    }
+    DefectFileHeader header;
+    std::vector<DefectivePixel> pixels;
+    bool bValid =       1 == fread( &header, sizeof( header ), 1, pFile )
+                    &&  DEFECT_FILE_MAGIC == header.nMagic
+                    &&  DEFECT_FILE_VERSION == header.nVersion
+                    &&  0 != GetBytesPerPixel( static_cast<VmbPixelFormatType>( header.nPixelFormat ) )
+                    &&  header.nCount <= static_cast<VmbUint64_t>( header.nWidth ) * header.nHeight;
+    if( bValid && 0 != header.nCount )
+    {
+        pixels.resize( header.nCount );
+        bValid = header.nCount == fread( &pixels[0], sizeof( DefectivePixel ), header.nCount, pFile );
+    }
+    fclose( pFile );
+    // Sorted, without duplicates and inside the frame
+    for( size_t i = 0; bValid && i < pixels.size(); ++i )
+    {
+        bValid =        pixels[i].nX < header.nWidth
+                    &&  pixels[i].nY < header.nHeight
+                    &&  ( 0 == i || IsBefore( pixels[i - 1], pixels[i] ) );
+    }
+    if( !bValid )
+    {
+        return VmbErrorInvalidValue;
+    }
+    m_nWidth = header.nWidth;
+    m_nHeight = header.nHeight;
+    m_ePixelFormat = static_cast<VmbPixelFormatType>( header.nPixelFormat );
+    m_Pixels.swap( pixels );
+    UpdateNeighbourMasks();
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the map to a file. It is replaced as a whole.
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType DefectivePixelMap::Save( const std::string &rStrPath ) const
+{
+    DefectFileHeader header;
+    header.nMagic       = DEFECT_FILE_MAGIC;
+    header.nVersion     = DEFECT_FILE_VERSION;
+    header.nWidth       = m_nWidth;
+    header.nHeight      = m_nHeight;
+    header.nPixelFormat = static_cast<VmbUint32_t>( m_ePixelFormat );
+    header.nCount       = static_cast<VmbUint32_t>( m_Pixels.size() );
+
+    const std::string strTemporary = rStrPath + ".tmp";
+    FILE *pFile = fopen( strTemporary.c_str(), "wb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorResources;
+    }
+    const bool bWritten =   1 == fwrite( &header, sizeof( header ), 1, pFile )
+                        &&  (   m_Pixels.empty()
+                            ||  m_Pixels.size() == fwrite( &m_Pixels[0], sizeof( DefectivePixel ), m_Pixels.size(), pFile ) );
+    if( 0 != fclose( pFile ) || !bWritten )
+    {
+        return VmbErrorResources;
+    }
+    if( !MoveFileExA( strTemporary.c_str(), rStrPath.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+        return VmbErrorResources;
+    }
+    return VmbErrorSuccess;
+}
+
+bool DefectivePixelMap::Matches( const ImageView &rView ) const
+{
+    return      rView.nWidth == m_nWidth
+            &&  rView.nHeight == m_nHeight
+            &&  rView.ePixelFormat == m_ePixelFormat;
+}
+
+bool DefectivePixelMap::Contains( VmbUint32_t nX, VmbUint32_t nY ) const
+{
+    if( nX >= m_nWidth || nY >= m_nHeight )
+    {
+        return false;
+    }
+    const DefectivePixel pixel = { static_cast<VmbUint16_t>( nX ), static_cast<VmbUint16_t>( nY ) };
+    const std::vector<DefectivePixel>::const_iterator it = std::lower_bound( m_Pixels.begin(), m_Pixels.end(), pixel, IsBefore );
+    return m_Pixels.end() != it && it->nX == nX && it->nY == nY;
+}
+
+void DefectivePixelMap::UpdateNeighbourMasks()
+{
+    const int nDistance = static_cast<int>( GetNeighbourDistance( m_ePixelFormat ) );
+    m_NeighbourMasks.assign( m_Pixels.size(), 0 );
+    for( size_t i = 0; i < m_Pixels.size(); ++i )
+    {
+        for( int n = 0; n < NEIGHBOUR_COUNT; ++n )
+        {
+            const VmbUint32_t nX = m_Pixels[i].nX + NEIGHBOUR_DX[n] * nDistance;
+            const VmbUint32_t nY = m_Pixels[i].nY + NEIGHBOUR_DY[n] * nDistance;
+            if(     nX < m_nWidth
+                &&  nY < m_nHeight
+                &&  !Contains( nX, nY ) )
+            {
+                m_NeighbourMasks[i] |= static_cast<VmbUchar_t>( 1 << n );
+            }
+        }
+    }
+}
+
+//
+// Replaces every defective pixel by the median of its good neighbours of
+// the same color. Only the pixels on the map are touched.
+//
+// Parameters:
+//  [in]    rView           The frame, the map must match it
+//  [in]    rMap            The defective pixels
+//  [out]   pTarget         The repaired frame, laid out like rView. Pixels not
+//                          on the map are not written, so it is usually rView.pBuffer.
+//
+// Returns:
+//  VmbErrorBadParameter if the map does not match the frame
+//
+VmbErrorType CorrectDefectivePixels( const ImageView &rView, const DefectivePixelMap &rMap, VmbUchar_t *pTarget )
+{
+    if(     !rMap.Matches( rView )
+        ||  NULL == rView.pBuffer
+        ||  NULL == pTarget )
+    {
+        return VmbErrorBadParameter;
+    }
+    if( 2 == GetBytesPerPixel( rView.ePixelFormat ) )
+    {
+        RepairPixels<VmbUint16_t>( rView, rMap, pTarget );
+    }
+    else
+    {
+        RepairPixels<VmbUchar_t>( rView, rMap, pTarget );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
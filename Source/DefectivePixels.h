@@ -0,0 +1,148 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DefectivePixels.h
+
+  Description: Defective pixel maps: hot, dead and stuck pixels found in
+               calibration stacks, stored per camera and repaired sparsely.
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_DEFECTIVEPIXELS
+#define AVT_VMBAPI_EXAMPLES_DEFECTIVEPIXELS
+
+#include <string>
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "FlatField.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+struct DefectivePixel
+{
+    VmbUint16_t     nX;
+    VmbUint16_t     nY;
+};
+
+struct DefectDetectionSettings
+{
+    // A pixel is hot if its dark level exceeds its neighbours' by more, in 8 bit values
+    double          dHotThreshold;
+    // A pixel is dead if it sees less of the flat light than this part of its neighbours ...
+    double          dDeadRatio;
+    // ... and stuck bright if it sees more than this
+    double          dBrightRatio;
+
+    DefectDetectionSettings();
+};
+
+//
+// The defective pixels of a sensor, sorted row by row. Every pixel is
+// compared to its neighbours of the same color, so vignetting and
+// shading of the calibration frames do not count as defects.
+//
+class DefectivePixelMap
+{
+  public:
+    DefectivePixelMap();
+
+    //
+    // Finds the defective pixels in the stacks of a calibration. Dark
+    // frames reveal hot pixels, flat frames dead and stuck ones.
+    //
+    // Parameters:
+    //  [in]    rBuilder        The stacks
+    //  [in]    settings        The thresholds
+    //
+    // Returns:
+    //  VmbErrorInvalidCall if both stacks are empty,
+    //  VmbErrorWrongType for sensors wider or higher than 65536 pixels
+    //
+    VmbErrorType        Detect( const CalibrationBuilder &rBuilder, const DefectDetectionSettings &settings );
+
+    //
+    // Reads a map written by Save
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  VmbErrorNotFound if there is no such file,
+    //  VmbErrorInvalidValue if it is no defect map
+    //
+    VmbErrorType        Load( const std::string &rStrPath );
+
+    //
+    // Writes the map to a file. It is replaced as a whole.
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        Save( const std::string &rStrPath ) const;
+
+    // The map was made for frames of the size and format of the view
+    bool                Matches( const ImageView &rView ) const;
+
+    // Whether a pixel is on the map, by binary search
+    bool                Contains( VmbUint32_t nX, VmbUint32_t nY ) const;
+
+    VmbUint32_t         GetWidth() const                { return m_nWidth; }
+    VmbUint32_t         GetHeight() const               { return m_nHeight; }
+    VmbPixelFormatType  GetPixelFormat() const          { return m_ePixelFormat; }
+    const std::vector<DefectivePixel>& GetPixels() const { return m_Pixels; }
+    // Bit n is set if neighbour n of a pixel can stand in for it
+    const std::vector<VmbUchar_t>& GetNeighbourMasks() const { return m_NeighbourMasks; }
+
+  private:
+    // Looks up the neighbours that are inside the frame and not defective themselves
+    void                UpdateNeighbourMasks();
+
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbPixelFormatType          m_ePixelFormat;
+    std::vector<DefectivePixel> m_Pixels;
+    std::vector<VmbUchar_t>     m_NeighbourMasks;
+};
+
+//
+// Replaces every defective pixel by the median of its good neighbours of
+// the same color. Only the pixels on the map are touched.
+//
+// Parameters:
+//  [in]    rView           The frame, the map must match it
+//  [in]    rMap            The defective pixels
+//  [out]   pTarget         The repaired frame, laid out like rView. Pixels not
+//                          on the map are not written, so it is usually rView.pBuffer.
+//
+// Returns:
+//  VmbErrorBadParameter if the map does not match the frame
+//
+VmbErrorType CorrectDefectivePixels( const ImageView &rView, const DefectivePixelMap &rMap, VmbUchar_t *pTarget );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,128 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DisplayScheduler.cpp
+
+  Description: Limits how often a picture box is refreshed, independent of
+               the frame rate of its camera.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <DisplayScheduler.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Parameters:
+//  [in]    dMaxFps         The refresh rate cap of the picture box
+//
+DisplayScheduler::DisplayScheduler( double dMaxFps )
+    : m_Interval( Clock::duration::zero() )
+    , m_NextDue( Clock::now() )
+    , m_RateStart( Clock::now() )
+    , m_nPainted( 0 )
+    , m_nSkipped( 0 )
+{
+    SetMaxRate( dMaxFps );
+}
+
+//
+// Sets the refresh rate cap
+//
+// Parameters:
+//  [in]    dMaxFps         The refresh rate cap, 0 for no cap
+//
+void DisplayScheduler::SetMaxRate( double dMaxFps )
+{
+    m_Interval = dMaxFps > 0.0  ? std::chrono::duration_cast<Clock::duration>( std::chrono::duration<double>( 1.0 / dMaxFps ) )
+                                : Clock::duration::zero();
+    m_NextDue = Clock::now();
+}
+
+double DisplayScheduler::GetMaxRate() const
+{
+    return Clock::duration::zero() == m_Interval ? 0.0 : 1.0 / std::chrono::duration<double>( m_Interval ).count();
+}
+
+//
+// Decides whether a frame is converted and shown
+//
+// Parameters:
+//  [in]    bNewerFrameWaiting  A newer frame of the camera is already queued
+//
+// Returns:
+//  false if the frame is to be requeued without conversion
+//
+bool DisplayScheduler::ShouldShow( bool bNewerFrameWaiting )
+{
+    const Clock::time_point now = Clock::now();
+    if( bNewerFrameWaiting || now < m_NextDue )
+    {
+        ++m_nSkipped;
+        return false;
+    }
+    // Keeps the average at the cap for cameras slightly faster than it, but
+    // a pause in the stream does not earn a burst of refreshes
+    m_NextDue += m_Interval;
+    if( m_NextDue < now )
+    {
+        m_NextDue = now;
+    }
+    return true;
+}
+
+//
+// Counts a paint of the picture box
+//
+void DisplayScheduler::OnPainted()
+{
+    ++m_nPainted;
+}
+
+//
+// Gets the rates of the last second once a second has passed
+//
+// Parameters:
+//  [out]   rdPaintsPerSecond   Paints of the picture box per second
+//  [out]   rdSavedPerSecond    Conversions skipped per second
+//
+// Returns:
+//  false if the current second is not over yet
+//
+bool DisplayScheduler::TakeRates( double &rdPaintsPerSecond, double &rdSavedPerSecond )
+{
+    const Clock::time_point now = Clock::now();
+    const double dSeconds = std::chrono::duration<double>( now - m_RateStart ).count();
+    if( dSeconds < 1.0 )
+    {
+        return false;
+    }
+    rdPaintsPerSecond = m_nPainted / dSeconds;
+    rdSavedPerSecond = m_nSkipped / dSeconds;
+    m_nPainted = 0;
+    m_nSkipped = 0;
+    m_RateStart = now;
+    return true;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,103 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        DisplayScheduler.h
+
+  Description: Limits how often a picture box is refreshed, independent of
+               the frame rate of its camera.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_DISPLAYSCHEDULER
+#define AVT_VMBAPI_EXAMPLES_DISPLAYSCHEDULER
+
+#include <chrono>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Decides for every frame of a camera whether it is converted and shown.
+// Frames that would be painted over before the screen shows them are
+// requeued right away without conversion. Used by the GUI thread only.
+//
+class DisplayScheduler
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    dMaxFps         The refresh rate cap of the picture box
+    //
+    explicit DisplayScheduler( double dMaxFps = 30.0 );
+
+    //
+    // Sets the refresh rate cap
+    //
+    // Parameters:
+    //  [in]    dMaxFps         The refresh rate cap, 0 for no cap
+    //
+    void    SetMaxRate( double dMaxFps );
+
+    double  GetMaxRate() const;
+
+    //
+    // Decides whether a frame is converted and shown
+    //
+    // Parameters:
+    //  [in]    bNewerFrameWaiting  A newer frame of the camera is already queued
+    //
+    // Returns:
+    //  false if the frame is to be requeued without conversion
+    //
+    bool    ShouldShow( bool bNewerFrameWaiting );
+
+    //
+    // Counts a paint of the picture box
+    //
+    void    OnPainted();
+
+    //
+    // Gets the rates of the last second once a second has passed
+    //
+    // Parameters:
+    //  [out]   rdPaintsPerSecond   Paints of the picture box per second
+    //  [out]   rdSavedPerSecond    Conversions skipped per second
+    //
+    // Returns:
+    //  false if the current second is not over yet
+    //
+    bool    TakeRates( double &rdPaintsPerSecond, double &rdSavedPerSecond );
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::duration     m_Interval;
+    Clock::time_point   m_NextDue;
+    Clock::time_point   m_RateStart;
+    VmbUint32_t         m_nPainted;
+    VmbUint32_t         m_nSkipped;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
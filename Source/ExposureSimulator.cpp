@@ -0,0 +1,166 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ExposureSimulator.cpp
+
+  Description: A camera model whose brightness follows exposure time and
+               gain, to see how fast and how steady auto exposure settles.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <ExposureSimulator.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Parameters:
+//  [in]    nWidth          The width of the simulated frames
+//  [in]    nHeight         The height of the simulated frames
+//  [in]    nLatencyFrames  Frames from a feature write to the first frame taken with it
+//
+ExposureSimulator::ExposureSimulator( VmbUint32_t nWidth, VmbUint32_t nHeight, VmbUint32_t nLatencyFrames )
+    : m_nWidth( nWidth )
+    , m_nHeight( nHeight )
+    , m_nLatencyFrames( nLatencyFrames )
+{
+}
+
+//
+// Runs the controller against a scene. The scene has a gradient from
+// dark to bright, so strong light clips part of it first.
+//
+// Parameters:
+//  [in]    settings        The settings of the controller
+//  [in]    dRadiance       The mean brightness per microsecond at 0 dB, as part of full scale
+//  [in]    dStartExposureUs The exposure time the camera starts with
+//  [in]    nFrames         The frames to simulate
+//  [out]   rResult         How it went
+//
+// Returns:
+//  VmbErrorBadParameter for an empty scene or no frames
+//
+VmbErrorType ExposureSimulator::Run(    const AutoExposureSettings &settings,
+                                        double dRadiance,
+                                        double dStartExposureUs,
+                                        VmbUint32_t nFrames,
+                                        ExposureSimulationResult &rResult )
+{
+    if(     0 == m_nWidth
+        ||  0 == m_nHeight
+        ||  0 == nFrames
+        ||  dRadiance <= 0.0 )
+    {
+        return VmbErrorBadParameter;
+    }
+    m_Image.resize( static_cast<size_t>( m_nWidth ) * m_nHeight );
+
+    AutoExposureController controller;
+    controller.Reset( settings, dStartExposureUs, settings.dMinGainDb );
+
+    // What the camera uses, and the writes on their way to it
+    struct Write
+    {
+        VmbUint32_t     nFrame;
+        double          dExposureUs;
+        double          dGainDb;
+    };
+    std::deque<Write> writes;
+    double dExposureUs = dStartExposureUs;
+    double dGainDb = settings.dMinGainDb;
+
+    rResult.bConverged          = false;
+    rResult.nFramesToConverge   = 0;
+    rResult.nUpdates            = 0;
+    rResult.nReversals          = 0;
+    int nLastDirection = 0;
+    double dRequestedBrightness = dExposureUs * std::pow( 10.0, dGainDb / 20.0 );
+    ImageStatistics statistics;
+    for( VmbUint32_t nFrame = 0; nFrame < nFrames; ++nFrame )
+    {
+        while( !writes.empty() && writes.front().nFrame <= nFrame )
+        {
+            dExposureUs = writes.front().dExposureUs;
+            dGainDb = writes.front().dGainDb;
+            writes.pop_front();
+        }
+        Render( dRadiance * dExposureUs * std::pow( 10.0, dGainDb / 20.0 ) );
+
+        ImageView view;
+        MakeImageView( &m_Image[0], m_nWidth, m_nHeight, VmbPixelFormatMono8, view );
+        ComputeImageStatistics( view, 1, NULL, statistics );
+        statistics.nFrameID = nFrame;
+
+        double dNewExposureUs;
+        double dNewGainDb;
+        if( controller.Update( statistics, dNewExposureUs, dNewGainDb ) )
+        {
+            const double dNewBrightness = dNewExposureUs * std::pow( 10.0, dNewGainDb / 20.0 );
+            const int nDirection = dNewBrightness > dRequestedBrightness ? 1 : -1;
+            if( 0 != nLastDirection && nDirection != nLastDirection )
+            {
+                ++rResult.nReversals;
+            }
+            nLastDirection = nDirection;
+            dRequestedBrightness = dNewBrightness;
+            ++rResult.nUpdates;
+            Write write = { nFrame + 1 + m_nLatencyFrames, dNewExposureUs, dNewGainDb };
+            writes.push_back( write );
+        }
+
+        if( controller.IsConverged() )
+        {
+            if( !rResult.bConverged )
+            {
+                rResult.bConverged = true;
+                rResult.nFramesToConverge = nFrame + 1;
+            }
+        }
+        else
+        {
+            rResult.bConverged = false;
+        }
+        rResult.dFinalMean = statistics.dMean[0] / 255.0;
+    }
+    rResult.dFinalExposureUs = dExposureUs;
+    rResult.dFinalGainDb = dGainDb;
+    return VmbErrorSuccess;
+}
+
+void ExposureSimulator::Render( double dBrightness )
+{
+    // A horizontal gradient from 0.2 to 1.8 times the mean
+    for( VmbUint32_t x = 0; x < m_nWidth; ++x )
+    {
+        const double dLevel = dBrightness * ( 0.2 + 1.6 * x / ( m_nWidth - 1 ) ) * 255.0;
+        m_Image[x] = static_cast<VmbUchar_t>( (std::min)( 255.0, dLevel + 0.5 ) );
+    }
+    for( VmbUint32_t y = 1; y < m_nHeight; ++y )
+    {
+        std::copy( m_Image.begin(), m_Image.begin() + m_nWidth, m_Image.begin() + static_cast<size_t>( y ) * m_nWidth );
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,98 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ExposureSimulator.h
+
+  Description: A camera model whose brightness follows exposure time and
+               gain, to see how fast and how steady auto exposure settles.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_EXPOSURESIMULATOR
+#define AVT_VMBAPI_EXAMPLES_EXPOSURESIMULATOR
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "AutoExposure.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// How auto exposure did against the model
+struct ExposureSimulationResult
+{
+    bool            bConverged;
+    // The first frame from which on the controller stayed converged
+    VmbUint32_t     nFramesToConverge;
+    // Changes the controller asked for
+    VmbUint32_t     nUpdates;
+    // Changes of direction, more than one or two means it oscillates
+    VmbUint32_t     nReversals;
+    double          dFinalMean;
+    double          dFinalExposureUs;
+    double          dFinalGainDb;
+};
+
+class ExposureSimulator
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nWidth          The width of the simulated frames
+    //  [in]    nHeight         The height of the simulated frames
+    //  [in]    nLatencyFrames  Frames from a feature write to the first frame taken with it
+    //
+    ExposureSimulator( VmbUint32_t nWidth = 256, VmbUint32_t nHeight = 192, VmbUint32_t nLatencyFrames = 2 );
+
+    //
+    // Runs the controller against a scene. The scene has a gradient from
+    // dark to bright, so strong light clips part of it first.
+    //
+    // Parameters:
+    //  [in]    settings        The settings of the controller
+    //  [in]    dRadiance       The mean brightness per microsecond at 0 dB, as part of full scale
+    //  [in]    dStartExposureUs The exposure time the camera starts with
+    //  [in]    nFrames         The frames to simulate
+    //  [out]   rResult         How it went
+    //
+    // Returns:
+    //  VmbErrorBadParameter for an empty scene or no frames
+    //
+    VmbErrorType Run(   const AutoExposureSettings &settings,
+                        double dRadiance,
+                        double dStartExposureUs,
+                        VmbUint32_t nFrames,
+                        ExposureSimulationResult &rResult );
+
+  private:
+    void Render( double dBrightness );
+
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbUint32_t                 m_nLatencyFrames;
+    std::vector<VmbUchar_t>     m_Image;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,138 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureBenchmark.cpp
+
+  Description: Measures feature writes per second against a simulated node
+               map, once with a name lookup per write as GetFeatureByName
+               does it and once through a handle resolved in advance.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <FeatureBenchmark.h>
+
+#include <chrono>
+#include <sstream>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The feature the exposure slider writes
+static const char * const s_BenchmarkFeature = "ExposureTimeAbs";
+
+FeatureBenchmark::FeatureBenchmark( VmbUint32_t nFeatures )
+{
+    // Filler nodes make the lookup walk a node map of realistic size
+    for( VmbUint32_t i = 0; i < nFeatures; ++i )
+    {
+        std::ostringstream strName;
+        strName << "Feature" << i;
+        SimulatedFeaturePtr pFeature( new SimulatedFeature() );
+        pFeature->dMin      = 0.0;
+        pFeature->dMax      = 1000.0;
+        pFeature->dValue    = 0.0;
+        m_Nodes[strName.str()] = pFeature;
+    }
+    SimulatedFeaturePtr pExposure( new SimulatedFeature() );
+    pExposure->dMin     = 20.0;
+    pExposure->dMax     = 200000.0;
+    pExposure->dValue   = 1500.0;
+    m_Nodes[s_BenchmarkFeature] = pExposure;
+}
+
+VmbErrorType FeatureBenchmark::SimulatedFeature::SetValue( double dNewValue )
+{
+    if(     dNewValue < dMin
+        ||  dNewValue > dMax )
+    {
+        return VmbErrorInvalidValue;
+    }
+    dValue = dNewValue;
+    return VmbErrorSuccess;
+}
+
+VmbErrorType FeatureBenchmark::GetFeatureByName( const std::string &rStrName, SimulatedFeaturePtr &rFeature )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    SimulatedNodeMap::const_iterator iter = m_Nodes.find( rStrName );
+    if( m_Nodes.end() == iter )
+    {
+        return VmbErrorNotFound;
+    }
+    rFeature = iter->second;
+    return VmbErrorSuccess;
+}
+
+//
+// Writes ExposureTimeAbs nWrites times through each path
+//
+// Parameters:
+//  [in]    nWrites         The writes per path
+//  [out]   rResult         The writes per second of both paths
+//
+// Returns:
+//  VmbErrorBadParameter for no writes, else the first failed write
+//
+VmbErrorType FeatureBenchmark::Run( VmbUint32_t nWrites, FeatureBenchmarkResult &rResult )
+{
+    if( 0 == nWrites )
+    {
+        return VmbErrorBadParameter;
+    }
+    rResult.nFeatures   = static_cast<VmbUint32_t>( m_Nodes.size() );
+    rResult.nWrites     = nWrites;
+
+    // The name arrives as a string like in SetCameraFloatFeature, the
+    // values alternate so that every write changes the feature
+    const std::string strName( s_BenchmarkFeature );
+    VmbErrorType res = VmbErrorSuccess;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( VmbUint32_t i = 0; i < nWrites && VmbErrorSuccess == res; ++i )
+    {
+        SimulatedFeaturePtr pFeature;
+        res = GetFeatureByName( strName, pFeature );
+        if( VmbErrorSuccess == res )
+        {
+            res = pFeature->SetValue( 1000.0 + ( i & 1 ) );
+        }
+    }
+    const double dLookupSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    SimulatedFeaturePtr pHandle;
+    if( VmbErrorSuccess == res )
+    {
+        res = GetFeatureByName( strName, pHandle );
+    }
+    start = std::chrono::steady_clock::now();
+    for( VmbUint32_t i = 0; i < nWrites && VmbErrorSuccess == res; ++i )
+    {
+        res = pHandle->SetValue( 1000.0 + ( i & 1 ) );
+    }
+    const double dHandleSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    // The clock may not resolve a very fast loop
+    rResult.dLookupWritesPerSecond = dLookupSeconds > 0.0 ? nWrites / dLookupSeconds : 0.0;
+    rResult.dHandleWritesPerSecond = dHandleSeconds > 0.0 ? nWrites / dHandleSeconds : 0.0;
+    return res;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,102 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureBenchmark.h
+
+  Description: Measures feature writes per second against a simulated node
+               map, once with a name lookup per write as GetFeatureByName
+               does it and once through a handle resolved in advance.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FEATUREBENCHMARK
+#define AVT_VMBAPI_EXAMPLES_FEATUREBENCHMARK
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Writes per second through both access paths
+struct FeatureBenchmarkResult
+{
+    // Nodes in the simulated node map
+    VmbUint32_t     nFeatures;
+    // Writes done per path
+    VmbUint32_t     nWrites;
+    // The name is looked up on every write
+    double          dLookupWritesPerSecond;
+    // The handle was resolved once before the first write
+    double          dHandleWritesPerSecond;
+};
+
+class FeatureBenchmark
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nFeatures       The nodes of the simulated node map, a GigE
+    //                          camera exposes several hundred
+    //
+    FeatureBenchmark( VmbUint32_t nFeatures = 600 );
+
+    //
+    // Writes ExposureTimeAbs nWrites times through each path
+    //
+    // Parameters:
+    //  [in]    nWrites         The writes per path
+    //  [out]   rResult         The writes per second of both paths
+    //
+    // Returns:
+    //  VmbErrorBadParameter for no writes, else the first failed write
+    //
+    VmbErrorType Run( VmbUint32_t nWrites, FeatureBenchmarkResult &rResult );
+
+  private:
+    // A float node with its limits, writes outside are rejected like
+    // the camera would
+    struct SimulatedFeature
+    {
+        double  dMin;
+        double  dMax;
+        double  dValue;
+
+        VmbErrorType SetValue( double dValue );
+    };
+    typedef std::shared_ptr<SimulatedFeature>               SimulatedFeaturePtr;
+    typedef std::map<std::string, SimulatedFeaturePtr>      SimulatedNodeMap;
+
+    // Resolves a name the way the API does, under the lock of the node
+    // map and returning a shared handle
+    VmbErrorType GetFeatureByName( const std::string &rStrName, SimulatedFeaturePtr &rFeature );
+
+    SimulatedNodeMap    m_Nodes;
+    std::mutex          m_Mutex;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,234 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureCache.cpp
+
+  Description: Per camera cache of resolved feature handles.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <FeatureCache.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Resolved right when a camera is opened, everything else on first use
+static const char * const s_PreloadedFeatures[] =
+{
+    "Width",
+    "Height",
+    "PixelFormat",
+    "PayloadSize",
+    "ExposureTimeAbs",
+    "Gain",
+    "GevSCPSPacketSize",
+};
+
+FeatureCache::FeatureCache()
+    : m_nLookups( 0 )
+    , m_nHits( 0 )
+{
+}
+
+//
+// Binds the cache to a freshly opened camera and resolves the features
+// the example uses all the time
+//
+// Parameters:
+//  [in]    pCamera         The open camera
+//
+void FeatureCache::Attach( const CameraPtr &pCamera )
+{
+    Invalidate();
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_pCamera = pCamera;
+    }
+
+    FeaturePtr pFeature;
+    for( size_t i = 0; i < sizeof( s_PreloadedFeatures ) / sizeof( s_PreloadedFeatures[0] ); ++i )
+    {
+        // Not every camera has all of them, missing ones are simply not cached
+        GetFeature( s_PreloadedFeatures[i], pFeature );
+    }
+
+    const FloatFeature exposureTime = GetFloatFeature( "ExposureTimeAbs" );
+    const FloatFeature gain = GetFloatFeature( "Gain" );
+    const IntFeature packetSize = GetIntFeature( "GevSCPSPacketSize" );
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_ExposureTime  = exposureTime;
+    m_Gain          = gain;
+    m_PacketSize    = packetSize;
+}
+
+//
+// Drops all handles. Must be called before the camera is closed, the
+// handles of a closed camera are no longer valid.
+//
+void FeatureCache::Invalidate()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Features.clear();
+    m_ExposureTime  = FloatFeature();
+    m_Gain          = FloatFeature();
+    m_PacketSize    = IntFeature();
+    SP_RESET( m_pCamera );
+}
+
+//
+// Gets the handle of a feature, resolving it on first use
+//
+// Parameters:
+//  [in]    rStrName        The name of the feature
+//  [out]   rpFeature       The feature
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType FeatureCache::GetFeature( const std::string &rStrName, FeaturePtr &rpFeature )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    if( SP_ISNULL( m_pCamera ) )
+    {
+        return VmbErrorDeviceNotOpen;
+    }
+
+    FeatureMap::const_iterator iter = m_Features.find( rStrName );
+    if( m_Features.end() != iter )
+    {
+        ++m_nHits;
+        rpFeature = iter->second;
+        return VmbErrorSuccess;
+    }
+
+    ++m_nLookups;
+    VmbErrorType res = SP_ACCESS( m_pCamera )->GetFeatureByName( rStrName.c_str(), rpFeature );
+    if( VmbErrorSuccess == res )
+    {
+        m_Features[rStrName] = rpFeature;
+    }
+    return res;
+}
+
+//
+// Gets a typed handle for repeated access without string lookups
+//
+// Parameters:
+//  [in]    rStrName        The name of the feature
+//
+// Returns:
+//  The handle, invalid if the camera has no such feature
+//
+IntFeature FeatureCache::GetIntFeature( const std::string &rStrName )
+{
+    FeaturePtr pFeature;
+    GetFeature( rStrName, pFeature );
+    return IntFeature( pFeature );
+}
+
+FloatFeature FeatureCache::GetFloatFeature( const std::string &rStrName )
+{
+    FeaturePtr pFeature;
+    GetFeature( rStrName, pFeature );
+    return FloatFeature( pFeature );
+}
+
+//
+// Gets the handles of the features written while the camera streams,
+// resolved when the camera was attached
+//
+// Returns:
+//  The handle, invalid if the camera has no such feature
+//
+FloatFeature FeatureCache::GetExposureTimeFeature() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_ExposureTime;
+}
+
+FloatFeature FeatureCache::GetGainFeature() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_Gain;
+}
+
+IntFeature FeatureCache::GetPacketSizeFeature() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_PacketSize;
+}
+
+VmbErrorType FeatureCache::GetIntValue( const std::string &rStrName, VmbInt64_t &rValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( rStrName, pFeature );
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rValue );
+    }
+    return res;
+}
+
+VmbErrorType FeatureCache::SetIntValue( const std::string &rStrName, VmbInt64_t value )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( rStrName, pFeature );
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( value );
+    }
+    return res;
+}
+
+VmbErrorType FeatureCache::GetFloatValue( const std::string &rStrName, double &rValue )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( rStrName, pFeature );
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->GetValue( rValue );
+    }
+    return res;
+}
+
+VmbErrorType FeatureCache::SetFloatValue( const std::string &rStrName, double value )
+{
+    FeaturePtr pFeature;
+    VmbErrorType res = GetFeature( rStrName, pFeature );
+    if( VmbErrorSuccess == res )
+    {
+        res = SP_ACCESS( pFeature )->SetValue( value );
+    }
+    return res;
+}
+
+VmbUint64_t FeatureCache::GetLookupCount() const
+{
+    return m_nLookups.load();
+}
+
+VmbUint64_t FeatureCache::GetHitCount() const
+{
+    return m_nHits.load();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,170 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureCache.h
+
+  Description: Per camera cache of resolved feature handles. A feature name
+               is looked up through GenICam once, afterwards it is accessed
+               through its FeaturePtr without any string lookup.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FEATURECACHE
+#define AVT_VMBAPI_EXAMPLES_FEATURECACHE
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A resolved feature of a known type. Get and Set go straight to the
+// feature, the name is not looked up again.
+//
+template <typename T>
+class TypedFeature
+{
+  public:
+    TypedFeature() {;}
+    explicit TypedFeature( const FeaturePtr &pFeature ) : m_pFeature( pFeature ) {;}
+
+    bool IsValid() const
+    {
+        return !SP_ISNULL( m_pFeature );
+    }
+
+    VmbErrorType Get( T &rValue ) const
+    {
+        if( SP_ISNULL( m_pFeature ) )
+        {
+            return VmbErrorNotFound;
+        }
+        return SP_ACCESS( m_pFeature )->GetValue( rValue );
+    }
+
+    VmbErrorType Set( T value ) const
+    {
+        if( SP_ISNULL( m_pFeature ) )
+        {
+            return VmbErrorNotFound;
+        }
+        return SP_ACCESS( m_pFeature )->SetValue( value );
+    }
+
+  private:
+    FeaturePtr m_pFeature;
+};
+
+typedef TypedFeature<VmbInt64_t>    IntFeature;
+typedef TypedFeature<double>        FloatFeature;
+
+class FeatureCache
+{
+  public:
+    FeatureCache();
+
+    //
+    // Binds the cache to a freshly opened camera and resolves the features
+    // the example uses all the time
+    //
+    // Parameters:
+    //  [in]    pCamera         The open camera
+    //
+    void            Attach( const CameraPtr &pCamera );
+
+    //
+    // Drops all handles. Must be called before the camera is closed, the
+    // handles of a closed camera are no longer valid.
+    //
+    void            Invalidate();
+
+    //
+    // Gets the handle of a feature, resolving it on first use
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the feature
+    //  [out]   rpFeature       The feature
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    GetFeature( const std::string &rStrName, FeaturePtr &rpFeature );
+
+    //
+    // Gets a typed handle for repeated access without string lookups
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the feature
+    //
+    // Returns:
+    //  The handle, invalid if the camera has no such feature
+    //
+    IntFeature      GetIntFeature( const std::string &rStrName );
+    FloatFeature    GetFloatFeature( const std::string &rStrName );
+
+    //
+    // Gets the handles of the features written while the camera streams,
+    // resolved when the camera was attached
+    //
+    // Returns:
+    //  The handle, invalid if the camera has no such feature
+    //
+    FloatFeature    GetExposureTimeFeature() const;
+    FloatFeature    GetGainFeature() const;
+    IntFeature      GetPacketSizeFeature() const;
+
+    //
+    // Typed convenience access by name, each resolves the name only once
+    //
+    VmbErrorType    GetIntValue( const std::string &rStrName, VmbInt64_t &rValue );
+    VmbErrorType    SetIntValue( const std::string &rStrName, VmbInt64_t value );
+    VmbErrorType    GetFloatValue( const std::string &rStrName, double &rValue );
+    VmbErrorType    SetFloatValue( const std::string &rStrName, double value );
+
+    //
+    // Gets how often names were resolved through GenICam and how often a
+    // cached handle was used instead
+    //
+    VmbUint64_t     GetLookupCount() const;
+    VmbUint64_t     GetHitCount() const;
+
+  private:
+    typedef std::map<std::string, FeaturePtr> FeatureMap;
+
+    CameraPtr                   m_pCamera;
+    FeatureMap                  m_Features;
+    FloatFeature                m_ExposureTime;
+    FloatFeature                m_Gain;
+    IntFeature                  m_PacketSize;
+    // Features are accessed from the UI and from worker threads
+    mutable std::mutex          m_Mutex;
+    std::atomic<VmbUint64_t>    m_nLookups;
+    std::atomic<VmbUint64_t>    m_nHits;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
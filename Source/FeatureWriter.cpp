@@ -0,0 +1,253 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureWriter.cpp
+
+  Description: Writes features of a camera on a thread of its own. A write
+               that is still pending is replaced by a newer one, writes
+               from the UI wait until the value stops changing.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <FeatureWriter.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Starts the writer thread
+//
+// Parameters:
+//  [in]    write           Writes one feature
+//  [in]    nMaxHoldMs      The longest a debounced write waits for the
+//                          value to settle, so a long drag still shows
+//
+FeatureWriter::FeatureWriter( const WriteFunction &write, VmbUint32_t nMaxHoldMs )
+    : m_Write( write )
+    , m_MaxHold( std::chrono::milliseconds( nMaxHoldMs ) )
+    , m_dLatencySumMs( 0.0 )
+    , m_nFlushing( 0 )
+    , m_bWriting( false )
+    , m_bShutDown( false )
+{
+    m_Statistics.nRequested     = 0;
+    m_Statistics.nWritten       = 0;
+    m_Statistics.nCoalesced     = 0;
+    m_Statistics.nFailed        = 0;
+    m_Statistics.nBatches       = 0;
+    m_Statistics.eLastError     = VmbErrorSuccess;
+    m_Statistics.dMeanLatencyMs = 0.0;
+    m_Statistics.dMaxLatencyMs  = 0.0;
+    m_Thread = std::thread( &FeatureWriter::WriterThread, this );
+}
+
+//
+// Writes what is still pending and stops the thread
+//
+FeatureWriter::~FeatureWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bShutDown = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+}
+
+//
+// Queues a write and returns at once. Features are written in the
+// order they were first queued, a pending write of the same feature
+// only gets the new value.
+//
+// Parameters:
+//  [in]    rStrName        The name of the feature
+//  [in]    value           The value to write
+//  [in]    nDebounceMs     Time without a newer value before it is
+//                          written, 0 to write as soon as possible
+//
+void FeatureWriter::SetFloat( const std::string &rStrName, double value, VmbUint32_t nDebounceMs )
+{
+    Value write = { true, 0, value };
+    Queue( rStrName, write, nDebounceMs );
+}
+
+void FeatureWriter::SetInt( const std::string &rStrName, VmbInt64_t value, VmbUint32_t nDebounceMs )
+{
+    Value write = { false, value, 0.0 };
+    Queue( rStrName, write, nDebounceMs );
+}
+
+//
+// Writes everything pending without waiting for debounce and returns
+// once it is done, e.g. before features get locked by streaming
+//
+void FeatureWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    ++m_nFlushing;
+    m_Condition.notify_all();
+    m_IdleCondition.wait( lock, [this]() { return m_Pending.empty() && !m_bWriting; } );
+    --m_nFlushing;
+}
+
+//
+// Throws away all writes that are still pending, e.g. when the camera closes
+//
+void FeatureWriter::Discard()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Pending.clear();
+    }
+    m_IdleCondition.notify_all();
+}
+
+//
+// Reports the result of every write from now on
+//
+// Parameters:
+//  [in]    callback        Called on the writer thread, empty for none
+//
+void FeatureWriter::SetCompletionCallback( const CompletionCallback &callback )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Completion = callback;
+}
+
+FeatureWriter::Statistics FeatureWriter::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    Statistics statistics = m_Statistics;
+    const VmbUint64_t nDone = statistics.nWritten + statistics.nFailed;
+    statistics.dMeanLatencyMs = 0 == nDone ? 0.0 : m_dLatencySumMs / nDone;
+    return statistics;
+}
+
+void FeatureWriter::Queue( const std::string &rStrName, const Value &rValue, VmbUint32_t nDebounceMs )
+{
+    const Clock::time_point now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        ++m_Statistics.nRequested;
+        for( size_t i = 0; i < m_Pending.size(); ++i )
+        {
+            PendingWrite &rPending = m_Pending[i];
+            if( rPending.strName == rStrName )
+            {
+                // Last value wins, the camera never sees the one in between.
+                // Every new value starts the debounce over, but not beyond
+                // the hold limit.
+                rPending.value = rValue;
+                rPending.due = (std::min)( now + std::chrono::milliseconds( nDebounceMs ), rPending.queued + m_MaxHold );
+                ++m_Statistics.nCoalesced;
+                m_Condition.notify_one();
+                return;
+            }
+        }
+        PendingWrite pending;
+        pending.strName = rStrName;
+        pending.value   = rValue;
+        pending.queued  = now;
+        pending.due     = now + (std::min)( Clock::duration( std::chrono::milliseconds( nDebounceMs ) ), m_MaxHold );
+        m_Pending.push_back( pending );
+    }
+    m_Condition.notify_one();
+}
+
+void FeatureWriter::WriterThread()
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    for( ;; )
+    {
+        if( m_Pending.empty() )
+        {
+            if( m_bShutDown )
+            {
+                return;
+            }
+            m_Condition.wait( lock );
+            continue;
+        }
+
+        // Shut down and flush do not wait for values to settle
+        const bool bAllDue = m_bShutDown || 0 != m_nFlushing;
+        const Clock::time_point now = Clock::now();
+        Clock::time_point nextDue = m_Pending.front().due;
+        for( size_t i = 1; i < m_Pending.size(); ++i )
+        {
+            nextDue = (std::min)( nextDue, m_Pending[i].due );
+        }
+        if( !bAllDue && nextDue > now )
+        {
+            m_Condition.wait_until( lock, nextDue );
+            continue;
+        }
+
+        // The camera may take a while, new writes queue up meanwhile and
+        // replace each other. Writes that are not due keep their order.
+        std::vector<PendingWrite> batch;
+        std::vector<PendingWrite> notDue;
+        for( size_t i = 0; i < m_Pending.size(); ++i )
+        {
+            ( bAllDue || m_Pending[i].due <= now ? batch : notDue ).push_back( m_Pending[i] );
+        }
+        m_Pending.swap( notDue );
+        ++m_Statistics.nBatches;
+        m_bWriting = true;
+        const CompletionCallback completion = m_Completion;
+        lock.unlock();
+
+        for( size_t i = 0; i < batch.size(); ++i )
+        {
+            const VmbErrorType res = m_Write( batch[i].strName, batch[i].value );
+            const double dLatencyMs = std::chrono::duration<double, std::milli>( Clock::now() - batch[i].queued ).count();
+            {
+                std::lock_guard<std::mutex> statisticsLock( m_Mutex );
+                if( VmbErrorSuccess == res )
+                {
+                    ++m_Statistics.nWritten;
+                }
+                else
+                {
+                    ++m_Statistics.nFailed;
+                    m_Statistics.eLastError = res;
+                }
+                m_dLatencySumMs += dLatencyMs;
+                m_Statistics.dMaxLatencyMs = (std::max)( m_Statistics.dMaxLatencyMs, dLatencyMs );
+            }
+            if( completion )
+            {
+                completion( batch[i].strName, batch[i].value, res, dLatencyMs );
+            }
+        }
+
+        lock.lock();
+        m_bWriting = false;
+        if( m_Pending.empty() )
+        {
+            m_IdleCondition.notify_all();
+        }
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,165 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FeatureWriter.h
+
+  Description: Writes features of a camera on a thread of its own. A write
+               that is still pending is replaced by a newer one, writes
+               from the UI wait until the value stops changing.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FEATUREWRITER
+#define AVT_VMBAPI_EXAMPLES_FEATUREWRITER
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class FeatureWriter
+{
+  public:
+    struct Value
+    {
+        bool            bIsFloat;
+        VmbInt64_t      nValue;
+        double          dValue;
+    };
+
+    // Does the actual write, called on the writer thread
+    typedef std::function<VmbErrorType( const std::string &rStrName, const Value &rValue )> WriteFunction;
+
+    // Called on the writer thread after every write with its result and
+    // the time from the first queued value to the completed write
+    typedef std::function<void( const std::string &rStrName, const Value &rValue, VmbErrorType eResult, double dLatencyMs )> CompletionCallback;
+
+    struct Statistics
+    {
+        VmbUint64_t     nRequested;
+        VmbUint64_t     nWritten;
+        // Replaced by a newer value before they were written
+        VmbUint64_t     nCoalesced;
+        VmbUint64_t     nFailed;
+        // Writes taken from the queue together
+        VmbUint64_t     nBatches;
+        VmbErrorType    eLastError;
+        double          dMeanLatencyMs;
+        double          dMaxLatencyMs;
+    };
+
+    //
+    // Starts the writer thread
+    //
+    // Parameters:
+    //  [in]    write           Writes one feature
+    //  [in]    nMaxHoldMs      The longest a debounced write waits for the
+    //                          value to settle, so a long drag still shows
+    //
+    explicit FeatureWriter( const WriteFunction &write, VmbUint32_t nMaxHoldMs = 250 );
+
+    //
+    // Writes what is still pending and stops the thread
+    //
+    ~FeatureWriter();
+
+    //
+    // Queues a write and returns at once. Features are written in the
+    // order they were first queued, a pending write of the same feature
+    // only gets the new value.
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the feature
+    //  [in]    value           The value to write
+    //  [in]    nDebounceMs     Time without a newer value before it is
+    //                          written, 0 to write as soon as possible
+    //
+    void            SetFloat( const std::string &rStrName, double value, VmbUint32_t nDebounceMs = 0 );
+    void            SetInt( const std::string &rStrName, VmbInt64_t value, VmbUint32_t nDebounceMs = 0 );
+
+    //
+    // Writes everything pending without waiting for debounce and returns
+    // once it is done, e.g. before features get locked by streaming
+    //
+    void            Flush();
+
+    //
+    // Throws away all writes that are still pending, e.g. when the camera closes
+    //
+    void            Discard();
+
+    //
+    // Reports the result of every write from now on
+    //
+    // Parameters:
+    //  [in]    callback        Called on the writer thread, empty for none
+    //
+    void            SetCompletionCallback( const CompletionCallback &callback );
+
+    Statistics      GetStatistics() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct PendingWrite
+    {
+        std::string         strName;
+        Value               value;
+        // The first value queued since the last write of the feature
+        Clock::time_point   queued;
+        Clock::time_point   due;
+    };
+
+    // No copies, the object owns a thread
+    FeatureWriter( const FeatureWriter& );
+    FeatureWriter& operator=( const FeatureWriter& );
+
+    void Queue( const std::string &rStrName, const Value &rValue, VmbUint32_t nDebounceMs );
+    void WriterThread();
+
+    WriteFunction                   m_Write;
+    CompletionCallback              m_Completion;
+    const Clock::duration           m_MaxHold;
+    std::vector<PendingWrite>       m_Pending;
+    Statistics                      m_Statistics;
+    double                          m_dLatencySumMs;
+    mutable std::mutex              m_Mutex;
+    std::condition_variable         m_Condition;
+    // Signalled whenever the queue runs empty
+    std::condition_variable         m_IdleCondition;
+    // Flush calls waiting, pending writes are due at once meanwhile
+    VmbUint32_t                     m_nFlushing;
+    bool                            m_bWriting;
+    bool                            m_bShutDown;
+    std::thread                     m_Thread;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,529 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FlatField.cpp
+
+  Description: Flat-field and dark-frame correction: per pixel gain and
+               offset maps built from frame stacks, stored per camera.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <FlatField.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_FLATFIELD_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+enum { CALIBRATION_FILE_MAGIC = 0x43464641, CALIBRATION_FILE_VERSION = 1, };
+
+namespace {
+
+// The file starts with this, the gains and then the offsets follow
+struct CalibrationFileHeader
+{
+    VmbUint32_t     nMagic;
+    VmbUint32_t     nVersion;
+    VmbUint32_t     nWidth;
+    VmbUint32_t     nHeight;
+    VmbUint32_t     nPixelFormat;
+    VmbUint32_t     nDarkFrames;
+    VmbUint32_t     nFlatFrames;
+    VmbUint32_t     nReserved;
+};
+
+// Color pixels have a sample per channel, all others one
+VmbUint32_t GetSamplesPerPixel( VmbPixelFormatType ePixelFormat )
+{
+    return 3 == GetBytesPerPixel( ePixelFormat ) ? 3 : 1;
+}
+
+// Samples of one phase saw the same color filter
+VmbUint32_t GetPhase( VmbPixelFormatType ePixelFormat, VmbUint32_t nSample, VmbUint32_t nRow )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( ePixelFormat );
+    if( 3 == nBytesPerPixel )
+    {
+        return nSample % 3;
+    }
+    if( 1 == nBytesPerPixel && VmbPixelFormatMono8 != ePixelFormat )
+    {
+        return ( nRow & 1 ) * 2 + ( nSample & 1 );
+    }
+    return 0;
+}
+
+template <typename T>
+void CorrectRowScalar( const T *pSource, const VmbUint16_t *pGains, const VmbUint16_t *pOffsets, VmbUint32_t nFullScale, VmbUint32_t nFirst, VmbUint32_t nEnd, T *pTarget )
+{
+    for( VmbUint32_t i = nFirst; i < nEnd; ++i )
+    {
+        const VmbUint32_t nSignal = pSource[i] > pOffsets[i] ? pSource[i] - pOffsets[i] : 0;
+        const VmbUint32_t nCorrected = ( nSignal * pGains[i] + ( 1u << ( FLAT_FIELD_GAIN_BITS - 1 ) ) ) >> FLAT_FIELD_GAIN_BITS;
+        pTarget[i] = static_cast<T>( (std::min)( nCorrected, nFullScale ) );
+    }
+}
+
+void CorrectRow8( const VmbUchar_t *pSource, const VmbUint16_t *pGains, const VmbUint16_t *pOffsets, VmbUint32_t nSamples, VmbUchar_t *pTarget )
+{
+    VmbUint32_t i = 0;
+#ifdef AVT_FLATFIELD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 16 <= nSamples; i += 16 )
+    {
+        const __m128i raw = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSource + i ) );
+        __m128i halves[2] = { _mm_unpacklo_epi8( raw, zero ), _mm_unpackhi_epi8( raw, zero ) };
+        for( int h = 0; h < 2; ++h )
+        {
+            const __m128i offsets = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pOffsets + i + 8 * h ) );
+            const __m128i gains = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pGains + i + 8 * h ) );
+            // 8 bit signals times 32 keep the high word of the product at
+            // twice the result, averaging with 0 rounds it
+            const __m128i signal = _mm_subs_epu16( halves[h], offsets );
+            halves[h] = _mm_avg_epu16( _mm_mulhi_epu16( _mm_slli_epi16( signal, 16 - FLAT_FIELD_GAIN_BITS + 1 ), gains ), zero );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pTarget + i ), _mm_packus_epi16( halves[0], halves[1] ) );
+    }
+#endif
+    CorrectRowScalar<VmbUchar_t>( pSource, pGains, pOffsets, 0xFF, i, nSamples, pTarget );
+}
+
+void CorrectRow16( const VmbUint16_t *pSource, const VmbUint16_t *pGains, const VmbUint16_t *pOffsets, VmbUint32_t nSamples, VmbUint32_t nFullScale, VmbUint16_t *pTarget )
+{
+    VmbUint32_t i = 0;
+#ifdef AVT_FLATFIELD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16( 1 );
+    const __m128i headroom = _mm_set1_epi16( static_cast<short>( 0xFFFF - nFullScale ) );
+    for( ; i + 8 <= nSamples; i += 8 )
+    {
+        const __m128i raw = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSource + i ) );
+        const __m128i offsets = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pOffsets + i ) );
+        const __m128i gains = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pGains + i ) );
+        const __m128i signal = _mm_subs_epu16( raw, offsets );
+        // The 32 bit product shifted right, rounded by the highest bit shifted out
+        const __m128i low = _mm_mullo_epi16( signal, gains );
+        const __m128i high = _mm_mulhi_epu16( signal, gains );
+        __m128i corrected = _mm_or_si128(   _mm_slli_epi16( high, 16 - FLAT_FIELD_GAIN_BITS ),
+                                            _mm_srli_epi16( low, FLAT_FIELD_GAIN_BITS ) );
+        corrected = _mm_adds_epu16( corrected, _mm_and_si128( _mm_srli_epi16( low, FLAT_FIELD_GAIN_BITS - 1 ), one ) );
+        // Products beyond 16 bit after the shift saturate
+        const __m128i fits = _mm_cmpeq_epi16( _mm_srli_epi16( high, FLAT_FIELD_GAIN_BITS ), zero );
+        corrected = _mm_or_si128( corrected, _mm_andnot_si128( fits, _mm_cmpeq_epi16( zero, zero ) ) );
+        // Unsigned minimum with full scale
+        corrected = _mm_subs_epu16( _mm_adds_epu16( corrected, headroom ), headroom );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pTarget + i ), corrected );
+    }
+#endif
+    CorrectRowScalar<VmbUint16_t>( pSource, pGains, pOffsets, nFullScale, i, nSamples, pTarget );
+}
+
+}
+
+CalibrationMaps::CalibrationMaps()
+    : m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_ePixelFormat( VmbPixelFormatMono8 )
+    , m_nDarkFrames( 0 )
+    , m_nFlatFrames( 0 )
+    , m_hFile( NULL )
+    , m_hMapping( NULL )
+    , m_pView( NULL )
+    , m_pGains( NULL )
+    , m_pOffsets( NULL )
+{
+}
+
+CalibrationMaps::~CalibrationMaps()
+{
+    Unmap();
+}
+
+void CalibrationMaps::Unmap()
+{
+    if( NULL != m_pView )
+    {
+        UnmapViewOfFile( m_pView );
+        m_pView = NULL;
+    }
+    if( NULL != m_hMapping )
+    {
+        CloseHandle( m_hMapping );
+        m_hMapping = NULL;
+    }
+    if( NULL != m_hFile )
+    {
+        CloseHandle( m_hFile );
+        m_hFile = NULL;
+    }
+    m_pGains = NULL;
+    m_pOffsets = NULL;
+}
+
+//
+// Maps a file written by Save. The maps stay valid until this is destroyed.
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  VmbErrorNotFound if there is no such file,
+//  VmbErrorInvalidValue if it is no calibration file
+//
+VmbErrorType CalibrationMaps::Load( const std::string &rStrPath )
+{
+    Unmap();
+    m_Gains.clear();
+    m_Offsets.clear();
+
+    std::wstring strPath( rStrPath.begin(), rStrPath.end() );
+    HANDLE hFile = CreateFile( strPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( INVALID_HANDLE_VALUE == hFile )
+    {
+        return VmbErrorNotFound;
+    }
+    m_hFile = hFile;
+    LARGE_INTEGER size;
+    if(     !GetFileSizeEx( hFile, &size )
+        ||  size.QuadPart < static_cast<LONGLONG>( sizeof( CalibrationFileHeader ) ) )
+    {
+        Unmap();
+        return VmbErrorInvalidValue;
+    }
+    m_hMapping = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+    m_pView = NULL == m_hMapping ? NULL : MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 );
+    if( NULL == m_pView )
+    {
+        Unmap();
+        return VmbErrorResources;
+    }
+
+    const CalibrationFileHeader *pHeader = static_cast<const CalibrationFileHeader*>( m_pView );
+    const VmbPixelFormatType ePixelFormat = static_cast<VmbPixelFormatType>( pHeader->nPixelFormat );
+    const unsigned long long nSamples = static_cast<unsigned long long>( pHeader->nWidth ) * pHeader->nHeight * GetSamplesPerPixel( ePixelFormat );
+    if(     CALIBRATION_FILE_MAGIC != pHeader->nMagic
+        ||  CALIBRATION_FILE_VERSION != pHeader->nVersion
+        ||  0 == GetBytesPerPixel( ePixelFormat )
+        ||  static_cast<unsigned long long>( size.QuadPart ) != sizeof( CalibrationFileHeader ) + 2 * nSamples * sizeof( VmbUint16_t ) )
+    {
+        Unmap();
+        return VmbErrorInvalidValue;
+    }
+    m_nWidth        = pHeader->nWidth;
+    m_nHeight       = pHeader->nHeight;
+    m_ePixelFormat  = ePixelFormat;
+    m_nDarkFrames   = pHeader->nDarkFrames;
+    m_nFlatFrames   = pHeader->nFlatFrames;
+    m_pGains        = reinterpret_cast<const VmbUint16_t*>( pHeader + 1 );
+    m_pOffsets      = m_pGains + nSamples;
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the maps to a file. It is replaced as a whole, so readers never
+// see half of it.
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType CalibrationMaps::Save( const std::string &rStrPath ) const
+{
+    if( NULL == m_pGains )
+    {
+        return VmbErrorInvalidCall;
+    }
+    CalibrationFileHeader header;
+    header.nMagic       = CALIBRATION_FILE_MAGIC;
+    header.nVersion     = CALIBRATION_FILE_VERSION;
+    header.nWidth       = m_nWidth;
+    header.nHeight      = m_nHeight;
+    header.nPixelFormat = static_cast<VmbUint32_t>( m_ePixelFormat );
+    header.nDarkFrames  = m_nDarkFrames;
+    header.nFlatFrames  = m_nFlatFrames;
+    header.nReserved    = 0;
+    const size_t nSamples = static_cast<size_t>( m_nWidth ) * m_nHeight * GetSamplesPerPixel( m_ePixelFormat );
+
+    const std::string strTemporary = rStrPath + ".tmp";
+    FILE *pFile = fopen( strTemporary.c_str(), "wb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorResources;
+    }
+    const bool bWritten =   1 == fwrite( &header, sizeof( header ), 1, pFile )
+                        &&  nSamples == fwrite( m_pGains, sizeof( VmbUint16_t ), nSamples, pFile )
+                        &&  nSamples == fwrite( m_pOffsets, sizeof( VmbUint16_t ), nSamples, pFile );
+    if( 0 != fclose( pFile ) || !bWritten )
+    {
+        return VmbErrorResources;
+    }
+    if( !MoveFileExA( strTemporary.c_str(), rStrPath.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+        return VmbErrorResources;
+    }
+    return VmbErrorSuccess;
+}
+
+bool CalibrationMaps::Matches( const ImageView &rView ) const
+{
+    return      NULL != m_pGains
+            &&  rView.nWidth == m_nWidth
+            &&  rView.nHeight == m_nHeight
+            &&  rView.ePixelFormat == m_ePixelFormat;
+}
+
+CalibrationBuilder::CalibrationBuilder()
+{
+    Reset();
+}
+
+void CalibrationBuilder::Reset()
+{
+    m_nWidth = 0;
+    m_nHeight = 0;
+    m_ePixelFormat = VmbPixelFormatMono8;
+    m_nDarkFrames = 0;
+    m_nFlatFrames = 0;
+    m_DarkSums.clear();
+    m_FlatSums.clear();
+}
+
+//
+// Adds a frame to a stack. The first frame sets size and format.
+//
+// Parameters:
+//  [in]    eType           The stack
+//  [in]    rView           The frame
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support,
+//  VmbErrorBadParameter for a frame of another size or format
+//
+VmbErrorType CalibrationBuilder::Add( CalibrationFrameType eType, const ImageView &rView )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+    if( NULL == rView.pBuffer || 0 == rView.nWidth || 0 == rView.nHeight )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nRowSamples = rView.nWidth * GetSamplesPerPixel( rView.ePixelFormat );
+    if( 0 == m_nDarkFrames + m_nFlatFrames )
+    {
+        m_nWidth = rView.nWidth;
+        m_nHeight = rView.nHeight;
+        m_ePixelFormat = rView.ePixelFormat;
+        m_DarkSums.assign( static_cast<size_t>( nRowSamples ) * m_nHeight, 0 );
+        m_FlatSums.assign( m_DarkSums.size(), 0 );
+    }
+    else if(    rView.nWidth != m_nWidth
+            ||  rView.nHeight != m_nHeight
+            ||  rView.ePixelFormat != m_ePixelFormat )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    std::vector<VmbUint32_t> &rSums = CalibrationDark == eType ? m_DarkSums : m_FlatSums;
+    for( VmbUint32_t y = 0; y < m_nHeight; ++y )
+    {
+        const VmbUchar_t *pRow = rView.pBuffer + static_cast<size_t>( y ) * rView.nStride;
+        VmbUint32_t *pSums = &rSums[static_cast<size_t>( y ) * nRowSamples];
+        if( 2 == nBytesPerPixel )
+        {
+            const VmbUint16_t *pSamples = reinterpret_cast<const VmbUint16_t*>( pRow );
+            for( VmbUint32_t i = 0; i < nRowSamples; ++i )
+            {
+                pSums[i] += pSamples[i];
+            }
+        }
+        else
+        {
+            for( VmbUint32_t i = 0; i < nRowSamples; ++i )
+            {
+                pSums[i] += pRow[i];
+            }
+        }
+    }
+    ++( CalibrationDark == eType ? m_nDarkFrames : m_nFlatFrames );
+    return VmbErrorSuccess;
+}
+
+VmbUint32_t CalibrationBuilder::GetCount( CalibrationFrameType eType ) const
+{
+    return CalibrationDark == eType ? m_nDarkFrames : m_nFlatFrames;
+}
+
+//
+// Gets the sums of a stack, a sample after the other and a row after
+// the other. Divided by GetCount they are the mean frame.
+//
+// Returns:
+//  The sums, NULL while the stack is empty
+//
+const VmbUint32_t* CalibrationBuilder::GetSums( CalibrationFrameType eType ) const
+{
+    if( 0 == GetCount( eType ) )
+    {
+        return NULL;
+    }
+    return &( CalibrationDark == eType ? m_DarkSums : m_FlatSums )[0];
+}
+
+//
+// Builds the maps. Every color of the sensor keeps its mean response,
+// the gains only even out the pixels of one color. Without dark frames
+// the offsets are 0.
+//
+// Parameters:
+//  [out]   rMaps           The maps
+//
+// Returns:
+//  VmbErrorInvalidCall without flat frames
+//
+VmbErrorType CalibrationBuilder::Build( CalibrationMaps &rMaps ) const
+{
+    if( 0 == m_nFlatFrames )
+    {
+        return VmbErrorInvalidCall;
+    }
+    const VmbUint32_t nRowSamples = m_nWidth * GetSamplesPerPixel( m_ePixelFormat );
+    const size_t nSamples = static_cast<size_t>( nRowSamples ) * m_nHeight;
+    std::vector<double> signals( nSamples );
+    double dPhaseSums[4] = { 0.0, 0.0, 0.0, 0.0 };
+    VmbUint64_t nPhaseCounts[4] = { 0, 0, 0, 0 };
+    rMaps.Unmap();
+    rMaps.m_Offsets.resize( nSamples );
+    for( VmbUint32_t y = 0; y < m_nHeight; ++y )
+    {
+        for( VmbUint32_t i = 0; i < nRowSamples; ++i )
+        {
+            const size_t n = static_cast<size_t>( y ) * nRowSamples + i;
+            const double dDark = 0 == m_nDarkFrames ? 0.0 : static_cast<double>( m_DarkSums[n] ) / m_nDarkFrames;
+            signals[n] = static_cast<double>( m_FlatSums[n] ) / m_nFlatFrames - dDark;
+            rMaps.m_Offsets[n] = static_cast<VmbUint16_t>( dDark + 0.5 );
+            if( signals[n] >= 1.0 )
+            {
+                const VmbUint32_t nPhase = GetPhase( m_ePixelFormat, i, y );
+                dPhaseSums[nPhase] += signals[n];
+                ++nPhaseCounts[nPhase];
+            }
+        }
+    }
+
+    // Pixels that did not respond keep a gain of 1, they are defects
+    const double dMaxGain = 65535.0 / ( 1 << FLAT_FIELD_GAIN_BITS );
+    rMaps.m_Gains.resize( nSamples );
+    for( VmbUint32_t y = 0; y < m_nHeight; ++y )
+    {
+        for( VmbUint32_t i = 0; i < nRowSamples; ++i )
+        {
+            const size_t n = static_cast<size_t>( y ) * nRowSamples + i;
+            const VmbUint32_t nPhase = GetPhase( m_ePixelFormat, i, y );
+            double dGain = 1.0;
+            if( signals[n] >= 1.0 )
+            {
+                dGain = (std::min)( dMaxGain, dPhaseSums[nPhase] / nPhaseCounts[nPhase] / signals[n] );
+            }
+            rMaps.m_Gains[n] = static_cast<VmbUint16_t>( dGain * ( 1 << FLAT_FIELD_GAIN_BITS ) + 0.5 );
+        }
+    }
+    rMaps.m_nWidth          = m_nWidth;
+    rMaps.m_nHeight         = m_nHeight;
+    rMaps.m_ePixelFormat    = m_ePixelFormat;
+    rMaps.m_nDarkFrames     = m_nDarkFrames;
+    rMaps.m_nFlatFrames     = m_nFlatFrames;
+    rMaps.m_pGains          = &rMaps.m_Gains[0];
+    rMaps.m_pOffsets        = &rMaps.m_Offsets[0];
+    return VmbErrorSuccess;
+}
+
+//
+// Corrects a frame by the maps in one pass: subtracts the offset,
+// multiplies by the gain and clamps to the range of the format
+//
+// Parameters:
+//  [in]    rView           The frame, the maps must match it
+//  [in]    rMaps           The maps
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   pTarget         The corrected frame, laid out like rView. May be rView.pBuffer.
+//
+// Returns:
+//  VmbErrorBadParameter if the maps do not match the frame
+//
+VmbErrorType CorrectFlatField( const ImageView &rView, const CalibrationMaps &rMaps, ThreadPool *pPool, VmbUchar_t *pTarget )
+{
+    if(     !rMaps.Matches( rView )
+        ||  NULL == rView.pBuffer
+        ||  NULL == pTarget )
+    {
+        return VmbErrorBadParameter;
+    }
+    const bool bIs16Bit = 2 == GetBytesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nFullScale = ( 1u << GetBitDepth( rView.ePixelFormat ) ) - 1;
+    const VmbUint32_t nRowSamples = rView.nWidth * GetSamplesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, rView.nHeight / MIN_STRIPE_ROWS ) );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nEndRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rView.nHeight ) * ( nStripe + 1 ) / nStripes );
+        for( VmbUint32_t y = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rView.nHeight ) * nStripe / nStripes ); y < nEndRow; ++y )
+        {
+            const size_t nRowOffset = static_cast<size_t>( y ) * rView.nStride;
+            const size_t nMapOffset = static_cast<size_t>( y ) * nRowSamples;
+            if( bIs16Bit )
+            {
+                CorrectRow16(   reinterpret_cast<const VmbUint16_t*>( rView.pBuffer + nRowOffset ),
+                                rMaps.GetGains() + nMapOffset, rMaps.GetOffsets() + nMapOffset, nRowSamples, nFullScale,
+                                reinterpret_cast<VmbUint16_t*>( pTarget + nRowOffset ) );
+            }
+            else
+            {
+                CorrectRow8(    rView.pBuffer + nRowOffset, rMaps.GetGains() + nMapOffset, rMaps.GetOffsets() + nMapOffset, nRowSamples,
+                                pTarget + nRowOffset );
+            }
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
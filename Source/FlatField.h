@@ -0,0 +1,204 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FlatField.h
+
+  Description: Flat-field and dark-frame correction: per pixel gain and
+               offset maps built from frame stacks, stored per camera.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FLATFIELD
+#define AVT_VMBAPI_EXAMPLES_FLATFIELD
+
+#include <string>
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum CalibrationFrameType
+{
+    CalibrationDark,        // Lens covered, the offset of every pixel
+    CalibrationFlat,        // Even illumination, the response of every pixel
+};
+
+// Gains are fixed point with this many bits of fraction, up to almost 16
+enum { FLAT_FIELD_GAIN_BITS = 12, };
+
+//
+// The gain and offset of every sample of a frame, a color pixel has three.
+// Corrected = ( raw - offset ) * gain. The maps are either built in memory
+// or mapped from a file.
+//
+class CalibrationMaps
+{
+  public:
+    CalibrationMaps();
+    ~CalibrationMaps();
+
+    //
+    // Maps a file written by Save. The maps stay valid until this is destroyed.
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  VmbErrorNotFound if there is no such file,
+    //  VmbErrorInvalidValue if it is no calibration file
+    //
+    VmbErrorType        Load( const std::string &rStrPath );
+
+    //
+    // Writes the maps to a file. It is replaced as a whole, so readers never
+    // see half of it.
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        Save( const std::string &rStrPath ) const;
+
+    // The maps were made for frames of the size and format of the view
+    bool                Matches( const ImageView &rView ) const;
+
+    VmbUint32_t         GetWidth() const                { return m_nWidth; }
+    VmbUint32_t         GetHeight() const               { return m_nHeight; }
+    VmbPixelFormatType  GetPixelFormat() const          { return m_ePixelFormat; }
+    VmbUint32_t         GetDarkFrames() const           { return m_nDarkFrames; }
+    VmbUint32_t         GetFlatFrames() const           { return m_nFlatFrames; }
+    // One entry per sample, row after row without padding
+    const VmbUint16_t*  GetGains() const                { return m_pGains; }
+    const VmbUint16_t*  GetOffsets() const              { return m_pOffsets; }
+
+  private:
+    friend class CalibrationBuilder;
+
+    // Not copyable, the pointers may go into a mapping
+    CalibrationMaps( const CalibrationMaps& );
+    CalibrationMaps& operator=( const CalibrationMaps& );
+
+    void                Unmap();
+
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbPixelFormatType          m_ePixelFormat;
+    VmbUint32_t                 m_nDarkFrames;
+    VmbUint32_t                 m_nFlatFrames;
+    // Filled by the builder
+    std::vector<VmbUint16_t>    m_Gains;
+    std::vector<VmbUint16_t>    m_Offsets;
+    // HANDLEs of the file and its mapping, and the mapped view
+    void                       *m_hFile;
+    void                       *m_hMapping;
+    const void                 *m_pView;
+    const VmbUint16_t          *m_pGains;
+    const VmbUint16_t          *m_pOffsets;
+};
+
+//
+// Sums stacks of dark and flat frames of one camera and builds the maps
+// from their means
+//
+class CalibrationBuilder
+{
+  public:
+    CalibrationBuilder();
+
+    // Forgets both stacks
+    void                Reset();
+
+    //
+    // Adds a frame to a stack. The first frame sets size and format.
+    //
+    // Parameters:
+    //  [in]    eType           The stack
+    //  [in]    rView           The frame
+    //
+    // Returns:
+    //  VmbErrorWrongType for pixel formats the views do not support,
+    //  VmbErrorBadParameter for a frame of another size or format
+    //
+    VmbErrorType        Add( CalibrationFrameType eType, const ImageView &rView );
+
+    VmbUint32_t         GetCount( CalibrationFrameType eType ) const;
+
+    VmbUint32_t         GetWidth() const                { return m_nWidth; }
+    VmbUint32_t         GetHeight() const               { return m_nHeight; }
+    VmbPixelFormatType  GetPixelFormat() const          { return m_ePixelFormat; }
+
+    //
+    // Gets the sums of a stack, a sample after the other and a row after
+    // the other. Divided by GetCount they are the mean frame.
+    //
+    // Returns:
+    //  The sums, NULL while the stack is empty
+    //
+    const VmbUint32_t*  GetSums( CalibrationFrameType eType ) const;
+
+    //
+    // Builds the maps. Every color of the sensor keeps its mean response,
+    // the gains only even out the pixels of one color. Without dark frames
+    // the offsets are 0.
+    //
+    // Parameters:
+    //  [out]   rMaps           The maps
+    //
+    // Returns:
+    //  VmbErrorInvalidCall without flat frames
+    //
+    VmbErrorType        Build( CalibrationMaps &rMaps ) const;
+
+  private:
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbPixelFormatType          m_ePixelFormat;
+    VmbUint32_t                 m_nDarkFrames;
+    VmbUint32_t                 m_nFlatFrames;
+    std::vector<VmbUint32_t>    m_DarkSums;
+    std::vector<VmbUint32_t>    m_FlatSums;
+};
+
+//
+// Corrects a frame by the maps in one pass: subtracts the offset,
+// multiplies by the gain and clamps to the range of the format
+//
+// Parameters:
+//  [in]    rView           The frame, the maps must match it
+//  [in]    rMaps           The maps
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   pTarget         The corrected frame, laid out like rView. May be rView.pBuffer.
+//
+// Returns:
+//  VmbErrorBadParameter if the maps do not match the frame
+//
+VmbErrorType CorrectFlatField( const ImageView &rView, const CalibrationMaps &rMaps, ThreadPool *pPool, VmbUchar_t *pTarget );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,143 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameLease.cpp
+
+  Description: Shared ownership of a received frame. The frame goes back
+               to the camera when the last holder lets go of it.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <FrameLease.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Parameters:
+//  [in]    pFrame          The received frame
+//  [in]    eReceiveStatus  The receive status of the frame
+//  [in]    release         Called with the frame when the lease ends,
+//                          usually queues the frame at the camera again
+//
+FrameLease::FrameLease( const FramePtr &pFrame, VmbFrameStatusType eReceiveStatus, const ReleaseFunction &release )
+    : m_pFrame( pFrame )
+    , m_eReceiveStatus( eReceiveStatus )
+    , m_nFrameID( 0 )
+    , m_Release( release )
+    , m_eImageResult( VmbErrorIncomplete )
+{
+    SP_ACCESS( m_pFrame )->GetFrameID( m_nFrameID );
+    if( VmbFrameStatusComplete == m_eReceiveStatus )
+    {
+        VmbUchar_t *pBuffer = NULL;
+        VmbUint32_t nWidth = 0;
+        VmbUint32_t nHeight = 0;
+        VmbPixelFormatType ePixelFormat = VmbPixelFormatMono8;
+        m_eImageResult = SP_ACCESS( m_pFrame )->GetImage( pBuffer );
+        if( VmbErrorSuccess == m_eImageResult )
+        {
+            m_eImageResult = SP_ACCESS( m_pFrame )->GetWidth( nWidth );
+        }
+        if( VmbErrorSuccess == m_eImageResult )
+        {
+            m_eImageResult = SP_ACCESS( m_pFrame )->GetHeight( nHeight );
+        }
+        if( VmbErrorSuccess == m_eImageResult )
+        {
+            m_eImageResult = SP_ACCESS( m_pFrame )->GetPixelFormat( ePixelFormat );
+        }
+        if( VmbErrorSuccess == m_eImageResult )
+        {
+            m_eImageResult = MakeImageView( pBuffer, nWidth, nHeight, ePixelFormat, m_Image );
+        }
+    }
+}
+
+//
+// Hands the frame back
+//
+FrameLease::~FrameLease()
+{
+    if( m_Release )
+    {
+        m_Release( m_pFrame );
+    }
+}
+
+const FramePtr& FrameLease::GetFrame() const
+{
+    return m_pFrame;
+}
+
+VmbFrameStatusType FrameLease::GetReceiveStatus() const
+{
+    return m_eReceiveStatus;
+}
+
+VmbUint64_t FrameLease::GetFrameID() const
+{
+    return m_nFrameID;
+}
+
+bool FrameLease::IsComplete() const
+{
+    return VmbFrameStatusComplete == m_eReceiveStatus;
+}
+
+//
+// Gets the current image, the camera buffer or the result of the
+// last stage that replaced it
+//
+// Parameters:
+//  [out]   rView           The image
+//
+// Returns:
+//  VmbErrorWrongType if the pixel format has no view
+//
+VmbErrorType FrameLease::GetImage( ImageView &rView ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    if( VmbErrorSuccess == m_eImageResult )
+    {
+        rView = m_Image;
+    }
+    return m_eImageResult;
+}
+
+//
+// Replaces the image for the following stages
+//
+// Parameters:
+//  [in]    rView           The new image
+//  [in]    pStorage        The buffer of the new image, kept as long as the lease
+//
+void FrameLease::SetImage( const ImageView &rView, const std::shared_ptr<const void> &pStorage )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Image = rView;
+    m_eImageResult = VmbErrorSuccess;
+    // Stages on other branches may still read the previous image
+    m_Storages.push_back( pStorage );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
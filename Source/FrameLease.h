@@ -0,0 +1,149 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameLease.h
+
+  Description: Shared ownership of a received frame. The frame goes back
+               to the camera when the last holder lets go of it.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMELEASE
+#define AVT_VMBAPI_EXAMPLES_FRAMELEASE
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Every stage of a pipeline that works on a frame holds a lease on it.
+// Stages never write into the camera buffer: a stage that changes the
+// image puts its result in a buffer of its own and replaces the image of
+// the lease. Earlier images stay valid as long as the lease lives.
+// Results of analysis stages travel with the lease as attachments.
+//
+class FrameLease
+{
+  public:
+    typedef std::function<void( const FramePtr& )> ReleaseFunction;
+
+    //
+    // Parameters:
+    //  [in]    pFrame          The received frame
+    //  [in]    eReceiveStatus  The receive status of the frame
+    //  [in]    release         Called with the frame when the lease ends,
+    //                          usually queues the frame at the camera again
+    //
+    FrameLease( const FramePtr &pFrame, VmbFrameStatusType eReceiveStatus, const ReleaseFunction &release );
+
+    //
+    // Hands the frame back
+    //
+    ~FrameLease();
+
+    const FramePtr&     GetFrame() const;
+    VmbFrameStatusType  GetReceiveStatus() const;
+    VmbUint64_t         GetFrameID() const;
+    bool                IsComplete() const;
+
+    //
+    // Gets the current image, the camera buffer or the result of the
+    // last stage that replaced it
+    //
+    // Parameters:
+    //  [out]   rView           The image
+    //
+    // Returns:
+    //  VmbErrorWrongType if the pixel format has no view
+    //
+    VmbErrorType        GetImage( ImageView &rView ) const;
+
+    //
+    // Replaces the image for the following stages
+    //
+    // Parameters:
+    //  [in]    rView           The new image
+    //  [in]    pStorage        The buffer of the new image, kept as long as the lease
+    //
+    void                SetImage( const ImageView &rView, const std::shared_ptr<const void> &pStorage );
+
+    //
+    // Attaches the result of a stage
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the result
+    //  [in]    pResult         The result
+    //
+    template <typename T>
+    void SetAttachment( const std::string &rStrName, const std::shared_ptr<const T> &pResult )
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Attachments[rStrName] = pResult;
+    }
+
+    //
+    // Gets the result of a stage
+    //
+    // Parameters:
+    //  [in]    rStrName        The name of the result
+    //
+    // Returns:
+    //  The result, empty if no stage attached it (yet)
+    //
+    template <typename T>
+    std::shared_ptr<const T> GetAttachment( const std::string &rStrName ) const
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        std::map<std::string, std::shared_ptr<const void> >::const_iterator iter = m_Attachments.find( rStrName );
+        return m_Attachments.end() == iter ? std::shared_ptr<const T>() : std::static_pointer_cast<const T>( iter->second );
+    }
+
+  private:
+    // No copies, there is only one lease per frame
+    FrameLease( const FrameLease& );
+    FrameLease& operator=( const FrameLease& );
+
+    FramePtr                                            m_pFrame;
+    VmbFrameStatusType                                  m_eReceiveStatus;
+    VmbUint64_t                                         m_nFrameID;
+    ReleaseFunction                                     m_Release;
+    mutable std::mutex                                  m_Mutex;
+    ImageView                                           m_Image;
+    VmbErrorType                                        m_eImageResult;
+    std::vector< std::shared_ptr<const void> >          m_Storages;
+    std::map<std::string, std::shared_ptr<const void> > m_Attachments;
+};
+
+typedef std::shared_ptr<FrameLease> FrameLeasePtr;
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,232 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameMetrics.cpp
+
+  Description: Frame counters of every stream and their Prometheus export
+               format.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <sstream>
+#include <iomanip>
+#include <FrameMetrics.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+enum MetricKind
+{
+    MetricCounter,
+    MetricGauge,
+};
+
+typedef double ( *MetricValue )( const StreamMetricsSnapshot &rCurrent, const StreamMetricsSnapshot *pPrevious, double dSeconds );
+
+struct MetricDescription
+{
+    const char     *pName;
+    MetricKind      eKind;
+    const char     *pHelp;
+    MetricValue     value;
+};
+
+double Rate( VmbUint64_t nCurrent, VmbUint64_t nPrevious, double dSeconds )
+{
+    return ( dSeconds > 0.0 && nCurrent >= nPrevious ) ? ( nCurrent - nPrevious ) / dSeconds : 0.0;
+}
+
+const MetricDescription s_Metrics[] =
+{
+    { "vmb_frames_received_total",      MetricCounter,  "Frames delivered by the transport layer",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nReceived ); } },
+    { "vmb_frames_complete_total",      MetricCounter,  "Frames received complete",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nComplete ); } },
+    { "vmb_frames_incomplete_total",    MetricCounter,  "Frames received with missing data",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nIncomplete ); } },
+    { "vmb_frames_requeued_total",      MetricCounter,  "Frames handed back to the transport layer after display",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nRequeued ); } },
+    { "vmb_frames_dropped_total",       MetricCounter,  "Frames requeued without being displayed",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nDropped ); } },
+    { "vmb_frame_id_gaps_total",        MetricCounter,  "Frame IDs that never arrived",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nFrameIDGaps ); } },
+    { "vmb_received_bytes_total",       MetricCounter,  "Image bytes received",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nBytes ); } },
+    { "vmb_frame_queue_depth",          MetricGauge,    "Frames waiting for the view",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nQueueDepth ); } },
+    { "vmb_frames_per_second",          MetricGauge,    "Frames received per second since the last export",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot *p, double s ) { return NULL == p ? 0.0 : Rate( c.nReceived, p->nReceived, s ); } },
+    { "vmb_received_bytes_per_second",  MetricGauge,    "Image bytes received per second since the last export",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot *p, double s ) { return NULL == p ? 0.0 : Rate( c.nBytes, p->nBytes, s ); } },
+    { "vmb_conversion_seconds_sum",     MetricCounter,  "Time spent converting frames for display",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.nConversionTimeUs / 1e6; } },
+    { "vmb_conversion_seconds_count",   MetricCounter,  "Frames converted for display",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nConversions ); } },
+    { "vmb_conversion_seconds_max",     MetricGauge,    "Longest conversion of a frame for display",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.nConversionMaxUs / 1e6; } },
+    { "vmb_frames_analysed_total",      MetricCounter,  "Frames the exposure statistics were computed for",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nAnalysed ); } },
+    { "vmb_image_mean",                 MetricGauge,    "Mean pixel value of the last analysed frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dImageMean; } },
+    { "vmb_image_min",                  MetricGauge,    "Smallest pixel value of the last analysed frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nImageMin ); } },
+    { "vmb_image_max",                  MetricGauge,    "Largest pixel value of the last analysed frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nImageMax ); } },
+    { "vmb_image_clipped_low_ratio",    MetricGauge,    "Part of the pixels at 0 in the last analysed frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dClippedLowRatio; } },
+    { "vmb_image_clipped_high_ratio",   MetricGauge,    "Part of the pixels at full scale in the last analysed frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dClippedHighRatio; } },
+    { "vmb_frames_focus_measured_total", MetricCounter, "Frames the sharpness was measured for",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nFocusMeasured ); } },
+    { "vmb_focus_laplacian_variance",   MetricGauge,    "Variance of the Laplacian in the focus region of the last measured frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dLaplacianVariance; } },
+    { "vmb_focus_tenengrad",            MetricGauge,    "Mean squared Sobel gradient in the focus region of the last measured frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dTenengrad; } },
+    { "vmb_motion_events_total",        MetricCounter,  "Times motion started",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nMotionEvents ); } },
+    { "vmb_motion_changed_ratio",       MetricGauge,    "Part of the motion grid that differed from the background in the last frame",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return c.dMotionChangedRatio; } },
+    { "vmb_motion_active",              MetricGauge,    "1 while motion is going on",
+      []( const StreamMetricsSnapshot &c, const StreamMetricsSnapshot*, double ) { return static_cast<double>( c.nMotionActive ); } },
+};
+
+}
+
+MetricsRegistry::MetricsRegistry()
+{
+}
+
+//
+// Adds a stream. The counters live as long as the registry.
+//
+// Parameters:
+//  [in]    rStrSlot        The label of the stream, e.g. the camera slot
+//
+// Returns:
+//  The counters to update from the frame path
+//
+StreamMetrics* MetricsRegistry::AddStream( const std::string &rStrSlot )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_Streams.emplace_back();
+    m_Streams.back().strSlot = rStrSlot;
+    return &m_Streams.back().metrics;
+}
+
+//
+// Sets the camera a stream belongs to, a label of the export
+//
+// Parameters:
+//  [in]    pStream         The counters of the stream
+//  [in]    rStrCameraID    The ID of the camera
+//
+void MetricsRegistry::SetCameraID( const StreamMetrics *pStream, const std::string &rStrCameraID )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    for( std::deque<Stream>::iterator iter = m_Streams.begin(); m_Streams.end() != iter; ++iter )
+    {
+        if( &iter->metrics == pStream )
+        {
+            iter->strCameraID = rStrCameraID;
+        }
+    }
+}
+
+//
+// Reads all counters
+//
+// Parameters:
+//  [out]   rSnapshots      One entry per stream
+//
+void MetricsRegistry::GetSnapshot( std::vector<StreamMetricsSnapshot> &rSnapshots ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    rSnapshots.resize( m_Streams.size() );
+    for( size_t i = 0; i < m_Streams.size(); ++i )
+    {
+        const StreamMetrics &rMetrics = m_Streams[i].metrics;
+        StreamMetricsSnapshot &rSnapshot = rSnapshots[i];
+        rSnapshot.strSlot           = m_Streams[i].strSlot;
+        rSnapshot.strCameraID       = m_Streams[i].strCameraID;
+        rSnapshot.nReceived         = rMetrics.nReceived.load( std::memory_order_relaxed );
+        rSnapshot.nComplete         = rMetrics.nComplete.load( std::memory_order_relaxed );
+        rSnapshot.nIncomplete       = rMetrics.nIncomplete.load( std::memory_order_relaxed );
+        rSnapshot.nRequeued         = rMetrics.nRequeued.load( std::memory_order_relaxed );
+        rSnapshot.nDropped          = rMetrics.nDropped.load( std::memory_order_relaxed );
+        rSnapshot.nFrameIDGaps      = rMetrics.nFrameIDGaps.load( std::memory_order_relaxed );
+        rSnapshot.nBytes            = rMetrics.nBytes.load( std::memory_order_relaxed );
+        rSnapshot.nQueueDepth       = rMetrics.nQueueDepth.load( std::memory_order_relaxed );
+        rSnapshot.nConversions      = rMetrics.nConversions.load( std::memory_order_relaxed );
+        rSnapshot.nConversionTimeUs = rMetrics.nConversionTimeUs.load( std::memory_order_relaxed );
+        rSnapshot.nConversionMaxUs  = rMetrics.nConversionMaxUs.load( std::memory_order_relaxed );
+        rSnapshot.nAnalysed         = rMetrics.nAnalysed.load( std::memory_order_relaxed );
+        rSnapshot.dImageMean        = rMetrics.dImageMean.load( std::memory_order_relaxed );
+        rSnapshot.nImageMin         = rMetrics.nImageMin.load( std::memory_order_relaxed );
+        rSnapshot.nImageMax         = rMetrics.nImageMax.load( std::memory_order_relaxed );
+        rSnapshot.dClippedLowRatio  = rMetrics.dClippedLowRatio.load( std::memory_order_relaxed );
+        rSnapshot.dClippedHighRatio = rMetrics.dClippedHighRatio.load( std::memory_order_relaxed );
+        rSnapshot.nFocusMeasured    = rMetrics.nFocusMeasured.load( std::memory_order_relaxed );
+        rSnapshot.dLaplacianVariance = rMetrics.dLaplacianVariance.load( std::memory_order_relaxed );
+        rSnapshot.dTenengrad        = rMetrics.dTenengrad.load( std::memory_order_relaxed );
+        rSnapshot.nMotionEvents     = rMetrics.nMotionEvents.load( std::memory_order_relaxed );
+        rSnapshot.dMotionChangedRatio = rMetrics.dMotionChangedRatio.load( std::memory_order_relaxed );
+        rSnapshot.nMotionActive     = rMetrics.nMotionActive.load( std::memory_order_relaxed );
+    }
+}
+
+//
+// Formats two snapshots in the Prometheus text format. Rates are taken
+// over the time between them.
+//
+// Parameters:
+//  [in]    rCurrent        The current snapshot
+//  [in]    rPrevious       The previous snapshot, may be empty
+//  [in]    dSeconds        The time between the two
+//  [out]   rStrText        The exposition text
+//
+void MetricsRegistry::FormatPrometheus( const std::vector<StreamMetricsSnapshot> &rCurrent,
+                                        const std::vector<StreamMetricsSnapshot> &rPrevious,
+                                        double dSeconds,
+                                        std::string &rStrText )
+{
+    std::ostringstream os;
+    // Counters stay exact far beyond what a session reaches
+    os << std::setprecision( 15 );
+    for( size_t m = 0; m < sizeof( s_Metrics ) / sizeof( s_Metrics[0] ); ++m )
+    {
+        const MetricDescription &rMetric = s_Metrics[m];
+        os << "# HELP " << rMetric.pName << " " << rMetric.pHelp << "\n";
+        os << "# TYPE " << rMetric.pName << " " << ( MetricCounter == rMetric.eKind ? "counter" : "gauge" ) << "\n";
+        for( size_t i = 0; i < rCurrent.size(); ++i )
+        {
+            // Streams are only ever added, so equal positions are equal streams
+            const StreamMetricsSnapshot *pPrevious = i < rPrevious.size() ? &rPrevious[i] : NULL;
+            os  << rMetric.pName << "{slot=\"" << rCurrent[i].strSlot << "\",camera=\"" << rCurrent[i].strCameraID << "\"} "
+                << rMetric.value( rCurrent[i], pPrevious, dSeconds ) << "\n";
+        }
+    }
+    rStrText = os.str();
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,271 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameMetrics.h
+
+  Description: Frame counters of every stream. The frame path updates them
+               with relaxed atomic increments only, no locks and no
+               allocation, so counting costs next to nothing even at
+               thousands of frames per second. Readers take snapshots.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMEMETRICS
+#define AVT_VMBAPI_EXAMPLES_FRAMEMETRICS
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The counters of a stream at one moment
+struct StreamMetricsSnapshot
+{
+    std::string     strSlot;
+    std::string     strCameraID;
+    VmbUint64_t     nReceived;
+    VmbUint64_t     nComplete;
+    VmbUint64_t     nIncomplete;
+    VmbUint64_t     nRequeued;
+    VmbUint64_t     nDropped;
+    // Frame IDs that never arrived
+    VmbUint64_t     nFrameIDGaps;
+    VmbUint64_t     nBytes;
+    VmbUint32_t     nQueueDepth;
+    VmbUint64_t     nConversions;
+    VmbUint64_t     nConversionTimeUs;
+    VmbUint64_t     nConversionMaxUs;
+    VmbUint64_t     nAnalysed;
+    double          dImageMean;
+    VmbUint32_t     nImageMin;
+    VmbUint32_t     nImageMax;
+    double          dClippedLowRatio;
+    double          dClippedHighRatio;
+    VmbUint64_t     nFocusMeasured;
+    double          dLaplacianVariance;
+    double          dTenengrad;
+    VmbUint64_t     nMotionEvents;
+    double          dMotionChangedRatio;
+    VmbUint32_t     nMotionActive;
+};
+
+//
+// The live counters of one stream. Written by the frame callback and the
+// view, one cache line of its own so two streams never share one.
+//
+struct alignas( 64 ) StreamMetrics
+{
+    StreamMetrics()
+        : nReceived( 0 ), nComplete( 0 ), nIncomplete( 0 ), nRequeued( 0 ), nDropped( 0 )
+        , nFrameIDGaps( 0 ), nBytes( 0 ), nLastFrameID( 0 ), nQueueDepth( 0 )
+        , nConversions( 0 ), nConversionTimeUs( 0 ), nConversionMaxUs( 0 )
+        , nAnalysed( 0 ), dImageMean( 0.0 ), nImageMin( 0 ), nImageMax( 0 )
+        , dClippedLowRatio( 0.0 ), dClippedHighRatio( 0.0 )
+        , nFocusMeasured( 0 ), dLaplacianVariance( 0.0 ), dTenengrad( 0.0 )
+        , nMotionEvents( 0 ), dMotionChangedRatio( 0.0 ), nMotionActive( 0 )
+    {
+    }
+
+    //
+    // Counts a frame delivered by the transport layer
+    //
+    // Parameters:
+    //  [in]    bComplete       false for incomplete frames
+    //  [in]    nFrameID        The ID of the frame
+    //  [in]    nBytes          The size of the frame
+    //
+    void OnFrameReceived( bool bComplete, VmbUint64_t nFrameID, VmbUint64_t nBytes )
+    {
+        nReceived.fetch_add( 1, std::memory_order_relaxed );
+        ( bComplete ? nComplete : nIncomplete ).fetch_add( 1, std::memory_order_relaxed );
+        this->nBytes.fetch_add( nBytes, std::memory_order_relaxed );
+        // Only the callback thread of this stream writes the last ID
+        const VmbUint64_t nLast = nLastFrameID.exchange( nFrameID + 1, std::memory_order_relaxed );
+        if( 0 != nLast && nFrameID > nLast )
+        {
+            nFrameIDGaps.fetch_add( nFrameID - nLast, std::memory_order_relaxed );
+        }
+    }
+
+    void OnRequeued()                               { nRequeued.fetch_add( 1, std::memory_order_relaxed ); }
+    void OnDropped( VmbUint64_t nFrames = 1 )       { nDropped.fetch_add( nFrames, std::memory_order_relaxed ); }
+    void SetQueueDepth( VmbUint32_t nDepth )        { nQueueDepth.store( nDepth, std::memory_order_relaxed ); }
+
+    void OnConversion( VmbUint64_t nMicroseconds )
+    {
+        nConversions.fetch_add( 1, std::memory_order_relaxed );
+        nConversionTimeUs.fetch_add( nMicroseconds, std::memory_order_relaxed );
+        // Only the view converts, a plain compare is enough
+        if( nMicroseconds > nConversionMaxUs.load( std::memory_order_relaxed ) )
+        {
+            nConversionMaxUs.store( nMicroseconds, std::memory_order_relaxed );
+        }
+    }
+
+    //
+    // Keeps the exposure of the last analysed frame
+    //
+    // Parameters:
+    //  [in]    dMean           The mean pixel value
+    //  [in]    nMin            The smallest pixel value
+    //  [in]    nMax            The largest pixel value
+    //  [in]    dClippedLow     The part of the pixels at 0
+    //  [in]    dClippedHigh    The part of the pixels at full scale
+    //
+    void OnImageStatistics( double dMean, VmbUint32_t nMin, VmbUint32_t nMax, double dClippedLow, double dClippedHigh )
+    {
+        nAnalysed.fetch_add( 1, std::memory_order_relaxed );
+        dImageMean.store( dMean, std::memory_order_relaxed );
+        nImageMin.store( nMin, std::memory_order_relaxed );
+        nImageMax.store( nMax, std::memory_order_relaxed );
+        dClippedLowRatio.store( dClippedLow, std::memory_order_relaxed );
+        dClippedHighRatio.store( dClippedHigh, std::memory_order_relaxed );
+    }
+
+    //
+    // Keeps the sharpness of the last measured frame
+    //
+    // Parameters:
+    //  [in]    dLaplacianVariance  The variance of the Laplacian
+    //  [in]    dTenengrad          The mean squared gradient magnitude
+    //
+    void OnSharpness( double dLaplacianVariance, double dTenengrad )
+    {
+        nFocusMeasured.fetch_add( 1, std::memory_order_relaxed );
+        this->dLaplacianVariance.store( dLaplacianVariance, std::memory_order_relaxed );
+        this->dTenengrad.store( dTenengrad, std::memory_order_relaxed );
+    }
+
+    //
+    // Keeps the change of the last frame compared for motion
+    //
+    // Parameters:
+    //  [in]    dChangedRatio       The part of the grid that changed
+    //  [in]    bActive             Motion is going on
+    //  [in]    bStarted            Motion started with this frame
+    //
+    void OnMotion( double dChangedRatio, bool bActive, bool bStarted )
+    {
+        dMotionChangedRatio.store( dChangedRatio, std::memory_order_relaxed );
+        nMotionActive.store( bActive ? 1 : 0, std::memory_order_relaxed );
+        if( bStarted )
+        {
+            nMotionEvents.fetch_add( 1, std::memory_order_relaxed );
+        }
+    }
+
+    std::atomic<VmbUint64_t>    nReceived;
+    std::atomic<VmbUint64_t>    nComplete;
+    std::atomic<VmbUint64_t>    nIncomplete;
+    std::atomic<VmbUint64_t>    nRequeued;
+    std::atomic<VmbUint64_t>    nDropped;
+    std::atomic<VmbUint64_t>    nFrameIDGaps;
+    std::atomic<VmbUint64_t>    nBytes;
+    // The ID expected next, 0 before the first frame
+    std::atomic<VmbUint64_t>    nLastFrameID;
+    std::atomic<VmbUint32_t>    nQueueDepth;
+    std::atomic<VmbUint64_t>    nConversions;
+    std::atomic<VmbUint64_t>    nConversionTimeUs;
+    std::atomic<VmbUint64_t>    nConversionMaxUs;
+    std::atomic<VmbUint64_t>    nAnalysed;
+    std::atomic<double>         dImageMean;
+    std::atomic<VmbUint32_t>    nImageMin;
+    std::atomic<VmbUint32_t>    nImageMax;
+    std::atomic<double>         dClippedLowRatio;
+    std::atomic<double>         dClippedHighRatio;
+    std::atomic<VmbUint64_t>    nFocusMeasured;
+    std::atomic<double>         dLaplacianVariance;
+    std::atomic<double>         dTenengrad;
+    std::atomic<VmbUint64_t>    nMotionEvents;
+    std::atomic<double>         dMotionChangedRatio;
+    std::atomic<VmbUint32_t>    nMotionActive;
+};
+
+class MetricsRegistry
+{
+  public:
+    MetricsRegistry();
+
+    //
+    // Adds a stream. The counters live as long as the registry.
+    //
+    // Parameters:
+    //  [in]    rStrSlot        The label of the stream, e.g. the camera slot
+    //
+    // Returns:
+    //  The counters to update from the frame path
+    //
+    StreamMetrics*  AddStream( const std::string &rStrSlot );
+
+    //
+    // Sets the camera a stream belongs to, a label of the export
+    //
+    // Parameters:
+    //  [in]    pStream         The counters of the stream
+    //  [in]    rStrCameraID    The ID of the camera
+    //
+    void            SetCameraID( const StreamMetrics *pStream, const std::string &rStrCameraID );
+
+    //
+    // Reads all counters
+    //
+    // Parameters:
+    //  [out]   rSnapshots      One entry per stream
+    //
+    void            GetSnapshot( std::vector<StreamMetricsSnapshot> &rSnapshots ) const;
+
+    //
+    // Formats two snapshots in the Prometheus text format. Rates are taken
+    // over the time between them.
+    //
+    // Parameters:
+    //  [in]    rCurrent        The current snapshot
+    //  [in]    rPrevious       The previous snapshot, may be empty
+    //  [in]    dSeconds        The time between the two
+    //  [out]   rStrText        The exposition text
+    //
+    static void     FormatPrometheus(   const std::vector<StreamMetricsSnapshot> &rCurrent,
+                                        const std::vector<StreamMetricsSnapshot> &rPrevious,
+                                        double dSeconds,
+                                        std::string &rStrText );
+
+  private:
+    struct Stream
+    {
+        std::string     strSlot;
+        std::string     strCameraID;
+        StreamMetrics   metrics;
+    };
+
+    // A deque keeps the counters in place while streams are added
+    std::deque<Stream>  m_Streams;
+    mutable std::mutex  m_Mutex;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -41,72 +41,40 @@ namespace Examples {
 //
 void FrameObserver::FrameReceived( const FramePtr pFrame )
 {
-    bool bQueueDirectly = true;
     VmbFrameStatusType eReceiveStatus;
 
-    if( VmbErrorSuccess == pFrame->GetReceiveStatus( eReceiveStatus ) )
+    if( VmbErrorSuccess != pFrame->GetReceiveStatus( eReceiveStatus ) )
     {
-        CWinApp *pApp = AfxGetApp();
-        if( NULL != pApp )
+        // If any error occurred we queue the frame without notification
+        if( NULL != m_pMetrics )
         {
-            CWnd *pMainWin = pApp->GetMainWnd();
-            if( NULL != pMainWin )
-            {
-                // Lock the frame queue
-                m_FramesMutex.Lock();
-                // We store the FramePtr
-                m_Frames.push( pFrame );
-                // Unlock frame queue
-                m_FramesMutex.Unlock();
-                // And notify the view about it
-                pMainWin->PostMessage( WM_FRAME_READY1, eReceiveStatus );
-                bQueueDirectly = false;
-            }
+            m_pMetrics->OnDropped();
         }
-    }
-
-    // If any error occurred we queue the frame without notification
-    if( true == bQueueDirectly )
-    {
         m_pCamera->QueueFrame( pFrame );
+        return;
     }
-}
 
-//
-// After the view has been notified about a new frame it can pick it up.
-// It is then removed from the internal queue
-//
-// Returns:
-//  A shared pointer to the latest frame
-//
-FramePtr FrameObserver::GetFrame()
-{
-    // Lock frame queue
-    m_FramesMutex.Lock();
-    // Pop the frame from the queue
-    FramePtr res;
-    if( ! m_Frames.empty() )
+    if( NULL != m_pMetrics )
     {
-        res = m_Frames.front();
-        m_Frames.pop();
+        VmbUint32_t nSize = 0;
+        VmbUint64_t nFrameID = 0;
+        pFrame->GetImageSize( nSize );
+        pFrame->GetFrameID( nFrameID );
+        m_pMetrics->OnFrameReceived( VmbFrameStatusComplete == eReceiveStatus, nFrameID, nSize );
     }
-    // Unlock the frame queue
-    m_FramesMutex.Unlock();
-    return res;
-}
 
-//
-// Clears the internal (double buffering) frame queue
-//
-void FrameObserver::ClearFrameQueue()
-{
-    // Lock the frame queue
-    m_FramesMutex.Lock();
-    // Clear the frame queue and release the memory
-    std::queue<FramePtr> empty;
-    std::swap( m_Frames, empty );
-    // Unlock the frame queue
-    m_FramesMutex.Unlock();
+    // The frame goes back to the camera once the last stage let go of it
+    CameraPtr pCamera = m_pCamera;
+    StreamMetrics *pMetrics = m_pMetrics;
+    FrameLeasePtr pLease( new FrameLease( pFrame, eReceiveStatus, [pCamera, pMetrics]( const FramePtr &pReleased )
+    {
+        if(     VmbErrorSuccess == pCamera->QueueFrame( pReleased )
+            &&  NULL != pMetrics )
+        {
+            pMetrics->OnRequeued();
+        }
+    } ) );
+    m_pPipeline->Submit( pLease );
 }
 
 }}} // namespace AVT::VmbAPI::Examples
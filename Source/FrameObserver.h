@@ -29,8 +29,9 @@
 //#ifndef AVT_VMBAPI_EXAMPLES_FRAMEOBSERVER
 #define AVT_VMBAPI_EXAMPLES_FRAMEOBSERVER
 
-#include <queue>
 #include <VimbaCPP/Include/VimbaCPP.h>
+#include "FramePipeline.h"
+#include "FrameMetrics.h"
 
 namespace AVT {
 namespace VmbAPI {
@@ -46,8 +47,10 @@ class FrameObserver : virtual public IFrameObserver
     //
     // Parameters:
     //  [in]    pCamera             The camera the frame was queued at
+    //  [in]    pPipeline           The pipeline of this camera
+    //  [in]    pMetrics            The frame counters of this camera, may be NULL
     //
-    FrameObserver( CameraPtr pCamera ) : IFrameObserver( pCamera ) {;}
+    FrameObserver( CameraPtr pCamera, FramePipeline *pPipeline, StreamMetrics *pMetrics ) : IFrameObserver( pCamera ), m_pPipeline( pPipeline ), m_pMetrics( pMetrics ) {;}
     
     //
     // This is our callback routine that will be executed on every received frame.
@@ -58,25 +61,11 @@ class FrameObserver : virtual public IFrameObserver
     //
     virtual void FrameReceived( const FramePtr pFrame );
 
-    //
-    // After the view has been notified about a new frame it can pick it up.
-    // It is then removed from the internal queue
-    //
-    // Returns:
-    //  A shared pointer to the latest frame
-    //
-    FramePtr GetFrame();
-
-    //
-    // Clears the internal (double buffering) frame queue
-    //
-    void ClearFrameQueue();
-
   private:
-    // Since a MFC message cannot contain a whole frame
-    // the frame observer stores all FramePtr
-    std::queue<FramePtr> m_Frames;
-    AVT::VmbAPI::Mutex m_FramesMutex;
+    // Every frame is handed to it in a lease
+    FramePipeline *m_pPipeline;
+    // Counts every frame that passes through
+    StreamMetrics *m_pMetrics;
 };
 
 }}} // namespace AVT::VmbAPI::Examples
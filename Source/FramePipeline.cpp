@@ -0,0 +1,311 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FramePipeline.cpp
+
+  Description: Runs the stages that work on the frames of one camera. Each
+               stage runs inline or on a thread of its own with a bounded
+               queue, and keeps timing and drop counters.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <chrono>
+#include <FramePipeline.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+FramePipeline::Stage::Stage()
+    : nProcessed( 0 )
+    , nFailed( 0 )
+    , nDropped( 0 )
+    , nQueueHighWater( 0 )
+    , nTimeSumUs( 0 )
+    , nTimeMaxUs( 0 )
+{
+}
+
+FramePipeline::FramePipeline()
+    : m_bRunning( false )
+{
+}
+
+//
+// Stops the pipeline
+//
+FramePipeline::~FramePipeline()
+{
+    Stop();
+}
+
+//
+// Adds a stage. Only while the pipeline is stopped.
+//
+// Parameters:
+//  [in]    rStrName        The name the statistics are kept under
+//  [in]    pStage          The stage
+//  [in]    options         How the stage is run
+//  [in]    rParents        The stages whose frames it gets, none for
+//                          the frames handed to Submit
+//  [out]   rIndex          The index to name the stage as parent
+//
+// Returns:
+//  VmbErrorBadParameter if a parent does not exist yet,
+//  VmbErrorInvalidCall while running
+//
+VmbErrorType FramePipeline::AddStage(   const std::string &rStrName,
+                                        const FrameStagePtr &pStage,
+                                        const StageOptions &options,
+                                        const std::vector<size_t> &rParents,
+                                        size_t &rIndex )
+{
+    if( m_bRunning )
+    {
+        return VmbErrorInvalidCall;
+    }
+    if(     !pStage
+        ||  ( ThreadingDedicated == options.eThreading && 0 == options.nQueueDepth ) )
+    {
+        return VmbErrorBadParameter;
+    }
+    // Parents have to be added first, this keeps the graph free of cycles
+    for( size_t i = 0; i < rParents.size(); ++i )
+    {
+        if( rParents[i] >= m_Stages.size() )
+        {
+            return VmbErrorBadParameter;
+        }
+    }
+
+    rIndex = m_Stages.size();
+    std::unique_ptr<Stage> pNewStage( new Stage() );
+    pNewStage->strName = rStrName;
+    pNewStage->pStage = pStage;
+    pNewStage->options = options;
+    m_Stages.push_back( std::move( pNewStage ) );
+    if( rParents.empty() )
+    {
+        m_Roots.push_back( rIndex );
+    }
+    for( size_t i = 0; i < rParents.size(); ++i )
+    {
+        m_Stages[rParents[i]]->children.push_back( rIndex );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Starts the threads of the dedicated stages
+//
+void FramePipeline::Start()
+{
+    if( m_bRunning.exchange( true ) )
+    {
+        return;
+    }
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+        if( ThreadingDedicated == m_Stages[i]->options.eThreading )
+        {
+            m_Stages[i]->thread = std::thread( &FramePipeline::StageThread, this, m_Stages[i].get() );
+        }
+    }
+}
+
+//
+// Stops the threads. The frames still queued are dropped, so their
+// leases end.
+//
+void FramePipeline::Stop()
+{
+    if( !m_bRunning.exchange( false ) )
+    {
+        return;
+    }
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+        Stage &rStage = *m_Stages[i];
+        if( ThreadingDedicated != rStage.options.eThreading )
+        {
+            continue;
+        }
+        {
+            // Taking the lock makes sure the thread either sees the flag
+            // or already waits for the notification
+            std::lock_guard<std::mutex> lock( rStage.queueMutex );
+        }
+        rStage.queueNotEmpty.notify_all();
+        rStage.queueNotFull.notify_all();
+        rStage.thread.join();
+
+        std::deque<FrameLeasePtr> abandoned;
+        {
+            std::lock_guard<std::mutex> lock( rStage.queueMutex );
+            abandoned.swap( rStage.queue );
+        }
+        rStage.nDropped += abandoned.size();
+    }
+}
+
+//
+// Hands a frame to the stages without parents
+//
+// Parameters:
+//  [in]    pLease          The frame
+//
+void FramePipeline::Submit( const FrameLeasePtr &pLease )
+{
+    for( size_t i = 0; i < m_Roots.size(); ++i )
+    {
+        Deliver( *m_Stages[m_Roots[i]], pLease );
+    }
+}
+
+//
+// Gets the statistics of every stage
+//
+// Parameters:
+//  [out]   rStatistics     One entry per stage in the order they were added
+//
+void FramePipeline::GetStatistics( std::vector<StageStatistics> &rStatistics ) const
+{
+    rStatistics.clear();
+    for( size_t i = 0; i < m_Stages.size(); ++i )
+    {
+        const Stage &rStage = *m_Stages[i];
+        StageStatistics statistics;
+        statistics.strName          = rStage.strName;
+        statistics.nProcessed       = rStage.nProcessed.load( std::memory_order_relaxed );
+        statistics.nFailed          = rStage.nFailed.load( std::memory_order_relaxed );
+        statistics.nDropped         = rStage.nDropped.load( std::memory_order_relaxed );
+        statistics.nQueueHighWater  = rStage.nQueueHighWater.load( std::memory_order_relaxed );
+        const VmbUint64_t nRuns     = statistics.nProcessed + statistics.nFailed;
+        statistics.dMeanUs          = 0 == nRuns ? 0.0 : static_cast<double>( rStage.nTimeSumUs.load( std::memory_order_relaxed ) ) / nRuns;
+        statistics.dMaxUs           = static_cast<double>( rStage.nTimeMaxUs.load( std::memory_order_relaxed ) );
+        rStatistics.push_back( statistics );
+    }
+}
+
+void FramePipeline::Deliver( Stage &rStage, const FrameLeasePtr &pLease )
+{
+    if( ThreadingInline == rStage.options.eThreading )
+    {
+        Run( rStage, pLease );
+        return;
+    }
+
+    // The dropped lease must end outside of the lock, it queues the frame
+    // at the camera again
+    FrameLeasePtr pDropped;
+    {
+        std::unique_lock<std::mutex> lock( rStage.queueMutex );
+        if( !m_bRunning )
+        {
+            pDropped = pLease;
+        }
+        else if( rStage.queue.size() >= rStage.options.nQueueDepth )
+        {
+            switch( rStage.options.eDropPolicy )
+            {
+            case DropOldest:
+                pDropped = rStage.queue.front();
+                rStage.queue.pop_front();
+                break;
+            case DropNewest:
+                pDropped = pLease;
+                break;
+            case DropNever:
+                rStage.queueNotFull.wait( lock, [&]() { return !m_bRunning || rStage.queue.size() < rStage.options.nQueueDepth; } );
+                if( !m_bRunning )
+                {
+                    pDropped = pLease;
+                }
+                break;
+            }
+        }
+        if( pDropped != pLease )
+        {
+            rStage.queue.push_back( pLease );
+            const VmbUint32_t nSize = static_cast<VmbUint32_t>( rStage.queue.size() );
+            if( nSize > rStage.nQueueHighWater.load( std::memory_order_relaxed ) )
+            {
+                rStage.nQueueHighWater.store( nSize, std::memory_order_relaxed );
+            }
+        }
+    }
+    if( pDropped )
+    {
+        ++rStage.nDropped;
+    }
+    if( pDropped != pLease )
+    {
+        rStage.queueNotEmpty.notify_one();
+    }
+}
+
+void FramePipeline::Run( Stage &rStage, const FrameLeasePtr &pLease )
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const VmbErrorType res = rStage.pStage->Process( pLease );
+    const VmbUint64_t nElapsedUs = static_cast<VmbUint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count() );
+
+    rStage.nTimeSumUs.fetch_add( nElapsedUs, std::memory_order_relaxed );
+    VmbUint64_t nMaxUs = rStage.nTimeMaxUs.load( std::memory_order_relaxed );
+    while(      nElapsedUs > nMaxUs
+            &&  !rStage.nTimeMaxUs.compare_exchange_weak( nMaxUs, nElapsedUs, std::memory_order_relaxed ) )
+    {
+    }
+    if( VmbErrorSuccess != res )
+    {
+        rStage.nFailed.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+    rStage.nProcessed.fetch_add( 1, std::memory_order_relaxed );
+
+    for( size_t i = 0; i < rStage.children.size(); ++i )
+    {
+        Deliver( *m_Stages[rStage.children[i]], pLease );
+    }
+}
+
+void FramePipeline::StageThread( Stage *pStage )
+{
+    for( ;; )
+    {
+        FrameLeasePtr pLease;
+        {
+            std::unique_lock<std::mutex> lock( pStage->queueMutex );
+            pStage->queueNotEmpty.wait( lock, [&]() { return !m_bRunning || !pStage->queue.empty(); } );
+            if( !m_bRunning )
+            {
+                return;
+            }
+            pLease = pStage->queue.front();
+            pStage->queue.pop_front();
+        }
+        pStage->queueNotFull.notify_one();
+        Run( *pStage, pLease );
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,201 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FramePipeline.h
+
+  Description: Runs the stages that work on the frames of one camera. Each
+               stage runs inline or on a thread of its own with a bounded
+               queue, and keeps timing and drop counters.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMEPIPELINE
+#define AVT_VMBAPI_EXAMPLES_FRAMEPIPELINE
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "FrameLease.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// One step of the processing of a frame
+//
+class IFrameStage
+{
+  public:
+    virtual ~IFrameStage() {}
+
+    //
+    // Works on a frame. Called on the thread the stage was added with.
+    //
+    // Parameters:
+    //  [in]    pLease          The frame, keep the lease to hold on to it
+    //
+    // Returns:
+    //  VmbErrorSuccess to pass the frame on to the following stages
+    //
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease ) = 0;
+};
+
+typedef std::shared_ptr<IFrameStage> FrameStagePtr;
+
+class FramePipeline
+{
+  public:
+    enum ThreadingType
+    {
+        ThreadingInline,        // Runs on the thread that hands the frame in
+        ThreadingDedicated,     // Runs on a thread of its own behind a queue
+    };
+
+    // What a dedicated stage does with a frame while its queue is full
+    enum DropPolicyType
+    {
+        DropOldest,             // Throws the oldest waiting frame away
+        DropNewest,             // Throws the new frame away
+        DropNever,              // Makes the caller wait, this slows the camera down
+    };
+
+    struct StageOptions
+    {
+        ThreadingType   eThreading;
+        DropPolicyType  eDropPolicy;
+        VmbUint32_t     nQueueDepth;
+
+        StageOptions( ThreadingType threading = ThreadingInline, DropPolicyType dropPolicy = DropOldest, VmbUint32_t queueDepth = 2 )
+            : eThreading( threading ), eDropPolicy( dropPolicy ), nQueueDepth( queueDepth ) {}
+    };
+
+    struct StageStatistics
+    {
+        std::string     strName;
+        VmbUint64_t     nProcessed;
+        VmbUint64_t     nFailed;
+        VmbUint64_t     nDropped;
+        VmbUint32_t     nQueueHighWater;
+        double          dMeanUs;
+        double          dMaxUs;
+    };
+
+    FramePipeline();
+
+    //
+    // Stops the pipeline
+    //
+    ~FramePipeline();
+
+    //
+    // Adds a stage. Only while the pipeline is stopped.
+    //
+    // Parameters:
+    //  [in]    rStrName        The name the statistics are kept under
+    //  [in]    pStage          The stage
+    //  [in]    options         How the stage is run
+    //  [in]    rParents        The stages whose frames it gets, none for
+    //                          the frames handed to Submit
+    //  [out]   rIndex          The index to name the stage as parent
+    //
+    // Returns:
+    //  VmbErrorBadParameter if a parent does not exist yet,
+    //  VmbErrorInvalidCall while running
+    //
+    VmbErrorType AddStage(  const std::string &rStrName,
+                            const FrameStagePtr &pStage,
+                            const StageOptions &options,
+                            const std::vector<size_t> &rParents,
+                            size_t &rIndex );
+
+    //
+    // Starts the threads of the dedicated stages
+    //
+    void Start();
+
+    //
+    // Stops the threads. The frames still queued are dropped, so their
+    // leases end.
+    //
+    void Stop();
+
+    //
+    // Hands a frame to the stages without parents
+    //
+    // Parameters:
+    //  [in]    pLease          The frame
+    //
+    void Submit( const FrameLeasePtr &pLease );
+
+    //
+    // Gets the statistics of every stage
+    //
+    // Parameters:
+    //  [out]   rStatistics     One entry per stage in the order they were added
+    //
+    void GetStatistics( std::vector<StageStatistics> &rStatistics ) const;
+
+  private:
+    struct Stage
+    {
+        std::string                 strName;
+        FrameStagePtr               pStage;
+        StageOptions                options;
+        std::vector<size_t>         children;
+        std::deque<FrameLeasePtr>   queue;
+        std::mutex                  queueMutex;
+        std::condition_variable     queueNotEmpty;
+        std::condition_variable     queueNotFull;
+        std::thread                 thread;
+        std::atomic<VmbUint64_t>    nProcessed;
+        std::atomic<VmbUint64_t>    nFailed;
+        std::atomic<VmbUint64_t>    nDropped;
+        std::atomic<VmbUint32_t>    nQueueHighWater;
+        std::atomic<VmbUint64_t>    nTimeSumUs;
+        std::atomic<VmbUint64_t>    nTimeMaxUs;
+
+        Stage();
+    };
+
+    // No copies, the object owns threads
+    FramePipeline( const FramePipeline& );
+    FramePipeline& operator=( const FramePipeline& );
+
+    void Deliver( Stage &rStage, const FrameLeasePtr &pLease );
+    void Run( Stage &rStage, const FrameLeasePtr &pLease );
+    void StageThread( Stage *pStage );
+
+    std::vector< std::unique_ptr<Stage> >   m_Stages;
+    std::vector<size_t>                     m_Roots;
+    std::atomic<bool>                       m_bRunning;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,1270 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameStages.cpp
+
+  Description: The stages every camera pipeline starts with: recording and
+               publishing complete frames, and handing frames to the view.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <algorithm>
+#include <cstring>
+#include <FrameStages.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+CorrectionStage::CorrectionStage( ThreadPool *pPool )
+    : m_pPool( pPool )
+    , m_Buffers( FREE_BUFFERS )
+    , m_eCaptureType( CalibrationDark )
+    , m_nCaptureRemaining( 0 )
+    , m_bFlatFieldEnabled( false )
+    , m_bDefectRepairEnabled( false )
+{
+}
+
+VmbErrorType CorrectionStage::Process( const FrameLeasePtr &pLease )
+{
+    // The view shows incomplete frames as they are
+    if( !pLease->IsComplete() )
+    {
+        return VmbErrorSuccess;
+    }
+    ImageView view;
+    if( VmbErrorSuccess != pLease->GetImage( view ) )
+    {
+        return VmbErrorSuccess;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_CaptureMutex );
+        if(     0 != m_nCaptureRemaining
+            &&  VmbErrorSuccess == m_Builder.Add( m_eCaptureType, view ) )
+        {
+            --m_nCaptureRemaining;
+        }
+    }
+    std::shared_ptr<const CalibrationMaps> pMaps;
+    std::shared_ptr<const DefectivePixelMap> pDefects;
+    {
+        std::lock_guard<std::mutex> lock( m_MapsMutex );
+        if( m_bFlatFieldEnabled )
+        {
+            pMaps = m_pMaps;
+        }
+        if( m_bDefectRepairEnabled )
+        {
+            pDefects = m_pDefects;
+        }
+    }
+    // Frames of another size or format pass uncorrected
+    const bool bFlatField = NULL != pMaps && pMaps->Matches( view );
+    const bool bDefects = NULL != pDefects && pDefects->Matches( view ) && !pDefects->GetPixels().empty();
+    if( !bFlatField && !bDefects )
+    {
+        return VmbErrorSuccess;
+    }
+
+    // The camera buffer stays as received
+    const size_t nSize = static_cast<size_t>( view.nStride ) * view.nHeight;
+    const std::shared_ptr<VmbUchar_t> pBuffer = m_Buffers.Acquire( nSize );
+    if( bFlatField )
+    {
+        CorrectFlatField( view, *pMaps, m_pPool, pBuffer.get() );
+    }
+    else
+    {
+        memcpy( pBuffer.get(), view.pBuffer, nSize );
+    }
+    ImageView corrected = view;
+    corrected.pBuffer = pBuffer.get();
+    // Only touches the defects, in the buffer of the stage
+    if( bDefects )
+    {
+        CorrectDefectivePixels( corrected, *pDefects, pBuffer.get() );
+    }
+    pLease->SetImage( corrected, pBuffer );
+    return VmbErrorSuccess;
+}
+
+//
+// Stacks the next frames for a calibration. Dark frames start a new
+// calibration, flat frames are added to the dark frames captured before.
+//
+// Parameters:
+//  [in]    eType               What the camera looks at
+//  [in]    nFrames             The number of frames to stack
+//
+void CorrectionStage::StartCapture( CalibrationFrameType eType, VmbUint32_t nFrames )
+{
+    std::lock_guard<std::mutex> lock( m_CaptureMutex );
+    if(     CalibrationDark == eType
+        ||  0 != m_Builder.GetCount( CalibrationFlat ) )
+    {
+        m_Builder.Reset();
+    }
+    m_eCaptureType = eType;
+    m_nCaptureRemaining = nFrames;
+}
+
+bool CorrectionStage::IsCapturing() const
+{
+    std::lock_guard<std::mutex> lock( m_CaptureMutex );
+    return 0 != m_nCaptureRemaining;
+}
+
+//
+// Returns:
+//  The number of frames stacked of a type
+//
+VmbUint32_t CorrectionStage::GetCapturedCount( CalibrationFrameType eType ) const
+{
+    std::lock_guard<std::mutex> lock( m_CaptureMutex );
+    return m_Builder.GetCount( eType );
+}
+
+//
+// Builds flat-field maps from the frames stacked
+//
+// Parameters:
+//  [out]   rMaps               The maps
+//
+// Returns:
+//  VmbErrorInvalidCall without flat frames
+//
+VmbErrorType CorrectionStage::BuildMaps( CalibrationMaps &rMaps ) const
+{
+    std::lock_guard<std::mutex> lock( m_CaptureMutex );
+    return m_Builder.Build( rMaps );
+}
+
+//
+// Finds the defective pixels in the frames stacked
+//
+// Parameters:
+//  [out]   rMap                The defective pixels
+//
+// Returns:
+//  VmbErrorInvalidCall if no frames were stacked
+//
+VmbErrorType CorrectionStage::DetectDefects( DefectivePixelMap &rMap ) const
+{
+    std::lock_guard<std::mutex> lock( m_CaptureMutex );
+    return rMap.Detect( m_Builder, DefectDetectionSettings() );
+}
+
+//
+// Sets the flat-field maps to correct with, NULL for none
+//
+void CorrectionStage::SetMaps( const std::shared_ptr<const CalibrationMaps> &pMaps )
+{
+    std::lock_guard<std::mutex> lock( m_MapsMutex );
+    m_pMaps = pMaps;
+}
+
+bool CorrectionStage::HasMaps() const
+{
+    std::lock_guard<std::mutex> lock( m_MapsMutex );
+    return NULL != m_pMaps;
+}
+
+void CorrectionStage::SetFlatFieldEnabled( bool bEnabled )
+{
+    m_bFlatFieldEnabled = bEnabled;
+}
+
+bool CorrectionStage::IsFlatFieldEnabled() const
+{
+    return m_bFlatFieldEnabled;
+}
+
+//
+// Sets the defective pixels to repair, NULL for none
+//
+void CorrectionStage::SetDefectMap( const std::shared_ptr<const DefectivePixelMap> &pMap )
+{
+    std::lock_guard<std::mutex> lock( m_MapsMutex );
+    m_pDefects = pMap;
+}
+
+//
+// Returns:
+//  The defective pixels repaired, NULL for none
+//
+std::shared_ptr<const DefectivePixelMap> CorrectionStage::GetDefectMap() const
+{
+    std::lock_guard<std::mutex> lock( m_MapsMutex );
+    return m_pDefects;
+}
+
+void CorrectionStage::SetDefectRepairEnabled( bool bEnabled )
+{
+    m_bDefectRepairEnabled = bEnabled;
+}
+
+bool CorrectionStage::IsDefectRepairEnabled() const
+{
+    return m_bDefectRepairEnabled;
+}
+
+//
+// Drops the maps and a calibration in progress, e.g. for another camera
+//
+void CorrectionStage::Reset()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_CaptureMutex );
+        m_Builder.Reset();
+        m_nCaptureRemaining = 0;
+    }
+    std::lock_guard<std::mutex> lock( m_MapsMutex );
+    m_pMaps.reset();
+    m_pDefects.reset();
+}
+
+AverageStage::AverageStage( ThreadPool *pPool, VmbUint32_t nMaxLeases )
+    : m_pPool( pPool )
+    , m_nMaxLeases( nMaxLeases )
+    , m_Buffers( FREE_BUFFERS )
+    , m_Copies( 1 )
+    , m_nWindow( 1 )
+{
+}
+
+VmbErrorType AverageStage::Process( const FrameLeasePtr &pLease )
+{
+    const VmbUint32_t nWindow = m_nWindow;
+    // Frames leaving the window are let go after the lock, their leases requeue them
+    std::deque<RetainedFrame> dropped;
+    std::lock_guard<std::mutex> lock( m_FramesMutex );
+    if( nWindow < 2 )
+    {
+        m_Frames.swap( dropped );
+        m_Accumulator.Clear();
+        return VmbErrorSuccess;
+    }
+    // Incomplete frames stay out of the window
+    if( !pLease->IsComplete() )
+    {
+        return VmbErrorSuccess;
+    }
+    ImageView view;
+    if( VmbErrorSuccess != pLease->GetImage( view ) )
+    {
+        return VmbErrorSuccess;
+    }
+    // Another size or format starts over, packed formats pass as they are
+    if( !m_Accumulator.Matches( view ) )
+    {
+        m_Frames.swap( dropped );
+        if( VmbErrorSuccess != m_Accumulator.Reset( view ) )
+        {
+            return VmbErrorSuccess;
+        }
+    }
+    // A shorter window takes out the frames beyond it, the last frame
+    // leaving is taken out while the new one is added
+    while( m_Frames.size() > nWindow )
+    {
+        m_Accumulator.Remove( m_Frames.front().view );
+        dropped.push_back( m_Frames.front() );
+        m_Frames.pop_front();
+    }
+    const ImageView *pOldest = m_Frames.size() == nWindow ? &m_Frames.front().view : NULL;
+    const VmbUint32_t nFrames = static_cast<VmbUint32_t>( m_Frames.size() ) + ( NULL == pOldest ? 1 : 0 );
+
+    const size_t nSize = static_cast<size_t>( view.nStride ) * view.nHeight;
+    const std::shared_ptr<VmbUchar_t> pBuffer = m_Buffers.Acquire( nSize );
+    if( VmbErrorSuccess != m_Accumulator.Update( view, pOldest, nFrames, m_pPool, pBuffer.get() ) )
+    {
+        m_Frames.swap( dropped );
+        m_Accumulator.Clear();
+        return VmbErrorSuccess;
+    }
+    if( NULL != pOldest )
+    {
+        dropped.push_back( m_Frames.front() );
+        m_Frames.pop_front();
+    }
+
+    RetainedFrame newest;
+    newest.view = view;
+    if( nWindow <= m_nMaxLeases )
+    {
+        // The lease keeps the image even after it is replaced by the mean
+        newest.pLease = pLease;
+    }
+    else
+    {
+        newest.pCopy = m_Copies.Acquire( nSize );
+        memcpy( newest.pCopy.get(), view.pBuffer, nSize );
+        newest.view.pBuffer = newest.pCopy.get();
+    }
+    m_Frames.push_back( newest );
+
+    ImageView mean = view;
+    mean.pBuffer = pBuffer.get();
+    pLease->SetImage( mean, pBuffer );
+    return VmbErrorSuccess;
+}
+
+//
+// Sets the number of frames to average, taking effect with the next
+// frame. A shorter window drops the oldest frames.
+//
+// Parameters:
+//  [in]    nFrames             The frames, 1 to pass frames as they are
+//
+// Returns:
+//  VmbErrorBadParameter beyond MAX_WINDOW
+//
+VmbErrorType AverageStage::SetWindow( VmbUint32_t nFrames )
+{
+    if( nFrames > MAX_WINDOW )
+    {
+        return VmbErrorBadParameter;
+    }
+    m_nWindow = (std::max)( 1u, nFrames );
+    return VmbErrorSuccess;
+}
+
+VmbUint32_t AverageStage::GetWindow() const
+{
+    return m_nWindow;
+}
+
+//
+// Drops the frames kept, e.g. before the camera is closed
+//
+void AverageStage::Reset()
+{
+    std::deque<RetainedFrame> dropped;
+    std::lock_guard<std::mutex> lock( m_FramesMutex );
+    m_Frames.swap( dropped );
+    m_Accumulator.Clear();
+}
+
+UndistortStage::UndistortStage( ThreadPool *pPool )
+    : m_pPool( pPool )
+    , m_Buffers( FREE_BUFFERS )
+    , m_bEnabled( false )
+{
+}
+
+VmbErrorType UndistortStage::Process( const FrameLeasePtr &pLease )
+{
+    if(     !m_bEnabled
+        ||  !pLease->IsComplete() )
+    {
+        return VmbErrorSuccess;
+    }
+    const std::shared_ptr<const RemapTable> pTable = GetTable();
+    ImageView view;
+    // Frames of another size or format pass as they are
+    if(     NULL == pTable
+        ||  VmbErrorSuccess != pLease->GetImage( view )
+        ||  !pTable->Matches( view ) )
+    {
+        return VmbErrorSuccess;
+    }
+    const std::shared_ptr<VmbUchar_t> pBuffer = m_Buffers.Acquire( static_cast<size_t>( view.nStride ) * view.nHeight );
+    if( VmbErrorSuccess != RemapImage( view, *pTable, m_pPool, pBuffer.get() ) )
+    {
+        return VmbErrorSuccess;
+    }
+    ImageView remapped = view;
+    remapped.pBuffer = pBuffer.get();
+    pLease->SetImage( remapped, pBuffer );
+    return VmbErrorSuccess;
+}
+
+//
+// Sets the table to remap by, NULL for none
+//
+void UndistortStage::SetTable( const std::shared_ptr<const RemapTable> &pTable )
+{
+    std::lock_guard<std::mutex> lock( m_TableMutex );
+    m_pTable = pTable;
+}
+
+//
+// Returns:
+//  The table remapped by, NULL for none
+//
+std::shared_ptr<const RemapTable> UndistortStage::GetTable() const
+{
+    std::lock_guard<std::mutex> lock( m_TableMutex );
+    return m_pTable;
+}
+
+void UndistortStage::SetEnabled( bool bEnabled )
+{
+    m_bEnabled = bEnabled;
+}
+
+bool UndistortStage::IsEnabled() const
+{
+    return m_bEnabled;
+}
+
+//
+// Drops the table, e.g. for another camera
+//
+void UndistortStage::Reset()
+{
+    std::lock_guard<std::mutex> lock( m_TableMutex );
+    m_pTable.reset();
+}
+
+const char * const HdrBracketStage::ATTACHMENT = "HdrSlot";
+
+VmbErrorType HdrBracketStage::Process( const FrameLeasePtr &pLease )
+{
+    // The writes are queued under the lock, so none slips in after Disable
+    std::lock_guard<std::mutex> lock( m_BracketerMutex );
+    if( !m_bEnabled )
+    {
+        return VmbErrorSuccess;
+    }
+    // Incomplete frames still keep the cycle going
+    double dNextUs;
+    HdrSlot slot;
+    const bool bTaken = m_Bracketer.OnFrame( pLease->GetFrameID(), dNextUs, slot );
+    m_pWriter->SetFloat( "ExposureTimeAbs", dNextUs );
+    if(     bTaken
+        &&  pLease->IsComplete()
+        &&  VmbErrorSuccess == pLease->GetImage( slot.view ) )
+    {
+        pLease->SetAttachment( ATTACHMENT, std::shared_ptr<const HdrSlot>( new HdrSlot( slot ) ) );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Starts cycling with the next frame
+//
+// Parameters:
+//  [in]    rExposuresUs        The exposure times of a bracket
+//  [in]    nWriteLatency       Frames from a write to the first frame taken with it
+//  [in]    dRestoreUs          The exposure time to return to
+//
+// Returns:
+//  VmbErrorBadParameter for too many or too few exposure times
+//
+VmbErrorType HdrBracketStage::Enable( const std::vector<double> &rExposuresUs, VmbUint32_t nWriteLatency, double dRestoreUs )
+{
+    std::lock_guard<std::mutex> lock( m_BracketerMutex );
+    const VmbErrorType res = m_Bracketer.Reset( rExposuresUs, nWriteLatency );
+    if( VmbErrorSuccess == res )
+    {
+        m_bEnabled = true;
+        m_dRestoreUs = dRestoreUs;
+    }
+    return res;
+}
+
+//
+// Stops cycling and returns to the exposure time from before
+//
+void HdrBracketStage::Disable()
+{
+    std::lock_guard<std::mutex> lock( m_BracketerMutex );
+    if( m_bEnabled )
+    {
+        m_bEnabled = false;
+        m_pWriter->SetFloat( "ExposureTimeAbs", m_dRestoreUs );
+    }
+}
+
+bool HdrBracketStage::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock( m_BracketerMutex );
+    return m_bEnabled;
+}
+
+//
+// Lets the frames scheduled with an exposure time count once it was
+// written. Called on the thread of the feature writer.
+//
+// Parameters:
+//  [in]    dExposureUs         The exposure time written
+//
+void HdrBracketStage::OnExposureWritten( double dExposureUs )
+{
+    std::lock_guard<std::mutex> lock( m_BracketerMutex );
+    if( m_bEnabled )
+    {
+        m_Bracketer.OnWritten( dExposureUs );
+    }
+}
+
+HdrMergeStage::HdrMergeStage( ThreadPool *pPool )
+    : m_pPool( pPool )
+    , m_Copies( HDR_MAX_FRAMES - 1 )
+    , m_Buffers( FREE_BUFFERS )
+    , m_nBracket( 0 )
+    , m_nCollected( 0 )
+    , m_fKey( static_cast<float>( HdrSettings().dKey ) )
+    , m_fScale( 0.0f )
+{
+}
+
+VmbErrorType HdrMergeStage::Process( const FrameLeasePtr &pLease )
+{
+    const std::shared_ptr<const HdrSlot> pSlot = pLease->GetAttachment<HdrSlot>( HdrBracketStage::ATTACHMENT );
+    if( !pSlot )
+    {
+        return VmbErrorSuccess;
+    }
+    // Not the image of the lease, the stages behind the bracket stage may
+    // have replaced it by the mean or the undistorted frame by now
+    const ImageView &view = pSlot->view;
+    std::lock_guard<std::mutex> lock( m_PendingMutex );
+    if( pSlot->nBracket != m_nBracket )
+    {
+        m_nBracket = pSlot->nBracket;
+        m_nCollected = 0;
+    }
+    const bool bLast = pSlot->nIndex + 1 == pSlot->nFrames;
+    PendingFrame &rFrame = m_Pending[pSlot->nIndex];
+    rFrame.exposure.view = view;
+    rFrame.exposure.dExposureUs = pSlot->dExposureUs;
+    if( bLast )
+    {
+        // The lease holds the last frame until the merge is done
+        rFrame.pCopy.reset();
+    }
+    else
+    {
+        const size_t nSize = static_cast<size_t>( view.nStride ) * view.nHeight;
+        rFrame.pCopy = m_Copies.Acquire( nSize );
+        memcpy( rFrame.pCopy.get(), view.pBuffer, nSize );
+        rFrame.exposure.view.pBuffer = rFrame.pCopy.get();
+    }
+    m_nCollected |= 1u << pSlot->nIndex;
+    if( !bLast )
+    {
+        return VmbErrorSuccess;
+    }
+
+    // A bracket that lost a frame is skipped
+    const bool bComplete = ( ( 1u << pSlot->nFrames ) - 1 ) == m_nCollected;
+    m_nCollected = 0;
+    if( bComplete )
+    {
+        if( m_fScale <= 0.0f )
+        {
+            // Mid scale of the longest exposure until a mean is known
+            m_fScale = m_fKey * 2.0f / static_cast<float>( ( 1u << GetBitDepth( view.ePixelFormat ) ) - 1 );
+        }
+        HdrExposure frames[HDR_MAX_FRAMES];
+        for( VmbUint32_t f = 0; f < pSlot->nFrames; ++f )
+        {
+            frames[f] = m_Pending[f].exposure;
+        }
+        const size_t nSize = static_cast<size_t>( view.nWidth ) * ( 3 == GetBytesPerPixel( view.ePixelFormat ) ? 3 : 1 ) * view.nHeight;
+        const std::shared_ptr<VmbUchar_t> pBuffer = m_Buffers.Acquire( nSize );
+        std::shared_ptr<HdrImage> pImage( new HdrImage() );
+        if( VmbErrorSuccess == MergeExposures( frames, pSlot->nFrames, m_fScale, m_pPool, pBuffer.get(), pImage->view, pImage->fMeanRadiance ) )
+        {
+            if( pImage->fMeanRadiance > 0.0f )
+            {
+                m_fScale = m_fKey / pImage->fMeanRadiance;
+            }
+            pImage->pStorage = pBuffer;
+            pImage->nFrameID = pLease->GetFrameID();
+            std::lock_guard<std::mutex> latestLock( m_LatestMutex );
+            m_pLatest = pImage;
+        }
+    }
+    // The copies go back to the pool for the next bracket
+    for( VmbUint32_t f = 0; f < HDR_MAX_FRAMES; ++f )
+    {
+        m_Pending[f].pCopy.reset();
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Sets what the mean radiance is tone mapped to, from the next bracket
+//
+// Parameters:
+//  [in]    dKey                The mean is mapped to key / ( 1 + key ) of full scale
+//
+void HdrMergeStage::SetKey( double dKey )
+{
+    std::lock_guard<std::mutex> lock( m_PendingMutex );
+    if( m_fScale > 0.0f && m_fKey > 0.0f )
+    {
+        m_fScale *= static_cast<float>( dKey ) / m_fKey;
+    }
+    m_fKey = static_cast<float>( dKey );
+}
+
+//
+// Drops a bracket in progress and starts the tone mapping over
+//
+void HdrMergeStage::Reset()
+{
+    std::lock_guard<std::mutex> lock( m_PendingMutex );
+    for( VmbUint32_t f = 0; f < HDR_MAX_FRAMES; ++f )
+    {
+        m_Pending[f].pCopy.reset();
+    }
+    m_nCollected = 0;
+    m_fScale = 0.0f;
+}
+
+//
+// Returns:
+//  The last bracket merged, empty before the first
+//
+std::shared_ptr<const HdrImage> HdrMergeStage::GetLatest() const
+{
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    return m_pLatest;
+}
+
+// Forgets the last bracket merged
+void HdrMergeStage::ClearLatest()
+{
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    m_pLatest.reset();
+}
+
+VmbErrorType RecordStage::Process( const FrameLeasePtr &pLease )
+{
+    const bool bRecord  =   NULL != m_pBurst
+                        &&  (   BurstRecorder::StateArmed == m_pBurst->GetState()
+                            ||  BurstRecorder::StateCapturing == m_pBurst->GetState() )
+                        &&  ( NULL == m_pGate || m_pGate->IsRecordingAllowed() );
+    const bool bPublish =   NULL != m_pBus
+                        &&  m_pBus->IsOpen();
+    if(     !pLease->IsComplete()
+        ||  !( bRecord || bPublish ) )
+    {
+        return VmbErrorSuccess;
+    }
+
+    // The image of the lease, corrected by the stages before
+    ImageView view;
+    VmbUint32_t nSize;
+    if( VmbErrorSuccess == pLease->GetImage( view ) )
+    {
+        nSize = view.nStride * view.nHeight;
+    }
+    else
+    {
+        // Packed formats have no view, they go out as received
+        const FramePtr &pFrame = pLease->GetFrame();
+        VmbUchar_t *pBuffer;
+        if(     VmbErrorSuccess != pFrame->GetImage( pBuffer )
+            ||  VmbErrorSuccess != pFrame->GetImageSize( nSize )
+            ||  VmbErrorSuccess != pFrame->GetWidth( view.nWidth )
+            ||  VmbErrorSuccess != pFrame->GetHeight( view.nHeight )
+            ||  VmbErrorSuccess != pFrame->GetPixelFormat( view.ePixelFormat ) )
+        {
+            return VmbErrorSuccess;
+        }
+        view.pBuffer = pBuffer;
+    }
+    if( bRecord )
+    {
+        m_pBurst->Record( view.pBuffer, nSize, pLease->GetFrameID() );
+    }
+    if( bPublish )
+    {
+        m_pBus->Publish( view.pBuffer, nSize, pLease->GetFrameID(), view.nWidth, view.nHeight, view.ePixelFormat );
+    }
+    // Recording is a side line, the view gets the frame anyway
+    return VmbErrorSuccess;
+}
+
+VmbErrorType DisplayStage::Process( const FrameLeasePtr &pLease )
+{
+    CWinApp *pApp = AfxGetApp();
+    CWnd *pMainWin = NULL == pApp ? NULL : pApp->GetMainWnd();
+    if( NULL == pMainWin )
+    {
+        if( NULL != m_pMetrics )
+        {
+            m_pMetrics->OnDropped();
+        }
+        return VmbErrorInvalidCall;
+    }
+
+    // Lock the frame queue
+    m_FramesMutex.Lock();
+    // We store the lease
+    m_Frames.push( pLease );
+    if( NULL != m_pMetrics )
+    {
+        m_pMetrics->SetQueueDepth( static_cast<VmbUint32_t>( m_Frames.size() ) );
+    }
+    // Unlock frame queue
+    m_FramesMutex.Unlock();
+    // And notify the view about it
+    pMainWin->PostMessage( m_nMessage, pLease->GetReceiveStatus() );
+    return VmbErrorSuccess;
+}
+
+//
+// After the view has been notified about a new frame it can pick it up.
+// It is then removed from the internal queue
+//
+// Returns:
+//  The lease of the oldest frame, the frame is requeued once it ends
+//
+FrameLeasePtr DisplayStage::GetFrame()
+{
+    // Lock frame queue
+    m_FramesMutex.Lock();
+    // Pop the frame from the queue
+    FrameLeasePtr res;
+    if( ! m_Frames.empty() )
+    {
+        res = m_Frames.front();
+        m_Frames.pop();
+    }
+    if( NULL != m_pMetrics )
+    {
+        m_pMetrics->SetQueueDepth( static_cast<VmbUint32_t>( m_Frames.size() ) );
+    }
+    // Unlock the frame queue
+    m_FramesMutex.Unlock();
+    return res;
+}
+
+//
+// Clears the internal (double buffering) frame queue
+//
+void DisplayStage::ClearFrameQueue()
+{
+    // Lock the frame queue
+    m_FramesMutex.Lock();
+    // Clear the frame queue, the leases end after the unlock
+    std::queue<FrameLeasePtr> empty;
+    std::swap( m_Frames, empty );
+    if( NULL != m_pMetrics )
+    {
+        // Never shown by the view
+        m_pMetrics->OnDropped( empty.size() );
+        m_pMetrics->SetQueueDepth( 0 );
+    }
+    // Unlock the frame queue
+    m_FramesMutex.Unlock();
+}
+
+YuvStage::YuvStage( ThreadPool *pPool )
+    : m_pPool( pPool )
+    , m_Buffers( FREE_BUFFERS )
+    , m_bEnabled( false )
+{
+}
+
+VmbErrorType YuvStage::Process( const FrameLeasePtr &pLease )
+{
+    if(     !m_bEnabled
+        ||  !pLease->IsComplete() )
+    {
+        return VmbErrorSuccess;
+    }
+    YuvSettings settings;
+    YuvSink sink;
+    {
+        std::lock_guard<std::mutex> lock( m_SettingsMutex );
+        settings = m_Settings;
+        sink = m_Sink;
+    }
+    ImageView view;
+    size_t nSize;
+    // Other formats and odd sizes are left out
+    if(     VmbErrorSuccess != pLease->GetImage( view )
+        ||  VmbErrorSuccess != GetYuvImageSize( view.nWidth, view.nHeight, nSize ) )
+    {
+        return VmbErrorSuccess;
+    }
+    const std::shared_ptr<VmbUchar_t> pBuffer = m_Buffers.Acquire( nSize );
+    if( VmbErrorSuccess != ConvertToYuv( view, settings, m_pPool, pBuffer.get() ) )
+    {
+        return VmbErrorSuccess;
+    }
+    std::shared_ptr<YuvImage> pImage( new YuvImage() );
+    pImage->pStorage = pBuffer;
+    pImage->nSize = nSize;
+    pImage->nWidth = view.nWidth;
+    pImage->nHeight = view.nHeight;
+    pImage->settings = settings;
+    pImage->nFrameID = pLease->GetFrameID();
+    {
+        std::lock_guard<std::mutex> lock( m_LatestMutex );
+        m_pLatest = pImage;
+    }
+    if( sink )
+    {
+        sink( pImage );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Sets the layout, matrix and range, from the next frame
+//
+void YuvStage::SetSettings( const YuvSettings &rSettings )
+{
+    std::lock_guard<std::mutex> lock( m_SettingsMutex );
+    m_Settings = rSettings;
+}
+
+YuvSettings YuvStage::GetSettings() const
+{
+    std::lock_guard<std::mutex> lock( m_SettingsMutex );
+    return m_Settings;
+}
+
+void YuvStage::SetEnabled( bool bEnabled )
+{
+    m_bEnabled = bEnabled;
+}
+
+bool YuvStage::IsEnabled() const
+{
+    return m_bEnabled;
+}
+
+//
+// Sets what gets every converted frame, empty for none. It is called
+// on the thread of the stage.
+//
+void YuvStage::SetSink( const YuvSink &sink )
+{
+    std::lock_guard<std::mutex> lock( m_SettingsMutex );
+    m_Sink = sink;
+}
+
+//
+// Returns:
+//  The last frame converted, empty before the first
+//
+YuvImagePtr YuvStage::GetLatest() const
+{
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    return m_pLatest;
+}
+
+// Forgets the last frame converted
+void YuvStage::ClearLatest()
+{
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    m_pLatest.reset();
+}
+
+const char * const ImageStatsStage::ATTACHMENT = "ImageStatistics";
+
+VmbErrorType ImageStatsStage::Process( const FrameLeasePtr &pLease )
+{
+    if( !pLease->IsComplete() )
+    {
+        return VmbErrorIncomplete;
+    }
+    ImageView view;
+    VmbErrorType res = pLease->GetImage( view );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    std::shared_ptr<ImageStatistics> pStatistics( new ImageStatistics() );
+    res = ComputeImageStatistics( view, m_nSubsampling.load( std::memory_order_relaxed ), m_pPool, *pStatistics );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    pStatistics->nFrameID = pLease->GetFrameID();
+
+    if( NULL != m_pMetrics )
+    {
+        // Color images report their green channel, it carries most of the luminance
+        const VmbUint32_t c = 3 == pStatistics->nChannels ? 1 : 0;
+        const double dPixels = static_cast<double>( pStatistics->nPixels );
+        m_pMetrics->OnImageStatistics(  pStatistics->dMean[c], pStatistics->nMin[c], pStatistics->nMax[c],
+                                        pStatistics->nClippedLow[c] / dPixels, pStatistics->nClippedHigh[c] / dPixels );
+    }
+    std::shared_ptr<const ImageStatistics> pResult( pStatistics );
+    pLease->SetAttachment( ATTACHMENT, pResult );
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    m_pLatest = pResult;
+    return VmbErrorSuccess;
+}
+
+//
+// Looks at fewer pixels, e.g. for a preview at full frame rate
+//
+// Parameters:
+//  [in]    nSubsampling        Every nth pixel of every nth row, 1 for all
+//
+void ImageStatsStage::SetSubsampling( VmbUint32_t nSubsampling )
+{
+    m_nSubsampling.store( (std::max)( 1u, nSubsampling ), std::memory_order_relaxed );
+}
+
+//
+// Returns:
+//  The statistics of the last analysed frame, empty before the first
+//
+std::shared_ptr<const ImageStatistics> ImageStatsStage::GetLatest() const
+{
+    std::lock_guard<std::mutex> lock( m_LatestMutex );
+    return m_pLatest;
+}
+
+VmbErrorType AutoExposureStage::Process( const FrameLeasePtr &pLease )
+{
+    std::shared_ptr<const ImageStatistics> pStatistics = pLease->GetAttachment<ImageStatistics>( ImageStatsStage::ATTACHMENT );
+    if( !pStatistics )
+    {
+        // Not analysed, nothing to steer by
+        return VmbErrorSuccess;
+    }
+    // The writes are queued under the lock, so none slips in after Disable
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    double dExposureUs;
+    double dGainDb;
+    if(     !m_bEnabled
+        ||  !m_Controller.Update( *pStatistics, dExposureUs, dGainDb ) )
+    {
+        return VmbErrorSuccess;
+    }
+    m_pWriter->SetFloat( "ExposureTimeAbs", dExposureUs );
+    if( m_Controller.GetSettings().dMaxGainDb > m_Controller.GetSettings().dMinGainDb )
+    {
+        m_pWriter->SetFloat( "Gain", dGainDb );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Starts steering from what the camera currently uses
+//
+// Parameters:
+//  [in]    settings            The limits and the target
+//  [in]    dExposureUs         The current exposure time
+//  [in]    dGainDb             The current gain
+//
+void AutoExposureStage::Enable( const AutoExposureSettings &settings, double dExposureUs, double dGainDb )
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    m_Controller.Reset( settings, dExposureUs, dGainDb );
+    m_bEnabled = true;
+}
+
+//
+// Stops steering, the camera keeps the values written last
+//
+void AutoExposureStage::Disable()
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    m_bEnabled = false;
+}
+
+bool AutoExposureStage::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    return m_bEnabled;
+}
+
+bool AutoExposureStage::IsConverged() const
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    return m_bEnabled && m_Controller.IsConverged();
+}
+
+double AutoExposureStage::GetExposure() const
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    return m_Controller.GetExposure();
+}
+
+double AutoExposureStage::GetGain() const
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    return m_Controller.GetGain();
+}
+
+AutoExposureSettings AutoExposureStage::GetSettings() const
+{
+    std::lock_guard<std::mutex> lock( m_ControllerMutex );
+    return m_Controller.GetSettings();
+}
+
+SharpnessStage::SharpnessStage( ThreadPool *pPool, StreamMetrics *pMetrics )
+    : m_pPool( pPool )
+    , m_pMetrics( pMetrics )
+    , m_nLeft( 0 )
+    , m_nTop( 0 )
+    , m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_History( HISTORY_LENGTH )
+    , m_nHistoryNext( 0 )
+    , m_nHistoryCount( 0 )
+{
+}
+
+VmbErrorType SharpnessStage::Process( const FrameLeasePtr &pLease )
+{
+    if( !pLease->IsComplete() )
+    {
+        return VmbErrorIncomplete;
+    }
+    ImageView view;
+    VmbErrorType res = pLease->GetImage( view );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    ImageView region = view;
+    {
+        std::lock_guard<std::mutex> lock( m_RegionMutex );
+        if( 0 != m_nWidth && 0 != m_nHeight )
+        {
+            res = CropImageView( view, m_nLeft, m_nTop, m_nWidth, m_nHeight, region );
+        }
+    }
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    SharpnessMeasure measure;
+    res = ComputeSharpness( region, m_pPool, measure );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    measure.nFrameID = pLease->GetFrameID();
+
+    if( NULL != m_pMetrics )
+    {
+        m_pMetrics->OnSharpness( measure.dLaplacianVariance, measure.dTenengrad );
+    }
+    std::lock_guard<std::mutex> lock( m_HistoryMutex );
+    m_History[m_nHistoryNext] = measure;
+    m_nHistoryNext = ( m_nHistoryNext + 1 ) % m_History.size();
+    m_nHistoryCount = (std::min)( m_nHistoryCount + 1, m_History.size() );
+    return VmbErrorSuccess;
+}
+
+//
+// Sets the region to measure, clipped to the frame
+//
+// Parameters:
+//  [in]    nLeft               The first column
+//  [in]    nTop                The first row
+//  [in]    nWidth              The width, 0 for the whole frame
+//  [in]    nHeight             The height, 0 for the whole frame
+//
+void SharpnessStage::SetRegion( VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_RegionMutex );
+        m_nLeft     = nLeft;
+        m_nTop      = nTop;
+        m_nWidth    = nWidth;
+        m_nHeight   = nHeight;
+    }
+    // The measures of different regions do not compare
+    ClearHistory();
+}
+
+//
+// Gets the measures of the last frames
+//
+// Parameters:
+//  [out]   rHistory            Oldest first, at most HISTORY_LENGTH
+//
+void SharpnessStage::GetHistory( std::vector<SharpnessMeasure> &rHistory ) const
+{
+    std::lock_guard<std::mutex> lock( m_HistoryMutex );
+    rHistory.clear();
+    rHistory.reserve( m_nHistoryCount );
+    const size_t nOldest = ( m_nHistoryNext + m_History.size() - m_nHistoryCount ) % m_History.size();
+    for( size_t i = 0; i < m_nHistoryCount; ++i )
+    {
+        rHistory.push_back( m_History[( nOldest + i ) % m_History.size()] );
+    }
+}
+
+//
+// Gets the measure of the last frame
+//
+// Parameters:
+//  [out]   rMeasure            The measure
+//
+// Returns:
+//  false before the first frame
+//
+bool SharpnessStage::GetLatest( SharpnessMeasure &rMeasure ) const
+{
+    std::lock_guard<std::mutex> lock( m_HistoryMutex );
+    if( 0 == m_nHistoryCount )
+    {
+        return false;
+    }
+    rMeasure = m_History[( m_nHistoryNext + m_History.size() - 1 ) % m_History.size()];
+    return true;
+}
+
+void SharpnessStage::ClearHistory()
+{
+    std::lock_guard<std::mutex> lock( m_HistoryMutex );
+    m_nHistoryNext = 0;
+    m_nHistoryCount = 0;
+}
+
+MotionStage::MotionStage( StreamMetrics *pMetrics )
+    : m_pMetrics( pMetrics )
+    , m_bActive( false )
+    , m_bTriggerEnabled( false )
+{
+}
+
+VmbErrorType MotionStage::Process( const FrameLeasePtr &pLease )
+{
+    if( !pLease->IsComplete() )
+    {
+        return VmbErrorIncomplete;
+    }
+    ImageView view;
+    VmbErrorType res = pLease->GetImage( view );
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    MotionResult result;
+    {
+        std::lock_guard<std::mutex> lock( m_DetectorMutex );
+        res = m_Detector.Process( view, result );
+    }
+    if( VmbErrorSuccess != res )
+    {
+        return res;
+    }
+    result.nFrameID = pLease->GetFrameID();
+    // Open the gate before the callback arms the burst
+    m_bActive.store( result.bActive );
+    if( NULL != m_pMetrics )
+    {
+        m_pMetrics->OnMotion( result.dChangedRatio, result.bActive, MotionEventStarted == result.eEvent );
+    }
+    if( MotionEventNone == result.eEvent )
+    {
+        return VmbErrorSuccess;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_EventsMutex );
+        if( MAX_PENDING_EVENTS <= m_Events.size() )
+        {
+            m_Events.erase( m_Events.begin() );
+        }
+        m_Events.push_back( result );
+    }
+    std::lock_guard<std::mutex> lock( m_CallbackMutex );
+    if( m_Callback )
+    {
+        m_Callback( result );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Sets the grid, the thresholds and the hysteresis. The background
+// starts over with the next frame.
+//
+// Parameters:
+//  [in]    settings            The settings
+//
+void MotionStage::SetSettings( const MotionSettings &settings )
+{
+    std::lock_guard<std::mutex> lock( m_DetectorMutex );
+    m_Detector.Reset( settings );
+    m_bActive.store( false );
+}
+
+MotionSettings MotionStage::GetSettings() const
+{
+    std::lock_guard<std::mutex> lock( m_DetectorMutex );
+    return m_Detector.GetSettings();
+}
+
+//
+// Lets motion gate the recording
+//
+// Parameters:
+//  [in]    callback            Called on the stage thread when motion starts or stops
+//
+void MotionStage::EnableTrigger( const EventCallback &callback )
+{
+    std::lock_guard<std::mutex> lock( m_CallbackMutex );
+    m_Callback = callback;
+    m_bTriggerEnabled.store( true );
+}
+
+//
+// Records regardless of motion again. No callback is running or
+// made once this returns.
+//
+void MotionStage::DisableTrigger()
+{
+    std::lock_guard<std::mutex> lock( m_CallbackMutex );
+    m_Callback = EventCallback();
+    m_bTriggerEnabled.store( false );
+}
+
+bool MotionStage::IsTriggerEnabled() const
+{
+    return m_bTriggerEnabled.load();
+}
+
+bool MotionStage::IsActive() const
+{
+    return m_bActive.load();
+}
+
+bool MotionStage::IsRecordingAllowed() const
+{
+    return !m_bTriggerEnabled.load() || m_bActive.load();
+}
+
+//
+// Takes the starts and stops since the last call
+//
+// Parameters:
+//  [out]   rEvents             Oldest first, the oldest are dropped beyond MAX_PENDING_EVENTS
+//
+void MotionStage::TakeEvents( std::vector<MotionResult> &rEvents )
+{
+    rEvents.clear();
+    std::lock_guard<std::mutex> lock( m_EventsMutex );
+    rEvents.swap( m_Events );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
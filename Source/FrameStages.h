@@ -0,0 +1,815 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        FrameStages.h
+
+  Description: The stages every camera pipeline starts with: recording and
+               publishing complete frames, and handing frames to the view.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_FRAMESTAGES
+#define AVT_VMBAPI_EXAMPLES_FRAMESTAGES
+
+#include <queue>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "FramePipeline.h"
+#include "BurstRecorder.h"
+#include "SharedFrameBus.h"
+#include "FrameMetrics.h"
+#include "ImageStats.h"
+#include "Sharpness.h"
+#include "MotionDetector.h"
+#include "FlatField.h"
+#include "TemporalAverage.h"
+#include "HdrMerge.h"
+#include "LensRemap.h"
+#include "YuvConverter.h"
+#include "ImageBufferPool.h"
+#include "DefectivePixels.h"
+#include "ThreadPool.h"
+#include "AutoExposure.h"
+#include "FeatureWriter.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Where the stages every camera pipeline starts with were added, to name
+// them as parents of further stages
+struct PipelineStageIndices
+{
+    size_t  nCorrection;
+    size_t  nBracket;
+    size_t  nAverage;
+    size_t  nUndistort;
+    size_t  nHdr;
+    size_t  nRecord;
+    size_t  nDisplay;
+    size_t  nStats;
+    size_t  nAutoExposure;
+    size_t  nSharpness;
+    size_t  nMotion;
+    size_t  nYuv;
+
+    PipelineStageIndices()
+        : nCorrection( 0 )
+        , nBracket( 0 )
+        , nAverage( 0 )
+        , nUndistort( 0 )
+        , nHdr( 0 )
+        , nRecord( 0 )
+        , nDisplay( 0 )
+        , nStats( 0 )
+        , nAutoExposure( 0 )
+        , nSharpness( 0 )
+        , nMotion( 0 )
+        , nYuv( 0 )
+    {
+    }
+};
+
+class MotionStage;
+
+//
+// Corrects complete frames by the flat-field and dark-frame maps of the
+// camera and repairs its defective pixels, before anything else sees
+// them. Both go into one buffer of the stage, which replaces the image of
+// the lease. While a calibration is captured the raw frames are stacked
+// first. Runs inline, every later stage has to get the corrected frame.
+//
+class CorrectionStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //
+    CorrectionStage( ThreadPool *pPool );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Stacks the next frames for a calibration. Dark frames start a new
+    // calibration, flat frames are added to the dark frames captured before.
+    //
+    // Parameters:
+    //  [in]    eType               What the camera looks at
+    //  [in]    nFrames             The number of frames to stack
+    //
+    void StartCapture( CalibrationFrameType eType, VmbUint32_t nFrames );
+
+    // Whether frames are still being stacked
+    bool IsCapturing() const;
+
+    //
+    // Returns:
+    //  The number of frames stacked of a type
+    //
+    VmbUint32_t GetCapturedCount( CalibrationFrameType eType ) const;
+
+    //
+    // Builds flat-field maps from the frames stacked
+    //
+    // Parameters:
+    //  [out]   rMaps               The maps
+    //
+    // Returns:
+    //  VmbErrorInvalidCall without flat frames
+    //
+    VmbErrorType BuildMaps( CalibrationMaps &rMaps ) const;
+
+    //
+    // Finds the defective pixels in the frames stacked
+    //
+    // Parameters:
+    //  [out]   rMap                The defective pixels
+    //
+    // Returns:
+    //  VmbErrorInvalidCall if no frames were stacked
+    //
+    VmbErrorType DetectDefects( DefectivePixelMap &rMap ) const;
+
+    //
+    // Sets the flat-field maps to correct with, NULL for none
+    //
+    void SetMaps( const std::shared_ptr<const CalibrationMaps> &pMaps );
+
+    // Whether there are flat-field maps to correct with
+    bool HasMaps() const;
+
+    void SetFlatFieldEnabled( bool bEnabled );
+    bool IsFlatFieldEnabled() const;
+
+    //
+    // Sets the defective pixels to repair, NULL for none
+    //
+    void SetDefectMap( const std::shared_ptr<const DefectivePixelMap> &pMap );
+
+    //
+    // Returns:
+    //  The defective pixels repaired, NULL for none
+    //
+    std::shared_ptr<const DefectivePixelMap> GetDefectMap() const;
+
+    void SetDefectRepairEnabled( bool bEnabled );
+    bool IsDefectRepairEnabled() const;
+
+    //
+    // Drops the maps and a calibration in progress, e.g. for another camera
+    //
+    void Reset();
+
+  private:
+    // A corrected frame is on the screen while the next is corrected
+    enum { FREE_BUFFERS = 4, };
+
+    ThreadPool *m_pPool;
+    ImageBufferPool m_Buffers;
+    CalibrationBuilder m_Builder;
+    CalibrationFrameType m_eCaptureType;
+    VmbUint32_t m_nCaptureRemaining;
+    mutable std::mutex m_CaptureMutex;
+    std::shared_ptr<const CalibrationMaps> m_pMaps;
+    std::shared_ptr<const DefectivePixelMap> m_pDefects;
+    mutable std::mutex m_MapsMutex;
+    std::atomic<bool> m_bFlatFieldEnabled;
+    std::atomic<bool> m_bDefectRepairEnabled;
+};
+
+//
+// Replaces complete frames by the mean of the last frames to reduce
+// noise. The frames of a short window are kept by their leases, longer
+// windows would hold back too many buffers of the camera, so their
+// frames are copied. Runs inline behind the correction stage.
+//
+class AverageStage : public IFrameStage
+{
+  public:
+    // Longer windows take too much memory for full frames
+    enum { MAX_WINDOW = 64, };
+
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //  [in]    nMaxLeases          The frames kept by their leases at most
+    //
+    AverageStage( ThreadPool *pPool, VmbUint32_t nMaxLeases );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets the number of frames to average, taking effect with the next
+    // frame. A shorter window drops the oldest frames.
+    //
+    // Parameters:
+    //  [in]    nFrames             The frames, 1 to pass frames as they are
+    //
+    // Returns:
+    //  VmbErrorBadParameter beyond MAX_WINDOW
+    //
+    VmbErrorType SetWindow( VmbUint32_t nFrames );
+    VmbUint32_t GetWindow() const;
+
+    //
+    // Drops the frames kept, e.g. before the camera is closed
+    //
+    void Reset();
+
+  private:
+    // A frame in the window, either its lease or a copy keeps the pixels
+    struct RetainedFrame
+    {
+        FrameLeasePtr                   pLease;
+        std::shared_ptr<VmbUchar_t>     pCopy;
+        ImageView                       view;
+    };
+
+    // A mean is on the screen while the next is computed
+    enum { FREE_BUFFERS = 4, };
+
+    ThreadPool *m_pPool;
+    VmbUint32_t m_nMaxLeases;
+    ImageBufferPool m_Buffers;
+    // Only the copies leaving the window are kept for reuse
+    ImageBufferPool m_Copies;
+    FrameAccumulator m_Accumulator;
+    std::deque<RetainedFrame> m_Frames;
+    std::mutex m_FramesMutex;
+    std::atomic<VmbUint32_t> m_nWindow;
+};
+
+//
+// Replaces complete frames by their remapped image, e.g. to undistort
+// the lens, so recordings and every later stage see straight lines.
+// Runs inline behind the average stage.
+//
+class UndistortStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //
+    UndistortStage( ThreadPool *pPool );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets the table to remap by, NULL for none
+    //
+    void SetTable( const std::shared_ptr<const RemapTable> &pTable );
+
+    //
+    // Returns:
+    //  The table remapped by, NULL for none
+    //
+    std::shared_ptr<const RemapTable> GetTable() const;
+
+    void SetEnabled( bool bEnabled );
+    bool IsEnabled() const;
+
+    //
+    // Drops the table, e.g. for another camera
+    //
+    void Reset();
+
+  private:
+    // A remapped frame is on the screen while the next is remapped
+    enum { FREE_BUFFERS = 4, };
+
+    ThreadPool *m_pPool;
+    ImageBufferPool m_Buffers;
+    std::shared_ptr<const RemapTable> m_pTable;
+    mutable std::mutex m_TableMutex;
+    std::atomic<bool> m_bEnabled;
+};
+
+//
+// Cycles the exposure time of the camera over consecutive frames and
+// marks the frames taken with the exposure time of their slot. Runs
+// inline, the next exposure time has to be written as early as possible.
+//
+class HdrBracketStage : public IFrameStage
+{
+  public:
+    // The name of the HdrSlot attachment of the lease
+    static const char * const ATTACHMENT;
+
+    //
+    // Parameters:
+    //  [in]    pWriter             Writes the features of the camera
+    //
+    explicit HdrBracketStage( FeatureWriter *pWriter ) : m_pWriter( pWriter ), m_bEnabled( false ), m_dRestoreUs( 0.0 ) {;}
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Starts cycling with the next frame
+    //
+    // Parameters:
+    //  [in]    rExposuresUs        The exposure times of a bracket
+    //  [in]    nWriteLatency       Frames from a write to the first frame taken with it
+    //  [in]    dRestoreUs          The exposure time to return to
+    //
+    // Returns:
+    //  VmbErrorBadParameter for too many or too few exposure times
+    //
+    VmbErrorType Enable( const std::vector<double> &rExposuresUs, VmbUint32_t nWriteLatency, double dRestoreUs );
+
+    //
+    // Stops cycling and returns to the exposure time from before
+    //
+    void Disable();
+
+    bool IsEnabled() const;
+
+    //
+    // Lets the frames scheduled with an exposure time count once it was
+    // written. Called on the thread of the feature writer.
+    //
+    // Parameters:
+    //  [in]    dExposureUs         The exposure time written
+    //
+    void OnExposureWritten( double dExposureUs );
+
+  private:
+    FeatureWriter *m_pWriter;
+    ExposureBracketer m_Bracketer;
+    bool m_bEnabled;
+    double m_dRestoreUs;
+    mutable std::mutex m_BracketerMutex;
+};
+
+// A tone mapped bracket
+struct HdrImage
+{
+    ImageView                           view;
+    std::shared_ptr<const VmbUchar_t>   pStorage;
+    // The ID of the last frame of the bracket
+    VmbUint64_t                         nFrameID;
+    float                               fMeanRadiance;
+};
+
+//
+// Merges the frames of a bracket when its last frame arrives and keeps
+// the tone mapped result for the view. The tone mapping follows the mean
+// radiance of the bracket before. Runs on a thread of its own with the
+// merge spread over the pool, so brackets come at the frame rate divided
+// by their size.
+//
+class HdrMergeStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a bracket over, may be NULL
+    //
+    explicit HdrMergeStage( ThreadPool *pPool );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets what the mean radiance is tone mapped to, from the next bracket
+    //
+    // Parameters:
+    //  [in]    dKey                The mean is mapped to key / ( 1 + key ) of full scale
+    //
+    void SetKey( double dKey );
+
+    //
+    // Drops a bracket in progress and starts the tone mapping over
+    //
+    void Reset();
+
+    //
+    // Returns:
+    //  The last bracket merged, empty before the first
+    //
+    std::shared_ptr<const HdrImage> GetLatest() const;
+
+    // Forgets the last bracket merged
+    void ClearLatest();
+
+  private:
+    // A frame of the bracket in progress. All but the last are copied,
+    // so the camera gets its buffers back at once.
+    struct PendingFrame
+    {
+        std::shared_ptr<VmbUchar_t>     pCopy;
+        HdrExposure                     exposure;
+    };
+
+    // The view holds the last bracket while the next is merged
+    enum { FREE_BUFFERS = 2, };
+
+    ThreadPool *m_pPool;
+    ImageBufferPool m_Copies;
+    ImageBufferPool m_Buffers;
+    PendingFrame m_Pending[HDR_MAX_FRAMES];
+    VmbUint64_t m_nBracket;
+    // A bit per slot collected
+    VmbUint32_t m_nCollected;
+    float m_fKey;
+    // 0 until the first bracket is merged
+    float m_fScale;
+    std::mutex m_PendingMutex;
+    std::shared_ptr<const HdrImage> m_pLatest;
+    mutable std::mutex m_LatestMutex;
+};
+
+//
+// Copies complete frames into the burst arena and onto the frame bus.
+// Runs inline, the message loop of the view would be too slow for that.
+//
+class RecordStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pBurst              The burst recorder of the camera, may be NULL
+    //  [in]    pBus                The shared frame bus of the camera, may be NULL
+    //  [in]    pGate               The motion stage that gates the burst, may be NULL
+    //
+    RecordStage( BurstRecorder *pBurst, SharedFrameBus *pBus, const MotionStage *pGate = NULL ) : m_pBurst( pBurst ), m_pBus( pBus ), m_pGate( pGate ) {;}
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+  private:
+    BurstRecorder  *m_pBurst;
+    SharedFrameBus *m_pBus;
+    // Holds the burst back while the camera sees no motion, may be NULL
+    const MotionStage *m_pGate;
+};
+
+//
+// Keeps the frames until the view picks them up and notifies it
+//
+class DisplayStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nMessage            The message posted to the main window per frame
+    //  [in]    pMetrics            The frame counters of the camera, may be NULL
+    //
+    DisplayStage( UINT nMessage, StreamMetrics *pMetrics ) : m_nMessage( nMessage ), m_pMetrics( pMetrics ) {;}
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // After the view has been notified about a new frame it can pick it up.
+    // It is then removed from the internal queue
+    //
+    // Returns:
+    //  The lease of the oldest frame, the frame is requeued once it ends
+    //
+    FrameLeasePtr GetFrame();
+
+    //
+    // Clears the internal (double buffering) frame queue
+    //
+    void ClearFrameQueue();
+
+  private:
+    // Since a MFC message cannot contain a whole frame
+    // the stage stores all leases
+    std::queue<FrameLeasePtr> m_Frames;
+    AVT::VmbAPI::Mutex m_FramesMutex;
+    UINT m_nMessage;
+    StreamMetrics *m_pMetrics;
+};
+
+// A frame converted to YUV 4:2:0
+struct YuvImage
+{
+    std::shared_ptr<const VmbUchar_t>   pStorage;
+    size_t                              nSize;
+    VmbUint32_t                         nWidth;
+    VmbUint32_t                         nHeight;
+    YuvSettings                         settings;
+    VmbUint64_t                         nFrameID;
+};
+
+typedef std::shared_ptr<const YuvImage> YuvImagePtr;
+
+// Takes the converted frames, e.g. to a video encoder
+typedef std::function<void( const YuvImagePtr &pImage )> YuvSink;
+
+//
+// Converts complete frames to NV12 or I420 for video encoders, next to
+// the display, which converts them to BGR for the view. Runs on a
+// thread of its own, so a slow sink only loses converted frames.
+//
+class YuvStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //
+    explicit YuvStage( ThreadPool *pPool );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets the layout, matrix and range, from the next frame
+    //
+    void SetSettings( const YuvSettings &rSettings );
+    YuvSettings GetSettings() const;
+
+    void SetEnabled( bool bEnabled );
+    bool IsEnabled() const;
+
+    //
+    // Sets what gets every converted frame, empty for none. It is called
+    // on the thread of the stage.
+    //
+    void SetSink( const YuvSink &sink );
+
+    //
+    // Returns:
+    //  The last frame converted, empty before the first
+    //
+    YuvImagePtr GetLatest() const;
+
+    // Forgets the last frame converted
+    void ClearLatest();
+
+  private:
+    // The sink and the latest frame hold converted frames while the next is converted
+    enum { FREE_BUFFERS = 4, };
+
+    ThreadPool *m_pPool;
+    ImageBufferPool m_Buffers;
+    YuvSettings m_Settings;
+    YuvSink m_Sink;
+    mutable std::mutex m_SettingsMutex;
+    std::atomic<bool> m_bEnabled;
+    YuvImagePtr m_pLatest;
+    mutable std::mutex m_LatestMutex;
+};
+
+//
+// Computes the exposure statistics of complete frames. They are attached
+// to the lease and kept as the latest of the camera.
+//
+class ImageStatsStage : public IFrameStage
+{
+  public:
+    // The name of the ImageStatistics attachment of the lease
+    static const char * const ATTACHMENT;
+
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //  [in]    pMetrics            The frame counters of the camera, may be NULL
+    //
+    ImageStatsStage( ThreadPool *pPool, StreamMetrics *pMetrics ) : m_pPool( pPool ), m_pMetrics( pMetrics ), m_nSubsampling( 1 ) {;}
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Looks at fewer pixels, e.g. for a preview at full frame rate
+    //
+    // Parameters:
+    //  [in]    nSubsampling        Every nth pixel of every nth row, 1 for all
+    //
+    void SetSubsampling( VmbUint32_t nSubsampling );
+
+    //
+    // Returns:
+    //  The statistics of the last analysed frame, empty before the first
+    //
+    std::shared_ptr<const ImageStatistics> GetLatest() const;
+
+  private:
+    ThreadPool *m_pPool;
+    StreamMetrics *m_pMetrics;
+    std::atomic<VmbUint32_t> m_nSubsampling;
+    std::shared_ptr<const ImageStatistics> m_pLatest;
+    mutable std::mutex m_LatestMutex;
+};
+
+//
+// Steers exposure time and gain of the camera by the statistics the
+// stats stage attached. Runs inline behind it, the writes are queued.
+//
+class AutoExposureStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pWriter             Writes the features of the camera
+    //
+    explicit AutoExposureStage( FeatureWriter *pWriter ) : m_pWriter( pWriter ), m_bEnabled( false ) {;}
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Starts steering from what the camera currently uses
+    //
+    // Parameters:
+    //  [in]    settings            The limits and the target
+    //  [in]    dExposureUs         The current exposure time
+    //  [in]    dGainDb             The current gain
+    //
+    void Enable( const AutoExposureSettings &settings, double dExposureUs, double dGainDb );
+
+    //
+    // Stops steering, the camera keeps the values written last
+    //
+    void Disable();
+
+    bool IsEnabled() const;
+
+    //
+    // Returns:
+    //  true while the target is reached or a limit keeps it from being reached
+    //
+    bool IsConverged() const;
+
+    //
+    // Returns:
+    //  The exposure time written last
+    //
+    double GetExposure() const;
+    double GetGain() const;
+    AutoExposureSettings GetSettings() const;
+
+  private:
+    FeatureWriter *m_pWriter;
+    AutoExposureController m_Controller;
+    bool m_bEnabled;
+    mutable std::mutex m_ControllerMutex;
+};
+
+//
+// Measures the sharpness of a region of complete frames for focusing the
+// lens. Keeps the measures of the last frames for the view to plot.
+//
+class SharpnessStage : public IFrameStage
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    pPool               The pool to spread a frame over, may be NULL
+    //  [in]    pMetrics            The frame counters of the camera, may be NULL
+    //
+    SharpnessStage( ThreadPool *pPool, StreamMetrics *pMetrics );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets the region to measure, clipped to the frame
+    //
+    // Parameters:
+    //  [in]    nLeft               The first column
+    //  [in]    nTop                The first row
+    //  [in]    nWidth              The width, 0 for the whole frame
+    //  [in]    nHeight             The height, 0 for the whole frame
+    //
+    void SetRegion( VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight );
+
+    //
+    // Gets the measures of the last frames
+    //
+    // Parameters:
+    //  [out]   rHistory            Oldest first, at most HISTORY_LENGTH
+    //
+    void GetHistory( std::vector<SharpnessMeasure> &rHistory ) const;
+
+    //
+    // Gets the measure of the last frame
+    //
+    // Parameters:
+    //  [out]   rMeasure            The measure
+    //
+    // Returns:
+    //  false before the first frame
+    //
+    bool GetLatest( SharpnessMeasure &rMeasure ) const;
+
+    // Forgets the measures, e.g. when the region or the lens changed
+    void ClearHistory();
+
+    // The number of measures kept, a few seconds at full frame rate
+    enum { HISTORY_LENGTH = 512, };
+
+  private:
+    ThreadPool *m_pPool;
+    StreamMetrics *m_pMetrics;
+    VmbUint32_t m_nLeft;
+    VmbUint32_t m_nTop;
+    VmbUint32_t m_nWidth;
+    VmbUint32_t m_nHeight;
+    mutable std::mutex m_RegionMutex;
+    // A ring, m_nHistoryNext is where the next measure goes
+    std::vector<SharpnessMeasure> m_History;
+    size_t m_nHistoryNext;
+    size_t m_nHistoryCount;
+    mutable std::mutex m_HistoryMutex;
+};
+
+//
+// Detects changes of the scene by comparing a decimated frame with a
+// running background. Runs on a thread of its own, one per camera. While
+// the trigger is enabled the burst of the camera records only during
+// motion, and the callback is told when motion starts and stops.
+//
+class MotionStage : public IFrameStage
+{
+  public:
+    typedef std::function<void( const MotionResult &rResult )> EventCallback;
+
+    //
+    // Parameters:
+    //  [in]    pMetrics            The frame counters of the camera, may be NULL
+    //
+    explicit MotionStage( StreamMetrics *pMetrics );
+
+    virtual VmbErrorType Process( const FrameLeasePtr &pLease );
+
+    //
+    // Sets the grid, the thresholds and the hysteresis. The background
+    // starts over with the next frame.
+    //
+    // Parameters:
+    //  [in]    settings            The settings
+    //
+    void SetSettings( const MotionSettings &settings );
+    MotionSettings GetSettings() const;
+
+    //
+    // Lets motion gate the recording
+    //
+    // Parameters:
+    //  [in]    callback            Called on the stage thread when motion starts or stops
+    //
+    void EnableTrigger( const EventCallback &callback );
+
+    //
+    // Records regardless of motion again. No callback is running or
+    // made once this returns.
+    //
+    void DisableTrigger();
+
+    bool IsTriggerEnabled() const;
+
+    // Motion is going on
+    bool IsActive() const;
+
+    // The trigger is off, or motion is going on
+    bool IsRecordingAllowed() const;
+
+    //
+    // Takes the starts and stops since the last call
+    //
+    // Parameters:
+    //  [out]   rEvents             Oldest first, the oldest are dropped beyond MAX_PENDING_EVENTS
+    //
+    void TakeEvents( std::vector<MotionResult> &rEvents );
+
+    enum { MAX_PENDING_EVENTS = 64, };
+
+  private:
+    StreamMetrics *m_pMetrics;
+    MotionDetector m_Detector;
+    mutable std::mutex m_DetectorMutex;
+    std::atomic<bool> m_bActive;
+    std::atomic<bool> m_bTriggerEnabled;
+    // Held while the callback runs, so DisableTrigger waits for it
+    EventCallback m_Callback;
+    std::mutex m_CallbackMutex;
+    std::vector<MotionResult> m_Events;
+    std::mutex m_EventsMutex;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,410 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        HdrMerge.cpp
+
+  Description: Exposure bracketing: frames cycling through exposure times,
+               merged into radiance and tone mapped to 8 bit.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <HdrMerge.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_HDRMERGE_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+// The weight of the shortest exposure where all are black or clipped
+static const float SHORTEST_FLOOR_WEIGHT = 1.0f / 1024.0f;
+
+namespace {
+
+struct MergeConstants
+{
+    VmbUint32_t     nFrames;
+    // Takes samples to the longest exposure time
+    float           afGain[HDR_MAX_FRAMES];
+    // Longer exposures have less noise
+    float           afWeight[HDR_MAX_FRAMES];
+    float           afFloor[HDR_MAX_FRAMES];
+    float           fFullScale;
+    float           fScale;
+};
+
+inline VmbUchar_t ToneMap( float fRadiance, float fScale )
+{
+    const float fL = fRadiance * fScale;
+    return static_cast<VmbUchar_t>( fL / ( 1.0f + fL ) * 255.0f + 0.5f );
+}
+
+// The vector code computes the same per sample, only the sum differs in order
+template <typename T>
+void MergeRowScalar( const T * const *ppRows, const MergeConstants &rConstants, VmbUint32_t nFirst, VmbUint32_t nEnd, VmbUchar_t *pTarget, double &rdSum )
+{
+    for( VmbUint32_t i = nFirst; i < nEnd; ++i )
+    {
+        float fNumerator = 0.0f;
+        float fDenominator = 0.0f;
+        for( VmbUint32_t f = 0; f < rConstants.nFrames; ++f )
+        {
+            const float fValue = static_cast<float>( ppRows[f][i] );
+            const float fWeight = (std::min)( fValue, rConstants.fFullScale - fValue ) * rConstants.afWeight[f] + rConstants.afFloor[f];
+            fNumerator += fWeight * fValue * rConstants.afGain[f];
+            fDenominator += fWeight;
+        }
+        const float fRadiance = fNumerator / fDenominator;
+        rdSum += fRadiance;
+        pTarget[i] = ToneMap( fRadiance, rConstants.fScale );
+    }
+}
+
+#ifdef AVT_HDRMERGE_SSE2
+inline __m128 LoadSamples( const VmbUchar_t *pSamples )
+{
+    int nSamples;
+    memcpy( &nSamples, pSamples, sizeof( nSamples ) );
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( nSamples ), zero ), zero ) );
+}
+
+inline __m128 LoadSamples( const VmbUint16_t *pSamples )
+{
+    return _mm_cvtepi32_ps( _mm_unpacklo_epi16( _mm_loadl_epi64( reinterpret_cast<const __m128i*>( pSamples ) ), _mm_setzero_si128() ) );
+}
+#endif
+
+template <typename T>
+void MergeRow( const T * const *ppRows, const MergeConstants &rConstants, VmbUint32_t nSamples, VmbUchar_t *pTarget, double &rdSum )
+{
+    VmbUint32_t i = 0;
+#ifdef AVT_HDRMERGE_SSE2
+    __m128 gains[HDR_MAX_FRAMES];
+    __m128 weights[HDR_MAX_FRAMES];
+    __m128 floors[HDR_MAX_FRAMES];
+    for( VmbUint32_t f = 0; f < rConstants.nFrames; ++f )
+    {
+        gains[f] = _mm_set1_ps( rConstants.afGain[f] );
+        weights[f] = _mm_set1_ps( rConstants.afWeight[f] );
+        floors[f] = _mm_set1_ps( rConstants.afFloor[f] );
+    }
+    const __m128 fullScale = _mm_set1_ps( rConstants.fFullScale );
+    const __m128 scale = _mm_set1_ps( rConstants.fScale );
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 maxValue = _mm_set1_ps( 255.0f );
+    const __m128 half = _mm_set1_ps( 0.5f );
+    __m128 sum = _mm_setzero_ps();
+    for( ; i + 4 <= nSamples; i += 4 )
+    {
+        __m128 numerator = _mm_setzero_ps();
+        __m128 denominator = _mm_setzero_ps();
+        for( VmbUint32_t f = 0; f < rConstants.nFrames; ++f )
+        {
+            const __m128 value = LoadSamples( ppRows[f] + i );
+            const __m128 weight = _mm_add_ps( _mm_mul_ps( _mm_min_ps( value, _mm_sub_ps( fullScale, value ) ), weights[f] ), floors[f] );
+            numerator = _mm_add_ps( numerator, _mm_mul_ps( _mm_mul_ps( weight, value ), gains[f] ) );
+            denominator = _mm_add_ps( denominator, weight );
+        }
+        const __m128 radiance = _mm_div_ps( numerator, denominator );
+        sum = _mm_add_ps( sum, radiance );
+        const __m128 l = _mm_mul_ps( radiance, scale );
+        const __m128i mapped = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( _mm_div_ps( l, _mm_add_ps( one, l ) ), maxValue ), half ) );
+        const __m128i packed = _mm_packs_epi32( mapped, mapped );
+        const int nMapped = _mm_cvtsi128_si32( _mm_packus_epi16( packed, packed ) );
+        memcpy( pTarget + i, &nMapped, sizeof( nMapped ) );
+    }
+    float afSum[4];
+    _mm_storeu_ps( afSum, sum );
+    rdSum += static_cast<double>( afSum[0] ) + afSum[1] + afSum[2] + afSum[3];
+#endif
+    MergeRowScalar<T>( ppRows, rConstants, i, nSamples, pTarget, rdSum );
+}
+
+template <typename T>
+void MergeRows( const HdrExposure *pFrames, const MergeConstants &rConstants, VmbUint32_t nRowSamples,
+                VmbUint32_t nFirstRow, VmbUint32_t nEndRow, VmbUchar_t *pTarget, double &rdSum )
+{
+    const T *apRows[HDR_MAX_FRAMES];
+    for( VmbUint32_t y = nFirstRow; y < nEndRow; ++y )
+    {
+        for( VmbUint32_t f = 0; f < rConstants.nFrames; ++f )
+        {
+            apRows[f] = reinterpret_cast<const T*>( pFrames[f].view.pBuffer + static_cast<size_t>( y ) * pFrames[f].view.nStride );
+        }
+        MergeRow<T>( apRows, rConstants, nRowSamples, pTarget + static_cast<size_t>( y ) * nRowSamples, rdSum );
+    }
+}
+
+} // namespace
+
+HdrSettings::HdrSettings()
+    : nFrames( 3 )
+    , dStep( 4.0 )
+    , nWriteLatency( 2 )
+    , dKey( 1.0 )
+{
+}
+
+ExposureBracketer::ExposureBracketer()
+    : m_nWriteLatency( 1 )
+    , m_nLastFrameID( 0 )
+    , m_bHasFrame( false )
+{
+    std::fill( m_Scheduled, m_Scheduled + SCHEDULE_LENGTH, 0 );
+    std::fill( m_ScheduledUs, m_ScheduledUs + SCHEDULE_LENGTH, 0.0 );
+    std::fill( m_bScheduled, m_bScheduled + SCHEDULE_LENGTH, false );
+    std::fill( m_bConfirmed, m_bConfirmed + SCHEDULE_LENGTH, false );
+}
+
+//
+// Starts over
+//
+// Parameters:
+//  [in]    rExposuresUs    The exposure times of a bracket, 1 to HDR_MAX_FRAMES
+//  [in]    nWriteLatency   Frames from a write to the first frame taken with it
+//
+// Returns:
+//  VmbErrorBadParameter for too many or too few exposure times
+//
+VmbErrorType ExposureBracketer::Reset( const std::vector<double> &rExposuresUs, VmbUint32_t nWriteLatency )
+{
+    if(     rExposuresUs.empty()
+        ||  rExposuresUs.size() > HDR_MAX_FRAMES
+        ||  0 == nWriteLatency
+        ||  nWriteLatency >= SCHEDULE_LENGTH
+        ||  *std::min_element( rExposuresUs.begin(), rExposuresUs.end() ) <= 0.0 )
+    {
+        return VmbErrorBadParameter;
+    }
+    m_ExposuresUs = rExposuresUs;
+    m_nWriteLatency = nWriteLatency;
+    std::fill( m_bScheduled, m_bScheduled + SCHEDULE_LENGTH, false );
+    std::fill( m_bConfirmed, m_bConfirmed + SCHEDULE_LENGTH, false );
+    m_bHasFrame = false;
+    return VmbErrorSuccess;
+}
+
+//
+// Looks at a received frame
+//
+// Parameters:
+//  [in]    nFrameID        The ID of the frame
+//  [out]   rdNextUs        The exposure time to write now
+//  [out]   rSlot           Where the frame belongs
+//
+// Returns:
+//  true if the frame was taken with the exposure time of its slot,
+//  false if the write for it was missed or not confirmed in time
+//
+bool ExposureBracketer::OnFrame( VmbUint64_t nFrameID, double &rdNextUs, HdrSlot &rSlot )
+{
+    const VmbUint32_t nFrames = static_cast<VmbUint32_t>( m_ExposuresUs.size() );
+    if( 0 == nFrames )
+    {
+        return false;
+    }
+    const size_t nEntry = static_cast<size_t>( nFrameID % SCHEDULE_LENGTH );
+    const bool bTaken = m_bScheduled[nEntry] && m_bConfirmed[nEntry] && nFrameID == m_Scheduled[nEntry];
+    m_nLastFrameID = nFrameID;
+    m_bHasFrame = true;
+
+    const VmbUint64_t nNextID = nFrameID + m_nWriteLatency;
+    const size_t nNextEntry = static_cast<size_t>( nNextID % SCHEDULE_LENGTH );
+    rdNextUs = m_ExposuresUs[static_cast<size_t>( nNextID % nFrames )];
+    m_Scheduled[nNextEntry] = nNextID;
+    m_ScheduledUs[nNextEntry] = rdNextUs;
+    m_bScheduled[nNextEntry] = true;
+    m_bConfirmed[nNextEntry] = false;
+
+    rSlot.nBracket = nFrameID / nFrames;
+    rSlot.nIndex = static_cast<VmbUint32_t>( nFrameID % nFrames );
+    rSlot.nFrames = nFrames;
+    rSlot.dExposureUs = m_ExposuresUs[rSlot.nIndex];
+    return bTaken;
+}
+
+//
+// Confirms that an exposure time was written to the camera. It counts
+// for the newest frame still to come that is scheduled with it.
+//
+// Parameters:
+//  [in]    dExposureUs     The exposure time written
+//
+// Returns:
+//  true if a frame to come was scheduled with it
+//
+bool ExposureBracketer::OnWritten( double dExposureUs )
+{
+    if( !m_bHasFrame )
+    {
+        return false;
+    }
+    // Only frames still to come can be taken with it. The newest one
+    // scheduled with the value is the one the write was queued for.
+    for( VmbUint64_t nID = m_nLastFrameID + m_nWriteLatency; nID > m_nLastFrameID; --nID )
+    {
+        const size_t nEntry = static_cast<size_t>( nID % SCHEDULE_LENGTH );
+        if(     m_bScheduled[nEntry]
+            &&  nID == m_Scheduled[nEntry]
+            &&  dExposureUs == m_ScheduledUs[nEntry] )
+        {
+            m_bConfirmed[nEntry] = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Gets the format merged frames are tone mapped to
+//
+// Parameters:
+//  [in]    ePixelFormat    The format of the frames
+//
+// Returns:
+//  Mono8 for deeper mono, else the format itself
+//
+VmbPixelFormatType GetHdrPixelFormat( VmbPixelFormatType ePixelFormat )
+{
+    return 2 == GetBytesPerPixel( ePixelFormat ) ? VmbPixelFormatMono8 : ePixelFormat;
+}
+
+//
+// Merges the frames of a bracket into radiance and tone maps it. Every
+// sample is weighted by how far it is from black and full scale and by
+// its exposure time, so the longer exposures decide the shadows and the
+// shorter ones the highlights.
+//
+// Parameters:
+//  [in]    pFrames         The frames, of one size and format
+//  [in]    nFrames         The number of frames, 1 to HDR_MAX_FRAMES
+//  [in]    fScale          Radiance times this is L, mapped to L / ( 1 + L )
+//  [in]    pPool           The pool to spread the merge over, may be NULL
+//  [out]   pTarget         The merged image, rows without padding
+//  [out]   rMerged         The view of pTarget
+//  [out]   rfMeanRadiance  The mean radiance in samples of the longest exposure
+//
+// Returns:
+//  VmbErrorBadParameter if the frames do not match,
+//  VmbErrorWrongType for packed formats
+//
+VmbErrorType MergeExposures(    const HdrExposure *pFrames, VmbUint32_t nFrames, float fScale, ThreadPool *pPool,
+                                VmbUchar_t *pTarget, ImageView &rMerged, float &rfMeanRadiance )
+{
+    if(     NULL == pFrames
+        ||  0 == nFrames
+        ||  nFrames > HDR_MAX_FRAMES
+        ||  NULL == pTarget )
+    {
+        return VmbErrorBadParameter;
+    }
+    const ImageView &rFirst = pFrames[0].view;
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rFirst.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+    VmbUint32_t nLongest = 0;
+    VmbUint32_t nShortest = 0;
+    for( VmbUint32_t f = 0; f < nFrames; ++f )
+    {
+        const ImageView &rView = pFrames[f].view;
+        if(     NULL == rView.pBuffer
+            ||  rView.nWidth != rFirst.nWidth
+            ||  rView.nHeight != rFirst.nHeight
+            ||  rView.ePixelFormat != rFirst.ePixelFormat
+            ||  pFrames[f].dExposureUs <= 0.0 )
+        {
+            return VmbErrorBadParameter;
+        }
+        if( pFrames[f].dExposureUs > pFrames[nLongest].dExposureUs )
+        {
+            nLongest = f;
+        }
+        if( pFrames[f].dExposureUs < pFrames[nShortest].dExposureUs )
+        {
+            nShortest = f;
+        }
+    }
+
+    MergeConstants constants;
+    constants.nFrames = nFrames;
+    for( VmbUint32_t f = 0; f < nFrames; ++f )
+    {
+        const double dRatio = pFrames[f].dExposureUs / pFrames[nLongest].dExposureUs;
+        constants.afGain[f] = static_cast<float>( 1.0 / dRatio );
+        constants.afWeight[f] = static_cast<float>( dRatio );
+        constants.afFloor[f] = f == nShortest ? SHORTEST_FLOOR_WEIGHT : 0.0f;
+    }
+    constants.fFullScale = static_cast<float>( ( 1u << GetBitDepth( rFirst.ePixelFormat ) ) - 1 );
+    constants.fScale = fScale;
+
+    const bool bIs16Bit = 2 == nBytesPerPixel;
+    const VmbUint32_t nRowSamples = rFirst.nWidth * ( 3 == nBytesPerPixel ? 3 : 1 );
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, rFirst.nHeight / MIN_STRIPE_ROWS ) );
+    std::vector<double> sums( nStripes, 0.0 );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nFirstRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rFirst.nHeight ) * nStripe / nStripes );
+        const VmbUint32_t nEndRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rFirst.nHeight ) * ( nStripe + 1 ) / nStripes );
+        if( bIs16Bit )
+        {
+            MergeRows<VmbUint16_t>( pFrames, constants, nRowSamples, nFirstRow, nEndRow, pTarget, sums[nStripe] );
+        }
+        else
+        {
+            MergeRows<VmbUchar_t>( pFrames, constants, nRowSamples, nFirstRow, nEndRow, pTarget, sums[nStripe] );
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+
+    double dSum = 0.0;
+    for( size_t i = 0; i < sums.size(); ++i )
+    {
+        dSum += sums[i];
+    }
+    const double dSamples = static_cast<double>( nRowSamples ) * rFirst.nHeight;
+    rfMeanRadiance = dSamples > 0.0 ? static_cast<float>( dSum / dSamples ) : 0.0f;
+    rMerged.pBuffer = pTarget;
+    rMerged.nWidth = rFirst.nWidth;
+    rMerged.nHeight = rFirst.nHeight;
+    rMerged.nStride = nRowSamples;
+    rMerged.ePixelFormat = GetHdrPixelFormat( rFirst.ePixelFormat );
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,181 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        HdrMerge.h
+
+  Description: Exposure bracketing: frames cycling through exposure times,
+               merged into radiance and tone mapped to 8 bit.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_HDRMERGE
+#define AVT_VMBAPI_EXAMPLES_HDRMERGE
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The most frames a bracket may have
+enum { HDR_MAX_FRAMES = 4, };
+
+struct HdrSettings
+{
+    // The exposure times of a bracket in the order they are taken, empty
+    // to bracket around the current exposure time
+    std::vector<double> exposuresUs;
+    // The frames of a bracket around the current exposure time
+    VmbUint32_t     nFrames;
+    // The factor from one of them to the next
+    double          dStep;
+    // Frames from the one an exposure time is written on to the first
+    // one taken with it, the camera has the next ones in flight
+    VmbUint32_t     nWriteLatency;
+    // The mean radiance is tone mapped to key / ( 1 + key ) of full scale
+    double          dKey;
+
+    HdrSettings();
+};
+
+// Where a frame belongs in the brackets
+struct HdrSlot
+{
+    VmbUint64_t     nBracket;
+    VmbUint32_t     nIndex;
+    VmbUint32_t     nFrames;
+    double          dExposureUs;
+    // The corrected frame, later stages may replace the image of the
+    // lease, which keeps this one until it ends
+    ImageView       view;
+};
+
+//
+// Cycles the exposure time over consecutive frames. Frame n is taken with
+// the exposure time n modulo the bracket size, it is written nWriteLatency
+// frames ahead, when frame n - nWriteLatency arrives. A frame only counts
+// as taken with it once the write was confirmed before the frame arrived.
+//
+class ExposureBracketer
+{
+  public:
+    ExposureBracketer();
+
+    //
+    // Starts over
+    //
+    // Parameters:
+    //  [in]    rExposuresUs    The exposure times of a bracket, 1 to HDR_MAX_FRAMES
+    //  [in]    nWriteLatency   Frames from a write to the first frame taken with it
+    //
+    // Returns:
+    //  VmbErrorBadParameter for too many or too few exposure times
+    //
+    VmbErrorType    Reset( const std::vector<double> &rExposuresUs, VmbUint32_t nWriteLatency );
+
+    //
+    // Looks at a received frame
+    //
+    // Parameters:
+    //  [in]    nFrameID        The ID of the frame
+    //  [out]   rdNextUs        The exposure time to write now
+    //  [out]   rSlot           Where the frame belongs
+    //
+    // Returns:
+    //  true if the frame was taken with the exposure time of its slot,
+    //  false if the write for it was missed or not confirmed in time
+    //
+    bool            OnFrame( VmbUint64_t nFrameID, double &rdNextUs, HdrSlot &rSlot );
+
+    //
+    // Confirms that an exposure time was written to the camera. It counts
+    // for the newest frame still to come that is scheduled with it.
+    //
+    // Parameters:
+    //  [in]    dExposureUs     The exposure time written
+    //
+    // Returns:
+    //  true if a frame to come was scheduled with it
+    //
+    bool            OnWritten( double dExposureUs );
+
+  private:
+    // Frames whose exposure time was written, by ID modulo the length
+    enum { SCHEDULE_LENGTH = 64, };
+
+    std::vector<double>     m_ExposuresUs;
+    VmbUint32_t             m_nWriteLatency;
+    VmbUint64_t             m_Scheduled[SCHEDULE_LENGTH];
+    double                  m_ScheduledUs[SCHEDULE_LENGTH];
+    bool                    m_bScheduled[SCHEDULE_LENGTH];
+    bool                    m_bConfirmed[SCHEDULE_LENGTH];
+    // The frame seen last, later ones are still to come
+    VmbUint64_t             m_nLastFrameID;
+    bool                    m_bHasFrame;
+};
+
+// A frame of a bracket
+struct HdrExposure
+{
+    ImageView       view;
+    double          dExposureUs;
+};
+
+//
+// Gets the format merged frames are tone mapped to
+//
+// Parameters:
+//  [in]    ePixelFormat    The format of the frames
+//
+// Returns:
+//  Mono8 for deeper mono, else the format itself
+//
+VmbPixelFormatType  GetHdrPixelFormat( VmbPixelFormatType ePixelFormat );
+
+//
+// Merges the frames of a bracket into radiance and tone maps it. Every
+// sample is weighted by how far it is from black and full scale and by
+// its exposure time, so the longer exposures decide the shadows and the
+// shorter ones the highlights.
+//
+// Parameters:
+//  [in]    pFrames         The frames, of one size and format
+//  [in]    nFrames         The number of frames, 1 to HDR_MAX_FRAMES
+//  [in]    fScale          Radiance times this is L, mapped to L / ( 1 + L )
+//  [in]    pPool           The pool to spread the merge over, may be NULL
+//  [out]   pTarget         The merged image, rows without padding
+//  [out]   rMerged         The view of pTarget
+//  [out]   rfMeanRadiance  The mean radiance in samples of the longest exposure
+//
+// Returns:
+//  VmbErrorBadParameter if the frames do not match,
+//  VmbErrorWrongType for packed formats
+//
+VmbErrorType        MergeExposures( const HdrExposure *pFrames, VmbUint32_t nFrames, float fScale, ThreadPool *pPool,
+                                    VmbUchar_t *pTarget, ImageView &rMerged, float &rfMeanRadiance );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,114 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageBufferPool.cpp
+
+  Description: Recycles the image buffers of pipeline stages that replace
+               the image of a frame lease.
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <ImageBufferPool.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Parameters:
+//  [in]    nMaxFree        The number of returned buffers kept for reuse
+//
+ImageBufferPool::ImageBufferPool( size_t nMaxFree )
+    : m_pFreeList( new FreeList() )
+{
+    m_pFreeList->nMaxFree = nMaxFree;
+}
+
+//
+// Gets a buffer, a returned one if there is one of the size
+//
+// Parameters:
+//  [in]    nSize           The size in bytes
+//
+// Returns:
+//  The buffer
+//
+std::shared_ptr<VmbUchar_t> ImageBufferPool::Acquire( size_t nSize )
+{
+    std::vector<VmbUchar_t> *pBuffer = NULL;
+    {
+        std::lock_guard<std::mutex> lock( m_pFreeList->Mutex );
+        std::vector< std::vector<VmbUchar_t>* > &rBuffers = m_pFreeList->Buffers;
+        while( NULL == pBuffer && !rBuffers.empty() )
+        {
+            pBuffer = rBuffers.back();
+            rBuffers.pop_back();
+            // Buffers of an earlier frame size are of no use any more
+            if( pBuffer->size() != nSize )
+            {
+                delete pBuffer;
+                pBuffer = NULL;
+            }
+        }
+    }
+    if( NULL == pBuffer )
+    {
+        pBuffer = new std::vector<VmbUchar_t>( nSize );
+    }
+    const std::weak_ptr<FreeList> pFreeList( m_pFreeList );
+    return std::shared_ptr<VmbUchar_t>( pBuffer->data(), [pFreeList, pBuffer]( VmbUchar_t* ) { Release( pFreeList, pBuffer ); } );
+}
+
+ImageBufferPool::FreeList::~FreeList()
+{
+    for( size_t i = 0; i < Buffers.size(); ++i )
+    {
+        delete Buffers[i];
+    }
+}
+
+// Frees the buffers kept for reuse
+void ImageBufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock( m_pFreeList->Mutex );
+    for( size_t i = 0; i < m_pFreeList->Buffers.size(); ++i )
+    {
+        delete m_pFreeList->Buffers[i];
+    }
+    m_pFreeList->Buffers.clear();
+}
+
+// Puts a buffer back or frees it
+void ImageBufferPool::Release( const std::weak_ptr<FreeList> &rpFreeList, std::vector<VmbUchar_t> *pBuffer )
+{
+    const std::shared_ptr<FreeList> pFreeList = rpFreeList.lock();
+    if( NULL != pFreeList )
+    {
+        std::lock_guard<std::mutex> lock( pFreeList->Mutex );
+        if( pFreeList->Buffers.size() < pFreeList->nMaxFree )
+        {
+            pFreeList->Buffers.push_back( pBuffer );
+            return;
+        }
+    }
+    delete pBuffer;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,87 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageBufferPool.h
+
+  Description: Recycles the image buffers of pipeline stages that replace
+               the image of a frame lease.
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_IMAGEBUFFERPOOL
+#define AVT_VMBAPI_EXAMPLES_IMAGEBUFFERPOOL
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Hands out image buffers that go back to the pool when the last
+// reference ends, e.g. with the lease the buffer was set on. Buffers
+// outliving the pool are freed instead.
+//
+class ImageBufferPool
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nMaxFree        The number of returned buffers kept for reuse
+    //
+    explicit ImageBufferPool( size_t nMaxFree );
+
+    //
+    // Gets a buffer, a returned one if there is one of the size
+    //
+    // Parameters:
+    //  [in]    nSize           The size in bytes
+    //
+    // Returns:
+    //  The buffer
+    //
+    std::shared_ptr<VmbUchar_t> Acquire( size_t nSize );
+
+    // Frees the buffers kept for reuse
+    void Trim();
+
+  private:
+    // Shared with the buffers handed out, which may outlive the pool
+    struct FreeList
+    {
+        std::mutex                                  Mutex;
+        std::vector< std::vector<VmbUchar_t>* >     Buffers;
+        size_t                                      nMaxFree;
+
+        ~FreeList();
+    };
+
+    // Puts a buffer back or frees it
+    static void Release( const std::weak_ptr<FreeList> &rpFreeList, std::vector<VmbUchar_t> *pBuffer );
+
+    std::shared_ptr<FreeList> m_pFreeList;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,313 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageStats.cpp
+
+  Description: Exposure statistics of an image: histogram, mean, minimum,
+               maximum and clipped pixels per channel.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+#include <ImageStats.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_IMAGESTATS_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+// 8 bit histograms are counted into this many interleaved copies, so
+// neighbouring equal pixels do not wait for each other's increment
+enum { SUB_HISTOGRAMS = 4, };
+
+namespace {
+
+struct StripeAccumulator
+{
+    std::vector<VmbUint32_t>    histogram;
+    // Only kept for formats wider than the histogram
+    VmbUint64_t                 nSum;
+    VmbUint32_t                 nMin;
+    VmbUint32_t                 nMax;
+    VmbUint64_t                 nClippedLow;
+    VmbUint64_t                 nClippedHigh;
+};
+
+// Full rows of 8 bit mono, 16 pixels per load
+void AccumulateRow8( const VmbUchar_t *pRow, VmbUint32_t nWidth, VmbUint32_t *pHistograms )
+{
+    VmbUint32_t *pH0 = pHistograms;
+    VmbUint32_t *pH1 = pHistograms + 256;
+    VmbUint32_t *pH2 = pHistograms + 512;
+    VmbUint32_t *pH3 = pHistograms + 768;
+    VmbUint32_t x = 0;
+    for( ; x + 16 <= nWidth; x += 16 )
+    {
+        VmbUint32_t words[4];
+#ifdef AVT_IMAGESTATS_SSE2
+        const __m128i pixels = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRow + x ) );
+        words[0] = static_cast<VmbUint32_t>( _mm_cvtsi128_si32( pixels ) );
+        words[1] = static_cast<VmbUint32_t>( _mm_cvtsi128_si32( _mm_srli_si128( pixels, 4 ) ) );
+        words[2] = static_cast<VmbUint32_t>( _mm_cvtsi128_si32( _mm_srli_si128( pixels, 8 ) ) );
+        words[3] = static_cast<VmbUint32_t>( _mm_cvtsi128_si32( _mm_srli_si128( pixels, 12 ) ) );
+#else
+        memcpy( words, pRow + x, sizeof( words ) );
+#endif
+        for( int i = 0; i < 4; ++i )
+        {
+            const VmbUint32_t nWord = words[i];
+            ++pH0[nWord & 0xFF];
+            ++pH1[( nWord >> 8 ) & 0xFF];
+            ++pH2[( nWord >> 16 ) & 0xFF];
+            ++pH3[nWord >> 24];
+        }
+    }
+    for( ; x < nWidth; ++x )
+    {
+        ++pH0[pRow[x]];
+    }
+}
+
+void AccumulateStripe(  const ImageView &rView,
+                        VmbUint32_t nBitDepth,
+                        VmbUint32_t nSubsampling,
+                        VmbUint32_t nFirstRow,
+                        VmbUint32_t nEndRow,
+                        StripeAccumulator &rAccumulator )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    VmbUint32_t *pHistogram = &rAccumulator.histogram[0];
+    for( VmbUint32_t nRow = nFirstRow; nRow < nEndRow; ++nRow )
+    {
+        const VmbUchar_t *pRow = rView.pBuffer + static_cast<size_t>( nRow ) * nSubsampling * rView.nStride;
+        if( 1 == nBytesPerPixel )
+        {
+            if( 1 == nSubsampling )
+            {
+                AccumulateRow8( pRow, rView.nWidth, pHistogram );
+            }
+            else
+            {
+                for( VmbUint32_t x = 0; x < rView.nWidth; x += nSubsampling )
+                {
+                    ++pHistogram[pRow[x]];
+                }
+            }
+        }
+        else if( 3 == nBytesPerPixel )
+        {
+            // The histogram keeps R, G, B, Bgr8 has them the other way round
+            const bool bIsBgr = VmbPixelFormatBgr8 == rView.ePixelFormat;
+            VmbUint32_t *pRed   = pHistogram + ( bIsBgr ? 512 : 0 );
+            VmbUint32_t *pGreen = pHistogram + 256;
+            VmbUint32_t *pBlue  = pHistogram + ( bIsBgr ? 0 : 512 );
+            const size_t nStep = static_cast<size_t>( nSubsampling ) * 3;
+            const VmbUchar_t *pEnd = pRow + static_cast<size_t>( rView.nWidth ) * 3;
+            for( const VmbUchar_t *pPixel = pRow; pPixel < pEnd; pPixel += nStep )
+            {
+                ++pRed[pPixel[0]];
+                ++pGreen[pPixel[1]];
+                ++pBlue[pPixel[2]];
+            }
+        }
+        else
+        {
+            const VmbUint16_t *pPixels = reinterpret_cast<const VmbUint16_t*>( pRow );
+            const VmbUint32_t nFullScale = ( 1u << nBitDepth ) - 1;
+            if( nBitDepth <= 12 )
+            {
+                // Every value has a bin of its own
+                const VmbUint32_t nShift = 12 - nBitDepth;
+                for( VmbUint32_t x = 0; x < rView.nWidth; x += nSubsampling )
+                {
+                    ++pHistogram[(std::min)( static_cast<VmbUint32_t>( pPixels[x] ), nFullScale ) << nShift];
+                }
+            }
+            else
+            {
+                const VmbUint32_t nShift = nBitDepth - 12;
+                VmbUint64_t nSum = 0;
+                VmbUint32_t nMin = rAccumulator.nMin;
+                VmbUint32_t nMax = rAccumulator.nMax;
+                for( VmbUint32_t x = 0; x < rView.nWidth; x += nSubsampling )
+                {
+                    const VmbUint32_t nValue = (std::min)( static_cast<VmbUint32_t>( pPixels[x] ), nFullScale );
+                    ++pHistogram[nValue >> nShift];
+                    nSum += nValue;
+                    nMin = (std::min)( nMin, nValue );
+                    nMax = (std::max)( nMax, nValue );
+                    rAccumulator.nClippedLow += 0 == nValue;
+                    rAccumulator.nClippedHigh += nFullScale == nValue;
+                }
+                rAccumulator.nSum += nSum;
+                rAccumulator.nMin = nMin;
+                rAccumulator.nMax = nMax;
+            }
+        }
+    }
+}
+
+}
+
+//
+// Computes the statistics of an image. The rows are split into stripes
+// that run on the pool.
+//
+// Parameters:
+//  [in]    rView           The image
+//  [in]    nSubsampling    Looks at every nth pixel of every nth row, 1 for all
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   rStatistics     The statistics
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support
+//
+VmbErrorType ComputeImageStatistics( const ImageView &rView, VmbUint32_t nSubsampling, ThreadPool *pPool, ImageStatistics &rStatistics )
+{
+    if(     NULL == rView.pBuffer
+        ||  0 == rView.nWidth
+        ||  0 == rView.nHeight
+        ||  0 == nSubsampling )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nBitDepth = GetBitDepth( rView.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+
+    rStatistics.nChannels       = 3 == nBytesPerPixel ? 3 : 1;
+    rStatistics.nBitDepth       = nBitDepth;
+    rStatistics.nBins           = 8 == nBitDepth ? 256 : 4096;
+    rStatistics.nSubsampling    = nSubsampling;
+    const VmbUint32_t nRows     = ( rView.nHeight + nSubsampling - 1 ) / nSubsampling;
+    const VmbUint32_t nColumns  = ( rView.nWidth + nSubsampling - 1 ) / nSubsampling;
+    rStatistics.nPixels         = static_cast<VmbUint64_t>( nRows ) * nColumns;
+
+    // Full 8 bit mono rows count into interleaved copies of the histogram
+    const VmbUint32_t nCopies = ( 1 == nBytesPerPixel && 1 == nSubsampling ) ? static_cast<VmbUint32_t>( SUB_HISTOGRAMS ) : rStatistics.nChannels;
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, nRows / MIN_STRIPE_ROWS ) );
+    std::vector<StripeAccumulator> accumulators( nStripes );
+    for( VmbUint32_t i = 0; i < nStripes; ++i )
+    {
+        accumulators[i].histogram.assign( static_cast<size_t>( nCopies ) * rStatistics.nBins, 0 );
+        accumulators[i].nSum = 0;
+        accumulators[i].nMin = 0xFFFFFFFF;
+        accumulators[i].nMax = 0;
+        accumulators[i].nClippedLow = 0;
+        accumulators[i].nClippedHigh = 0;
+    }
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        AccumulateStripe(   rView, nBitDepth, nSubsampling,
+                            nRows * nStripe / nStripes, nRows * ( nStripe + 1 ) / nStripes,
+                            accumulators[nStripe] );
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+
+    // Fold the stripes and the interleaved copies into one histogram per channel
+    const size_t nBins = rStatistics.nBins;
+    rStatistics.histogram.assign( rStatistics.nChannels * nBins, 0 );
+    for( VmbUint32_t i = 0; i < nStripes; ++i )
+    {
+        const VmbUint32_t *pSource = &accumulators[i].histogram[0];
+        for( VmbUint32_t nCopy = 0; nCopy < nCopies; ++nCopy )
+        {
+            VmbUint32_t *pTarget = &rStatistics.histogram[( nCopy % rStatistics.nChannels ) * nBins];
+            for( size_t nBin = 0; nBin < nBins; ++nBin )
+            {
+                pTarget[nBin] += pSource[nCopy * nBins + nBin];
+            }
+        }
+    }
+
+    for( VmbUint32_t c = 0; c < MAX_STATISTICS_CHANNELS; ++c )
+    {
+        rStatistics.dMean[c]        = 0.0;
+        rStatistics.nMin[c]         = 0;
+        rStatistics.nMax[c]         = 0;
+        rStatistics.nClippedLow[c]  = 0;
+        rStatistics.nClippedHigh[c] = 0;
+    }
+    if( nBitDepth > 12 )
+    {
+        // The bins are wider than a value, the stripes kept the exact numbers
+        VmbUint64_t nSum = 0;
+        rStatistics.nMin[0] = 0xFFFFFFFF;
+        for( VmbUint32_t i = 0; i < nStripes; ++i )
+        {
+            nSum += accumulators[i].nSum;
+            rStatistics.nMin[0] = (std::min)( rStatistics.nMin[0], accumulators[i].nMin );
+            rStatistics.nMax[0] = (std::max)( rStatistics.nMax[0], accumulators[i].nMax );
+            rStatistics.nClippedLow[0] += accumulators[i].nClippedLow;
+            rStatistics.nClippedHigh[0] += accumulators[i].nClippedHigh;
+        }
+        rStatistics.dMean[0] = static_cast<double>( nSum ) / rStatistics.nPixels;
+        return VmbErrorSuccess;
+    }
+
+    // Every bin is one value, everything else follows from the histogram
+    const VmbUint32_t nShift = ( 8 == nBitDepth ? 8 : 12 ) - nBitDepth;
+    const VmbUint32_t nFullScale = ( 1u << nBitDepth ) - 1;
+    for( VmbUint32_t c = 0; c < rStatistics.nChannels; ++c )
+    {
+        const VmbUint32_t *pHistogram = &rStatistics.histogram[c * nBins];
+        VmbUint64_t nSum = 0;
+        bool bFirst = true;
+        for( size_t nBin = 0; nBin < nBins; ++nBin )
+        {
+            if( 0 == pHistogram[nBin] )
+            {
+                continue;
+            }
+            const VmbUint32_t nValue = static_cast<VmbUint32_t>( nBin >> nShift );
+            nSum += static_cast<VmbUint64_t>( nValue ) * pHistogram[nBin];
+            if( bFirst )
+            {
+                rStatistics.nMin[c] = nValue;
+                bFirst = false;
+            }
+            rStatistics.nMax[c] = nValue;
+        }
+        rStatistics.dMean[c]        = static_cast<double>( nSum ) / rStatistics.nPixels;
+        rStatistics.nClippedLow[c]  = pHistogram[0];
+        rStatistics.nClippedHigh[c] = pHistogram[nFullScale << nShift];
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
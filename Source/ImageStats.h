@@ -0,0 +1,84 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageStats.h
+
+  Description: Exposure statistics of an image: histogram, mean, minimum,
+               maximum and clipped pixels per channel.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_IMAGESTATS
+#define AVT_VMBAPI_EXAMPLES_IMAGESTATS
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Color images have their channels in R, G, B order
+enum { MAX_STATISTICS_CHANNELS = 3, };
+
+struct ImageStatistics
+{
+    VmbUint64_t                 nFrameID;
+    VmbUint32_t                 nChannels;
+    VmbUint32_t                 nBitDepth;
+    // 256 for 8 bit images, 4096 for wider ones
+    VmbUint32_t                 nBins;
+    // Every nth pixel of every nth row was looked at
+    VmbUint32_t                 nSubsampling;
+    // Pixels looked at, per channel
+    VmbUint64_t                 nPixels;
+    // nBins counts per channel, one channel after the other
+    std::vector<VmbUint32_t>    histogram;
+    // In pixel values of the bit depth
+    double                      dMean[MAX_STATISTICS_CHANNELS];
+    VmbUint32_t                 nMin[MAX_STATISTICS_CHANNELS];
+    VmbUint32_t                 nMax[MAX_STATISTICS_CHANNELS];
+    // Pixels at 0 and at full scale
+    VmbUint64_t                 nClippedLow[MAX_STATISTICS_CHANNELS];
+    VmbUint64_t                 nClippedHigh[MAX_STATISTICS_CHANNELS];
+};
+
+//
+// Computes the statistics of an image. The rows are split into stripes
+// that run on the pool.
+//
+// Parameters:
+//  [in]    rView           The image
+//  [in]    nSubsampling    Looks at every nth pixel of every nth row, 1 for all
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   rStatistics     The statistics
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support
+//
+VmbErrorType ComputeImageStatistics( const ImageView &rView, VmbUint32_t nSubsampling, ThreadPool *pPool, ImageStatistics &rStatistics );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,160 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageView.cpp
+
+  Description: Describes an image or a rectangle of it in a buffer owned by
+               someone else, so a region can be processed without copying it.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <ImageView.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Gets the size of a pixel of the formats the views support: 8 bit mono,
+// raw Bayer and color, and unpacked mono up to 16 bit
+//
+// Parameters:
+//  [in]    ePixelFormat    The pixel format
+//
+// Returns:
+//  The bytes per pixel, 0 for packed formats
+//
+VmbUint32_t GetBytesPerPixel( VmbPixelFormatType ePixelFormat )
+{
+    switch( ePixelFormat )
+    {
+    case VmbPixelFormatMono8:
+    case VmbPixelFormatBayerGR8:
+    case VmbPixelFormatBayerRG8:
+    case VmbPixelFormatBayerGB8:
+    case VmbPixelFormatBayerBG8:
+        return 1;
+    case VmbPixelFormatMono10:
+    case VmbPixelFormatMono12:
+    case VmbPixelFormatMono14:
+    case VmbPixelFormatMono16:
+        return 2;
+    case VmbPixelFormatRgb8:
+    case VmbPixelFormatBgr8:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+//
+// Gets the significant bits of a channel of the formats the views support
+//
+// Parameters:
+//  [in]    ePixelFormat    The pixel format
+//
+// Returns:
+//  The bits per channel, 0 for packed formats
+//
+VmbUint32_t GetBitDepth( VmbPixelFormatType ePixelFormat )
+{
+    switch( ePixelFormat )
+    {
+    case VmbPixelFormatMono10:
+        return 10;
+    case VmbPixelFormatMono12:
+        return 12;
+    case VmbPixelFormatMono14:
+        return 14;
+    case VmbPixelFormatMono16:
+        return 16;
+    default:
+        return 0 == GetBytesPerPixel( ePixelFormat ) ? 0 : 8;
+    }
+}
+
+//
+// Describes a whole image
+//
+// Parameters:
+//  [in]    pBuffer         The image
+//  [in]    nWidth          The width of the image
+//  [in]    nHeight         The height of the image
+//  [in]    ePixelFormat    The pixel format of the image
+//  [out]   rView           The view of the image
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats GetBytesPerPixel does not know
+//
+VmbErrorType MakeImageView( const VmbUchar_t *pBuffer, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, ImageView &rView )
+{
+    if( NULL == pBuffer )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+    rView.pBuffer       = pBuffer;
+    rView.nWidth        = nWidth;
+    rView.nHeight       = nHeight;
+    rView.nStride       = nWidth * nBytesPerPixel;
+    rView.ePixelFormat  = ePixelFormat;
+    return VmbErrorSuccess;
+}
+
+//
+// Describes a rectangle of a view without copying a pixel. The rectangle
+// is clipped to the view.
+//
+// Parameters:
+//  [in]    rView           The view to crop
+//  [in]    nLeft           The first column of the rectangle
+//  [in]    nTop            The first row of the rectangle
+//  [in]    nWidth          The width of the rectangle
+//  [in]    nHeight         The height of the rectangle
+//  [out]   rRegion         The view of the rectangle
+//
+// Returns:
+//  VmbErrorBadParameter if the rectangle lies outside the view
+//
+VmbErrorType CropImageView( const ImageView &rView, VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight, ImageView &rRegion )
+{
+    if(     nLeft >= rView.nWidth
+        ||  nTop >= rView.nHeight
+        ||  0 == nWidth
+        ||  0 == nHeight )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    rRegion.pBuffer         = rView.pBuffer + static_cast<size_t>( nTop ) * rView.nStride + nLeft * nBytesPerPixel;
+    rRegion.nWidth          = (std::min)( nWidth, rView.nWidth - nLeft );
+    rRegion.nHeight         = (std::min)( nHeight, rView.nHeight - nTop );
+    rRegion.nStride         = rView.nStride;
+    rRegion.ePixelFormat    = rView.ePixelFormat;
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,110 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ImageView.h
+
+  Description: Describes an image or a rectangle of it in a buffer owned by
+               someone else, so a region can be processed without copying it.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_IMAGEVIEW
+#define AVT_VMBAPI_EXAMPLES_IMAGEVIEW
+
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A view of pixels in a buffer it does not own. The view is only valid
+// as long as the buffer is, for frames until they are requeued.
+//
+struct ImageView
+{
+    // The first pixel of the first row
+    const VmbUchar_t       *pBuffer;
+    VmbUint32_t             nWidth;
+    VmbUint32_t             nHeight;
+    // Bytes from one row to the next, larger than a row for a region
+    VmbUint32_t             nStride;
+    VmbPixelFormatType      ePixelFormat;
+};
+
+//
+// Gets the size of a pixel of the formats the views support: 8 bit mono,
+// raw Bayer and color, and unpacked mono up to 16 bit
+//
+// Parameters:
+//  [in]    ePixelFormat    The pixel format
+//
+// Returns:
+//  The bytes per pixel, 0 for packed formats
+//
+VmbUint32_t     GetBytesPerPixel( VmbPixelFormatType ePixelFormat );
+
+//
+// Gets the significant bits of a channel of the formats the views support
+//
+// Parameters:
+//  [in]    ePixelFormat    The pixel format
+//
+// Returns:
+//  The bits per channel, 0 for packed formats
+//
+VmbUint32_t     GetBitDepth( VmbPixelFormatType ePixelFormat );
+
+//
+// Describes a whole image
+//
+// Parameters:
+//  [in]    pBuffer         The image
+//  [in]    nWidth          The width of the image
+//  [in]    nHeight         The height of the image
+//  [in]    ePixelFormat    The pixel format of the image
+//  [out]   rView           The view of the image
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats GetBytesPerPixel does not know
+//
+VmbErrorType    MakeImageView( const VmbUchar_t *pBuffer, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat, ImageView &rView );
+
+//
+// Describes a rectangle of a view without copying a pixel. The rectangle
+// is clipped to the view.
+//
+// Parameters:
+//  [in]    rView           The view to crop
+//  [in]    nLeft           The first column of the rectangle
+//  [in]    nTop            The first row of the rectangle
+//  [in]    nWidth          The width of the rectangle
+//  [in]    nHeight         The height of the rectangle
+//  [out]   rRegion         The view of the rectangle
+//
+// Returns:
+//  VmbErrorBadParameter if the rectangle lies outside the view
+//
+VmbErrorType    CropImageView( const ImageView &rView, VmbUint32_t nLeft, VmbUint32_t nTop, VmbUint32_t nWidth, VmbUint32_t nHeight, ImageView &rRegion );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,551 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LensRemap.cpp
+
+  Description: Geometric remapping of frames by a precomputed fixed point
+               lookup table, e.g. to undistort a lens.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <LensRemap.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+// A tile of the remapped frame, its source rows fit the cache of a core
+enum { TILE_ROWS = 32, TILE_COLUMNS = 256, };
+enum { REMAP_FILE_MAGIC = 0x50524D41, REMAP_FILE_VERSION = 1, };
+enum { REMAP_FLAG_LENS = 1, };
+// A fraction of 1, it fits the byte it is kept in
+enum { FRACTION_ONE = 1 << REMAP_FRACTION_BITS, };
+
+namespace {
+
+// The file starts with this, the sources and then the fractions follow
+struct RemapFileHeader
+{
+    VmbUint32_t     nMagic;
+    VmbUint32_t     nVersion;
+    VmbUint32_t     nWidth;
+    VmbUint32_t     nHeight;
+    VmbUint32_t     nPixelFormat;
+    VmbUint32_t     nFlags;
+    LensModel       lens;
+};
+
+// Raw Bayer pixels are interpolated from the next ones of their color
+VmbUint32_t GetNeighbourDistance( VmbPixelFormatType ePixelFormat )
+{
+    return 1 == GetBytesPerPixel( ePixelFormat ) && VmbPixelFormatMono8 != ePixelFormat ? 2 : 1;
+}
+
+//
+// Finds the source pixel of a position along a row or a column and the
+// fraction towards the next one of the same phase. Positions up to half
+// a pixel beyond the frame are taken from its edge.
+//
+bool Locate( double dSource, VmbUint32_t nPhase, VmbUint32_t nSize, VmbUint32_t nDistance, VmbUint32_t &rnFirst, VmbUint32_t &rnFraction )
+{
+    if(     !( dSource >= -0.5 )
+        ||  !( dSource <= nSize - 0.5 ) )
+    {
+        return false;
+    }
+    // The first of the last two pixels of the phase
+    const int nLast = static_cast<int>( ( nSize - 1 - nPhase ) / nDistance * nDistance + nPhase ) - static_cast<int>( nDistance );
+    if( nLast < static_cast<int>( nPhase ) )
+    {
+        return false;
+    }
+    const double dSteps = ( dSource - nPhase ) / nDistance;
+    const double dFloor = std::floor( dSteps );
+    int nFirst = static_cast<int>( nPhase ) + static_cast<int>( dFloor ) * static_cast<int>( nDistance );
+    double dFraction = dSteps - dFloor;
+    if( nFirst < static_cast<int>( nPhase ) )
+    {
+        nFirst = nPhase;
+        dFraction = 0.0;
+    }
+    else if( nFirst > nLast )
+    {
+        nFirst = nLast;
+        dFraction = 1.0;
+    }
+    rnFirst = static_cast<VmbUint32_t>( nFirst );
+    rnFraction = static_cast<VmbUint32_t>( dFraction * FRACTION_ONE + 0.5 );
+    return true;
+}
+
+template <typename T, VmbUint32_t CHANNELS>
+void RemapSpan( const ImageView &rView, const VmbUint32_t *pSources, const VmbUint16_t *pFractions, VmbUint32_t nDistance,
+                VmbUint32_t nFirst, VmbUint32_t nEnd, T *pTarget )
+{
+    const size_t nRowStep = static_cast<size_t>( nDistance ) * rView.nStride;
+    const VmbUint32_t nNext = nDistance * CHANNELS;
+    for( VmbUint32_t i = nFirst; i < nEnd; ++i )
+    {
+        T *pPixel = pTarget + static_cast<size_t>( i ) * CHANNELS;
+        const VmbUint32_t nSource = pSources[i];
+        if( REMAP_OUTSIDE == nSource )
+        {
+            for( VmbUint32_t c = 0; c < CHANNELS; ++c )
+            {
+                pPixel[c] = 0;
+            }
+            continue;
+        }
+        const T *pTop = reinterpret_cast<const T*>( rView.pBuffer + static_cast<size_t>( nSource >> 16 ) * rView.nStride ) + ( nSource & 0xFFFF ) * CHANNELS;
+        const T *pBottom = reinterpret_cast<const T*>( reinterpret_cast<const VmbUchar_t*>( pTop ) + nRowStep );
+        const VmbUint32_t nAcross = pFractions[i] & 0xFF;
+        const VmbUint32_t nDown = pFractions[i] >> 8;
+        for( VmbUint32_t c = 0; c < CHANNELS; ++c )
+        {
+            const VmbUint32_t nTop = pTop[c] * ( FRACTION_ONE - nAcross ) + pTop[c + nNext] * nAcross;
+            const VmbUint32_t nBottom = pBottom[c] * ( FRACTION_ONE - nAcross ) + pBottom[c + nNext] * nAcross;
+            pPixel[c] = static_cast<T>( ( nTop * ( FRACTION_ONE - nDown ) + nBottom * nDown + ( 1u << ( 2 * REMAP_FRACTION_BITS - 1 ) ) ) >> ( 2 * REMAP_FRACTION_BITS ) );
+        }
+    }
+}
+
+} // namespace
+
+//
+// Without distortion, centered on a frame of the size
+//
+LensModel::LensModel( VmbUint32_t nWidth, VmbUint32_t nHeight )
+    : dFx( (std::max)( 1u, (std::max)( nWidth, nHeight ) ) )
+    , dFy( (std::max)( 1u, (std::max)( nWidth, nHeight ) ) )
+    , dCx( nWidth > 0 ? ( nWidth - 1 ) / 2.0 : 0.0 )
+    , dCy( nHeight > 0 ? ( nHeight - 1 ) / 2.0 : 0.0 )
+    , dK1( 0.0 )
+    , dK2( 0.0 )
+    , dP1( 0.0 )
+    , dP2( 0.0 )
+    , dK3( 0.0 )
+{
+}
+
+//
+// Gets where a pixel of the undistorted frame is seen in the camera
+//
+// Parameters:
+//  [in]    dX              The column in the undistorted frame
+//  [in]    dY              The row in the undistorted frame
+//  [out]   rdSourceX       The column in the frame of the camera
+//  [out]   rdSourceY       The row in the frame of the camera
+//
+void LensModel::Distort( double dX, double dY, double &rdSourceX, double &rdSourceY ) const
+{
+    const double dU = ( dX - dCx ) / dFx;
+    const double dV = ( dY - dCy ) / dFy;
+    const double dR2 = dU * dU + dV * dV;
+    const double dRadial = 1.0 + dR2 * ( dK1 + dR2 * ( dK2 + dR2 * dK3 ) );
+    const double dDistortedU = dU * dRadial + 2.0 * dP1 * dU * dV + dP2 * ( dR2 + 2.0 * dU * dU );
+    const double dDistortedV = dV * dRadial + dP1 * ( dR2 + 2.0 * dV * dV ) + 2.0 * dP2 * dU * dV;
+    rdSourceX = dDistortedU * dFx + dCx;
+    rdSourceY = dDistortedV * dFy + dCy;
+}
+
+bool LensModel::operator==( const LensModel &rOther ) const
+{
+    return      dFx == rOther.dFx
+            &&  dFy == rOther.dFy
+            &&  dCx == rOther.dCx
+            &&  dCy == rOther.dCy
+            &&  dK1 == rOther.dK1
+            &&  dK2 == rOther.dK2
+            &&  dP1 == rOther.dP1
+            &&  dP2 == rOther.dP2
+            &&  dK3 == rOther.dK3;
+}
+
+//
+// Reads the lens from a text file holding fx fy cx cy k1 k2 p1 p2 k3
+// separated by white space, as calibration tools print them
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  VmbErrorNotFound without the file,
+//  VmbErrorInvalidValue if it holds no valid lens
+//
+VmbErrorType LensModel::Load( const std::string &rStrPath )
+{
+    FILE *pFile = fopen( rStrPath.c_str(), "r" );
+    if( NULL == pFile )
+    {
+        return VmbErrorNotFound;
+    }
+    LensModel lens;
+    const bool bValid =     9 == fscanf( pFile, "%lf %lf %lf %lf %lf %lf %lf %lf %lf",
+                                            &lens.dFx, &lens.dFy, &lens.dCx, &lens.dCy,
+                                            &lens.dK1, &lens.dK2, &lens.dP1, &lens.dP2, &lens.dK3 )
+                        &&  lens.dFx > 0.0
+                        &&  lens.dFy > 0.0;
+    fclose( pFile );
+    if( !bValid )
+    {
+        return VmbErrorInvalidValue;
+    }
+    *this = lens;
+    return VmbErrorSuccess;
+}
+
+RemapTable::RemapTable()
+    : m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_ePixelFormat( VmbPixelFormatMono8 )
+    , m_bHasLens( false )
+{
+}
+
+//
+// Builds the table that undistorts frames taken through a lens
+//
+// Parameters:
+//  [in]    rLens           The lens
+//  [in]    nWidth          The width of the frames
+//  [in]    nHeight         The height of the frames
+//  [in]    ePixelFormat    The pixel format of the frames
+//
+// Returns:
+//  VmbErrorWrongType for packed formats,
+//  VmbErrorBadParameter for frames beyond 65535 pixels a side
+//
+VmbErrorType RemapTable::Build( const LensModel &rLens, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat )
+{
+    const VmbErrorType res = Build(
+        [&rLens]( double dX, double dY, double &rdSourceX, double &rdSourceY )
+        {
+            rLens.Distort( dX, dY, rdSourceX, rdSourceY );
+            return true;
+        },
+        nWidth, nHeight, ePixelFormat );
+    if( VmbErrorSuccess == res )
+    {
+        m_bHasLens = true;
+        m_Lens = rLens;
+    }
+    return res;
+}
+
+//
+// Builds the table of any other mapping, e.g. a rectification
+//
+// Parameters:
+//  [in]    mapping         The mapping
+//  [in]    nWidth          The width of the frames
+//  [in]    nHeight         The height of the frames
+//  [in]    ePixelFormat    The pixel format of the frames
+//
+// Returns:
+//  VmbErrorWrongType for packed formats,
+//  VmbErrorBadParameter for frames beyond 65535 pixels a side
+//
+VmbErrorType RemapTable::Build( const Mapping &mapping, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat )
+{
+    if( 0 == GetBytesPerPixel( ePixelFormat ) )
+    {
+        return VmbErrorWrongType;
+    }
+    if(     0 == nWidth
+        ||  0 == nHeight
+        ||  nWidth > 0xFFFF
+        ||  nHeight > 0xFFFF )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nDistance = GetNeighbourDistance( ePixelFormat );
+    std::vector<VmbUint32_t> sources( static_cast<size_t>( nWidth ) * nHeight, REMAP_OUTSIDE );
+    std::vector<VmbUint16_t> fractions( sources.size(), 0 );
+    for( VmbUint32_t y = 0; y < nHeight; ++y )
+    {
+        for( VmbUint32_t x = 0; x < nWidth; ++x )
+        {
+            double dSourceX;
+            double dSourceY;
+            VmbUint32_t nX;
+            VmbUint32_t nY;
+            VmbUint32_t nAcross;
+            VmbUint32_t nDown;
+            if(     mapping( x, y, dSourceX, dSourceY )
+                &&  Locate( dSourceX, x % nDistance, nWidth, nDistance, nX, nAcross )
+                &&  Locate( dSourceY, y % nDistance, nHeight, nDistance, nY, nDown ) )
+            {
+                const size_t i = static_cast<size_t>( y ) * nWidth + x;
+                sources[i] = ( nY << 16 ) | nX;
+                fractions[i] = static_cast<VmbUint16_t>( ( nDown << 8 ) | nAcross );
+            }
+        }
+    }
+    m_nWidth = nWidth;
+    m_nHeight = nHeight;
+    m_ePixelFormat = ePixelFormat;
+    m_bHasLens = false;
+    m_Sources.swap( sources );
+    m_Fractions.swap( fractions );
+    return VmbErrorSuccess;
+}
+
+//
+// Reads a table written by Save
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  VmbErrorNotFound if there is no such file,
+//  VmbErrorInvalidValue if it is no remap file
+//
+VmbErrorType RemapTable::Load( const std::string &rStrPath )
+{
+    FILE *pFile = fopen( rStrPath.c_str(), "rb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorNotFound;
+    }
+    RemapFileHeader header;
+    std::vector<VmbUint32_t> sources;
+    std::vector<VmbUint16_t> fractions;
+    bool bValid =       1 == fread( &header, sizeof( header ), 1, pFile )
+                    &&  REMAP_FILE_MAGIC == header.nMagic
+                    &&  REMAP_FILE_VERSION == header.nVersion
+                    &&  0 != GetBytesPerPixel( static_cast<VmbPixelFormatType>( header.nPixelFormat ) )
+                    &&  0 != header.nWidth
+                    &&  0 != header.nHeight
+                    &&  header.nWidth <= 0xFFFF
+                    &&  header.nHeight <= 0xFFFF;
+    if( bValid )
+    {
+        const size_t nPixels = static_cast<size_t>( header.nWidth ) * header.nHeight;
+        sources.resize( nPixels );
+        fractions.resize( nPixels );
+        bValid =        nPixels == fread( &sources[0], sizeof( VmbUint32_t ), nPixels, pFile )
+                    &&  nPixels == fread( &fractions[0], sizeof( VmbUint16_t ), nPixels, pFile );
+    }
+    fclose( pFile );
+    // Every source and its next pixels inside the frame
+    const VmbUint32_t nDistance = GetNeighbourDistance( static_cast<VmbPixelFormatType>( header.nPixelFormat ) );
+    for( size_t i = 0; bValid && i < sources.size(); ++i )
+    {
+        bValid =        REMAP_OUTSIDE == sources[i]
+                    ||  (       ( sources[i] & 0xFFFF ) + nDistance < header.nWidth
+                            &&  ( sources[i] >> 16 ) + nDistance < header.nHeight
+                            &&  ( fractions[i] & 0xFF ) <= FRACTION_ONE
+                            &&  ( fractions[i] >> 8 ) <= FRACTION_ONE );
+    }
+    if( !bValid )
+    {
+        return VmbErrorInvalidValue;
+    }
+    m_nWidth = header.nWidth;
+    m_nHeight = header.nHeight;
+    m_ePixelFormat = static_cast<VmbPixelFormatType>( header.nPixelFormat );
+    m_bHasLens = 0 != ( header.nFlags & REMAP_FLAG_LENS );
+    m_Lens = header.lens;
+    m_Sources.swap( sources );
+    m_Fractions.swap( fractions );
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the table to a file. It is replaced as a whole.
+//
+// Parameters:
+//  [in]    rStrPath        The file
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType RemapTable::Save( const std::string &rStrPath ) const
+{
+    if( m_Sources.empty() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    RemapFileHeader header;
+    header.nMagic       = REMAP_FILE_MAGIC;
+    header.nVersion     = REMAP_FILE_VERSION;
+    header.nWidth       = m_nWidth;
+    header.nHeight      = m_nHeight;
+    header.nPixelFormat = static_cast<VmbUint32_t>( m_ePixelFormat );
+    header.nFlags       = m_bHasLens ? REMAP_FLAG_LENS : 0;
+    header.lens         = m_Lens;
+
+    const std::string strTemporary = rStrPath + ".tmp";
+    FILE *pFile = fopen( strTemporary.c_str(), "wb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorResources;
+    }
+    const bool bWritten =   1 == fwrite( &header, sizeof( header ), 1, pFile )
+                        &&  m_Sources.size() == fwrite( &m_Sources[0], sizeof( VmbUint32_t ), m_Sources.size(), pFile )
+                        &&  m_Fractions.size() == fwrite( &m_Fractions[0], sizeof( VmbUint16_t ), m_Fractions.size(), pFile );
+    if( 0 != fclose( pFile ) || !bWritten )
+    {
+        return VmbErrorResources;
+    }
+    if( !MoveFileExA( strTemporary.c_str(), rStrPath.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+        return VmbErrorResources;
+    }
+    return VmbErrorSuccess;
+}
+
+bool RemapTable::Matches( const ImageView &rView ) const
+{
+    return      !m_Sources.empty()
+            &&  rView.nWidth == m_nWidth
+            &&  rView.nHeight == m_nHeight
+            &&  rView.ePixelFormat == m_ePixelFormat;
+}
+
+//
+// Whether the table undistorts this lens for these frames, so it
+// does not have to be built again
+//
+bool RemapTable::IsBuiltFrom( const LensModel &rLens, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat ) const
+{
+    return      m_bHasLens
+            &&  !m_Sources.empty()
+            &&  m_Lens == rLens
+            &&  nWidth == m_nWidth
+            &&  nHeight == m_nHeight
+            &&  ePixelFormat == m_ePixelFormat;
+}
+
+//
+// Gets the lens the table was built from
+//
+// Returns:
+//  false for tables of other mappings
+//
+bool RemapTable::GetLens( LensModel &rLens ) const
+{
+    if( m_bHasLens )
+    {
+        rLens = m_Lens;
+    }
+    return m_bHasLens;
+}
+
+VmbUint32_t RemapTable::GetWidth() const
+{
+    return m_nWidth;
+}
+
+VmbUint32_t RemapTable::GetHeight() const
+{
+    return m_nHeight;
+}
+
+VmbPixelFormatType RemapTable::GetPixelFormat() const
+{
+    return m_ePixelFormat;
+}
+
+const VmbUint32_t* RemapTable::GetSources() const
+{
+    return m_Sources.empty() ? NULL : &m_Sources[0];
+}
+
+const VmbUint16_t* RemapTable::GetFractions() const
+{
+    return m_Fractions.empty() ? NULL : &m_Fractions[0];
+}
+
+//
+// Remaps a frame by bilinear interpolation. The frame is worked on in
+// tiles, so the source rows a tile needs stay in the cache, and the
+// tiles are spread over the pool.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [in]    rTable          The table, built for frames like this one
+//  [in]    pPool           The pool to spread the frame over, may be NULL
+//  [out]   pTarget         The remapped frame, with the stride of rView
+//
+// Returns:
+//  VmbErrorBadParameter if the table does not match the frame
+//
+VmbErrorType RemapImage( const ImageView &rView, const RemapTable &rTable, ThreadPool *pPool, VmbUchar_t *pTarget )
+{
+    if(     !rTable.Matches( rView )
+        ||  NULL == rView.pBuffer
+        ||  NULL == pTarget )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nDistance = GetNeighbourDistance( rView.ePixelFormat );
+    const VmbUint32_t nWidth = rView.nWidth;
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, rView.nHeight / MIN_STRIPE_ROWS ) );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nFirstRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rView.nHeight ) * nStripe / nStripes );
+        const VmbUint32_t nEndRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( rView.nHeight ) * ( nStripe + 1 ) / nStripes );
+        for( VmbUint32_t nTileRow = nFirstRow; nTileRow < nEndRow; nTileRow += TILE_ROWS )
+        {
+            const VmbUint32_t nTileEndRow = (std::min)( nEndRow, nTileRow + TILE_ROWS );
+            for( VmbUint32_t nTileColumn = 0; nTileColumn < nWidth; nTileColumn += TILE_COLUMNS )
+            {
+                const VmbUint32_t nTileEndColumn = (std::min)( nWidth, nTileColumn + TILE_COLUMNS );
+                for( VmbUint32_t y = nTileRow; y < nTileEndRow; ++y )
+                {
+                    const VmbUint32_t *pSources = rTable.GetSources() + static_cast<size_t>( y ) * nWidth;
+                    const VmbUint16_t *pFractions = rTable.GetFractions() + static_cast<size_t>( y ) * nWidth;
+                    VmbUchar_t *pRow = pTarget + static_cast<size_t>( y ) * rView.nStride;
+                    switch( nBytesPerPixel )
+                    {
+                    case 3:
+                        RemapSpan<VmbUchar_t, 3>( rView, pSources, pFractions, nDistance, nTileColumn, nTileEndColumn, pRow );
+                        break;
+                    case 2:
+                        RemapSpan<VmbUint16_t, 1>( rView, pSources, pFractions, nDistance, nTileColumn, nTileEndColumn, reinterpret_cast<VmbUint16_t*>( pRow ) );
+                        break;
+                    default:
+                        RemapSpan<VmbUchar_t, 1>( rView, pSources, pFractions, nDistance, nTileColumn, nTileEndColumn, pRow );
+                        break;
+                    }
+                }
+            }
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
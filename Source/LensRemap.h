@@ -0,0 +1,221 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LensRemap.h
+
+  Description: Geometric remapping of frames by a precomputed fixed point
+               lookup table, e.g. to undistort a lens.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_LENSREMAP
+#define AVT_VMBAPI_EXAMPLES_LENSREMAP
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Source positions are kept with this many bits of fraction
+enum { REMAP_FRACTION_BITS = 7, };
+// The source of a pixel that comes from outside of the frame
+static const VmbUint32_t REMAP_OUTSIDE = 0xFFFFFFFF;
+
+//
+// The pinhole intrinsics and the radial and tangential distortion of a
+// lens, as camera calibration tools report them. All in pixels of the
+// full frame.
+//
+struct LensModel
+{
+    double          dFx;
+    double          dFy;
+    double          dCx;
+    double          dCy;
+    double          dK1;
+    double          dK2;
+    double          dP1;
+    double          dP2;
+    double          dK3;
+
+    // Without distortion, centered on a frame of the size
+    LensModel( VmbUint32_t nWidth = 0, VmbUint32_t nHeight = 0 );
+
+    //
+    // Gets where a pixel of the undistorted frame is seen in the camera
+    //
+    // Parameters:
+    //  [in]    dX              The column in the undistorted frame
+    //  [in]    dY              The row in the undistorted frame
+    //  [out]   rdSourceX       The column in the frame of the camera
+    //  [out]   rdSourceY       The row in the frame of the camera
+    //
+    void            Distort( double dX, double dY, double &rdSourceX, double &rdSourceY ) const;
+
+    bool            operator==( const LensModel &rOther ) const;
+
+    //
+    // Reads the lens from a text file holding fx fy cx cy k1 k2 p1 p2 k3
+    // separated by white space, as calibration tools print them
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  VmbErrorNotFound without the file,
+    //  VmbErrorInvalidValue if it holds no valid lens
+    //
+    VmbErrorType    Load( const std::string &rStrPath );
+};
+
+//
+// For every pixel of the remapped frame the source pixel above left of
+// the position it comes from and the fraction towards the next ones.
+// Raw Bayer frames are interpolated between pixels of the same color.
+//
+class RemapTable
+{
+  public:
+    //
+    // Gets where a pixel of the remapped frame comes from
+    //
+    // Returns:
+    //  false if it lies outside of the source frame
+    //
+    typedef std::function<bool( double dX, double dY, double &rdSourceX, double &rdSourceY )> Mapping;
+
+    RemapTable();
+
+    //
+    // Builds the table that undistorts frames taken through a lens
+    //
+    // Parameters:
+    //  [in]    rLens           The lens
+    //  [in]    nWidth          The width of the frames
+    //  [in]    nHeight         The height of the frames
+    //  [in]    ePixelFormat    The pixel format of the frames
+    //
+    // Returns:
+    //  VmbErrorWrongType for packed formats,
+    //  VmbErrorBadParameter for frames beyond 65535 pixels a side
+    //
+    VmbErrorType        Build( const LensModel &rLens, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat );
+
+    //
+    // Builds the table of any other mapping, e.g. a rectification
+    //
+    // Parameters:
+    //  [in]    mapping         The mapping
+    //  [in]    nWidth          The width of the frames
+    //  [in]    nHeight         The height of the frames
+    //  [in]    ePixelFormat    The pixel format of the frames
+    //
+    // Returns:
+    //  VmbErrorWrongType for packed formats,
+    //  VmbErrorBadParameter for frames beyond 65535 pixels a side
+    //
+    VmbErrorType        Build( const Mapping &mapping, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat );
+
+    //
+    // Reads a table written by Save
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  VmbErrorNotFound if there is no such file,
+    //  VmbErrorInvalidValue if it is no remap file
+    //
+    VmbErrorType        Load( const std::string &rStrPath );
+
+    //
+    // Writes the table to a file. It is replaced as a whole.
+    //
+    // Parameters:
+    //  [in]    rStrPath        The file
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType        Save( const std::string &rStrPath ) const;
+
+    // Whether frames like this one can be remapped
+    bool                Matches( const ImageView &rView ) const;
+
+    //
+    // Whether the table undistorts this lens for these frames, so it
+    // does not have to be built again
+    //
+    bool                IsBuiltFrom( const LensModel &rLens, VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat ) const;
+
+    //
+    // Gets the lens the table was built from
+    //
+    // Returns:
+    //  false for tables of other mappings
+    //
+    bool                GetLens( LensModel &rLens ) const;
+
+    VmbUint32_t         GetWidth() const;
+    VmbUint32_t         GetHeight() const;
+    VmbPixelFormatType  GetPixelFormat() const;
+
+    // Row by row, column in the low and row in the high 16 bit, REMAP_OUTSIDE for none
+    const VmbUint32_t*  GetSources() const;
+    // Row by row, the fraction across in the low and down in the high byte
+    const VmbUint16_t*  GetFractions() const;
+
+  private:
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbPixelFormatType          m_ePixelFormat;
+    bool                        m_bHasLens;
+    LensModel                   m_Lens;
+    std::vector<VmbUint32_t>    m_Sources;
+    std::vector<VmbUint16_t>    m_Fractions;
+};
+
+//
+// Remaps a frame by bilinear interpolation. The frame is worked on in
+// tiles, so the source rows a tile needs stay in the cache, and the
+// tiles are spread over the pool.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [in]    rTable          The table, built for frames like this one
+//  [in]    pPool           The pool to spread the frame over, may be NULL
+//  [out]   pTarget         The remapped frame, with the stride of rView
+//
+// Returns:
+//  VmbErrorBadParameter if the table does not match the frame
+//
+VmbErrorType    RemapImage( const ImageView &rView, const RemapTable &rTable, ThreadPool *pPool, VmbUchar_t *pTarget );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
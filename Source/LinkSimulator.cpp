@@ -0,0 +1,170 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LinkSimulator.cpp
+
+  Description: A packet level model of cameras sharing one link through a
+               switch.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <LinkSimulator.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+namespace {
+
+// A packet arriving at the switch port
+struct PacketEvent
+{
+    double          dTime;
+    size_t          nCamera;
+    VmbUint64_t     nFrame;
+    double          dWireBytes;
+    VmbUint32_t     nAttempt;
+
+    bool operator>( const PacketEvent &rOther ) const
+    {
+        return dTime > rOther.dTime;
+    }
+};
+
+typedef std::priority_queue< PacketEvent, std::vector<PacketEvent>, std::greater<PacketEvent> > EventQueue;
+
+}
+
+//
+// Parameters:
+//  [in]    nMaxResends     The resends the host asks for per packet
+//  [in]    dResendDelayMs  The time from a drop to the resent packet
+//
+LinkSimulator::LinkSimulator( VmbUint32_t nMaxResends, double dResendDelayMs )
+    : m_nMaxResends( nMaxResends )
+    , m_dResendDelay( dResendDelayMs / 1000.0 )
+{
+}
+
+//
+// Simulates all cameras of one link. All cameras start their first
+// frame at the same moment, which is the worst case for the switch.
+//
+// Parameters:
+//  [in]    rLink           The shared link
+//  [in]    rDemands        The cameras on this link
+//  [in]    rAllocations    The plan for these cameras, same order
+//  [in]    dSeconds        The simulated time
+//  [out]   rResults        One result per camera, same order
+//
+void LinkSimulator::Simulate(   const LinkDescription &rLink,
+                                const std::vector<StreamDemand> &rDemands,
+                                const std::vector<StreamAllocation> &rAllocations,
+                                double dSeconds,
+                                std::vector<LinkSimulationResult> &rResults ) const
+{
+    rResults.assign( rDemands.size(), LinkSimulationResult() );
+    std::vector< std::set<VmbUint64_t> > lostFrames( rDemands.size() );
+
+    // Every packet of every frame, paced by the allocation. A camera that
+    // got less than it needs stretches its frame period.
+    EventQueue events;
+    for( size_t i = 0; i < rDemands.size() && i < rAllocations.size(); ++i )
+    {
+        const StreamDemand &rDemand = rDemands[i];
+        const StreamAllocation &rAllocation = rAllocations[i];
+        LinkSimulationResult &rResult = rResults[i];
+        rResult.strCameraID = rDemand.strCameraID;
+        rResult.nPacketsSent = 0;
+        rResult.nPacketsDropped = 0;
+        rResult.nResendRequests = 0;
+        rResult.nFramesSent = 0;
+        rResult.nFramesLost = 0;
+        if(     rAllocation.dWireBytesPerSecond <= 0.0
+            ||  rDemand.dTargetFps <= 0.0
+            ||  rAllocation.nPacketSize <= GVSP_PACKET_HEADER_BYTES )
+        {
+            continue;
+        }
+
+        const VmbUint32_t nDataPerPacket = rAllocation.nPacketSize - GVSP_PACKET_HEADER_BYTES;
+        const VmbInt64_t nPackets = ( rDemand.nPayloadSize + nDataPerPacket - 1 ) / nDataPerPacket;
+        const double dPacketWireBytes = static_cast<double>( rAllocation.nPacketSize ) + ETHERNET_OVERHEAD_BYTES;
+        const double dPacketInterval = dPacketWireBytes / rAllocation.dWireBytesPerSecond;
+        const double dFramePeriod = (std::max)( 1.0 / rDemand.dTargetFps,
+                                                BandwidthPlanner::GetWireBytesPerFrame( rDemand.nPayloadSize, rAllocation.nPacketSize ) / rAllocation.dWireBytesPerSecond );
+        for( VmbUint64_t nFrame = 0; nFrame * dFramePeriod < dSeconds; ++nFrame )
+        {
+            const double dFrameStart = nFrame * dFramePeriod;
+            for( VmbInt64_t nPacket = 0; nPacket < nPackets; ++nPacket )
+            {
+                PacketEvent event = { dFrameStart + nPacket * dPacketInterval, i, nFrame, dPacketWireBytes, 0 };
+                events.push( event );
+            }
+            ++rResult.nFramesSent;
+        }
+    }
+
+    // The switch port: a byte queue drained at line rate
+    double dQueuedBytes = 0.0;
+    double dLastTime = 0.0;
+    while( !events.empty() )
+    {
+        PacketEvent event = events.top();
+        events.pop();
+        dQueuedBytes = (std::max)( 0.0, dQueuedBytes - ( event.dTime - dLastTime ) * rLink.dBytesPerSecond );
+        dLastTime = event.dTime;
+
+        LinkSimulationResult &rResult = rResults[event.nCamera];
+        ++rResult.nPacketsSent;
+        if( dQueuedBytes + event.dWireBytes <= rLink.nSwitchBufferBytes )
+        {
+            dQueuedBytes += event.dWireBytes;
+            continue;
+        }
+
+        ++rResult.nPacketsDropped;
+        if( event.nAttempt < m_nMaxResends )
+        {
+            ++rResult.nResendRequests;
+            event.dTime += m_dResendDelay;
+            ++event.nAttempt;
+            events.push( event );
+        }
+        else
+        {
+            lostFrames[event.nCamera].insert( event.nFrame );
+        }
+    }
+
+    for( size_t i = 0; i < rResults.size(); ++i )
+    {
+        LinkSimulationResult &rResult = rResults[i];
+        rResult.nFramesLost = lostFrames[i].size();
+        rResult.dDropRate = 0 == rResult.nPacketsSent ? 0.0 : static_cast<double>( rResult.nPacketsDropped ) / rResult.nPacketsSent;
+        rResult.dResendRate = 0 == rResult.nPacketsSent ? 0.0 : static_cast<double>( rResult.nResendRequests ) / rResult.nPacketsSent;
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,94 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        LinkSimulator.h
+
+  Description: A packet level model of cameras sharing one link through a
+               switch. Every camera sends its frames as packets paced by its
+               allocation, the switch port queues them in a finite buffer
+               and drains it at line rate. Packets that do not fit are
+               dropped and resent on request, the way the GigE transport
+               layer does. Used to check a bandwidth plan before it is
+               applied to the cameras.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_LINKSIMULATOR
+#define AVT_VMBAPI_EXAMPLES_LINKSIMULATOR
+
+#include <vector>
+#include "BandwidthPlanner.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// What one camera experienced during the simulation
+struct LinkSimulationResult
+{
+    std::string     strCameraID;
+    VmbUint64_t     nPacketsSent;
+    VmbUint64_t     nPacketsDropped;
+    VmbUint64_t     nResendRequests;
+    VmbUint64_t     nFramesSent;
+    // Frames with at least one packet lost for good
+    VmbUint64_t     nFramesLost;
+    // Dropped packets per packet sent
+    double          dDropRate;
+    // Resend requests per packet sent
+    double          dResendRate;
+};
+
+class LinkSimulator
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    nMaxResends     The resends the host asks for per packet
+    //  [in]    dResendDelayMs  The time from a drop to the resent packet
+    //
+    LinkSimulator( VmbUint32_t nMaxResends = 3, double dResendDelayMs = 2.0 );
+
+    //
+    // Simulates all cameras of one link. All cameras start their first
+    // frame at the same moment, which is the worst case for the switch.
+    //
+    // Parameters:
+    //  [in]    rLink           The shared link
+    //  [in]    rDemands        The cameras on this link
+    //  [in]    rAllocations    The plan for these cameras, same order
+    //  [in]    dSeconds        The simulated time
+    //  [out]   rResults        One result per camera, same order
+    //
+    void Simulate(  const LinkDescription &rLink,
+                    const std::vector<StreamDemand> &rDemands,
+                    const std::vector<StreamAllocation> &rAllocations,
+                    double dSeconds,
+                    std::vector<LinkSimulationResult> &rResults ) const;
+
+  private:
+    VmbUint32_t m_nMaxResends;
+    double      m_dResendDelay;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,155 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsExporter.cpp
+
+  Description: Writes the frame counters to a file in the Prometheus
+               text format once a second.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <cstdio>
+#include <chrono>
+#include <MetricsExporter.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+MetricsExporter::MetricsExporter()
+    : m_pRegistry( NULL )
+    , m_nIntervalMs( 0 )
+    , m_bStop( false )
+    , m_eLastResult( VmbErrorSuccess )
+{
+}
+
+//
+// Stops the export thread
+//
+MetricsExporter::~MetricsExporter()
+{
+    Stop();
+}
+
+//
+// Starts writing the counters of a registry
+//
+// Parameters:
+//  [in]    pRegistry       The counters to export
+//  [in]    rStrPath        The file to write
+//  [in]    nIntervalMs     The time between two writes
+//
+// Returns:
+//  VmbErrorInvalidCall if already running
+//
+VmbErrorType MetricsExporter::Start( const MetricsRegistry *pRegistry, const std::string &rStrPath, VmbUint32_t nIntervalMs )
+{
+    if( NULL == pRegistry || 0 == nIntervalMs )
+    {
+        return VmbErrorBadParameter;
+    }
+    if( m_Thread.joinable() )
+    {
+        return VmbErrorInvalidCall;
+    }
+    m_pRegistry = pRegistry;
+    m_strPath = rStrPath;
+    m_nIntervalMs = nIntervalMs;
+    m_bStop = false;
+    m_Thread = std::thread( &MetricsExporter::ExportThread, this );
+    return VmbErrorSuccess;
+}
+
+//
+// Writes the file one last time and stops
+//
+void MetricsExporter::Stop()
+{
+    if( !m_Thread.joinable() )
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_bStop = true;
+    }
+    m_Condition.notify_all();
+    m_Thread.join();
+}
+
+VmbErrorType MetricsExporter::GetLastResult() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return m_eLastResult;
+}
+
+void MetricsExporter::ExportThread()
+{
+    typedef std::chrono::steady_clock Clock;
+    std::vector<StreamMetricsSnapshot> previous;
+    Clock::time_point last = Clock::now();
+    bool bStop = false;
+    while( !bStop )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_Mutex );
+            m_Condition.wait_for( lock, std::chrono::milliseconds( m_nIntervalMs ), [this] { return m_bStop; } );
+            bStop = m_bStop;
+        }
+        const Clock::time_point now = Clock::now();
+        const VmbErrorType res = Export( previous, std::chrono::duration<double>( now - last ).count() );
+        last = now;
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_eLastResult = res;
+    }
+}
+
+VmbErrorType MetricsExporter::Export( std::vector<StreamMetricsSnapshot> &rPrevious, double dSeconds )
+{
+    std::vector<StreamMetricsSnapshot> current;
+    m_pRegistry->GetSnapshot( current );
+    std::string strText;
+    MetricsRegistry::FormatPrometheus( current, rPrevious, dSeconds, strText );
+    rPrevious.swap( current );
+
+    // Written aside and moved over the old file, a scraper reads either
+    // the old or the new counters
+    const std::string strTemporary = m_strPath + ".tmp";
+    FILE *pFile = fopen( strTemporary.c_str(), "wb" );
+    if( NULL == pFile )
+    {
+        return VmbErrorResources;
+    }
+    const bool bWritten = strText.size() == fwrite( strText.data(), 1, strText.size(), pFile );
+    if( 0 != fclose( pFile ) || !bWritten )
+    {
+        return VmbErrorResources;
+    }
+    if( !MoveFileExA( strTemporary.c_str(), m_strPath.c_str(), MOVEFILE_REPLACE_EXISTING ) )
+    {
+        return VmbErrorResources;
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
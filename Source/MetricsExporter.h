@@ -0,0 +1,103 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MetricsExporter.h
+
+  Description: Writes the frame counters to a file in the Prometheus
+               text format once a second.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_METRICSEXPORTER
+#define AVT_VMBAPI_EXAMPLES_METRICSEXPORTER
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "FrameMetrics.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// A scraper (e.g. the textfile collector of the node exporter) picks the
+// file up. The file is replaced as a whole, so it never sees half of it.
+//
+class MetricsExporter
+{
+  public:
+    MetricsExporter();
+
+    //
+    // Stops the export thread
+    //
+    ~MetricsExporter();
+
+    //
+    // Starts writing the counters of a registry
+    //
+    // Parameters:
+    //  [in]    pRegistry       The counters to export
+    //  [in]    rStrPath        The file to write
+    //  [in]    nIntervalMs     The time between two writes
+    //
+    // Returns:
+    //  VmbErrorInvalidCall if already running
+    //
+    VmbErrorType    Start( const MetricsRegistry *pRegistry, const std::string &rStrPath, VmbUint32_t nIntervalMs );
+
+    //
+    // Writes the file one last time and stops
+    //
+    void            Stop();
+
+    //
+    // Gets the result of the last write
+    //
+    // Returns:
+    //  VmbErrorSuccess or VmbErrorResources if the file could not be written
+    //
+    VmbErrorType    GetLastResult() const;
+
+  private:
+    // No copies, the object owns a thread
+    MetricsExporter( const MetricsExporter& );
+    MetricsExporter& operator=( const MetricsExporter& );
+
+    void            ExportThread();
+    VmbErrorType    Export( std::vector<StreamMetricsSnapshot> &rPrevious, double dSeconds );
+
+    const MetricsRegistry      *m_pRegistry;
+    std::string                 m_strPath;
+    VmbUint32_t                 m_nIntervalMs;
+    std::thread                 m_Thread;
+    mutable std::mutex          m_Mutex;
+    std::condition_variable     m_Condition;
+    bool                        m_bStop;
+    VmbErrorType                m_eLastResult;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
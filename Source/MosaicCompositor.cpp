@@ -0,0 +1,340 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MosaicCompositor.cpp
+
+  Description: Composes scaled previews of all cameras into the tiles of
+               one frame buffer that is blitted as a whole.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <MosaicCompositor.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Pixels between two tiles
+enum { TILE_GAP = 2, };
+// Rows a worker gets at least, smaller stripes cost more than they save
+enum { MIN_STRIPE_ROWS = 16, };
+// Gray of the gaps and of the letterbox around an image
+enum { BACKGROUND = 0x20, };
+
+//
+// Parameters:
+//  [in]    rPool           The workers the tiles are scaled on
+//
+MosaicCompositor::MosaicCompositor( ThreadPool &rPool )
+    : m_Pool( rPool )
+    , m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_nStride( 0 )
+    , m_nTiles( 1 )
+    , m_nColumns( 0 )
+{
+}
+
+//
+// Sets the size of the frame buffer, usually the client size of the
+// window it is shown in. Clears all tiles.
+//
+// Parameters:
+//  [in]    nWidth          The width in pixels
+//  [in]    nHeight         The height in pixels
+//
+void MosaicCompositor::Resize( VmbUint32_t nWidth, VmbUint32_t nHeight )
+{
+    m_nWidth = nWidth;
+    m_nHeight = nHeight;
+    m_nStride = ( nWidth * 3 + 3 ) & ~3u;
+    UpdateTiles();
+}
+
+//
+// Sets the tile grid. Clears all tiles.
+//
+// Parameters:
+//  [in]    nTiles          The number of tiles
+//  [in]    nColumns        The number of columns, 0 for a grid as square as possible
+//
+void MosaicCompositor::SetLayout( VmbUint32_t nTiles, VmbUint32_t nColumns )
+{
+    m_nTiles = (std::max)( nTiles, 1u );
+    m_nColumns = nColumns;
+    UpdateTiles();
+}
+
+void MosaicCompositor::UpdateTiles()
+{
+    m_FrameBuffer.assign( static_cast<size_t>( m_nStride ) * m_nHeight, static_cast<VmbUchar_t>( BACKGROUND ) );
+
+    const VmbUint32_t nColumns = 0 != m_nColumns    ? (std::min)( m_nColumns, m_nTiles )
+                                                    : static_cast<VmbUint32_t>( std::ceil( std::sqrt( static_cast<double>( m_nTiles ) ) ) );
+    const VmbUint32_t nRows = ( m_nTiles + nColumns - 1 ) / nColumns;
+    const VmbUint32_t nTileWidth = m_nWidth > ( nColumns - 1 ) * TILE_GAP ? ( m_nWidth - ( nColumns - 1 ) * TILE_GAP ) / nColumns : 0;
+    const VmbUint32_t nTileHeight = m_nHeight > ( nRows - 1 ) * TILE_GAP ? ( m_nHeight - ( nRows - 1 ) * TILE_GAP ) / nRows : 0;
+
+    m_Tiles.resize( m_nTiles );
+    for( VmbUint32_t i = 0; i < m_nTiles; ++i )
+    {
+        m_Tiles[i].rect.nLeft = ( i % nColumns ) * ( nTileWidth + TILE_GAP );
+        m_Tiles[i].rect.nTop = ( i / nColumns ) * ( nTileHeight + TILE_GAP );
+        m_Tiles[i].rect.nWidth = nTileWidth;
+        m_Tiles[i].rect.nHeight = nTileHeight;
+        m_Tiles[i].bDirty = true;
+    }
+}
+
+//
+// Scales an image into a tile, keeping its aspect ratio. The rows of
+// the tile are split among the pool.
+//
+// Parameters:
+//  [in]    nTile           The index of the tile
+//  [in]    rView           The image or a region of it
+//
+// Returns:
+//  VmbErrorBadParameter for an unknown tile, VmbErrorWrongType for
+//  pixel formats other than Mono8 to Mono16, 8 bit Bayer, which is
+//  shown in gray, RGB8 and BGR8
+//
+VmbErrorType MosaicCompositor::Render( VmbUint32_t nTile, const ImageView &rView )
+{
+    if(     nTile >= m_Tiles.size()
+        ||  0 == rView.nWidth
+        ||  0 == rView.nHeight )
+    {
+        return VmbErrorBadParameter;
+    }
+    // Fit the image into the tile, the rest of the tile is letterbox
+    const MosaicRect &rRect = m_Tiles[nTile].rect;
+    const double dScale = (std::min)(   static_cast<double>( rRect.nWidth ) / rView.nWidth,
+                                        static_cast<double>( rRect.nHeight ) / rView.nHeight );
+    return RenderImage( nTile,
+                        rView,
+                        (std::max)( 1u, static_cast<VmbUint32_t>( rView.nWidth * dScale ) ),
+                        (std::max)( 1u, static_cast<VmbUint32_t>( rView.nHeight * dScale ) ) );
+}
+
+//
+// Shows an image in a tile at native resolution: every pixel becomes a
+// square of whole screen pixels, never a blend. An image larger than
+// the tile is cut to its center.
+//
+// Parameters:
+//  [in]    nTile           The index of the tile
+//  [in]    rView           The image or a region of it
+//
+// Returns:
+//  VmbErrorBadParameter for an unknown tile, VmbErrorWrongType for
+//  pixel formats other than Mono8 to Mono16, 8 bit Bayer, which is
+//  shown in gray, RGB8 and BGR8
+//
+VmbErrorType MosaicCompositor::RenderZoom( VmbUint32_t nTile, const ImageView &rView )
+{
+    if(     nTile >= m_Tiles.size()
+        ||  0 == rView.nWidth
+        ||  0 == rView.nHeight )
+    {
+        return VmbErrorBadParameter;
+    }
+    const MosaicRect &rRect = m_Tiles[nTile].rect;
+    ImageView view = rView;
+    if( view.nWidth > rRect.nWidth || view.nHeight > rRect.nHeight )
+    {
+        const VmbUint32_t nWidth = (std::min)( view.nWidth, rRect.nWidth );
+        const VmbUint32_t nHeight = (std::min)( view.nHeight, rRect.nHeight );
+        const VmbErrorType res = CropImageView( rView, ( rView.nWidth - nWidth ) / 2, ( rView.nHeight - nHeight ) / 2, nWidth, nHeight, view );
+        if( VmbErrorSuccess != res )
+        {
+            return res;
+        }
+    }
+    const VmbUint32_t nZoom = (std::max)( 1u, (std::min)( rRect.nWidth / view.nWidth, rRect.nHeight / view.nHeight ) );
+    return RenderImage( nTile, view, view.nWidth * nZoom, view.nHeight * nZoom );
+}
+
+VmbErrorType MosaicCompositor::RenderImage( VmbUint32_t nTile, const ImageView &rView, VmbUint32_t nImageWidth, VmbUint32_t nImageHeight )
+{
+    if( NULL == rView.pBuffer )
+    {
+        return VmbErrorBadParameter;
+    }
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nBitDepth = GetBitDepth( rView.ePixelFormat );
+    if( 0 == nBitDepth )
+    {
+        return VmbErrorWrongType;
+    }
+    // The screen shows 8 bit only, wider samples lose their low bits
+    const VmbUint32_t nShift = nBitDepth - 8;
+    Tile &rTile = m_Tiles[nTile];
+    if( 0 == rTile.rect.nWidth || 0 == rTile.rect.nHeight )
+    {
+        return VmbErrorSuccess;
+    }
+
+    const VmbUint32_t nOffsetX = ( rTile.rect.nWidth - nImageWidth ) / 2;
+    const VmbUint32_t nOffsetY = ( rTile.rect.nHeight - nImageHeight ) / 2;
+
+    // Nearest neighbour, the columns are the same for every row
+    m_SourceColumns.resize( nImageWidth );
+    for( VmbUint32_t x = 0; x < nImageWidth; ++x )
+    {
+        m_SourceColumns[x] = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( x ) * rView.nWidth / nImageWidth ) * nBytesPerPixel;
+    }
+
+    const MosaicRect rect = rTile.rect;
+    const VmbUint32_t nStride = m_nStride;
+    const VmbUint32_t nSourceStride = rView.nStride;
+    const VmbUint32_t *pSourceColumns = &m_SourceColumns[0];
+    VmbUchar_t *pTarget = &m_FrameBuffer[0] + static_cast<size_t>( rect.nTop ) * nStride + rect.nLeft * 3;
+    const VmbUint32_t nStripes = (std::max)( 1u, (std::min)( m_Pool.GetThreadCount() + 1, rect.nHeight / MIN_STRIPE_ROWS ) );
+    m_Pool.ParallelFor( nStripes, [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nFirstRow = rect.nHeight * nStripe / nStripes;
+        const VmbUint32_t nEndRow = rect.nHeight * ( nStripe + 1 ) / nStripes;
+        for( VmbUint32_t y = nFirstRow; y < nEndRow; ++y )
+        {
+            VmbUchar_t *pRow = pTarget + static_cast<size_t>( y ) * nStride;
+            if( y < nOffsetY || y >= nOffsetY + nImageHeight )
+            {
+                memset( pRow, BACKGROUND, rect.nWidth * 3 );
+                continue;
+            }
+            memset( pRow, BACKGROUND, nOffsetX * 3 );
+            memset( pRow + ( nOffsetX + nImageWidth ) * 3, BACKGROUND, ( rect.nWidth - nOffsetX - nImageWidth ) * 3 );
+            const VmbUchar_t *pSourceRow = rView.pBuffer + static_cast<size_t>( static_cast<VmbUint64_t>( y - nOffsetY ) * rView.nHeight / nImageHeight ) * nSourceStride;
+            VmbUchar_t *pPixel = pRow + nOffsetX * 3;
+            switch( rView.ePixelFormat )
+            {
+            case VmbPixelFormatMono8:
+            // Raw Bayer is shown as it is, in gray
+            case VmbPixelFormatBayerGR8:
+            case VmbPixelFormatBayerRG8:
+            case VmbPixelFormatBayerGB8:
+            case VmbPixelFormatBayerBG8:
+                for( VmbUint32_t x = 0; x < nImageWidth; ++x, pPixel += 3 )
+                {
+                    pPixel[0] = pPixel[1] = pPixel[2] = pSourceRow[pSourceColumns[x]];
+                }
+                break;
+            case VmbPixelFormatMono10:
+            case VmbPixelFormatMono12:
+            case VmbPixelFormatMono14:
+            case VmbPixelFormatMono16:
+                for( VmbUint32_t x = 0; x < nImageWidth; ++x, pPixel += 3 )
+                {
+                    const VmbUint16_t nSample = *reinterpret_cast<const VmbUint16_t*>( pSourceRow + pSourceColumns[x] );
+                    pPixel[0] = pPixel[1] = pPixel[2] = static_cast<VmbUchar_t>( (std::min)( nSample >> nShift, 255 ) );
+                }
+                break;
+            case VmbPixelFormatRgb8:
+                for( VmbUint32_t x = 0; x < nImageWidth; ++x, pPixel += 3 )
+                {
+                    const VmbUchar_t *pSource = pSourceRow + pSourceColumns[x];
+                    pPixel[0] = pSource[2];
+                    pPixel[1] = pSource[1];
+                    pPixel[2] = pSource[0];
+                }
+                break;
+            default:
+                for( VmbUint32_t x = 0; x < nImageWidth; ++x, pPixel += 3 )
+                {
+                    memcpy( pPixel, pSourceRow + pSourceColumns[x], 3 );
+                }
+                break;
+            }
+        }
+    } );
+    rTile.bDirty = true;
+    return VmbErrorSuccess;
+}
+
+//
+// Gets the smallest rectangle covering all tiles changed since the
+// last call and marks them clean
+//
+// Parameters:
+//  [out]   rRect           The changed area
+//
+// Returns:
+//  false if nothing changed
+//
+bool MosaicCompositor::TakeDirtyRect( MosaicRect &rRect )
+{
+    VmbUint32_t nLeft = m_nWidth;
+    VmbUint32_t nTop = m_nHeight;
+    VmbUint32_t nRight = 0;
+    VmbUint32_t nBottom = 0;
+    for( size_t i = 0; i < m_Tiles.size(); ++i )
+    {
+        if( m_Tiles[i].bDirty )
+        {
+            const MosaicRect &rTileRect = m_Tiles[i].rect;
+            nLeft = (std::min)( nLeft, rTileRect.nLeft );
+            nTop = (std::min)( nTop, rTileRect.nTop );
+            nRight = (std::max)( nRight, rTileRect.nLeft + rTileRect.nWidth );
+            nBottom = (std::max)( nBottom, rTileRect.nTop + rTileRect.nHeight );
+            m_Tiles[i].bDirty = false;
+        }
+    }
+    if( nRight <= nLeft || nBottom <= nTop )
+    {
+        return false;
+    }
+    rRect.nLeft = nLeft;
+    rRect.nTop = nTop;
+    rRect.nWidth = nRight - nLeft;
+    rRect.nHeight = nBottom - nTop;
+    return true;
+}
+
+const VmbUchar_t* MosaicCompositor::GetFrameBuffer() const
+{
+    return m_FrameBuffer.empty() ? NULL : &m_FrameBuffer[0];
+}
+
+VmbUint32_t MosaicCompositor::GetWidth() const
+{
+    return m_nWidth;
+}
+
+VmbUint32_t MosaicCompositor::GetHeight() const
+{
+    return m_nHeight;
+}
+
+VmbUint32_t MosaicCompositor::GetStride() const
+{
+    return m_nStride;
+}
+
+VmbUint32_t MosaicCompositor::GetTileCount() const
+{
+    return m_nTiles;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,155 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MosaicCompositor.h
+
+  Description: Composes scaled previews of all cameras into the tiles of
+               one frame buffer that is blitted as a whole.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_MOSAICCOMPOSITOR
+#define AVT_VMBAPI_EXAMPLES_MOSAICCOMPOSITOR
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ThreadPool.h"
+#include "ImageView.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// A rectangle in frame buffer pixels
+struct MosaicRect
+{
+    VmbUint32_t     nLeft;
+    VmbUint32_t     nTop;
+    VmbUint32_t     nWidth;
+    VmbUint32_t     nHeight;
+};
+
+//
+// The frame buffer is 24 bit BGR, top down, with rows aligned to 4 bytes
+// as a device independent bitmap wants them. Tiles are filled row by row
+// and column by column in the order of their index.
+//
+class MosaicCompositor
+{
+  public:
+    //
+    // Parameters:
+    //  [in]    rPool           The workers the tiles are scaled on
+    //
+    explicit MosaicCompositor( ThreadPool &rPool );
+
+    //
+    // Sets the size of the frame buffer, usually the client size of the
+    // window it is shown in. Clears all tiles.
+    //
+    // Parameters:
+    //  [in]    nWidth          The width in pixels
+    //  [in]    nHeight         The height in pixels
+    //
+    void            Resize( VmbUint32_t nWidth, VmbUint32_t nHeight );
+
+    //
+    // Sets the tile grid. Clears all tiles.
+    //
+    // Parameters:
+    //  [in]    nTiles          The number of tiles
+    //  [in]    nColumns        The number of columns, 0 for a grid as square as possible
+    //
+    void            SetLayout( VmbUint32_t nTiles, VmbUint32_t nColumns );
+
+    //
+    // Scales an image into a tile, keeping its aspect ratio. The rows of
+    // the tile are split among the pool.
+    //
+    // Parameters:
+    //  [in]    nTile           The index of the tile
+    //  [in]    rView           The image or a region of it
+    //
+    // Returns:
+    //  VmbErrorBadParameter for an unknown tile, VmbErrorWrongType for
+    //  pixel formats other than Mono8 to Mono16, RGB8 and BGR8
+    //
+    VmbErrorType    Render( VmbUint32_t nTile, const ImageView &rView );
+
+    //
+    // Shows an image in a tile at native resolution: every pixel becomes a
+    // square of whole screen pixels, never a blend. An image larger than
+    // the tile is cut to its center.
+    //
+    // Parameters:
+    //  [in]    nTile           The index of the tile
+    //  [in]    rView           The image or a region of it
+    //
+    // Returns:
+    //  VmbErrorBadParameter for an unknown tile, VmbErrorWrongType for
+    //  pixel formats other than Mono8 to Mono16, RGB8 and BGR8
+    //
+    VmbErrorType    RenderZoom( VmbUint32_t nTile, const ImageView &rView );
+
+    //
+    // Gets the smallest rectangle covering all tiles changed since the
+    // last call and marks them clean
+    //
+    // Parameters:
+    //  [out]   rRect           The changed area
+    //
+    // Returns:
+    //  false if nothing changed
+    //
+    bool            TakeDirtyRect( MosaicRect &rRect );
+
+    const VmbUchar_t*   GetFrameBuffer() const;
+    VmbUint32_t         GetWidth() const;
+    VmbUint32_t         GetHeight() const;
+    VmbUint32_t         GetStride() const;
+    VmbUint32_t         GetTileCount() const;
+
+  private:
+    struct Tile
+    {
+        MosaicRect  rect;
+        bool        bDirty;
+    };
+
+    void            UpdateTiles();
+    VmbErrorType    RenderImage( VmbUint32_t nTile, const ImageView &rView, VmbUint32_t nImageWidth, VmbUint32_t nImageHeight );
+
+    ThreadPool                 &m_Pool;
+    std::vector<VmbUchar_t>     m_FrameBuffer;
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbUint32_t                 m_nStride;
+    VmbUint32_t                 m_nTiles;
+    VmbUint32_t                 m_nColumns;
+    std::vector<Tile>           m_Tiles;
+    // Source column of every tile column, kept to save the allocation
+    std::vector<VmbUint32_t>    m_SourceColumns;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
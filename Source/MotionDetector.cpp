@@ -0,0 +1,253 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MotionDetector.cpp
+
+  Description: Change detection by differencing a decimated frame against
+               a running background, with hysteresis on the result.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <MotionDetector.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_MOTIONDETECTOR_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fraction bits of the background, 8 bit values plus these stay within int16
+enum { BACKGROUND_FRACTION_BITS = 7, };
+
+MotionSettings::MotionSettings()
+    : nGridStep( 4 )
+    , nPixelThreshold( 20 )
+    , dStartRatio( 0.01 )
+    , nStartFrames( 2 )
+    , dStopRatio( 0.005 )
+    , nStopFrames( 15 )
+    , nBackgroundShift( 4 )
+{
+}
+
+MotionDetector::MotionDetector( const MotionSettings &settings )
+{
+    Reset( settings );
+}
+
+//
+// Forgets the background, the next frame starts a new one
+//
+// Parameters:
+//  [in]    settings        The grid, the thresholds and the hysteresis
+//
+void MotionDetector::Reset( const MotionSettings &settings )
+{
+    m_Settings = settings;
+    m_Settings.nGridStep = (std::max)( 1u, m_Settings.nGridStep );
+    m_Settings.nPixelThreshold = (std::min)( 255u, m_Settings.nPixelThreshold );
+    m_Settings.nBackgroundShift = (std::min)( static_cast<VmbUint32_t>( BACKGROUND_FRACTION_BITS ), m_Settings.nBackgroundShift );
+    m_nGridWidth = 0;
+    m_nGridHeight = 0;
+    m_Grid.clear();
+    m_Background.clear();
+    m_bActive = false;
+    m_nFramesAbove = 0;
+    m_nFramesBelow = 0;
+}
+
+void MotionDetector::SampleGrid( const ImageView &rView, VmbUint32_t nStep )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    const size_t nPixelStep = static_cast<size_t>( nStep ) * nBytesPerPixel;
+    VmbUchar_t *pCell = &m_Grid[0];
+    if( 2 == nBytesPerPixel )
+    {
+        const VmbUint32_t nShift = GetBitDepth( rView.ePixelFormat ) - 8;
+        for( VmbUint32_t y = 0; y < m_nGridHeight; ++y )
+        {
+            const VmbUchar_t *pPixel = rView.pBuffer + static_cast<size_t>( y ) * nStep * rView.nStride;
+            for( VmbUint32_t x = 0; x < m_nGridWidth; ++x, pPixel += nPixelStep )
+            {
+                *pCell++ = static_cast<VmbUchar_t>( *reinterpret_cast<const VmbUint16_t*>( pPixel ) >> nShift );
+            }
+        }
+    }
+    else
+    {
+        // Green is in the middle of RGB and BGR alike
+        const size_t nOffset = 3 == nBytesPerPixel ? 1 : 0;
+        for( VmbUint32_t y = 0; y < m_nGridHeight; ++y )
+        {
+            const VmbUchar_t *pPixel = rView.pBuffer + static_cast<size_t>( y ) * nStep * rView.nStride + nOffset;
+            for( VmbUint32_t x = 0; x < m_nGridWidth; ++x, pPixel += nPixelStep )
+            {
+                *pCell++ = *pPixel;
+            }
+        }
+    }
+}
+
+//
+// Compares a frame with the background and blends it in. The first
+// frame and frames of another size start a new background.
+// Color images are compared by their green channel.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [out]   rResult         The change, nFrameID is left to the caller
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support
+//
+VmbErrorType MotionDetector::Process( const ImageView &rView, MotionResult &rResult )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+    if( NULL == rView.pBuffer || 0 == rView.nWidth || 0 == rView.nHeight )
+    {
+        return VmbErrorBadParameter;
+    }
+    // An even step stays on one color of a Bayer mosaic
+    const bool bIsBayer = 1 == nBytesPerPixel && VmbPixelFormatMono8 != rView.ePixelFormat;
+    const VmbUint32_t nStep = bIsBayer ? ( m_Settings.nGridStep + 1 ) & ~1u : m_Settings.nGridStep;
+    const VmbUint32_t nGridWidth = ( rView.nWidth + nStep - 1 ) / nStep;
+    const VmbUint32_t nGridHeight = ( rView.nHeight + nStep - 1 ) / nStep;
+
+    rResult.dChangedRatio = 0.0;
+    rResult.dMeanDifference = 0.0;
+    rResult.eEvent = MotionEventNone;
+    const bool bNewBackground = nGridWidth != m_nGridWidth || nGridHeight != m_nGridHeight;
+    if( bNewBackground )
+    {
+        m_nGridWidth = nGridWidth;
+        m_nGridHeight = nGridHeight;
+        m_Grid.resize( static_cast<size_t>( nGridWidth ) * nGridHeight );
+        m_Background.resize( m_Grid.size() );
+    }
+    SampleGrid( rView, nStep );
+    const size_t nCells = m_Grid.size();
+    if( bNewBackground )
+    {
+        for( size_t i = 0; i < nCells; ++i )
+        {
+            m_Background[i] = static_cast<VmbUint16_t>( m_Grid[i] << BACKGROUND_FRACTION_BITS );
+        }
+        rResult.bActive = m_bActive;
+        return VmbErrorSuccess;
+    }
+
+    const int nShift = static_cast<int>( m_Settings.nBackgroundShift );
+    VmbUint64_t nDifferenceSum = 0;
+    VmbUint64_t nChanged = 0;
+    size_t i = 0;
+#ifdef AVT_MOTIONDETECTOR_SSE2
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i threshold = _mm_set1_epi8( static_cast<char>( m_Settings.nPixelThreshold ) );
+        const __m128i ones = _mm_set1_epi8( 1 );
+        // Both sums are in the two 64 bit halves, _mm_sad_epu8 adds 8 bytes into each
+        __m128i differenceSum = zero;
+        __m128i changedSum = zero;
+        for( ; i + 16 <= nCells; i += 16 )
+        {
+            const __m128i cells = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &m_Grid[i] ) );
+            __m128i backgroundLow = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &m_Background[i] ) );
+            __m128i backgroundHigh = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &m_Background[i + 8] ) );
+            const __m128i background = _mm_packus_epi16(    _mm_srli_epi16( backgroundLow, BACKGROUND_FRACTION_BITS ),
+                                                            _mm_srli_epi16( backgroundHigh, BACKGROUND_FRACTION_BITS ) );
+            const __m128i difference = _mm_or_si128( _mm_subs_epu8( cells, background ), _mm_subs_epu8( background, cells ) );
+            differenceSum = _mm_add_epi64( differenceSum, _mm_sad_epu8( difference, zero ) );
+            // 0xff where the difference is within the threshold, 1 where not
+            const __m128i unchanged = _mm_cmpeq_epi8( _mm_subs_epu8( difference, threshold ), zero );
+            changedSum = _mm_add_epi64( changedSum, _mm_sad_epu8( _mm_andnot_si128( unchanged, ones ), zero ) );
+
+            const __m128i cellsLow = _mm_slli_epi16( _mm_unpacklo_epi8( cells, zero ), BACKGROUND_FRACTION_BITS );
+            const __m128i cellsHigh = _mm_slli_epi16( _mm_unpackhi_epi8( cells, zero ), BACKGROUND_FRACTION_BITS );
+            backgroundLow = _mm_add_epi16( backgroundLow, _mm_sra_epi16( _mm_sub_epi16( cellsLow, backgroundLow ), _mm_cvtsi32_si128( nShift ) ) );
+            backgroundHigh = _mm_add_epi16( backgroundHigh, _mm_sra_epi16( _mm_sub_epi16( cellsHigh, backgroundHigh ), _mm_cvtsi32_si128( nShift ) ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( &m_Background[i] ), backgroundLow );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( &m_Background[i + 8] ), backgroundHigh );
+        }
+        VmbUint64_t sums[2];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( sums ), differenceSum );
+        nDifferenceSum = sums[0] + sums[1];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( sums ), changedSum );
+        nChanged = sums[0] + sums[1];
+    }
+#endif
+    for( ; i < nCells; ++i )
+    {
+        const int nCell = m_Grid[i];
+        const int nBackground = m_Background[i];
+        const int nDifference = std::abs( nCell - ( nBackground >> BACKGROUND_FRACTION_BITS ) );
+        nDifferenceSum += nDifference;
+        nChanged += nDifference > static_cast<int>( m_Settings.nPixelThreshold ) ? 1 : 0;
+        // Shifts right like _mm_sra_epi16, rounding down
+        const int nDelta = ( nCell << BACKGROUND_FRACTION_BITS ) - nBackground;
+        m_Background[i] = static_cast<VmbUint16_t>( nBackground + ( nDelta >= 0 ? nDelta >> nShift : -( ( -nDelta + ( 1 << nShift ) - 1 ) >> nShift ) ) );
+    }
+    rResult.dChangedRatio = static_cast<double>( nChanged ) / nCells;
+    rResult.dMeanDifference = static_cast<double>( nDifferenceSum ) / nCells;
+
+    if( !m_bActive )
+    {
+        m_nFramesAbove = rResult.dChangedRatio >= m_Settings.dStartRatio ? m_nFramesAbove + 1 : 0;
+        if( m_nFramesAbove >= (std::max)( 1u, m_Settings.nStartFrames ) )
+        {
+            m_bActive = true;
+            m_nFramesBelow = 0;
+            rResult.eEvent = MotionEventStarted;
+        }
+    }
+    else
+    {
+        m_nFramesBelow = rResult.dChangedRatio < m_Settings.dStopRatio ? m_nFramesBelow + 1 : 0;
+        if( m_nFramesBelow >= (std::max)( 1u, m_Settings.nStopFrames ) )
+        {
+            m_bActive = false;
+            m_nFramesAbove = 0;
+            rResult.eEvent = MotionEventStopped;
+        }
+    }
+    rResult.bActive = m_bActive;
+    return VmbErrorSuccess;
+}
+
+bool MotionDetector::IsActive() const
+{
+    return m_bActive;
+}
+
+const MotionSettings& MotionDetector::GetSettings() const
+{
+    return m_Settings;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,130 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        MotionDetector.h
+
+  Description: Change detection by differencing a decimated frame against
+               a running background, with hysteresis on the result.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_MOTIONDETECTOR
+#define AVT_VMBAPI_EXAMPLES_MOTIONDETECTOR
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+struct MotionSettings
+{
+    // Every nth pixel of every nth row is compared, rounded up to even for Bayer
+    VmbUint32_t     nGridStep;
+    // A cell changed if it differs from the background by more, in 8 bit values
+    VmbUint32_t     nPixelThreshold;
+    // Motion starts when this part of the cells changed ...
+    double          dStartRatio;
+    // ... in this many frames in a row
+    VmbUint32_t     nStartFrames;
+    // Motion stops when less than this part changed ...
+    double          dStopRatio;
+    // ... in this many frames in a row
+    VmbUint32_t     nStopFrames;
+    // The background follows the frames with a time constant of 2^n frames
+    VmbUint32_t     nBackgroundShift;
+
+    MotionSettings();
+};
+
+enum MotionEventType
+{
+    MotionEventNone,
+    MotionEventStarted,
+    MotionEventStopped,
+};
+
+struct MotionResult
+{
+    VmbUint64_t     nFrameID;
+    // The part of the cells that differ from the background
+    double          dChangedRatio;
+    // The mean absolute difference of the cells in 8 bit values
+    double          dMeanDifference;
+    // Motion is going on, after the hysteresis
+    bool            bActive;
+    // The change of bActive this frame made
+    MotionEventType eEvent;
+};
+
+class MotionDetector
+{
+  public:
+    explicit MotionDetector( const MotionSettings &settings = MotionSettings() );
+
+    //
+    // Forgets the background, the next frame starts a new one
+    //
+    // Parameters:
+    //  [in]    settings        The grid, the thresholds and the hysteresis
+    //
+    void            Reset( const MotionSettings &settings );
+
+    //
+    // Compares a frame with the background and blends it in. The first
+    // frame and frames of another size start a new background.
+    // Color images are compared by their green channel.
+    //
+    // Parameters:
+    //  [in]    rView           The frame
+    //  [out]   rResult         The change, nFrameID is left to the caller
+    //
+    // Returns:
+    //  VmbErrorWrongType for pixel formats the views do not support
+    //
+    VmbErrorType    Process( const ImageView &rView, MotionResult &rResult );
+
+    bool            IsActive() const;
+    const MotionSettings& GetSettings() const;
+
+  private:
+    // Samples the grid of a frame into m_Grid
+    void            SampleGrid( const ImageView &rView, VmbUint32_t nStep );
+
+    MotionSettings              m_Settings;
+    VmbUint32_t                 m_nGridWidth;
+    VmbUint32_t                 m_nGridHeight;
+    // The sampled frame, one byte per cell
+    std::vector<VmbUchar_t>     m_Grid;
+    // The running background, 8 bit values with 7 bits of fraction
+    std::vector<VmbUint16_t>    m_Background;
+    bool                        m_bActive;
+    // Frames in a row beyond the start or below the stop ratio
+    VmbUint32_t                 m_nFramesAbove;
+    VmbUint32_t                 m_nFramesBelow;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
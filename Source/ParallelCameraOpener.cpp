@@ -0,0 +1,116 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ParallelCameraOpener.cpp
+
+  Description: Opens and configures a set of cameras concurrently on a
+               bounded number of threads.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <chrono>
+#include <ParallelCameraOpener.h>
+#include <ThreadPool.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+typedef std::chrono::steady_clock Clock;
+
+static double ToMilliseconds( Clock::duration duration )
+{
+    return std::chrono::duration<double, std::milli>( duration ).count();
+}
+
+//
+// Parameters:
+//  [in]    nMaxParallel    The number of cameras opened at the same time
+//
+ParallelCameraOpener::ParallelCameraOpener( unsigned int nMaxParallel )
+    : m_nMaxParallel( 0 == nMaxParallel ? 1 : nMaxParallel )
+{
+}
+
+//
+// Runs the open function for every camera and waits for all of them
+//
+// Parameters:
+//  [in]    rCameraIDs      The IDs of the cameras to open
+//  [in]    openFunction    Opens and configures one camera
+//  [out]   rResults        One result per camera, in the order of rCameraIDs
+//
+// Returns:
+//  The wall time of the whole run in milliseconds
+//
+double ParallelCameraOpener::Run( const std::vector<std::string> &rCameraIDs, const OpenFunction &openFunction, std::vector<CameraOpenResult> &rResults )
+{
+    const Clock::time_point start = Clock::now();
+
+    rResults.assign( rCameraIDs.size(), CameraOpenResult() );
+    for( size_t i = 0; i < rCameraIDs.size(); ++i )
+    {
+        rResults[i].strCameraID = rCameraIDs[i];
+        rResults[i].eResult = VmbErrorOther;
+        rResults[i].dDurationMs = 0.0;
+        rResults[i].dQueuedMs = 0.0;
+    }
+    if( rCameraIDs.empty() )
+    {
+        return 0.0;
+    }
+
+    {
+        // No more threads than cameras, a GigE open is mostly waiting on the network
+        const unsigned int nThreads = static_cast<unsigned int>( (std::min)( rCameraIDs.size(), static_cast<size_t>( m_nMaxParallel ) ) );
+        ThreadPool pool( nThreads );
+        std::vector< std::future<void> > pending;
+        for( size_t i = 0; i < rCameraIDs.size(); ++i )
+        {
+            // Every task writes only its own result, so no locking is needed
+            CameraOpenResult *pResult = &rResults[i];
+            pending.push_back( pool.Submit( [pResult, i, start, &openFunction]()
+            {
+                const Clock::time_point begin = Clock::now();
+                pResult->dQueuedMs = ToMilliseconds( begin - start );
+                try
+                {
+                    pResult->eResult = openFunction( i, pResult->strCameraID );
+                }
+                catch( ... )
+                {
+                    // One misbehaving camera must not take down the others
+                    pResult->eResult = VmbErrorInternalFault;
+                }
+                pResult->dDurationMs = ToMilliseconds( Clock::now() - begin );
+            } ) );
+        }
+        for( size_t i = 0; i < pending.size(); ++i )
+        {
+            pending[i].wait();
+        }
+    }
+
+    return ToMilliseconds( Clock::now() - start );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
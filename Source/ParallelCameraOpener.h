@@ -0,0 +1,91 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ParallelCameraOpener.h
+
+  Description: Opens and configures a set of cameras concurrently on a
+               bounded number of threads. Every camera is timed on its own,
+               a camera that fails does not hold up the others.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_PARALLELCAMERAOPENER
+#define AVT_VMBAPI_EXAMPLES_PARALLELCAMERAOPENER
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// The outcome of opening one camera
+struct CameraOpenResult
+{
+    std::string     strCameraID;
+    VmbErrorType    eResult;
+    // Time from picking up the camera until it was configured
+    double          dDurationMs;
+    // Time the camera waited for a free thread
+    double          dQueuedMs;
+};
+
+class ParallelCameraOpener
+{
+  public:
+    //
+    // Opens and configures a single camera. Called from a worker thread,
+    // concurrently for different cameras.
+    //
+    // Parameters:
+    //  [in]    nIndex          The position of the camera in the list
+    //  [in]    rStrCameraID    The ID of the camera as reported by Vimba
+    //
+    typedef std::function<VmbErrorType( size_t nIndex, const std::string &rStrCameraID )> OpenFunction;
+
+    //
+    // Parameters:
+    //  [in]    nMaxParallel    The number of cameras opened at the same time
+    //
+    explicit ParallelCameraOpener( unsigned int nMaxParallel );
+
+    //
+    // Runs the open function for every camera and waits for all of them
+    //
+    // Parameters:
+    //  [in]    rCameraIDs      The IDs of the cameras to open
+    //  [in]    openFunction    Opens and configures one camera
+    //  [out]   rResults        One result per camera, in the order of rCameraIDs
+    //
+    // Returns:
+    //  The wall time of the whole run in milliseconds
+    //
+    double Run( const std::vector<std::string> &rCameraIDs, const OpenFunction &openFunction, std::vector<CameraOpenResult> &rResults );
+
+  private:
+    unsigned int m_nMaxParallel;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
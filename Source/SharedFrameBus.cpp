@@ -0,0 +1,244 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SharedFrameBus.cpp
+
+  Description: Publishes the frames of one camera into a named shared memory
+               ring so that analysis processes can read them without copies.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <afxwin.h>
+#include <cstring>
+#include <SharedFrameBus.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+SharedFrameBus::SharedFrameBus()
+    : m_hMapping( NULL )
+    , m_pRegion( NULL )
+    , m_pHeader( NULL )
+{
+}
+
+SharedFrameBus::~SharedFrameBus()
+{
+    Close();
+}
+
+//
+// Creates the shared region of a camera or attaches to it if readers
+// still hold it from a previous session
+//
+// Parameters:
+//  [in]    rStrCameraID    The camera ID, used to name the region
+//  [in]    nSlotCount      The number of frames the ring holds
+//  [in]    nSlotBytes      The maximum image size (PayloadSize)
+//
+// Returns:
+//  An API status code
+//
+VmbErrorType SharedFrameBus::Open( const std::string &rStrCameraID, VmbUint32_t nSlotCount, VmbUint32_t nSlotBytes )
+{
+    if(     nSlotCount < 2
+        ||  0 == nSlotBytes )
+    {
+        return VmbErrorBadParameter;
+    }
+    Close();
+
+    std::wstring strName( SHARED_FRAME_BUS_NAME_PREFIX );
+    strName.append( rStrCameraID.begin(), rStrCameraID.end() );
+
+    const unsigned long long nRegionSize = SharedFrameBusSize( nSlotCount, nSlotBytes );
+    HANDLE hMapping = CreateFileMapping(    INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                            static_cast<DWORD>( nRegionSize >> 32 ),
+                                            static_cast<DWORD>( nRegionSize & 0xFFFFFFFF ),
+                                            strName.c_str() );
+    if( NULL == hMapping )
+    {
+        return VmbErrorResources;
+    }
+    const bool bExisted = ( ERROR_ALREADY_EXISTS == GetLastError() );
+
+    VmbUchar_t *pRegion = static_cast<VmbUchar_t*>( MapViewOfFile( hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0 ) );
+    if( NULL == pRegion )
+    {
+        CloseHandle( hMapping );
+        return VmbErrorResources;
+    }
+
+    SharedFrameBusHeader *pHeader = reinterpret_cast<SharedFrameBusHeader*>( pRegion );
+    if( bExisted )
+    {
+        // Readers kept the region of an earlier session alive. Keep using it
+        // (and its sequence) if it has the same geometry, so they carry on.
+        if(     SHARED_FRAME_BUS_MAGIC != pHeader->nMagic
+            ||  SHARED_FRAME_BUS_VERSION != pHeader->nVersion
+            ||  nSlotCount != pHeader->nSlotCount
+            ||  nSlotBytes != pHeader->nSlotBytes )
+        {
+            UnmapViewOfFile( pRegion );
+            CloseHandle( hMapping );
+            return VmbErrorInvalidValue;
+        }
+    }
+    else
+    {
+        // A new mapping is zero filled, so all sequences and cursors start at 0
+        pHeader->nVersion       = SHARED_FRAME_BUS_VERSION;
+        pHeader->nSlotCount     = nSlotCount;
+        pHeader->nSlotBytes     = nSlotBytes;
+        pHeader->nSlotStride    = static_cast<unsigned int>( SharedFrameSlotStride( nSlotBytes ) );
+        // Readers check the magic first, so it is written last
+        std::atomic_thread_fence( std::memory_order_release );
+        pHeader->nMagic         = SHARED_FRAME_BUS_MAGIC;
+    }
+
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    m_hMapping  = hMapping;
+    m_pRegion   = pRegion;
+    m_pHeader   = pHeader;
+    return VmbErrorSuccess;
+}
+
+//
+// Unmaps the region. It disappears once the last reader closes it.
+//
+void SharedFrameBus::Close()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    if( NULL != m_pRegion )
+    {
+        UnmapViewOfFile( m_pRegion );
+        m_pRegion = NULL;
+        m_pHeader = NULL;
+    }
+    if( NULL != m_hMapping )
+    {
+        CloseHandle( m_hMapping );
+        m_hMapping = NULL;
+    }
+}
+
+bool SharedFrameBus::IsOpen() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return NULL != m_pHeader;
+}
+
+//
+// Copies a frame into the next slot. Never waits for readers.
+//
+// Parameters:
+//  [in]    pBuffer         The image data
+//  [in]    nSize           The size of the image data in bytes
+//  [in]    nFrameID        The frame ID as reported by the camera
+//  [in]    nWidth          The width of the image
+//  [in]    nHeight         The height of the image
+//  [in]    ePixelFormat    The pixel format of the image
+//
+// Returns:
+//  true if the frame was published
+//
+bool SharedFrameBus::Publish(   const VmbUchar_t *pBuffer, VmbUint32_t nSize, VmbUint64_t nFrameID,
+                                VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat )
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    if(     NULL == m_pHeader
+        ||  nSize > m_pHeader->nSlotBytes )
+    {
+        return false;
+    }
+
+    // We are the only writer, so the sequence can be read relaxed
+    const unsigned long long nSequence = m_pHeader->nWriteSequence.load( std::memory_order_relaxed );
+    VmbUchar_t *pSlot = m_pRegion + sizeof( SharedFrameBusHeader )
+                        + static_cast<size_t>( nSequence % m_pHeader->nSlotCount ) * m_pHeader->nSlotStride;
+    SharedFrameSlotHeader *pSlotHeader = reinterpret_cast<SharedFrameSlotHeader*>( pSlot );
+
+    // Mark the slot as being written, readers that still look at the
+    // previous frame in here will notice on release
+    pSlotHeader->nSequence.store( 2 * nSequence + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    LARGE_INTEGER nNow;
+    QueryPerformanceCounter( &nNow );
+    pSlotHeader->nFrameID       = nFrameID;
+    pSlotHeader->nPublishTicks  = nNow.QuadPart;
+    pSlotHeader->nWidth         = nWidth;
+    pSlotHeader->nHeight        = nHeight;
+    pSlotHeader->nPixelFormat   = static_cast<unsigned int>( ePixelFormat );
+    pSlotHeader->nImageSize     = nSize;
+    memcpy( pSlot + sizeof( SharedFrameSlotHeader ), pBuffer, nSize );
+
+    pSlotHeader->nSequence.store( 2 * nSequence + 2, std::memory_order_release );
+    m_pHeader->nWriteSequence.store( nSequence + 1, std::memory_order_release );
+    return true;
+}
+
+//
+// Gets the number of frames published since the region was created
+//
+VmbUint64_t SharedFrameBus::GetPublishedCount() const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    return NULL != m_pHeader ? m_pHeader->nWriteSequence.load() : 0;
+}
+
+//
+// Gets how far behind the slowest registered reader is
+//
+// Parameters:
+//  [out]   rnReaders       The number of registered readers
+//
+// Returns:
+//  The lag of the slowest reader in frames
+//
+VmbUint64_t SharedFrameBus::GetMaxReaderLag( VmbUint32_t &rnReaders ) const
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    rnReaders = 0;
+    if( NULL == m_pHeader )
+    {
+        return 0;
+    }
+    const unsigned long long nHead = m_pHeader->nWriteSequence.load();
+    VmbUint64_t nMaxLag = 0;
+    for( unsigned int i = 0; i < SHARED_FRAME_BUS_MAX_READERS; ++i )
+    {
+        const SharedFrameReaderCursor &rCursor = m_pHeader->readers[i];
+        if( 0 != rCursor.nInUse.load() )
+        {
+            ++rnReaders;
+            const unsigned long long nNext = rCursor.nNextSequence.load();
+            if( nHead > nNext && nHead - nNext > nMaxLag )
+            {
+                nMaxLag = nHead - nNext;
+            }
+        }
+    }
+    return nMaxLag;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,118 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SharedFrameBus.h
+
+  Description: Publishes the frames of one camera into a named shared memory
+               ring so that analysis processes can read them without copies.
+               See SharedFrameLayout.h for the memory layout and
+               SharedFrameReader.h for the reading side.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SHAREDFRAMEBUS
+#define AVT_VMBAPI_EXAMPLES_SHAREDFRAMEBUS
+
+#include <string>
+#include <mutex>
+#include <VimbaCPP/Include/VimbaCPP.h>
+#include "SharedFrameLayout.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class SharedFrameBus
+{
+  public:
+    SharedFrameBus();
+    ~SharedFrameBus();
+
+    //
+    // Creates the shared region of a camera or attaches to it if readers
+    // still hold it from a previous session
+    //
+    // Parameters:
+    //  [in]    rStrCameraID    The camera ID, used to name the region
+    //  [in]    nSlotCount      The number of frames the ring holds
+    //  [in]    nSlotBytes      The maximum image size (PayloadSize)
+    //
+    // Returns:
+    //  An API status code
+    //
+    VmbErrorType    Open( const std::string &rStrCameraID, VmbUint32_t nSlotCount, VmbUint32_t nSlotBytes );
+
+    //
+    // Unmaps the region. It disappears once the last reader closes it.
+    //
+    void            Close();
+
+    bool            IsOpen() const;
+
+    //
+    // Copies a frame into the next slot. Never waits for readers.
+    //
+    // Parameters:
+    //  [in]    pBuffer         The image data
+    //  [in]    nSize           The size of the image data in bytes
+    //  [in]    nFrameID        The frame ID as reported by the camera
+    //  [in]    nWidth          The width of the image
+    //  [in]    nHeight         The height of the image
+    //  [in]    ePixelFormat    The pixel format of the image
+    //
+    // Returns:
+    //  true if the frame was published
+    //
+    bool            Publish( const VmbUchar_t *pBuffer, VmbUint32_t nSize, VmbUint64_t nFrameID,
+                             VmbUint32_t nWidth, VmbUint32_t nHeight, VmbPixelFormatType ePixelFormat );
+
+    //
+    // Gets the number of frames published since the region was created
+    //
+    VmbUint64_t     GetPublishedCount() const;
+
+    //
+    // Gets how far behind the slowest registered reader is
+    //
+    // Parameters:
+    //  [out]   rnReaders       The number of registered readers
+    //
+    // Returns:
+    //  The lag of the slowest reader in frames
+    //
+    VmbUint64_t     GetMaxReaderLag( VmbUint32_t &rnReaders ) const;
+
+  private:
+    // No copies, the object owns a mapping
+    SharedFrameBus( const SharedFrameBus& );
+    SharedFrameBus& operator=( const SharedFrameBus& );
+
+    // HANDLE of the file mapping
+    void                    *m_hMapping;
+    VmbUchar_t              *m_pRegion;
+    SharedFrameBusHeader    *m_pHeader;
+    // Guards the mapping against Close while a frame is published
+    mutable std::mutex      m_Mutex;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
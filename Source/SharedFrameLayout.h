@@ -0,0 +1,144 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SharedFrameLayout.h
+
+  Description: Memory layout of the shared frame bus. This header is shared
+               between the publishing application and external readers and
+               therefore must not depend on VimbaCPP or MFC.
+
+               A bus is one named shared memory region per camera:
+
+               +------------------------+
+               | SharedFrameBusHeader   |  write sequence, reader cursors
+               +------------------------+
+               | slot 0                 |  SharedFrameSlotHeader + image
+               | slot 1                 |
+               | ...                    |
+               +------------------------+
+
+               Frame number s is written to slot s % nSlotCount. Every slot
+               is guarded by a sequence lock: while a frame is being written
+               the slot sequence is odd (2s+1), afterwards it is 2s+2.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SHAREDFRAMELAYOUT
+#define AVT_VMBAPI_EXAMPLES_SHAREDFRAMELAYOUT
+
+#include <cstddef>
+#include <atomic>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// "VFBS" - Vimba frame bus
+const unsigned int          SHARED_FRAME_BUS_MAGIC          = 0x53424656;
+const unsigned int          SHARED_FRAME_BUS_VERSION        = 1;
+const unsigned int          SHARED_FRAME_BUS_MAX_READERS    = 8;
+const unsigned int          SHARED_FRAME_BUS_ALIGNMENT      = 64;
+// Region names are this prefix followed by the camera ID
+const wchar_t * const       SHARED_FRAME_BUS_NAME_PREFIX    = L"Local\\VmbFrameBus_";
+
+// The position of one registered reader. Readers publish their cursor so
+// that the application can see who is lagging, it never waits for them.
+struct SharedFrameReaderCursor
+{
+    std::atomic<unsigned int>           nInUse;
+    std::atomic<unsigned long long>     nNextSequence;
+    std::atomic<unsigned long long>     nSkippedFrames;
+    char                                padding[ SHARED_FRAME_BUS_ALIGNMENT - 24 ];
+};
+
+struct SharedFrameBusHeader
+{
+    unsigned int                        nMagic;
+    unsigned int                        nVersion;
+    unsigned int                        nSlotCount;
+    // Maximum image size a slot can hold
+    unsigned int                        nSlotBytes;
+    // Distance between two slots, slot header included
+    unsigned int                        nSlotStride;
+    unsigned int                        nReserved;
+    // Number of frames published so far
+    std::atomic<unsigned long long>     nWriteSequence;
+    char                                padding[ SHARED_FRAME_BUS_ALIGNMENT - 32 ];
+    SharedFrameReaderCursor             readers[ SHARED_FRAME_BUS_MAX_READERS ];
+};
+
+struct SharedFrameSlotHeader
+{
+    // Sequence lock of the slot. To publish frame s the writer stores 2s+1
+    // (odd) before it touches the slot and 2s+2 (even) once header and
+    // image are complete. A reader loads the sequence, copies the slot and
+    // loads it again (acquire on both sides); it retries when the first
+    // value is odd or the two differ, and has lost frame s when the value
+    // is beyond 2s+2
+    std::atomic<unsigned long long>     nSequence;
+    unsigned long long                  nFrameID;
+    // QueryPerformanceCounter ticks when the frame was published
+    long long                           nPublishTicks;
+    unsigned int                        nWidth;
+    unsigned int                        nHeight;
+    unsigned int                        nPixelFormat;
+    unsigned int                        nImageSize;
+    char                                padding[ SHARED_FRAME_BUS_ALIGNMENT - 40 ];
+};
+
+// Readers in other processes rely on these sizes
+static_assert( sizeof( SharedFrameReaderCursor ) == SHARED_FRAME_BUS_ALIGNMENT, "SharedFrameReaderCursor must fill one cache line" );
+static_assert( sizeof( SharedFrameSlotHeader ) == SHARED_FRAME_BUS_ALIGNMENT, "SharedFrameSlotHeader must fill one cache line" );
+static_assert( sizeof( SharedFrameBusHeader ) == ( 1 + SHARED_FRAME_BUS_MAX_READERS ) * SHARED_FRAME_BUS_ALIGNMENT, "Unexpected SharedFrameBusHeader size" );
+
+//
+// Computes the distance between two slots
+//
+// Parameters:
+//  [in]    nSlotBytes      The maximum image size of a slot
+//
+// Returns:
+//  The slot stride in bytes
+//
+inline size_t SharedFrameSlotStride( size_t nSlotBytes )
+{
+    const size_t nStride = sizeof( SharedFrameSlotHeader ) + nSlotBytes;
+    return ( nStride + SHARED_FRAME_BUS_ALIGNMENT - 1 ) & ~static_cast<size_t>( SHARED_FRAME_BUS_ALIGNMENT - 1 );
+}
+
+//
+// Computes the size of a whole shared region
+//
+// Parameters:
+//  [in]    nSlotCount      The number of slots in the ring
+//  [in]    nSlotBytes      The maximum image size of a slot
+//
+// Returns:
+//  The region size in bytes
+//
+inline size_t SharedFrameBusSize( size_t nSlotCount, size_t nSlotBytes )
+{
+    return sizeof( SharedFrameBusHeader ) + nSlotCount * SharedFrameSlotStride( nSlotBytes );
+}
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,331 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        SharedFrameReader.h
+
+  Description: Header only reader for the shared frame bus, meant to be
+               included by external analysis processes. Frames are accessed
+               in place, without any copy:
+
+                   SharedFrameReader reader;
+                   if( reader.Open( "DEV_000F315B91E2" ) )
+                   {
+                       SharedFrameReader::FrameView frame;
+                       if( reader.Acquire( frame ) )
+                       {
+                           Analyze( frame.pImage, frame.nWidth, frame.nHeight );
+                           if( !reader.Release() )
+                           {
+                               // The publisher overwrote the slot meanwhile,
+                               // the analysis result must be discarded
+                           }
+                       }
+                   }
+
+               A reader that falls more than one ring behind skips ahead to
+               the oldest frame still available and counts what it missed.
+               Every acquired frame also yields the publish-to-acquire latency,
+               which makes the reader its own latency benchmark.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SHAREDFRAMEREADER
+#define AVT_VMBAPI_EXAMPLES_SHAREDFRAMEREADER
+
+#include <windows.h>
+#include <string>
+#include "SharedFrameLayout.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class SharedFrameReader
+{
+  public:
+    // A frame inside the shared region, valid until Release
+    struct FrameView
+    {
+        const unsigned char    *pImage;
+        unsigned long long      nSequence;
+        unsigned long long      nFrameID;
+        unsigned int            nWidth;
+        unsigned int            nHeight;
+        unsigned int            nPixelFormat;
+        unsigned int            nImageSize;
+        // Time from publishing to Acquire in microseconds
+        double                  dLatencyUs;
+    };
+
+    SharedFrameReader()
+        : m_hMapping( NULL )
+        , m_pRegion( NULL )
+        , m_pHeader( NULL )
+        , m_pCursor( NULL )
+        , m_nNextSequence( 0 )
+        , m_nSkippedFrames( 0 )
+        , m_nTornFrames( 0 )
+        , m_bAcquired( false )
+    {
+        LARGE_INTEGER nFrequency;
+        QueryPerformanceFrequency( &nFrequency );
+        m_dTicksToUs = 1e6 / static_cast<double>( nFrequency.QuadPart );
+        ResetLatency();
+    }
+
+    ~SharedFrameReader()
+    {
+        Close();
+    }
+
+    //
+    // Maps the bus of a camera and registers a reader cursor. Reading
+    // starts with the next frame that gets published.
+    //
+    // Parameters:
+    //  [in]    rStrCameraID    The ID of the camera as reported by Vimba
+    //
+    // Returns:
+    //  false if the bus does not exist (yet) or all cursors are taken
+    //
+    bool Open( const std::string &rStrCameraID )
+    {
+        Close();
+
+        std::wstring strName( SHARED_FRAME_BUS_NAME_PREFIX );
+        strName.append( rStrCameraID.begin(), rStrCameraID.end() );
+        m_hMapping = OpenFileMappingW( FILE_MAP_ALL_ACCESS, FALSE, strName.c_str() );
+        if( NULL == m_hMapping )
+        {
+            return false;
+        }
+        m_pRegion = static_cast<unsigned char*>( MapViewOfFile( m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0 ) );
+        if( NULL == m_pRegion )
+        {
+            Close();
+            return false;
+        }
+        m_pHeader = reinterpret_cast<SharedFrameBusHeader*>( m_pRegion );
+        if(     SHARED_FRAME_BUS_MAGIC != m_pHeader->nMagic
+            ||  SHARED_FRAME_BUS_VERSION != m_pHeader->nVersion )
+        {
+            Close();
+            return false;
+        }
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        for( unsigned int i = 0; i < SHARED_FRAME_BUS_MAX_READERS && NULL == m_pCursor; ++i )
+        {
+            unsigned int nFree = 0;
+            if( m_pHeader->readers[i].nInUse.compare_exchange_strong( nFree, 1 ) )
+            {
+                m_pCursor = &m_pHeader->readers[i];
+            }
+        }
+        if( NULL == m_pCursor )
+        {
+            Close();
+            return false;
+        }
+
+        m_nNextSequence = m_pHeader->nWriteSequence.load( std::memory_order_acquire );
+        m_nSkippedFrames = 0;
+        m_nTornFrames = 0;
+        m_pCursor->nSkippedFrames.store( 0 );
+        m_pCursor->nNextSequence.store( m_nNextSequence );
+        return true;
+    }
+
+    //
+    // Releases the reader cursor and unmaps the bus
+    //
+    void Close()
+    {
+        if( NULL != m_pCursor )
+        {
+            m_pCursor->nInUse.store( 0 );
+            m_pCursor = NULL;
+        }
+        if( NULL != m_pRegion )
+        {
+            UnmapViewOfFile( m_pRegion );
+            m_pRegion = NULL;
+            m_pHeader = NULL;
+        }
+        if( NULL != m_hMapping )
+        {
+            CloseHandle( m_hMapping );
+            m_hMapping = NULL;
+        }
+        m_bAcquired = false;
+    }
+
+    //
+    // Gets the next frame in place. A lagging reader skips to the oldest
+    // frame still in the ring.
+    //
+    // Parameters:
+    //  [out]   rFrame          The frame, valid until Release
+    //
+    // Returns:
+    //  false if no new frame has been published
+    //
+    bool Acquire( FrameView &rFrame )
+    {
+        if(     NULL == m_pHeader
+            ||  m_bAcquired )
+        {
+            return false;
+        }
+
+        const unsigned long long nSlotCount = m_pHeader->nSlotCount;
+        for( ;; )
+        {
+            const unsigned long long nHead = m_pHeader->nWriteSequence.load( std::memory_order_acquire );
+            if( m_nNextSequence >= nHead )
+            {
+                return false;
+            }
+            // The slot of frame nHead may be written right now, so only
+            // nSlotCount - 1 frames are safely behind the writer
+            if( nHead - m_nNextSequence > nSlotCount - 1 )
+            {
+                const unsigned long long nOldest = nHead - ( nSlotCount - 1 );
+                m_nSkippedFrames += nOldest - m_nNextSequence;
+                m_nNextSequence = nOldest;
+            }
+
+            const SharedFrameSlotHeader *pSlotHeader = GetSlotHeader( m_nNextSequence );
+            const unsigned long long nSequence = pSlotHeader->nSequence.load( std::memory_order_acquire );
+            if( 2 * m_nNextSequence + 2 != nSequence )
+            {
+                // Overtaken between reading the head and the slot
+                ++m_nSkippedFrames;
+                ++m_nNextSequence;
+                continue;
+            }
+
+            LARGE_INTEGER nNow;
+            QueryPerformanceCounter( &nNow );
+            rFrame.pImage       = reinterpret_cast<const unsigned char*>( pSlotHeader ) + sizeof( SharedFrameSlotHeader );
+            rFrame.nSequence    = m_nNextSequence;
+            rFrame.nFrameID     = pSlotHeader->nFrameID;
+            rFrame.nWidth       = pSlotHeader->nWidth;
+            rFrame.nHeight      = pSlotHeader->nHeight;
+            rFrame.nPixelFormat = pSlotHeader->nPixelFormat;
+            rFrame.nImageSize   = pSlotHeader->nImageSize;
+            rFrame.dLatencyUs   = ( nNow.QuadPart - pSlotHeader->nPublishTicks ) * m_dTicksToUs;
+            AddLatency( rFrame.dLatencyUs );
+            m_bAcquired = true;
+            return true;
+        }
+    }
+
+    //
+    // Ends the access to the acquired frame and moves on
+    //
+    // Returns:
+    //  false if the publisher overwrote the frame while it was in use
+    //
+    bool Release()
+    {
+        if( false == m_bAcquired )
+        {
+            return false;
+        }
+        std::atomic_thread_fence( std::memory_order_acquire );
+        const bool bValid = ( 2 * m_nNextSequence + 2 == GetSlotHeader( m_nNextSequence )->nSequence.load( std::memory_order_relaxed ) );
+        if( false == bValid )
+        {
+            ++m_nTornFrames;
+        }
+        ++m_nNextSequence;
+        m_bAcquired = false;
+
+        m_pCursor->nNextSequence.store( m_nNextSequence, std::memory_order_relaxed );
+        m_pCursor->nSkippedFrames.store( m_nSkippedFrames + m_nTornFrames, std::memory_order_relaxed );
+        return bValid;
+    }
+
+    // Frames never seen because the reader lagged behind
+    unsigned long long GetSkippedFrames() const     { return m_nSkippedFrames; }
+    // Frames overwritten while being read
+    unsigned long long GetTornFrames() const        { return m_nTornFrames; }
+
+    //
+    // Latency statistics of all frames acquired since the last reset
+    //
+    unsigned long long GetLatencyCount() const      { return m_nLatencyCount; }
+    double GetLatencyMinUs() const                  { return m_dLatencyMinUs; }
+    double GetLatencyMaxUs() const                  { return m_dLatencyMaxUs; }
+    double GetLatencyMeanUs() const                 { return 0 == m_nLatencyCount ? 0.0 : m_dLatencySumUs / m_nLatencyCount; }
+
+    void ResetLatency()
+    {
+        m_nLatencyCount = 0;
+        m_dLatencySumUs = 0.0;
+        m_dLatencyMinUs = 0.0;
+        m_dLatencyMaxUs = 0.0;
+    }
+
+  private:
+    // No copies, the object owns a mapping
+    SharedFrameReader( const SharedFrameReader& );
+    SharedFrameReader& operator=( const SharedFrameReader& );
+
+    const SharedFrameSlotHeader* GetSlotHeader( unsigned long long nSequence ) const
+    {
+        return reinterpret_cast<const SharedFrameSlotHeader*>(  m_pRegion + sizeof( SharedFrameBusHeader )
+                                                                + static_cast<size_t>( nSequence % m_pHeader->nSlotCount ) * m_pHeader->nSlotStride );
+    }
+
+    void AddLatency( double dLatencyUs )
+    {
+        if( 0 == m_nLatencyCount || dLatencyUs < m_dLatencyMinUs )
+        {
+            m_dLatencyMinUs = dLatencyUs;
+        }
+        if( 0 == m_nLatencyCount || dLatencyUs > m_dLatencyMaxUs )
+        {
+            m_dLatencyMaxUs = dLatencyUs;
+        }
+        m_dLatencySumUs += dLatencyUs;
+        ++m_nLatencyCount;
+    }
+
+    HANDLE                      m_hMapping;
+    unsigned char              *m_pRegion;
+    SharedFrameBusHeader       *m_pHeader;
+    SharedFrameReaderCursor    *m_pCursor;
+    unsigned long long          m_nNextSequence;
+    unsigned long long          m_nSkippedFrames;
+    unsigned long long          m_nTornFrames;
+    bool                        m_bAcquired;
+    double                      m_dTicksToUs;
+    unsigned long long          m_nLatencyCount;
+    double                      m_dLatencySumUs;
+    double                      m_dLatencyMinUs;
+    double                      m_dLatencyMaxUs;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,279 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Sharpness.cpp
+
+  Description: Sharpness of an image region for focusing a lens: the
+               variance of the Laplacian and the Tenengrad measure.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <Sharpness.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_SHARPNESS_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+// 16 pixel steps summed in unsigned 32 bit lanes before they are moved to
+// 64 bit. A lane gets at most 4 * 2040^2 squares per step.
+enum { LANE_FLUSH_STEPS = 128, };
+
+namespace {
+
+struct StripeAccumulator
+{
+    VmbInt64_t      nLaplacianSum;
+    VmbUint64_t     nLaplacianSquares;
+    VmbUint64_t     nGradientSquares;
+};
+
+// The pixels of one color plane: every nPixelStep bytes of every nRowStep rows
+struct Plane
+{
+    const VmbUchar_t   *pBuffer;
+    VmbUint32_t         nWidth;
+    VmbUint32_t         nHeight;
+    size_t              nRowBytes;
+    VmbUint32_t         nPixelStep;
+};
+
+template <typename T>
+inline int PixelAt( const VmbUchar_t *pRow, VmbUint32_t nPixelStep, VmbUint32_t x )
+{
+    return *reinterpret_cast<const T*>( pRow + static_cast<size_t>( x ) * nPixelStep );
+}
+
+// Adds the columns nFirst to nEnd of an interior row
+template <typename T>
+void AccumulateColumns( const Plane &rPlane, VmbUint32_t y, VmbUint32_t nFirst, VmbUint32_t nEnd, StripeAccumulator &rAccumulator )
+{
+    const VmbUchar_t *pUp   = rPlane.pBuffer + ( y - 1 ) * rPlane.nRowBytes;
+    const VmbUchar_t *pMid  = pUp + rPlane.nRowBytes;
+    const VmbUchar_t *pDown = pMid + rPlane.nRowBytes;
+    const VmbUint32_t s = rPlane.nPixelStep;
+    VmbInt64_t nLaplacianSum = 0;
+    VmbUint64_t nLaplacianSquares = 0;
+    VmbUint64_t nGradientSquares = 0;
+    for( VmbUint32_t x = nFirst; x < nEnd; ++x )
+    {
+        const VmbInt64_t ul = PixelAt<T>( pUp, s, x - 1 ),   u = PixelAt<T>( pUp, s, x ),   ur = PixelAt<T>( pUp, s, x + 1 );
+        const VmbInt64_t l  = PixelAt<T>( pMid, s, x - 1 ),  c = PixelAt<T>( pMid, s, x ),  r  = PixelAt<T>( pMid, s, x + 1 );
+        const VmbInt64_t dl = PixelAt<T>( pDown, s, x - 1 ), d = PixelAt<T>( pDown, s, x ), dr = PixelAt<T>( pDown, s, x + 1 );
+        const VmbInt64_t nLaplacian = 4 * c - l - r - u - d;
+        const VmbInt64_t gx = ( ur + 2 * r + dr ) - ( ul + 2 * l + dl );
+        const VmbInt64_t gy = ( dl + 2 * d + dr ) - ( ul + 2 * u + ur );
+        nLaplacianSum       += nLaplacian;
+        nLaplacianSquares   += static_cast<VmbUint64_t>( nLaplacian * nLaplacian );
+        nGradientSquares    += static_cast<VmbUint64_t>( gx * gx + gy * gy );
+    }
+    rAccumulator.nLaplacianSum      += nLaplacianSum;
+    rAccumulator.nLaplacianSquares  += nLaplacianSquares;
+    rAccumulator.nGradientSquares   += nGradientSquares;
+}
+
+#ifdef AVT_SHARPNESS_SSE2
+inline VmbUint64_t HorizontalSum( __m128i v )
+{
+    VmbUint32_t lanes[4];
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), v );
+    return static_cast<VmbUint64_t>( lanes[0] ) + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Both halves of 16 loaded pixels in 16 bit lanes
+struct Widened
+{
+    __m128i low;
+    __m128i high;
+};
+
+inline Widened Load16( const VmbUchar_t *p )
+{
+    const __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( p ) );
+    Widened pixels = { _mm_unpacklo_epi8( bytes, _mm_setzero_si128() ), _mm_unpackhi_epi8( bytes, _mm_setzero_si128() ) };
+    return pixels;
+}
+
+inline void AccumulateLanes(  __m128i ul, __m128i u, __m128i ur,
+                              __m128i l,  __m128i c, __m128i r,
+                              __m128i dl, __m128i d, __m128i dr,
+                              __m128i &rLaplacianSum, __m128i &rLaplacianSquares, __m128i &rGradientSquares )
+{
+    const __m128i laplacian = _mm_sub_epi16( _mm_slli_epi16( c, 2 ), _mm_add_epi16( _mm_add_epi16( l, r ), _mm_add_epi16( u, d ) ) );
+    const __m128i gx = _mm_sub_epi16(   _mm_add_epi16( _mm_add_epi16( ur, dr ), _mm_slli_epi16( r, 1 ) ),
+                                        _mm_add_epi16( _mm_add_epi16( ul, dl ), _mm_slli_epi16( l, 1 ) ) );
+    const __m128i gy = _mm_sub_epi16(   _mm_add_epi16( _mm_add_epi16( dl, dr ), _mm_slli_epi16( d, 1 ) ),
+                                        _mm_add_epi16( _mm_add_epi16( ul, ur ), _mm_slli_epi16( u, 1 ) ) );
+    rLaplacianSum       = _mm_add_epi32( rLaplacianSum, _mm_madd_epi16( laplacian, _mm_set1_epi16( 1 ) ) );
+    rLaplacianSquares   = _mm_add_epi32( rLaplacianSquares, _mm_madd_epi16( laplacian, laplacian ) );
+    rGradientSquares    = _mm_add_epi32( rGradientSquares, _mm_add_epi32( _mm_madd_epi16( gx, gx ), _mm_madd_epi16( gy, gy ) ) );
+}
+
+// An interior row of 8 bit mono, 16 pixels per step in two halves of 16 bit lanes
+void AccumulateRow8( const Plane &rPlane, VmbUint32_t y, StripeAccumulator &rAccumulator )
+{
+    const VmbUchar_t *pUp   = rPlane.pBuffer + ( y - 1 ) * rPlane.nRowBytes;
+    const VmbUchar_t *pMid  = pUp + rPlane.nRowBytes;
+    const VmbUchar_t *pDown = pMid + rPlane.nRowBytes;
+    // Loads reach one pixel to the right of the 16 pixels of a step
+    const VmbUint32_t nVectorEnd = rPlane.nWidth >= 18 ? 1 + ( ( rPlane.nWidth - 2 ) / 16 ) * 16 : 1;
+    VmbUint32_t x = 1;
+    while( x < nVectorEnd )
+    {
+        __m128i laplacianSum        = _mm_setzero_si128();
+        __m128i laplacianSquares    = _mm_setzero_si128();
+        __m128i gradientSquares     = _mm_setzero_si128();
+        const VmbUint32_t nBlockEnd = (std::min)( nVectorEnd, x + 16 * LANE_FLUSH_STEPS );
+        for( ; x < nBlockEnd; x += 16 )
+        {
+            const Widened ul = Load16( pUp + x - 1 ),   u = Load16( pUp + x ),   ur = Load16( pUp + x + 1 );
+            const Widened l  = Load16( pMid + x - 1 ),  c = Load16( pMid + x ),  r  = Load16( pMid + x + 1 );
+            const Widened dl = Load16( pDown + x - 1 ), d = Load16( pDown + x ), dr = Load16( pDown + x + 1 );
+            AccumulateLanes(    ul.low, u.low, ur.low, l.low, c.low, r.low, dl.low, d.low, dr.low,
+                                laplacianSum, laplacianSquares, gradientSquares );
+            AccumulateLanes(    ul.high, u.high, ur.high, l.high, c.high, r.high, dl.high, d.high, dr.high,
+                                laplacianSum, laplacianSquares, gradientSquares );
+        }
+        // The sum is signed, the lanes are added as such
+        VmbInt32_t sums[4];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( sums ), laplacianSum );
+        rAccumulator.nLaplacianSum      += static_cast<VmbInt64_t>( sums[0] ) + sums[1] + sums[2] + sums[3];
+        rAccumulator.nLaplacianSquares  += HorizontalSum( laplacianSquares );
+        rAccumulator.nGradientSquares   += HorizontalSum( gradientSquares );
+    }
+    AccumulateColumns<VmbUchar_t>( rPlane, y, x, rPlane.nWidth - 1, rAccumulator );
+}
+#endif
+
+template <typename T>
+void AccumulateStripe( const Plane &rPlane, VmbUint32_t nFirstRow, VmbUint32_t nEndRow, StripeAccumulator &rAccumulator )
+{
+    for( VmbUint32_t y = nFirstRow; y < nEndRow; ++y )
+    {
+#ifdef AVT_SHARPNESS_SSE2
+        if( 1 == sizeof( T ) && 1 == rPlane.nPixelStep )
+        {
+            AccumulateRow8( rPlane, y, rAccumulator );
+            continue;
+        }
+#endif
+        AccumulateColumns<T>( rPlane, y, 1, rPlane.nWidth - 1, rAccumulator );
+    }
+}
+
+}
+
+//
+// Measures the sharpness of an image, e.g. a region cropped from a frame.
+// Color images are measured by their green channel, Bayer images by one
+// color of the mosaic. The rows are split into stripes that run on the pool.
+//
+// Parameters:
+//  [in]    rView           The image
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   rMeasure        The sharpness, nFrameID is left to the caller
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support,
+//  VmbErrorBadParameter for images too small for a 3x3 neighbourhood
+//
+VmbErrorType ComputeSharpness( const ImageView &rView, ThreadPool *pPool, SharpnessMeasure &rMeasure )
+{
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rView.ePixelFormat );
+    const VmbUint32_t nBitDepth = GetBitDepth( rView.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+
+    // Neighbouring pixels of a Bayer mosaic have different colors, the
+    // measures are taken on the color at the first pixel only
+    const bool bIsBayer = 1 == nBytesPerPixel && VmbPixelFormatMono8 != rView.ePixelFormat;
+    const VmbUint32_t nSkip = bIsBayer ? 2 : 1;
+    Plane plane;
+    plane.pBuffer       = rView.pBuffer + ( 3 == nBytesPerPixel ? 1 : 0 );
+    plane.nWidth        = rView.nWidth / nSkip;
+    plane.nHeight       = rView.nHeight / nSkip;
+    plane.nRowBytes     = static_cast<size_t>( rView.nStride ) * nSkip;
+    plane.nPixelStep    = nBytesPerPixel * nSkip;
+    if(     NULL == rView.pBuffer
+        ||  plane.nWidth < 3
+        ||  plane.nHeight < 3 )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    const VmbUint32_t nRows = plane.nHeight - 2;
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, nRows / MIN_STRIPE_ROWS ) );
+    std::vector<StripeAccumulator> accumulators( nStripes );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        StripeAccumulator &rAccumulator = accumulators[nStripe];
+        rAccumulator.nLaplacianSum      = 0;
+        rAccumulator.nLaplacianSquares  = 0;
+        rAccumulator.nGradientSquares   = 0;
+        const VmbUint32_t nFirstRow = 1 + nRows * nStripe / nStripes;
+        const VmbUint32_t nEndRow   = 1 + nRows * ( nStripe + 1 ) / nStripes;
+        if( 2 == nBytesPerPixel )
+        {
+            AccumulateStripe<VmbUint16_t>( plane, nFirstRow, nEndRow, rAccumulator );
+        }
+        else
+        {
+            AccumulateStripe<VmbUchar_t>( plane, nFirstRow, nEndRow, rAccumulator );
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+
+    VmbInt64_t nLaplacianSum = 0;
+    double dLaplacianSquares = 0.0;
+    double dGradientSquares = 0.0;
+    for( VmbUint32_t i = 0; i < nStripes; ++i )
+    {
+        nLaplacianSum       += accumulators[i].nLaplacianSum;
+        dLaplacianSquares   += static_cast<double>( accumulators[i].nLaplacianSquares );
+        dGradientSquares    += static_cast<double>( accumulators[i].nGradientSquares );
+    }
+    rMeasure.nPixels = static_cast<VmbUint64_t>( nRows ) * ( plane.nWidth - 2 );
+    const double dPixels = static_cast<double>( rMeasure.nPixels );
+    // Squares of wider pixels are scaled back to 8 bit values
+    const double dScale = 1.0 / static_cast<double>( 1u << ( 2 * ( nBitDepth - 8 ) ) );
+    const double dLaplacianMean = nLaplacianSum / dPixels;
+    rMeasure.dLaplacianVariance = ( dLaplacianSquares / dPixels - dLaplacianMean * dLaplacianMean ) * dScale;
+    rMeasure.dTenengrad         = dGradientSquares / dPixels * dScale;
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
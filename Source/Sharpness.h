@@ -0,0 +1,75 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        Sharpness.h
+
+  Description: Sharpness of an image region for focusing a lens: the
+               variance of the Laplacian and the Tenengrad measure.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_SHARPNESS
+#define AVT_VMBAPI_EXAMPLES_SHARPNESS
+
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Both measures grow with the contrast of edges, so they peak when the
+// lens is in focus. They are scaled to 8 bit pixel values, so cameras of
+// different bit depths compare.
+//
+struct SharpnessMeasure
+{
+    VmbUint64_t     nFrameID;
+    // Variance of the 4-neighbour Laplacian
+    double          dLaplacianVariance;
+    // Mean squared Sobel gradient magnitude
+    double          dTenengrad;
+    // Pixels the measures were taken at, the border of the region is left out
+    VmbUint64_t     nPixels;
+};
+
+//
+// Measures the sharpness of an image, e.g. a region cropped from a frame.
+// Color images are measured by their green channel, Bayer images by one
+// color of the mosaic. The rows are split into stripes that run on the pool.
+//
+// Parameters:
+//  [in]    rView           The image
+//  [in]    pPool           The pool to run the stripes on, NULL for the calling thread only
+//  [out]   rMeasure        The sharpness, nFrameID is left to the caller
+//
+// Returns:
+//  VmbErrorWrongType for pixel formats the views do not support,
+//  VmbErrorBadParameter for images too small for a 3x3 neighbourhood
+//
+VmbErrorType ComputeSharpness( const ImageView &rView, ThreadPool *pPool, SharpnessMeasure &rMeasure );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,307 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        TemporalAverage.cpp
+
+  Description: Temporal averaging of frames: rolling per sample sums of the
+               last frames, updated by the newest and the oldest frame.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <functional>
+#include <TemporalAverage.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_TEMPORALAVERAGE_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+
+namespace {
+
+// The mean of a sum, rounded. The vector code rounds the same way.
+inline VmbUint32_t GetMean( VmbUint32_t nSum, float fInverse )
+{
+    return static_cast<VmbUint32_t>( static_cast<float>( nSum ) * fInverse + 0.5f );
+}
+
+template <typename T, typename S>
+void UpdateRowScalar( const T *pNewest, const T *pOldest, S *pSums, VmbUint32_t nFirst, VmbUint32_t nEnd, float fInverse, T *pTarget )
+{
+    for( VmbUint32_t i = nFirst; i < nEnd; ++i )
+    {
+        S nSum = static_cast<S>( pSums[i] + pNewest[i] );
+        if( NULL != pOldest )
+        {
+            nSum = static_cast<S>( nSum - pOldest[i] );
+        }
+        pSums[i] = nSum;
+        pTarget[i] = static_cast<T>( GetMean( nSum, fInverse ) );
+    }
+}
+
+#ifdef AVT_TEMPORALAVERAGE_SSE2
+inline __m128i GetMeans( __m128i sums, __m128 inverse, __m128 half )
+{
+    return _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( sums ), inverse ), half ) );
+}
+#endif
+
+void UpdateRow8( const VmbUchar_t *pNewest, const VmbUchar_t *pOldest, VmbUint16_t *pSums, VmbUint32_t nSamples, float fInverse, VmbUchar_t *pTarget )
+{
+    VmbUint32_t i = 0;
+#ifdef AVT_TEMPORALAVERAGE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 inverse = _mm_set1_ps( fInverse );
+    const __m128 half = _mm_set1_ps( 0.5f );
+    for( ; i + 16 <= nSamples; i += 16 )
+    {
+        const __m128i newest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pNewest + i ) );
+        __m128i sums[2] = { _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSums + i ) ),
+                            _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSums + i + 8 ) ) };
+        sums[0] = _mm_add_epi16( sums[0], _mm_unpacklo_epi8( newest, zero ) );
+        sums[1] = _mm_add_epi16( sums[1], _mm_unpackhi_epi8( newest, zero ) );
+        if( NULL != pOldest )
+        {
+            const __m128i oldest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pOldest + i ) );
+            sums[0] = _mm_sub_epi16( sums[0], _mm_unpacklo_epi8( oldest, zero ) );
+            sums[1] = _mm_sub_epi16( sums[1], _mm_unpackhi_epi8( oldest, zero ) );
+        }
+        __m128i means[2];
+        for( int h = 0; h < 2; ++h )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( pSums + i + 8 * h ), sums[h] );
+            // Means of 8 bit samples fit the signed packing
+            means[h] = _mm_packs_epi32( GetMeans( _mm_unpacklo_epi16( sums[h], zero ), inverse, half ),
+                                        GetMeans( _mm_unpackhi_epi16( sums[h], zero ), inverse, half ) );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pTarget + i ), _mm_packus_epi16( means[0], means[1] ) );
+    }
+#endif
+    UpdateRowScalar<VmbUchar_t, VmbUint16_t>( pNewest, pOldest, pSums, i, nSamples, fInverse, pTarget );
+}
+
+void UpdateRow16( const VmbUint16_t *pNewest, const VmbUint16_t *pOldest, VmbUint32_t *pSums, VmbUint32_t nSamples, float fInverse, VmbUint16_t *pTarget )
+{
+    VmbUint32_t i = 0;
+#ifdef AVT_TEMPORALAVERAGE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias32 = _mm_set1_epi32( 0x8000 );
+    const __m128i bias16 = _mm_set1_epi16( static_cast<short>( 0x8000 ) );
+    const __m128 inverse = _mm_set1_ps( fInverse );
+    const __m128 half = _mm_set1_ps( 0.5f );
+    for( ; i + 8 <= nSamples; i += 8 )
+    {
+        const __m128i newest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pNewest + i ) );
+        __m128i sums[2] = { _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSums + i ) ),
+                            _mm_loadu_si128( reinterpret_cast<const __m128i*>( pSums + i + 4 ) ) };
+        sums[0] = _mm_add_epi32( sums[0], _mm_unpacklo_epi16( newest, zero ) );
+        sums[1] = _mm_add_epi32( sums[1], _mm_unpackhi_epi16( newest, zero ) );
+        if( NULL != pOldest )
+        {
+            const __m128i oldest = _mm_loadu_si128( reinterpret_cast<const __m128i*>( pOldest + i ) );
+            sums[0] = _mm_sub_epi32( sums[0], _mm_unpacklo_epi16( oldest, zero ) );
+            sums[1] = _mm_sub_epi32( sums[1], _mm_unpackhi_epi16( oldest, zero ) );
+        }
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pSums + i ), sums[0] );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pSums + i + 4 ), sums[1] );
+        // SSE2 only packs signed, so the means are shifted into its range and back
+        const __m128i means = _mm_packs_epi32(  _mm_sub_epi32( GetMeans( sums[0], inverse, half ), bias32 ),
+                                                _mm_sub_epi32( GetMeans( sums[1], inverse, half ), bias32 ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( pTarget + i ), _mm_xor_si128( means, bias16 ) );
+    }
+#endif
+    UpdateRowScalar<VmbUint16_t, VmbUint32_t>( pNewest, pOldest, pSums, i, nSamples, fInverse, pTarget );
+}
+
+template <typename T, typename S>
+void RemoveRows( const ImageView &rOldest, VmbUint32_t nRowSamples, S *pSums )
+{
+    for( VmbUint32_t y = 0; y < rOldest.nHeight; ++y )
+    {
+        const T *pRow = reinterpret_cast<const T*>( rOldest.pBuffer + static_cast<size_t>( y ) * rOldest.nStride );
+        S *pRowSums = pSums + static_cast<size_t>( y ) * nRowSamples;
+        for( VmbUint32_t i = 0; i < nRowSamples; ++i )
+        {
+            pRowSums[i] = static_cast<S>( pRowSums[i] - pRow[i] );
+        }
+    }
+}
+
+} // namespace
+
+FrameAccumulator::FrameAccumulator()
+    : m_nWidth( 0 )
+    , m_nHeight( 0 )
+    , m_ePixelFormat( VmbPixelFormatMono8 )
+    , m_nRowSamples( 0 )
+{
+}
+
+//
+// Starts over with no frames, for frames like the one described
+//
+// Parameters:
+//  [in]    rLayout         Size and format of the frames to come
+//
+// Returns:
+//  VmbErrorWrongType for packed formats
+//
+VmbErrorType FrameAccumulator::Reset( const ImageView &rLayout )
+{
+    Clear();
+    const VmbUint32_t nBytesPerPixel = GetBytesPerPixel( rLayout.ePixelFormat );
+    if( 0 == nBytesPerPixel )
+    {
+        return VmbErrorWrongType;
+    }
+    m_nWidth = rLayout.nWidth;
+    m_nHeight = rLayout.nHeight;
+    m_ePixelFormat = rLayout.ePixelFormat;
+    m_nRowSamples = rLayout.nWidth * ( 3 == nBytesPerPixel ? 3 : 1 );
+    const size_t nSamples = static_cast<size_t>( m_nRowSamples ) * m_nHeight;
+    if( 2 == nBytesPerPixel )
+    {
+        m_Sums32.assign( nSamples, 0 );
+    }
+    else
+    {
+        m_Sums16.assign( nSamples, 0 );
+    }
+    return VmbErrorSuccess;
+}
+
+// Frees the sums
+void FrameAccumulator::Clear()
+{
+    std::vector<VmbUint16_t>().swap( m_Sums16 );
+    std::vector<VmbUint32_t>().swap( m_Sums32 );
+    m_nWidth = 0;
+    m_nHeight = 0;
+    m_nRowSamples = 0;
+}
+
+//
+// Whether frames like this one can be summed without a Reset
+//
+bool FrameAccumulator::Matches( const ImageView &rView ) const
+{
+    return      ( !m_Sums16.empty() || !m_Sums32.empty() )
+            &&  rView.nWidth == m_nWidth
+            &&  rView.nHeight == m_nHeight
+            &&  rView.ePixelFormat == m_ePixelFormat;
+}
+
+//
+// Adds the newest frame, takes out the oldest one and writes the mean
+// of the frames summed then
+//
+// Parameters:
+//  [in]    rNewest         The frame to add
+//  [in]    pOldest         The frame to take out, NULL while the window fills
+//  [in]    nFrames         The number of frames summed after the update
+//  [in]    pPool           The pool to spread the frame over, may be NULL
+//  [out]   pTarget         The mean, with the stride of rNewest
+//
+// Returns:
+//  VmbErrorBadParameter if a frame does not match or nFrames is out of range
+//
+VmbErrorType FrameAccumulator::Update( const ImageView &rNewest, const ImageView *pOldest, VmbUint32_t nFrames, ThreadPool *pPool, VmbUchar_t *pTarget )
+{
+    if(     !Matches( rNewest )
+        ||  ( NULL != pOldest && !Matches( *pOldest ) )
+        ||  0 == nFrames
+        ||  nFrames > MAX_FRAMES
+        ||  NULL == rNewest.pBuffer
+        ||  NULL == pTarget )
+    {
+        return VmbErrorBadParameter;
+    }
+    const float fInverse = 1.0f / static_cast<float>( nFrames );
+    const bool bIs16Bit = !m_Sums32.empty();
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, m_nHeight / MIN_STRIPE_ROWS ) );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nEndRow = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( m_nHeight ) * ( nStripe + 1 ) / nStripes );
+        for( VmbUint32_t y = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( m_nHeight ) * nStripe / nStripes ); y < nEndRow; ++y )
+        {
+            const size_t nRowOffset = static_cast<size_t>( y ) * rNewest.nStride;
+            const VmbUchar_t *pOldestRow = NULL == pOldest ? NULL : pOldest->pBuffer + static_cast<size_t>( y ) * pOldest->nStride;
+            const size_t nSumOffset = static_cast<size_t>( y ) * m_nRowSamples;
+            if( bIs16Bit )
+            {
+                UpdateRow16(    reinterpret_cast<const VmbUint16_t*>( rNewest.pBuffer + nRowOffset ),
+                                reinterpret_cast<const VmbUint16_t*>( pOldestRow ),
+                                &m_Sums32[nSumOffset], m_nRowSamples, fInverse,
+                                reinterpret_cast<VmbUint16_t*>( pTarget + nRowOffset ) );
+            }
+            else
+            {
+                UpdateRow8( rNewest.pBuffer + nRowOffset, pOldestRow, &m_Sums16[nSumOffset], m_nRowSamples, fInverse, pTarget + nRowOffset );
+            }
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+    return VmbErrorSuccess;
+}
+
+//
+// Takes out a frame without adding one, e.g. when the window shrinks
+//
+// Parameters:
+//  [in]    rOldest         The frame to take out
+//
+// Returns:
+//  VmbErrorBadParameter if the frame does not match
+//
+VmbErrorType FrameAccumulator::Remove( const ImageView &rOldest )
+{
+    if(     !Matches( rOldest )
+        ||  NULL == rOldest.pBuffer )
+    {
+        return VmbErrorBadParameter;
+    }
+    if( !m_Sums32.empty() )
+    {
+        RemoveRows<VmbUint16_t, VmbUint32_t>( rOldest, m_nRowSamples, &m_Sums32[0] );
+    }
+    else
+    {
+        RemoveRows<VmbUchar_t, VmbUint16_t>( rOldest, m_nRowSamples, &m_Sums16[0] );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
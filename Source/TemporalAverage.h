@@ -0,0 +1,115 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        TemporalAverage.h
+
+  Description: Temporal averaging of frames: rolling per sample sums of the
+               last frames, updated by the newest and the oldest frame.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_TEMPORALAVERAGE
+#define AVT_VMBAPI_EXAMPLES_TEMPORALAVERAGE
+
+#include <vector>
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// The sum of every sample over the frames of a window. 8 bit samples are
+// summed in 16 bit, all others in 32 bit. A new frame is added while the
+// oldest is taken out in the same pass, which also writes the mean, so
+// the cost does not depend on the length of the window.
+//
+class FrameAccumulator
+{
+  public:
+    // 16 bit sums of 8 bit samples hold this many frames
+    enum { MAX_FRAMES = 256, };
+
+    FrameAccumulator();
+
+    //
+    // Starts over with no frames, for frames like the one described
+    //
+    // Parameters:
+    //  [in]    rLayout         Size and format of the frames to come
+    //
+    // Returns:
+    //  VmbErrorWrongType for packed formats
+    //
+    VmbErrorType        Reset( const ImageView &rLayout );
+
+    // Frees the sums
+    void                Clear();
+
+    //
+    // Whether frames like this one can be summed without a Reset
+    //
+    bool                Matches( const ImageView &rView ) const;
+
+    //
+    // Adds the newest frame, takes out the oldest one and writes the mean
+    // of the frames summed then
+    //
+    // Parameters:
+    //  [in]    rNewest         The frame to add
+    //  [in]    pOldest         The frame to take out, NULL while the window fills
+    //  [in]    nFrames         The number of frames summed after the update
+    //  [in]    pPool           The pool to spread the frame over, may be NULL
+    //  [out]   pTarget         The mean, with the stride of rNewest
+    //
+    // Returns:
+    //  VmbErrorBadParameter if a frame does not match or nFrames is out of range
+    //
+    VmbErrorType        Update( const ImageView &rNewest, const ImageView *pOldest, VmbUint32_t nFrames, ThreadPool *pPool, VmbUchar_t *pTarget );
+
+    //
+    // Takes out a frame without adding one, e.g. when the window shrinks
+    //
+    // Parameters:
+    //  [in]    rOldest         The frame to take out
+    //
+    // Returns:
+    //  VmbErrorBadParameter if the frame does not match
+    //
+    VmbErrorType        Remove( const ImageView &rOldest );
+
+  private:
+    VmbUint32_t                 m_nWidth;
+    VmbUint32_t                 m_nHeight;
+    VmbPixelFormatType          m_ePixelFormat;
+    // The samples of a row, a color pixel has three
+    VmbUint32_t                 m_nRowSamples;
+    // Only one of them is used, by the size of a sample
+    std::vector<VmbUint16_t>    m_Sums16;
+    std::vector<VmbUint32_t>    m_Sums32;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
@@ -0,0 +1,177 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ThreadPool.cpp
+
+  Description: A fixed size pool of worker threads for camera operations and
+               image processing that should run in parallel.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <exception>
+#include <memory>
+#include <ThreadPool.h>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+//
+// Starts the worker threads
+//
+// Parameters:
+//  [in]    nThreads        The number of workers, 0 for one per core
+//
+ThreadPool::ThreadPool( unsigned int nThreads )
+    : m_bShutDown( false )
+{
+    if( 0 == nThreads )
+    {
+        nThreads = std::thread::hardware_concurrency();
+        if( 0 == nThreads )
+        {
+            nThreads = 2;
+        }
+    }
+    for( unsigned int i = 0; i < nThreads; ++i )
+    {
+        m_Workers.push_back( std::thread( &ThreadPool::WorkerThread, this ) );
+    }
+}
+
+//
+// Runs all queued tasks to completion and joins the workers
+//
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_TasksMutex );
+        m_bShutDown = true;
+    }
+    m_TasksCondition.notify_all();
+    for( size_t i = 0; i < m_Workers.size(); ++i )
+    {
+        m_Workers[i].join();
+    }
+}
+
+//
+// Queues a task
+//
+// Parameters:
+//  [in]    task            The task to run on one of the workers
+//
+// Returns:
+//  A future that is ready once the task has run. Exceptions thrown by
+//  the task are rethrown by its get().
+//
+std::future<void> ThreadPool::Submit( const TaskType &task )
+{
+    // std::function needs a copyable target, so the packaged task is shared
+    std::shared_ptr< std::packaged_task<void()> > pTask( new std::packaged_task<void()>( task ) );
+    std::future<void> result = pTask->get_future();
+    {
+        std::lock_guard<std::mutex> lock( m_TasksMutex );
+        m_Tasks.push_back( [pTask]() { ( *pTask )(); } );
+    }
+    m_TasksCondition.notify_one();
+    return result;
+}
+
+//
+// Runs fn( 0 ) ... fn( nCount - 1 ) spread over the workers and the
+// calling thread and returns when all of them are done. The first
+// exception thrown by fn is rethrown after that.
+//
+// Parameters:
+//  [in]    nCount          The number of work items (e.g. image stripes)
+//  [in]    fn              The function to run for every item
+//
+void ThreadPool::ParallelFor( unsigned int nCount, const std::function<void( unsigned int )> &fn )
+{
+    if( 0 == nCount )
+    {
+        return;
+    }
+    std::vector< std::future<void> > pending;
+    pending.reserve( nCount - 1 );
+    for( unsigned int i = 1; i < nCount; ++i )
+    {
+        pending.push_back( Submit( [&fn, i]() { fn( i ); } ) );
+    }
+    // The caller would only wait otherwise, so it takes the first item.
+    // The tasks refer to fn, so every one of them has to be done before
+    // an exception may leave this function.
+    std::exception_ptr pError;
+    try
+    {
+        fn( 0 );
+    }
+    catch( ... )
+    {
+        pError = std::current_exception();
+    }
+    for( size_t i = 0; i < pending.size(); ++i )
+    {
+        try
+        {
+            pending[i].get();
+        }
+        catch( ... )
+        {
+            if( !pError )
+            {
+                pError = std::current_exception();
+            }
+        }
+    }
+    if( pError )
+    {
+        std::rethrow_exception( pError );
+    }
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+    return static_cast<unsigned int>( m_Workers.size() );
+}
+
+void ThreadPool::WorkerThread()
+{
+    for( ;; )
+    {
+        TaskType task;
+        {
+            std::unique_lock<std::mutex> lock( m_TasksMutex );
+            m_TasksCondition.wait( lock, [this] { return m_bShutDown || !m_Tasks.empty(); } );
+            if( m_Tasks.empty() )
+            {
+                // Shut down and nothing left to do
+                return;
+            }
+            task = m_Tasks.front();
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
+
+}}} // namespace AVT::VmbAPI::Examples
@@ -0,0 +1,103 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        ThreadPool.h
+
+  Description: A fixed size pool of worker threads for camera operations and
+               image processing that should run in parallel.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_THREADPOOL
+#define AVT_VMBAPI_EXAMPLES_THREADPOOL
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+class ThreadPool
+{
+  public:
+    typedef std::function<void()> TaskType;
+
+    //
+    // Starts the worker threads
+    //
+    // Parameters:
+    //  [in]    nThreads        The number of workers, 0 for one per core
+    //
+    explicit ThreadPool( unsigned int nThreads = 0 );
+
+    //
+    // Runs all queued tasks to completion and joins the workers
+    //
+    ~ThreadPool();
+
+    //
+    // Queues a task
+    //
+    // Parameters:
+    //  [in]    task            The task to run on one of the workers
+    //
+    // Returns:
+    //  A future that is ready once the task has run. Exceptions thrown by
+    //  the task are rethrown by its get().
+    //
+    std::future<void> Submit( const TaskType &task );
+
+    //
+    // Runs fn( 0 ) ... fn( nCount - 1 ) spread over the workers and the
+    // calling thread and returns when all of them are done. The first
+    // exception thrown by fn is rethrown after that.
+    //
+    // Parameters:
+    //  [in]    nCount          The number of work items (e.g. image stripes)
+    //  [in]    fn              The function to run for every item
+    //
+    void ParallelFor( unsigned int nCount, const std::function<void( unsigned int )> &fn );
+
+    unsigned int GetThreadCount() const;
+
+  private:
+    // No copies, the object owns threads
+    ThreadPool( const ThreadPool& );
+    ThreadPool& operator=( const ThreadPool& );
+
+    void WorkerThread();
+
+    std::vector<std::thread>    m_Workers;
+    std::deque<TaskType>        m_Tasks;
+    std::mutex                  m_TasksMutex;
+    std::condition_variable     m_TasksCondition;
+    bool                        m_bShutDown;
+};
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
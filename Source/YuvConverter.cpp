@@ -0,0 +1,461 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        YuvConverter.cpp
+
+  Description: Conversion of frames to the planar YUV 4:2:0 layouts video
+               encoders take, NV12 and I420.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <YuvConverter.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __SSE2__ )
+#include <emmintrin.h>
+#define AVT_YUVCONVERTER_SSE2
+#endif
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+// Fewer rows are not worth a task of their own
+enum { MIN_STRIPE_ROWS = 32, };
+// The matrix is fixed point with this many bits of fraction
+enum { YUV_COEFFICIENT_BITS = 14, };
+// Chroma is computed from the sum of 2 x 2 pixels
+enum { YUV_CHROMA_BITS = YUV_COEFFICIENT_BITS + 2, };
+
+YuvSettings::YuvSettings()
+    : eLayout( YuvLayoutNv12 )
+    , eMatrix( YuvMatrixBt709 )
+    , eRange( YuvRangeLimited )
+{
+}
+
+namespace {
+
+//
+// Y = ( R * nYr + G * nYg + B * nYb + nYBias ) >> YUV_COEFFICIENT_BITS,
+// U and V alike from the sums of 2 x 2 pixels >> YUV_CHROMA_BITS. The
+// green coefficients are what is left of the rounded others, so gray
+// has no chroma and full white is full scale.
+//
+struct YuvCoefficients
+{
+    VmbInt32_t  nYr;
+    VmbInt32_t  nYg;
+    VmbInt32_t  nYb;
+    VmbInt32_t  nUr;
+    VmbInt32_t  nUg;
+    VmbInt32_t  nUb;
+    VmbInt32_t  nVr;
+    VmbInt32_t  nVg;
+    VmbInt32_t  nVb;
+    // The offset and the rounding
+    VmbInt32_t  nYBias;
+    VmbInt32_t  nCBias;
+};
+
+VmbInt32_t ToFixedPoint( double dValue )
+{
+    const double dScaled = dValue * ( 1 << YUV_COEFFICIENT_BITS );
+    return static_cast<VmbInt32_t>( dScaled < 0.0 ? dScaled - 0.5 : dScaled + 0.5 );
+}
+
+YuvCoefficients GetCoefficients( const YuvSettings &rSettings )
+{
+    const double dKr = YuvMatrixBt601 == rSettings.eMatrix ? 0.299 : 0.2126;
+    const double dKb = YuvMatrixBt601 == rSettings.eMatrix ? 0.114 : 0.0722;
+    const bool bLimited = YuvRangeLimited == rSettings.eRange;
+    const double dLumaScale = bLimited ? 219.0 / 255.0 : 1.0;
+    const double dChromaScale = bLimited ? 224.0 / 255.0 : 1.0;
+
+    YuvCoefficients c;
+    c.nYr = ToFixedPoint( dKr * dLumaScale );
+    c.nYb = ToFixedPoint( dKb * dLumaScale );
+    c.nYg = ToFixedPoint( dLumaScale ) - c.nYr - c.nYb;
+    c.nUr = ToFixedPoint( -dKr / ( 2.0 * ( 1.0 - dKb ) ) * dChromaScale );
+    c.nUb = ToFixedPoint( 0.5 * dChromaScale );
+    c.nUg = -c.nUr - c.nUb;
+    c.nVr = ToFixedPoint( 0.5 * dChromaScale );
+    c.nVb = ToFixedPoint( -dKb / ( 2.0 * ( 1.0 - dKr ) ) * dChromaScale );
+    c.nVg = -c.nVr - c.nVb;
+    c.nYBias = ( ( bLimited ? 16 : 0 ) << YUV_COEFFICIENT_BITS ) + ( 1 << ( YUV_COEFFICIENT_BITS - 1 ) );
+    c.nCBias = ( 128 << YUV_CHROMA_BITS ) + ( 1 << ( YUV_CHROMA_BITS - 1 ) );
+    return c;
+}
+
+// Two rows unpacked to 16 bit planes
+struct PlanePair
+{
+    VmbInt16_t     *pR[2];
+    VmbInt16_t     *pG[2];
+    VmbInt16_t     *pB[2];
+};
+
+// Where a pair of rows goes, NV12 interleaves U and V
+struct YuvRows
+{
+    VmbUchar_t     *pY[2];
+    VmbUchar_t     *pU;
+    VmbUchar_t     *pV;
+    bool            bInterleaved;
+};
+
+inline VmbUchar_t ClampToByte( VmbInt32_t nValue )
+{
+    return static_cast<VmbUchar_t>( nValue < 0 ? 0 : ( nValue > 255 ? 255 : nValue ) );
+}
+
+//
+// Converts the pixels from nFirst to nEnd, both even. Has the same
+// results as the SSE2 version.
+//
+void ConvertSpan( const YuvCoefficients &rC, const PlanePair &rPlanes, VmbUint32_t nFirst, VmbUint32_t nEnd, bool bChroma, const YuvRows &rRows )
+{
+    for( VmbUint32_t x = nFirst; x < nEnd; x += 2 )
+    {
+        for( int r = 0; r < 2; ++r )
+        {
+            for( VmbUint32_t i = x; i < x + 2; ++i )
+            {
+                rRows.pY[r][i] = ClampToByte( ( rC.nYr * rPlanes.pR[r][i] + rC.nYg * rPlanes.pG[r][i] + rC.nYb * rPlanes.pB[r][i] + rC.nYBias ) >> YUV_COEFFICIENT_BITS );
+            }
+        }
+        if( !bChroma )
+        {
+            continue;
+        }
+        const VmbInt32_t nR = rPlanes.pR[0][x] + rPlanes.pR[0][x + 1] + rPlanes.pR[1][x] + rPlanes.pR[1][x + 1];
+        const VmbInt32_t nG = rPlanes.pG[0][x] + rPlanes.pG[0][x + 1] + rPlanes.pG[1][x] + rPlanes.pG[1][x + 1];
+        const VmbInt32_t nB = rPlanes.pB[0][x] + rPlanes.pB[0][x + 1] + rPlanes.pB[1][x] + rPlanes.pB[1][x + 1];
+        const VmbUint32_t nChroma = rRows.bInterleaved ? x : x / 2;
+        rRows.pU[nChroma] = ClampToByte( ( rC.nUr * nR + rC.nUg * nG + rC.nUb * nB + rC.nCBias ) >> YUV_CHROMA_BITS );
+        rRows.pV[nChroma] = ClampToByte( ( rC.nVr * nR + rC.nVg * nG + rC.nVb * nB + rC.nCBias ) >> YUV_CHROMA_BITS );
+    }
+}
+
+#ifdef AVT_YUVCONVERTER_SSE2
+// Two 16 bit coefficients for _mm_madd_epi16, the first one in the low half
+inline __m128i PairCoefficients( VmbInt32_t nFirst, VmbInt32_t nSecond )
+{
+    return _mm_set1_epi32( static_cast<int>( ( static_cast<VmbUint32_t>( nSecond ) << 16 ) | ( static_cast<VmbUint32_t>( nFirst ) & 0xFFFF ) ) );
+}
+
+// The matrix row of one output on 8 pixels, 16 bit results
+template <int SHIFT>
+inline __m128i Dot( __m128i r, __m128i g, __m128i b, __m128i rg, __m128i b0, __m128i bias )
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i low = _mm_add_epi32( _mm_madd_epi16( _mm_unpacklo_epi16( r, g ), rg ), _mm_madd_epi16( _mm_unpacklo_epi16( b, zero ), b0 ) );
+    __m128i high = _mm_add_epi32( _mm_madd_epi16( _mm_unpackhi_epi16( r, g ), rg ), _mm_madd_epi16( _mm_unpackhi_epi16( b, zero ), b0 ) );
+    low = _mm_srai_epi32( _mm_add_epi32( low, bias ), SHIFT );
+    high = _mm_srai_epi32( _mm_add_epi32( high, bias ), SHIFT );
+    return _mm_packs_epi32( low, high );
+}
+
+// The sums of 2 x 2 pixels of 16 pixels of both rows
+inline __m128i SumBlocks( const VmbInt16_t * const *pRows, VmbUint32_t x )
+{
+    const __m128i ones = _mm_set1_epi16( 1 );
+    const __m128i low = _mm_add_epi16(  _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRows[0] + x ) ),
+                                        _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRows[1] + x ) ) );
+    const __m128i high = _mm_add_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRows[0] + x + 8 ) ),
+                                        _mm_loadu_si128( reinterpret_cast<const __m128i*>( pRows[1] + x + 8 ) ) );
+    return _mm_packs_epi32( _mm_madd_epi16( low, ones ), _mm_madd_epi16( high, ones ) );
+}
+
+//
+// Converts 16 pixels of both rows at a time
+//
+// Returns:
+//  The first pixel left over
+//
+VmbUint32_t ConvertSpanSSE2( const YuvCoefficients &rC, const PlanePair &rPlanes, VmbUint32_t nWidth, bool bChroma, const YuvRows &rRows )
+{
+    const __m128i yRG = PairCoefficients( rC.nYr, rC.nYg );
+    const __m128i yB = PairCoefficients( rC.nYb, 0 );
+    const __m128i yBias = _mm_set1_epi32( rC.nYBias );
+    const __m128i uRG = PairCoefficients( rC.nUr, rC.nUg );
+    const __m128i uB = PairCoefficients( rC.nUb, 0 );
+    const __m128i vRG = PairCoefficients( rC.nVr, rC.nVg );
+    const __m128i vB = PairCoefficients( rC.nVb, 0 );
+    const __m128i cBias = _mm_set1_epi32( rC.nCBias );
+    const VmbUint32_t nEnd = nWidth & ~15u;
+    for( VmbUint32_t x = 0; x < nEnd; x += 16 )
+    {
+        for( int r = 0; r < 2; ++r )
+        {
+            __m128i luma[2];
+            for( int h = 0; h < 2; ++h )
+            {
+                const VmbUint32_t i = x + 8 * h;
+                luma[h] = Dot<YUV_COEFFICIENT_BITS>(    _mm_loadu_si128( reinterpret_cast<const __m128i*>( rPlanes.pR[r] + i ) ),
+                                                        _mm_loadu_si128( reinterpret_cast<const __m128i*>( rPlanes.pG[r] + i ) ),
+                                                        _mm_loadu_si128( reinterpret_cast<const __m128i*>( rPlanes.pB[r] + i ) ),
+                                                        yRG, yB, yBias );
+            }
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( rRows.pY[r] + x ), _mm_packus_epi16( luma[0], luma[1] ) );
+        }
+        if( !bChroma )
+        {
+            continue;
+        }
+        const __m128i red = SumBlocks( rPlanes.pR, x );
+        const __m128i green = SumBlocks( rPlanes.pG, x );
+        const __m128i blue = SumBlocks( rPlanes.pB, x );
+        const __m128i u = _mm_packus_epi16( Dot<YUV_CHROMA_BITS>( red, green, blue, uRG, uB, cBias ), _mm_setzero_si128() );
+        const __m128i v = _mm_packus_epi16( Dot<YUV_CHROMA_BITS>( red, green, blue, vRG, vB, cBias ), _mm_setzero_si128() );
+        if( rRows.bInterleaved )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( rRows.pU + x ), _mm_unpacklo_epi8( u, v ) );
+        }
+        else
+        {
+            _mm_storel_epi64( reinterpret_cast<__m128i*>( rRows.pU + x / 2 ), u );
+            _mm_storel_epi64( reinterpret_cast<__m128i*>( rRows.pV + x / 2 ), v );
+        }
+    }
+    return nEnd;
+}
+#endif
+
+void UnpackMonoRow( const VmbUchar_t *pRow, VmbUint32_t nWidth, VmbInt16_t *pGray )
+{
+    for( VmbUint32_t x = 0; x < nWidth; ++x )
+    {
+        pGray[x] = pRow[x];
+    }
+}
+
+void UnpackColorRow( const VmbUchar_t *pRow, VmbUint32_t nWidth, VmbInt16_t *pFirst, VmbInt16_t *pG, VmbInt16_t *pLast )
+{
+    for( VmbUint32_t x = 0; x < nWidth; ++x, pRow += 3 )
+    {
+        pFirst[x] = pRow[0];
+        pG[x] = pRow[1];
+        pLast[x] = pRow[2];
+    }
+}
+
+//
+// Demosaics a row from the 2 x 2 pixels starting at every pixel, or
+// ending at it in the last row and column. Its green is the mean of the
+// two greens.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [in]    y               The row
+//  [in]    nRedColumn      The column of red in the first 2 x 2 pixels
+//  [in]    nRedRow         The row of red in the first 2 x 2 pixels
+//  [out]   pR              The red plane of the row
+//  [out]   pG              The green plane of the row
+//  [out]   pB              The blue plane of the row
+//
+void UnpackBayerRow( const ImageView &rView, VmbUint32_t y, VmbUint32_t nRedColumn, VmbUint32_t nRedRow, VmbInt16_t *pR, VmbInt16_t *pG, VmbInt16_t *pB )
+{
+    const VmbUint32_t nTop = (std::min)( y, rView.nHeight - 2 );
+    const VmbUchar_t *pRows[2] = { rView.pBuffer + static_cast<size_t>( nTop ) * rView.nStride, rView.pBuffer + static_cast<size_t>( nTop + 1 ) * rView.nStride };
+    const VmbUchar_t *pRedRow = pRows[( nRedRow ^ nTop ) & 1];
+    const VmbUchar_t *pBlueRow = pRows[( nRedRow ^ nTop ^ 1 ) & 1];
+    for( VmbUint32_t x = 0; x < rView.nWidth; ++x )
+    {
+        const VmbUint32_t nLeft = (std::min)( x, rView.nWidth - 2 );
+        const VmbUint32_t nRed = nLeft + ( ( nRedColumn ^ nLeft ) & 1 );
+        const VmbUint32_t nBlue = nLeft + ( ( nRedColumn ^ nLeft ^ 1 ) & 1 );
+        pR[x] = pRedRow[nRed];
+        pB[x] = pBlueRow[nBlue];
+        pG[x] = static_cast<VmbInt16_t>( ( pRedRow[nBlue] + pBlueRow[nRed] + 1 ) >> 1 );
+    }
+}
+
+} // namespace
+
+//
+// Gets the size of a converted frame. Both planes are packed without
+// padding, a chroma sample covers 2 x 2 pixels.
+//
+// Parameters:
+//  [in]    nWidth          The width of the frame
+//  [in]    nHeight         The height of the frame
+//  [out]   rnSize          The size in bytes
+//
+// Returns:
+//  VmbErrorBadParameter for an odd or empty width or height
+//
+VmbErrorType GetYuvImageSize( VmbUint32_t nWidth, VmbUint32_t nHeight, size_t &rnSize )
+{
+    if(     0 == nWidth
+        ||  0 == nHeight
+        ||  0 != ( nWidth & 1 )
+        ||  0 != ( nHeight & 1 ) )
+    {
+        return VmbErrorBadParameter;
+    }
+    rnSize = static_cast<size_t>( nWidth ) * nHeight * 3 / 2;
+    return VmbErrorSuccess;
+}
+
+//
+// Converts Mono8, Rgb8, Bgr8 and raw Bayer frames to YUV 4:2:0 in one
+// pass. Raw Bayer is demosaiced from the 2 x 2 pixels starting at every
+// pixel. A pair of rows is unpacked to 16 bit planes of R, G and B, the
+// matrix is then applied to 16 pixels at a time. The frame is spread
+// over the pool in stripes of row pairs.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [in]    rSettings       The layout, matrix and range to convert to
+//  [in]    pPool           The pool to spread the frame over, may be NULL
+//  [out]   pTarget         The converted frame, see GetYuvImageSize
+//
+// Returns:
+//  VmbErrorWrongType for other formats,
+//  VmbErrorBadParameter for an odd or empty width or height
+//
+VmbErrorType ConvertToYuv( const ImageView &rView, const YuvSettings &rSettings, ThreadPool *pPool, VmbUchar_t *pTarget )
+{
+    bool bIsMono = false;
+    bool bIsBgr = false;
+    bool bIsBayer = false;
+    VmbUint32_t nRedColumn = 0;
+    VmbUint32_t nRedRow = 0;
+    switch( rView.ePixelFormat )
+    {
+    case VmbPixelFormatMono8:
+        bIsMono = true;
+        break;
+    case VmbPixelFormatRgb8:
+        break;
+    case VmbPixelFormatBgr8:
+        bIsBgr = true;
+        break;
+    case VmbPixelFormatBayerRG8:
+        bIsBayer = true;
+        break;
+    case VmbPixelFormatBayerGR8:
+        bIsBayer = true;
+        nRedColumn = 1;
+        break;
+    case VmbPixelFormatBayerGB8:
+        bIsBayer = true;
+        nRedRow = 1;
+        break;
+    case VmbPixelFormatBayerBG8:
+        bIsBayer = true;
+        nRedColumn = 1;
+        nRedRow = 1;
+        break;
+    default:
+        return VmbErrorWrongType;
+    }
+    size_t nSize;
+    if(     NULL == rView.pBuffer
+        ||  NULL == pTarget
+        ||  VmbErrorSuccess != GetYuvImageSize( rView.nWidth, rView.nHeight, nSize ) )
+    {
+        return VmbErrorBadParameter;
+    }
+
+    const YuvCoefficients coefficients = GetCoefficients( rSettings );
+    const VmbUint32_t nWidth = rView.nWidth;
+    const VmbUint32_t nPairs = rView.nHeight / 2;
+    const bool bInterleaved = YuvLayoutNv12 == rSettings.eLayout;
+    VmbUchar_t * const pLuma = pTarget;
+    VmbUchar_t * const pChroma = pTarget + static_cast<size_t>( nWidth ) * rView.nHeight;
+    // NV12 has a row of U and V pairs per pair of rows, I420 half a row of each
+    const size_t nChromaStride = bInterleaved ? nWidth : nWidth / 2;
+    const size_t nPlaneSize = nChromaStride * nPairs;
+    const VmbUint32_t nStripes = NULL == pPool ? 1 : (std::max)( 1u, (std::min)( pPool->GetThreadCount() + 1, rView.nHeight / MIN_STRIPE_ROWS ) );
+    const std::function<void( unsigned int )> stripe = [&]( unsigned int nStripe )
+    {
+        const VmbUint32_t nFirstPair = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( nPairs ) * nStripe / nStripes );
+        const VmbUint32_t nEndPair = static_cast<VmbUint32_t>( static_cast<VmbUint64_t>( nPairs ) * ( nStripe + 1 ) / nStripes );
+        // R, G and B of both rows, gray uses one plane per row for all three
+        std::vector<VmbInt16_t> planes( static_cast<size_t>( nWidth ) * 6 );
+        PlanePair pair;
+        for( int r = 0; r < 2; ++r )
+        {
+            VmbInt16_t *pRow = &planes[static_cast<size_t>( nWidth ) * 3 * r];
+            pair.pR[r] = pRow;
+            pair.pG[r] = bIsMono ? pRow : pRow + nWidth;
+            pair.pB[r] = bIsMono ? pRow : pRow + 2 * nWidth;
+        }
+        for( VmbUint32_t p = nFirstPair; p < nEndPair; ++p )
+        {
+            YuvRows rows;
+            for( int r = 0; r < 2; ++r )
+            {
+                const VmbUint32_t y = 2 * p + r;
+                const VmbUchar_t *pRow = rView.pBuffer + static_cast<size_t>( y ) * rView.nStride;
+                if( bIsMono )
+                {
+                    UnpackMonoRow( pRow, nWidth, pair.pG[r] );
+                }
+                else if( bIsBayer )
+                {
+                    UnpackBayerRow( rView, y, nRedColumn, nRedRow, pair.pR[r], pair.pG[r], pair.pB[r] );
+                }
+                else if( bIsBgr )
+                {
+                    UnpackColorRow( pRow, nWidth, pair.pB[r], pair.pG[r], pair.pR[r] );
+                }
+                else
+                {
+                    UnpackColorRow( pRow, nWidth, pair.pR[r], pair.pG[r], pair.pB[r] );
+                }
+                rows.pY[r] = pLuma + static_cast<size_t>( y ) * nWidth;
+            }
+            rows.bInterleaved = bInterleaved;
+            rows.pU = pChroma + p * nChromaStride;
+            rows.pV = bInterleaved ? rows.pU + 1 : rows.pU + nPlaneSize;
+            // Gray has no chroma
+            if( bIsMono )
+            {
+                memset( rows.pU, 128, nChromaStride );
+                if( !bInterleaved )
+                {
+                    memset( rows.pV, 128, nChromaStride );
+                }
+            }
+            VmbUint32_t x = 0;
+#ifdef AVT_YUVCONVERTER_SSE2
+            x = ConvertSpanSSE2( coefficients, pair, nWidth, !bIsMono, rows );
+#endif
+            ConvertSpan( coefficients, pair, x, nWidth, !bIsMono, rows );
+        }
+    };
+    if( NULL == pPool || 1 == nStripes )
+    {
+        stripe( 0 );
+    }
+    else
+    {
+        pPool->ParallelFor( nStripes, stripe );
+    }
+    return VmbErrorSuccess;
+}
+
+}}} // namespace AVT::VmbAPI::Examples
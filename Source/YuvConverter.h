@@ -0,0 +1,104 @@
+/*=============================================================================
+  Copyright (C) 2012 - 2016 Allied Vision Technologies.  All Rights Reserved.
+
+  Redistribution of this file, in original or modified form, without
+  prior written consent of Allied Vision Technologies is prohibited.
+
+-------------------------------------------------------------------------------
+
+  File:        YuvConverter.h
+
+  Description: Conversion of frames to the planar YUV 4:2:0 layouts video
+               encoders take, NV12 and I420.
+
+-------------------------------------------------------------------------------
+
+  THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR IMPLIED
+  WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF TITLE,
+  NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR  PURPOSE ARE
+  DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+  INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+  AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR
+  TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+=============================================================================*/
+
+#ifndef AVT_VMBAPI_EXAMPLES_YUVCONVERTER
+#define AVT_VMBAPI_EXAMPLES_YUVCONVERTER
+
+#include <VimbaCPP/Include/VimbaCPP.h>
+
+#include "ImageView.h"
+#include "ThreadPool.h"
+
+namespace AVT {
+namespace VmbAPI {
+namespace Examples {
+
+enum YuvLayout
+{
+    YuvLayoutNv12,          // The Y plane, then U and V interleaved
+    YuvLayoutI420,          // The Y plane, then the U plane, then the V plane
+};
+
+enum YuvMatrix
+{
+    YuvMatrixBt601,         // Standard definition video
+    YuvMatrixBt709,         // High definition video
+};
+
+enum YuvRange
+{
+    YuvRangeLimited,        // Y 16 to 235, U and V 16 to 240, as video usually has it
+    YuvRangeFull,           // Y, U and V 0 to 255
+};
+
+struct YuvSettings
+{
+    YuvLayout       eLayout;
+    YuvMatrix       eMatrix;
+    YuvRange        eRange;
+
+    // NV12, BT.709, limited range
+    YuvSettings();
+};
+
+//
+// Gets the size of a converted frame. Both planes are packed without
+// padding, a chroma sample covers 2 x 2 pixels.
+//
+// Parameters:
+//  [in]    nWidth          The width of the frame
+//  [in]    nHeight         The height of the frame
+//  [out]   rnSize          The size in bytes
+//
+// Returns:
+//  VmbErrorBadParameter for an odd or empty width or height
+//
+VmbErrorType    GetYuvImageSize( VmbUint32_t nWidth, VmbUint32_t nHeight, size_t &rnSize );
+
+//
+// Converts Mono8, Rgb8, Bgr8 and raw Bayer frames to YUV 4:2:0 in one
+// pass. Raw Bayer is demosaiced from the 2 x 2 pixels starting at every
+// pixel. A pair of rows is unpacked to 16 bit planes of R, G and B, the
+// matrix is then applied to 16 pixels at a time. The frame is spread
+// over the pool in stripes of row pairs.
+//
+// Parameters:
+//  [in]    rView           The frame
+//  [in]    rSettings       The layout, matrix and range to convert to
+//  [in]    pPool           The pool to spread the frame over, may be NULL
+//  [out]   pTarget         The converted frame, see GetYuvImageSize
+//
+// Returns:
+//  VmbErrorWrongType for other formats,
+//  VmbErrorBadParameter for an odd or empty width or height
+//
+VmbErrorType    ConvertToYuv( const ImageView &rView, const YuvSettings &rSettings, ThreadPool *pPool, VmbUchar_t *pTarget );
+
+}}} // namespace AVT::VmbAPI::Examples
+
+#endif
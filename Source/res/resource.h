@@ -22,6 +22,28 @@
 #define IDC_STATIC_FRAME_ID2            1019
 #define IDC_BT_OPENCAM3                 1020
 #define IDC_STATIC_FRAME_ID3            1021
+#define IDC_CHECK_BURST                 1022
+#define IDC_STATIC_BURST1               1023
+#define IDC_STATIC_BURST2               1024
+#define IDC_CHECK_FRAMEBUS              1025
+#define IDC_STATIC_FRAMEBUS             1026
+#define IDC_BT_OPENALL                  1027
+#define IDC_STATIC_DISPLAY1             1028
+#define IDC_STATIC_DISPLAY2             1029
+#define IDC_CHECK_MOSAIC                1030
+#define IDC_CHECK_AUTOEXPOSURE1         1031
+#define IDC_CHECK_AUTOEXPOSURE2         1032
+#define IDC_STATIC_FOCUS1               1033
+#define IDC_STATIC_FOCUS2               1034
+#define IDC_CHECK_MOTION1               1035
+#define IDC_CHECK_MOTION2               1036
+#define IDC_BT_CAPTURE_DARK             1037
+#define IDC_BT_CAPTURE_FLAT             1038
+#define IDC_CHECK_FLATFIELD             1039
+#define IDC_CHECK_DEFECTS               1040
+#define IDC_EDIT_AVERAGE                1041
+#define IDC_CHECK_HDR                   1042
+#define IDC_CHECK_UNDISTORT             1043
 
 // Next default values for new objects
 // 
@@ -29,7 +51,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        130
 #define _APS_NEXT_COMMAND_VALUE         32771
-#define _APS_NEXT_CONTROL_VALUE         1019
+#define _APS_NEXT_CONTROL_VALUE         1044
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif